@@ -19,6 +19,7 @@ extern "C" {
  * 2. Connect Wi-Fi & TCP Server
  * 3. Send Player ID
  * 4. Recv & Write "control.dat" then "frame.dat"
+ * 5. Stop Wi-Fi and send UPLOAD_SUCCESS (main reloads the show and restarts BLE)
  */
 void tcp_client_start_update_task(void);
 
@@ -19,6 +19,8 @@
 #include "sd_writer.h"
 #include "bt_receiver.h"
 #include "readframe.h"
+#include "show_compile.h"
+#include "show_verify.h"
 
 static const char *TAG = "TCP_CLIENT";
 
@@ -115,6 +117,40 @@ static void wifi_init_sta(void)
     ESP_LOGI(TAG, "wifi_init_sta finished.");
 }
 
+/* Wi-Fi Teardown: hand the radio back to BLE without a reboot */
+static void wifi_deinit_sta(void)
+{
+    s_is_stopping = true; // Stop the disconnect handler from reconnecting
+
+    esp_wifi_disconnect();
+    esp_wifi_stop();
+    esp_wifi_deinit();
+
+    // The STA_DISCONNECTED posted above is delivered later by the event loop task:
+    // unregister first so it can never reach a deleted event group
+    if (instance_any_id != NULL) {
+        esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, instance_any_id);
+        instance_any_id = NULL;
+    }
+    if (instance_got_ip != NULL) {
+        esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, instance_got_ip);
+        instance_got_ip = NULL;
+    }
+
+    // The next upload creates a fresh station netif
+    if (s_wifi_netif != NULL) {
+        esp_netif_destroy_default_wifi(s_wifi_netif);
+        s_wifi_netif = NULL;
+    }
+
+    if (s_wifi_event_group != NULL) {
+        vEventGroupDelete(s_wifi_event_group);
+        s_wifi_event_group = NULL;
+    }
+
+    ESP_LOGI(TAG, "wifi_deinit_sta finished.");
+}
+
 /* Helper function to receive exact number of bytes */
 static int recv_exact(int sock, void *buf, size_t len) {
     size_t received = 0;
@@ -244,6 +280,11 @@ static void update_task_func(void *pvParameters) {
                 ESP_LOGI(TAG, "Sent Player ID: %s", msg);
 
                 // [Step 4] Download Files
+#if LD_CFG_ENABLE_SD
+                // New files must go through the one-time verification and compile passes again
+                show_verify_invalidate("0:/frame.dat");
+                show_compile_invalidate("0:/frame.dat");
+#endif
                 if (download_file(sock, "0:/control.dat") == ESP_OK) {
                     download_file(sock, "0:/frame.dat");
                 }
@@ -256,6 +297,9 @@ static void update_task_func(void *pvParameters) {
         ESP_LOGE(TAG, "Wi-Fi connection failed.");
     }
 
+    // [Step 5] Stop Wi-Fi so main can restart BLE
+    wifi_deinit_sta();
+
     if (sys_cmd_queue != NULL) {
         sys_cmd_t msg = UPLOAD_SUCCESS;
         xQueueSend(sys_cmd_queue, &msg, 0);
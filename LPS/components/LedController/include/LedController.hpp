@@ -14,6 +14,8 @@ class LedController {
     esp_err_t init();
     esp_err_t write_channel(int ch_idx, const grb8_t* data);
     esp_err_t write_frame(const frame_data* frame);
+    /* Output-ready frame (gamma / brightness applied): copied into the transmit buffers as is. */
+    esp_err_t write_wire(const frame_wire* wire);
 
     /* Backward-compatible alias for channel write path. */
     inline esp_err_t write_buffer(int ch_idx, const grb8_t* data) {
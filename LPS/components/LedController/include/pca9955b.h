@@ -42,6 +42,7 @@ esp_err_t pca9955b_del(pca9955b_dev_t* pca9955b);
 /* Buffer update */
 esp_err_t pca9955b_set_pixel(pca9955b_dev_t* pca9955b, uint8_t pixel_idx, grb8_t color);
 esp_err_t pca9955b_write_grb(pca9955b_dev_t* pca9955b, const grb8_t* colors, uint8_t count);
+esp_err_t pca9955b_write_rgb(pca9955b_dev_t* pca9955b, const uint8_t* data);
 esp_err_t pca9955b_fill(pca9955b_dev_t* pca9955b, grb8_t color);
 
 /* Transmission */
@@ -136,6 +136,23 @@ esp_err_t LedController::write_frame(const frame_data* frame) {
     return ESP_OK;
 }
 
+esp_err_t LedController::write_wire(const frame_wire* wire) {
+    ESP_RETURN_ON_FALSE(wire, ESP_ERR_INVALID_ARG, TAG, "wire is NULL");
+    ESP_LOGD(TAG, "write_wire start");
+
+    for(int i = 0; i < LD_BOARD_PCA9955B_NUM; ++i) {
+        ESP_RETURN_ON_ERROR(pca9955b_write_rgb(&pca9955b_devs[i], wire->pca9955b[i]), TAG, "write PCA %d failed", i);
+    }
+
+    for(int i = 0; i < LD_BOARD_WS2812B_NUM; ++i) {
+        // wire bytes are G R B per pixel, the same layout as grb8_t
+        ESP_RETURN_ON_ERROR(ws2812b_write_grb(&ws2812b_devs[i], (const grb8_t*)wire->ws2812b[i], ws2812b_devs[i].pixel_num), TAG, "write WS ch %d failed", i);
+    }
+
+    ESP_LOGD(TAG, "write_wire complete");
+    return ESP_OK;
+}
+
 esp_err_t LedController::show() {
     esp_err_t ret = ESP_OK;
     esp_err_t err = ESP_OK;
@@ -125,6 +125,17 @@ esp_err_t pca9955b_write_grb(pca9955b_dev_t* pca9955b, const grb8_t* colors, uin
     return ESP_OK;
 }
 
+esp_err_t pca9955b_write_rgb(pca9955b_dev_t* pca9955b, const uint8_t* data) {
+    // 1. Validate Input
+    ESP_RETURN_ON_FALSE(pca9955b, ESP_ERR_INVALID_ARG, TAG, "Handle is NULL");
+    ESP_RETURN_ON_FALSE(data, ESP_ERR_INVALID_ARG, TAG, "Input buffer is NULL");
+
+    // 2. Already in register order (RGB per pixel): copy the whole shadow buffer.
+    memcpy(pca9955b->buffer.data, data, sizeof(pca9955b->buffer.data));
+
+    return ESP_OK;
+}
+
 esp_err_t pca9955b_show(pca9955b_dev_t* pca9955b) {
     esp_err_t ret = ESP_OK;
 
@@ -33,7 +33,10 @@ typedef enum {
     LPS_CMD_CANCEL  = 0x06,
     LPS_CMD_CHECK   = 0x07,
     LPS_CMD_UPLOAD  = 0x08,
-    LPS_CMD_RESET   = 0x09
+    LPS_CMD_RESET   = 0x09,
+    LPS_CMD_SELECT  = 0x0A,
+    LPS_CMD_TEMPO   = 0x0B,
+    LPS_CMD_LOOP    = 0x0C
 } lps_cmd_t;
 
 typedef enum {
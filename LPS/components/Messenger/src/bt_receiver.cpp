@@ -13,6 +13,7 @@
 #include "freertos/queue.h"
 #include "freertos/task.h"
 
+#include "ld_config.h"
 #include "player.hpp"
 
 // --- HCI Command Definitions ---
@@ -59,6 +60,7 @@ typedef struct {
     volatile uint8_t target_cmd;    // Command action type (e.g., PLAY, PAUSE)
     volatile uint64_t target_mask;  // Target device bitmask
     volatile uint8_t data[3];       // Extra parameters (e.g., RGB values)
+    volatile int64_t target_us;     // Averaged target time (esp_timer), PLAY starts the show clock on it
 } bt_action_context_t;
 
 #define MAX_CONCURRENT_ACTIONS 16
@@ -342,6 +344,8 @@ static void trigger_ack_task(uint8_t my_id, uint8_t cmd_id, uint8_t cmd_type, ui
 static void IRAM_ATTR led_timer_cb(void* arg) {
     if (Player::getInstance().getState() == 4) { // Only stop if it's currently in TEST mode (4)
         Player::getInstance().stop();
+        // Pre-roll: the PLAY that armed this timer is still scheduled (CANCEL stops the timer)
+        Player::getInstance().preroll();
     }
 }
 
@@ -360,8 +364,8 @@ static void IRAM_ATTR timer_timeout_cb(void* arg) {
     
     // Dispatch to Player module
     switch(cmd) {
-        case LPS_CMD_PLAY: // PLAY
-            Player::getInstance().play();
+        case LPS_CMD_PLAY: // PLAY (fired LD_CFG_PLAYER_SYNC_LEAD_US early, the metronome waits for the target)
+            Player::getInstance().play(slot->ctx.target_us);
             break;
         case LPS_CMD_PAUSE: // PAUSE
             Player::getInstance().pause();
@@ -410,6 +414,20 @@ static void IRAM_ATTR timer_timeout_cb(void* arg) {
                              state);
             break;
         }
+        case LPS_CMD_SELECT: // SELECT (show id in Data[0])
+            Player::getInstance().select(test_data[0]);
+            break;
+        case LPS_CMD_TEMPO: // TEMPO (percent in Data[0])
+            Player::getInstance().setTempo(test_data[0]);
+            break;
+        case LPS_CMD_LOOP: // LOOP (A in 100 ms units in Data[0..1] LE, length in seconds in Data[2], 0 = off)
+            if (test_data[2] == 0) {
+                Player::getInstance().clearLoop();
+            } else {
+                uint32_t a_ms = (uint32_t)(test_data[0] | (test_data[1] << 8)) * 100;
+                Player::getInstance().setLoop(a_ms, a_ms + (uint32_t)test_data[2] * 1000);
+            }
+            break;
         case LPS_CMD_UPLOAD: // UPLOAD
         case LPS_CMD_RESET: // RESET
             // Send system-level commands to the main app task queue
@@ -486,9 +504,10 @@ static void sync_process_task(void* arg) {
                             target_slot->ctx.target_cmd = current_cmd;
                             target_slot->ctx.target_mask = current_mask;
                             memcpy((void*)target_slot->ctx.data, current_data, 3);
+                            target_slot->ctx.target_us = final_target;
                             
                             esp_timer_stop(target_slot->timer_handle);
-                            esp_timer_start_once(target_slot->timer_handle, wait_us);
+                            esp_timer_start_once(target_slot->timer_handle, wait_us - (current_cmd == LPS_CMD_PLAY ? LD_CFG_PLAYER_SYNC_LEAD_US : 0));
                             
                             if (!s_visual_ack_done[current_cmd_id]) {
                                 ESP_LOGI(TAG, "LOCKED -> ID:%d, CMD:0x%02X, AvgRSSI:%d dBm (Cnt:%d), Delay:%lld ms", 
@@ -500,6 +519,10 @@ static void sync_process_task(void* arg) {
                                     esp_timer_stop(s_led_timer); 
                                     esp_timer_start_once(s_led_timer, current_prep_time);
                                 }
+                                // Pre-roll: stage frame 0 now, the target only transmits (with a prep LED, led_timer_cb does it)
+                                else if (current_cmd == LPS_CMD_PLAY) {
+                                    Player::getInstance().preroll();
+                                }
                                 s_visual_ack_done[current_cmd_id] = true;
                             }
                             
@@ -546,9 +569,10 @@ static void sync_process_task(void* arg) {
                              target_slot->ctx.target_cmd = current_cmd;
                              target_slot->ctx.target_mask = current_mask;
                              memcpy((void*)target_slot->ctx.data, current_data, 3);
+                             target_slot->ctx.target_us = final_target;
                              
                              esp_timer_stop(target_slot->timer_handle);
-                             esp_timer_start_once(target_slot->timer_handle, wait_us);
+                             esp_timer_start_once(target_slot->timer_handle, wait_us - (current_cmd == LPS_CMD_PLAY ? LD_CFG_PLAYER_SYNC_LEAD_US : 0));
                              
                              if (!s_visual_ack_done[current_cmd_id]) {
                                  ESP_LOGI(TAG, "LOCKED -> ID:%d, CMD:0x%02X, AvgRSSI:%d dBm (Cnt:%d), Delay:%lld ms", 
@@ -560,6 +584,10 @@ static void sync_process_task(void* arg) {
                                      esp_timer_stop(s_led_timer);
                                      esp_timer_start_once(s_led_timer, current_prep_time);
                                  }
+                                 // Pre-roll: stage frame 0 now, the target only transmits (with a prep LED, led_timer_cb does it)
+                                 else if (current_cmd == LPS_CMD_PLAY) {
+                                     Player::getInstance().preroll();
+                                 }
                                  s_visual_ack_done[current_cmd_id] = true;
                              }
                          }
@@ -679,13 +707,15 @@ esp_err_t bt_receiver_deinit(void) {
             s_slots[i].timer_handle = NULL;
         }
     }
+    if (s_led_timer) {
+        esp_timer_delete(s_led_timer);
+        s_led_timer = NULL;
+    }
 
     // 6. Disable and De-initialize BT Controller
+    // BT memory is kept (no esp_bt_mem_release) so bt_receiver_init() can run again after an upload
     esp_bt_controller_disable();
     esp_bt_controller_deinit();
-    
-    // 7. (Optional) Release BT memory if needed
-    esp_bt_mem_release(ESP_BT_MODE_BTDM);
 
     ESP_LOGI(TAG, "Receiver De-initialized");
     return ESP_OK;
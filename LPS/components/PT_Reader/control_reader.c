@@ -1,25 +1,21 @@
 #include "control_reader.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "ff.h"
 #include "ld_board.h"
+#include "pt_format.h"
+#include "show_profile.h"
 
 static const char* TAG = "control_reader";
 
-static const uint8_t EXPECTED_VERSION_MAJOR = 1;
-static const uint8_t EXPECTED_VERSION_MINOR = 2;
+/* control.dat is read in blocks of this size (whole file in one read when it fits) */
+#define CONTROL_READ_CHUNK_SIZE 16384
 
-/* checksum helper */
-static inline void checksum_add_u8(uint32_t* sum, uint8_t b) {
-    *sum += (uint32_t)b;
-}
-static inline void checksum_add_u32(uint32_t* sum, uint32_t val) {
-    checksum_add_u8(sum, val & 0xFF);
-    checksum_add_u8(sum, (val >> 8) & 0xFF);
-    checksum_add_u8(sum, (val >> 16) & 0xFF);
-    checksum_add_u8(sum, (val >> 24) & 0xFF);
-}
+/* [version 2][PCA flags 40][strip counts 8][frame_num 4] */
+#define CONTROL_HEADER_SIZE (PT_VERSION_HEADER_SIZE + LD_BOARD_PCA9955B_CH_NUM + LD_BOARD_WS2812B_NUM + 4)
 
 /* -------------------------------------------------- */
 
@@ -37,9 +33,159 @@ static esp_err_t fr_to_err(FRESULT fr) {
     }
 }
 
+/* ---------------- buffered stream ---------------- */
+
+typedef struct {
+    FIL* fp;
+    uint8_t* buf;
+    uint32_t cap;
+    uint32_t len;
+    uint32_t pos;
+    uint32_t reads; /* number of f_read calls, for boot profiling */
+    pt_checksum_t kind;
+    uint32_t sum;
+} ctl_stream_t;
+
+static esp_err_t stream_fill(ctl_stream_t* s) {
+    UINT br;
+    if(f_read(s->fp, s->buf, s->cap, &br) != FR_OK || br == 0) {
+        return ESP_FAIL;
+    }
+    s->reads++;
+    s->len = br;
+    s->pos = 0;
+    return ESP_OK;
+}
+
+/* copy n bytes out of the stream, optionally feeding them into the checksum */
+static esp_err_t stream_read(ctl_stream_t* s, uint8_t* dst, uint32_t n, bool checksum) {
+    while(n > 0) {
+        if(s->pos == s->len && stream_fill(s) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        uint32_t k = s->len - s->pos;
+        if(k > n)
+            k = n;
+        if(checksum)
+            s->sum = pt_checksum_update(s->kind, s->sum, s->buf + s->pos, k);
+        memcpy(dst, s->buf + s->pos, k);
+        s->pos += k;
+        dst += k;
+        n -= k;
+    }
+    return ESP_OK;
+}
+
+/* checksum n bytes in place, one call per buffered block */
+static esp_err_t stream_checksum(ctl_stream_t* s, uint32_t n) {
+    while(n > 0) {
+        if(s->pos == s->len && stream_fill(s) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        uint32_t k = s->len - s->pos;
+        if(k > n)
+            k = n;
+        s->sum = pt_checksum_update(s->kind, s->sum, s->buf + s->pos, k);
+        s->pos += k;
+        n -= k;
+    }
+    return ESP_OK;
+}
+
+/* v1.2 ~ v1.6: n u32 timestamps into the profile, block by block, checksumming each block once */
+static esp_err_t stream_fixed_times(ctl_stream_t* s, uint32_t n, show_profile_t* profile) {
+    uint32_t ts = 0;
+    uint8_t have = 0; /* bytes of ts seen, a timestamp may straddle two blocks */
+
+    n *= 4;
+    while(n > 0) {
+        if(s->pos == s->len && stream_fill(s) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        uint32_t k = s->len - s->pos;
+        if(k > n)
+            k = n;
+        const uint8_t* b = s->buf + s->pos;
+        s->sum = pt_checksum_update(s->kind, s->sum, b, k);
+
+        uint32_t i = 0;
+        /* finish a timestamp begun in the previous block */
+        while(have && i < k) {
+            ts |= (uint32_t)b[i++] << (8 * have);
+            if(++have == 4) {
+                show_profile_add(profile, ts);
+                ts = 0;
+                have = 0;
+            }
+        }
+        for(; i + 4 <= k; i += 4)
+            show_profile_add(profile, pt_read_u32_le(b + i));
+        for(; i < k; i++)
+            ts |= (uint32_t)b[i] << (8 * have++);
+        s->pos += k;
+        n -= k;
+    }
+    return ESP_OK;
+}
+
+/* v1.7: decode n bytes of varint timestamp deltas block by block, checksumming each block once */
+static esp_err_t stream_varint_times(ctl_stream_t* s, uint32_t n, uint32_t frame_num, show_profile_t* profile) {
+    uint32_t count = 0;
+    uint32_t ts = 0;
+    uint32_t delta = 0;
+    uint8_t shift = 0;
+
+    while(n > 0) {
+        if(s->pos == s->len && stream_fill(s) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        uint32_t k = s->len - s->pos;
+        if(k > n)
+            k = n;
+        const uint8_t* b = s->buf + s->pos;
+        s->sum = pt_checksum_update(s->kind, s->sum, b, k);
+
+        for(uint32_t i = 0; i < k; i++) {
+            /* the 5th byte holds the top 4 bits and ends the varint */
+            if(shift == 28 && b[i] > 0x0f) {
+                ESP_LOGE(TAG, "timestamp[%lu]: varint longer than %d bytes", (unsigned long)count, PT_VARINT_MAX_SIZE);
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+            delta |= (uint32_t)(b[i] & 0x7f) << shift;
+            if(b[i] & 0x80) {
+                shift += 7;
+                continue;
+            }
+
+            if(count == frame_num || (count && delta == 0) || delta > UINT32_MAX - ts) {
+                ESP_LOGE(TAG, "timestamp[%lu]: delta %lu after %lu ms invalid", (unsigned long)count, (unsigned long)delta, (unsigned long)ts);
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+            ts += delta;
+            count++;
+            if(profile)
+                show_profile_add(profile, ts);
+            delta = 0;
+            shift = 0;
+        }
+        s->pos += k;
+        n -= k;
+    }
+
+    if(shift || count != frame_num) {
+        ESP_LOGE(TAG, "%lu timestamps decoded, frame_num=%lu", (unsigned long)count, (unsigned long)frame_num);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
+
 /* -------------------------------------------------- */
 
 esp_err_t get_channel_info(const char* control_path, ch_info_t* out) {
+    return get_channel_info_profile(control_path, out, NULL);
+}
+
+esp_err_t get_channel_info_profile(const char* control_path, ch_info_t* out, show_profile_t* profile) {
     if(!control_path || !out) {
         return ESP_ERR_INVALID_ARG;
     }
@@ -47,9 +193,9 @@ esp_err_t get_channel_info(const char* control_path, ch_info_t* out) {
     memset(out, 0, sizeof(*out));
 
     FIL fp;
-    UINT br;
-    uint32_t checksum_calc = 0;
+    esp_err_t ret = ESP_OK;
     uint32_t checksum_read = 0;
+    int64_t t_start = esp_timer_get_time();
 
     FRESULT fr = f_open(&fp, control_path, FA_READ);
     if(fr != FR_OK) {
@@ -57,35 +203,53 @@ esp_err_t get_channel_info(const char* control_path, ch_info_t* out) {
         return fr_to_err(fr);
     }
 
-    /* ===== version check ===== */
-    uint8_t version_bytes[2];
-    fr = f_read(&fp, version_bytes, 2, &br);
-
-    if(fr != FR_OK || br != 2) {
-        ESP_LOGE(TAG, "Failed to read version header");
+    /* ===== one buffer for the whole file when it fits ===== */
+    uint32_t file_size = (uint32_t)f_size(&fp);
+    uint32_t cap = (file_size > 0 && file_size < CONTROL_READ_CHUNK_SIZE) ? file_size : CONTROL_READ_CHUNK_SIZE;
+
+    ctl_stream_t s = {
+        .fp = &fp,
+        .buf = (uint8_t*)malloc(cap),
+        .cap = cap,
+    };
+    if(!s.buf) {
+        ESP_LOGE(TAG, "no memory for %u byte read buffer", (unsigned)cap);
         f_close(&fp);
-        return ESP_FAIL;
+        return ESP_ERR_NO_MEM;
     }
 
-    uint8_t major = version_bytes[0];
-    uint8_t minor = version_bytes[1];
+    /* ===== version check ===== */
+    uint8_t header[CONTROL_HEADER_SIZE];
+    if(stream_read(&s, header, PT_VERSION_HEADER_SIZE, false) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read version header");
+        ret = ESP_FAIL;
+        goto done;
+    }
 
-    checksum_add_u8(&checksum_calc, major);
-    checksum_add_u8(&checksum_calc, minor);
+    uint8_t major = header[0];
+    uint8_t minor = header[1];
 
-    if(major != EXPECTED_VERSION_MAJOR || minor != EXPECTED_VERSION_MINOR) {
-        goto version_fail;
+    if(!pt_version_supported(major, minor)) {
+        ESP_LOGE(TAG, "Version mismatch! Expected %d.%d~%d.%d, got %d.%d", PT_VERSION_MAJOR, PT_VERSION_MINOR_MIN, PT_VERSION_MAJOR, PT_VERSION_MINOR_MAX, major, minor);
+        ret = ESP_FAIL;
+        goto done;
     }
 
+    s.kind = pt_checksum_kind(minor);
+    s.sum = pt_checksum_update(s.kind, 0, header, PT_VERSION_HEADER_SIZE);
+
     ESP_LOGI(TAG, "control.dat version: %d.%d (OK)", major, minor);
 
+    /* ===== fixed header: PCA flags, strip counts, frame_num ===== */
+    if(stream_read(&s, header + PT_VERSION_HEADER_SIZE, CONTROL_HEADER_SIZE - PT_VERSION_HEADER_SIZE, true) != ESP_OK) {
+        goto io_fail;
+    }
+
+    const uint8_t* p = header + PT_VERSION_HEADER_SIZE;
+
     /* ===== PCA9955B enable flags ===== */
     for(int i = 0; i < LD_BOARD_PCA9955B_CH_NUM; i++) {
-        uint8_t v;
-        if(f_read(&fp, &v, 1, &br) != FR_OK || br != 1) {
-            goto io_fail;
-        }
-        checksum_add_u8(&checksum_calc, v);
+        uint8_t v = *p++;
         if(v > 1) {
             ESP_LOGE(TAG, "of_enable[%d]=%u invalid", i, v);
             goto fmt_fail;
@@ -96,11 +260,7 @@ esp_err_t get_channel_info(const char* control_path, ch_info_t* out) {
 
     /* ===== WS2812B strip LED counts ===== */
     for(int i = 0; i < LD_BOARD_WS2812B_NUM; i++) {
-        uint8_t v;
-        if(f_read(&fp, &v, 1, &br) != FR_OK || br != 1) {
-            goto io_fail;
-        }
-        checksum_add_u8(&checksum_calc, v);
+        uint8_t v = *p++;
         if(v > LD_BOARD_WS2812B_MAX_PIXEL_NUM) {
             ESP_LOGE(TAG, "strip_led_num[%d]=%u > %u", i, v, LD_BOARD_WS2812B_MAX_PIXEL_NUM);
             goto fmt_fail;
@@ -110,58 +270,82 @@ esp_err_t get_channel_info(const char* control_path, ch_info_t* out) {
     }
 
     /* ===== frame_num ===== */
-    uint32_t frame_num;
-    if(f_read(&fp, &frame_num, 4, &br) != FR_OK || br != 4) {
-        goto io_fail;
-    }
+    uint32_t frame_num = pt_read_u32_le(p);
 
-    checksum_add_u32(&checksum_calc, frame_num);
+    /* ===== v1.7 timestamps: [time_bytes][varint deltas], decoded a block at a time ===== */
+    if(pt_version_has_varint_times(minor)) {
+        uint8_t len_bytes[4];
+        if(stream_read(&s, len_bytes, sizeof(len_bytes), true) != ESP_OK) {
+            goto io_fail;
+        }
+        uint32_t time_bytes = pt_read_u32_le(len_bytes);
+        if(time_bytes < frame_num || time_bytes / PT_VARINT_MAX_SIZE > frame_num) {
+            ESP_LOGE(TAG, "time_bytes=%lu does not fit frame_num=%lu", (unsigned long)time_bytes, (unsigned long)frame_num);
+            goto fmt_fail;
+        }
 
-    /* ===== timestamps ===== */
-    for(uint32_t i = 0; i < frame_num; i++) {
-        uint32_t timestamp;
-        if(f_read(&fp, &timestamp, 4, &br) != FR_OK || br != 4) {
+        if(profile)
+            show_profile_begin(profile);
+        esp_err_t err = stream_varint_times(&s, time_bytes, frame_num, profile);
+        if(err == ESP_FAIL) {
+            goto io_fail;
+        }
+        if(err != ESP_OK) {
+            goto fmt_fail;
+        }
+    } else {
+        /* ===== v1.2 ~ v1.6 timestamps: checksummed block by block, parsed from the block into the profile ===== */
+        if(frame_num > (UINT32_MAX - CONTROL_HEADER_SIZE) / 4) {
             goto io_fail;
         }
-        checksum_add_u32(&checksum_calc, timestamp);
+        if(!profile) {
+            if(stream_checksum(&s, frame_num * 4) != ESP_OK) {
+                goto io_fail;
+            }
+        } else {
+            show_profile_begin(profile);
+            if(stream_fixed_times(&s, frame_num, profile) != ESP_OK) {
+                goto io_fail;
+            }
+        }
     }
 
-
     /* ===== checksum ===== */
-    if(f_read(&fp, &checksum_read, 4, &br) != FR_OK || br != 4) {
+    uint8_t checksum_bytes[PT_CHECKSUM_SIZE];
+    if(stream_read(&s, checksum_bytes, PT_CHECKSUM_SIZE, false) != ESP_OK) {
         goto io_fail;
     }
+    checksum_read = pt_read_u32_le(checksum_bytes);
 
     /* ===== verify checksum ===== */
-    if(checksum_read != checksum_calc) {
-        ESP_LOGE(TAG, "checksum mismatch! read=%lu calculated=%lu", (unsigned long)checksum_read, (unsigned long)checksum_calc);
-        memset(out, 0, sizeof(*out));
-        return ESP_ERR_INVALID_CRC;
+    if(checksum_read != s.sum) {
+        ESP_LOGE(TAG, "checksum mismatch! read=%lu calculated=%lu", (unsigned long)checksum_read, (unsigned long)s.sum);
+        ret = ESP_ERR_INVALID_CRC;
+        goto done;
     }
 
-    f_close(&fp);
+    ESP_LOGI(TAG, "channel info loaded, checksum OK (%lu frames, %u f_read, %lld us)", (unsigned long)frame_num, (unsigned)s.reads, (long long)(esp_timer_get_time() - t_start));
+    ret = ESP_OK;
+    goto done;
 
-    ESP_LOGI(TAG, "channel info loaded, checksum OK");
-    return ESP_OK;
     /* ---------------- error paths ---------------- */
 
 io_fail:
     ESP_LOGE(TAG, "I/O error while reading %s", control_path);
-    f_close(&fp);
-    memset(out, 0, sizeof(*out));
-    return ESP_FAIL;
+    ret = ESP_FAIL;
+    goto done;
 
 fmt_fail:
     ESP_LOGE(TAG, "format error in %s", control_path);
-    f_close(&fp);
-    memset(out, 0, sizeof(*out));
-    return ESP_ERR_INVALID_RESPONSE;
+    ret = ESP_ERR_INVALID_RESPONSE;
 
-version_fail:
-    ESP_LOGE(TAG, "Version mismatch! Expected %d.%d, got %d.%d", EXPECTED_VERSION_MAJOR, EXPECTED_VERSION_MINOR, major, minor);
+done:
+    free(s.buf);
     f_close(&fp);
-    memset(out, 0, sizeof(*out));
-    return ESP_FAIL;
+    if(ret != ESP_OK) {
+        memset(out, 0, sizeof(*out));
+    }
+    return ret;
 }
 /* ---------- helpers ---------- */
 
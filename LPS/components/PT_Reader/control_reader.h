@@ -2,8 +2,12 @@
 #include <stdint.h>
 #include "esp_err.h"
 #include "ld_board.h"
+#include "show_profile.h"
 
 // esp_err_t control_reader_load(const char *path, control_info_t *out);
 // void      control_reader_free(control_info_t *info);
 
-esp_err_t get_channel_info(const char* control_path, ch_info_t* out);
\ No newline at end of file
+esp_err_t get_channel_info(const char* control_path, ch_info_t* out);
+
+/* same as get_channel_info, and feeds every timestamp into profile (see show_profile.h) */
+esp_err_t get_channel_info_profile(const char* control_path, ch_info_t* out, show_profile_t* profile);
\ No newline at end of file
@@ -2,17 +2,27 @@
 
 #include <string.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "ff.h"
 #include "ld_board.h"  // global ch_info
+#include "ld_config.h"
+#include "ld_ease.h"
+#include "pt_format.h"
 #include "readframe.h"
+#include "sd_latency.h"
+#include "track_merge.h"
 
 /* ================= config ================= */
 
-static const uint8_t EXPECTED_VERSION_MAJOR = 1;
-static const uint8_t EXPECTED_VERSION_MINOR = 2;
-
 #define FRAME_RAW_MAX_SIZE 8192
-#define CHECKSUM_SIZE 4  // uint8 (reserved)
+
+/* largest decoded payload: every OF + every LED at max pixel count */
+#define FRAME_PAYLOAD_MAX_SIZE ((LD_BOARD_PCA9955B_CH_NUM + LD_BOARD_WS2812B_NUM * LD_BOARD_WS2812B_MAX_PIXEL_NUM) * 3)
+
+/* v1.8 track table: [track_count][masks][curve_count][curves][crc32] */
+#define TRACK_TABLE_MAX_SIZE (PT_TRACK_TABLE_HEADER_SIZE + PT_TRACK_MAX * PT_TRACK_MASK_SIZE + PT_CURVE_TABLE_HEADER_SIZE + PT_CURVE_MAX * PT_CURVE_SIZE + PT_CHECKSUM_SIZE)
+
+_Static_assert(PT_CURVE_MAX <= LD_EASE_CUSTOM_MAX, "custom curves of a show must fit ld_ease");
 
 /* ================= static ================= */
 
@@ -20,38 +30,212 @@ static const char* TAG = "frame_reader";
 
 static FIL fp;
 static bool opened = false;
-static uint32_t g_frame_size = 0;
 
-/* ================= helpers ================= */
+/* memory source (flash mapping / RAM copy), NULL when reading from SD */
+static const uint8_t* g_mem = NULL;
+static uint32_t g_mem_size = 0;
+static uint32_t g_mem_pos = 0;
 
-static inline void checksum_add_u8(uint32_t* sum, uint8_t b) {
-    *sum += (uint32_t)b;
-}
+static uint32_t g_frame_size = 0;
+static uint32_t g_payload_size = 0;
+static uint32_t g_offset = 0; /* file offset of the next record */
+static pt_checksum_t g_checksum_kind = PT_CHECKSUM_SUM8;
+static uint8_t g_minor = 0;
+static bool g_records = false; /* v1.4+ typed records */
+static bool g_tracks = false;  /* v1.6+ per-channel tracks */
+static uint32_t g_header_size = PT_VERSION_HEADER_SIZE; /* file offset of the first record */
+static bool g_verify = true;
+
+/* v1.4+: last KEY payload and the frame rebuilt from it.
+ * g_key_ref points at g_key, or straight into the memory source for a KEY record.
+ * v1.6+: g_key holds the whole-board record being decoded, g_have_key = a KEY / INDEXED one was read. */
+static uint8_t g_key[FRAME_PAYLOAD_MAX_SIZE];
+static const uint8_t* g_key_ref = g_key;
+static uint8_t g_payload[FRAME_PAYLOAD_MAX_SIZE];
+static bool g_have_key = false;
+
+/* one record as read from SD, shared by frame_reader_read() and frame_reader_seek() */
+static uint8_t g_raw[FRAME_RAW_MAX_SIZE];
+
+/* v1.5+: palette of the current segment, for INDEXED8 / INDEXED4 records */
+static uint8_t g_palette[PT_PALETTE_MAX_COLORS * 3];
+static uint16_t g_palette_size = 0;
+
+/* where the last frame came from, for frame_reader_sync_pos() */
+static uint32_t g_frame_offset = 0;   /* its frame / record, v1.6+ its SYNC record */
+static uint32_t g_palette_offset = 0; /* v1.5: PALETTE record in effect, 0 if none */
+static uint32_t g_frame_palette = 0;  /* g_palette_offset at g_frame_offset */
+static bool g_frame_sync = false;     /* decodes without the records before it */
+
+/* v1.6+: SYNC read ahead of its frame, and the time frame_reader_seek() resumed at */
+static bool g_sync_pending = false;
+static uint32_t g_sync_ts = 0;
+static uint32_t g_sync_offset = 0;
+static uint32_t g_sync_palette = 0;
+static uint32_t g_seek_ts = 0;
+
+#if LD_CFG_PT_READER_PROFILE
+static uint32_t prof_frames = 0;
+static uint32_t prof_keys = 0;
+static uint32_t prof_bytes = 0;
+static int64_t prof_decode_us = 0;
+#endif
 
 /* ================= init / deinit ================= */
 
-esp_err_t frame_reader_init(const char* path) {
-    if(!path){
-        ESP_LOGE(TAG, "path is NULL");
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    /* -------- sanity: ch_info must be valid -------- */
-
-    uint32_t of_cnt = 0;
-    uint32_t led_cnt = 0;
+static esp_err_t count_channels(uint32_t* of_cnt, uint32_t* led_cnt) {
+    *of_cnt = 0;
+    *led_cnt = 0;
 
     for(int i = 0; i < LD_BOARD_PCA9955B_CH_NUM; i++)
         if(ch_info_snapshot.i2c_leds[i])
-            of_cnt++;
+            (*of_cnt)++;
 
     for(int i = 0; i < LD_BOARD_WS2812B_NUM; i++)
-        led_cnt += ch_info_snapshot.rmt_strips[i];
+        *led_cnt += ch_info_snapshot.rmt_strips[i];
 
-    if(of_cnt == 0 && led_cnt == 0) {
+    if(*of_cnt == 0 && *led_cnt == 0) {
         ESP_LOGE(TAG, "ch_info empty (no OF, no LED)");
         return ESP_ERR_INVALID_STATE;
     }
+    return ESP_OK;
+}
+
+/* check [major][minor] and derive the frame layout, shared by SD and memory sources */
+static esp_err_t setup_format(const uint8_t* version_bytes, uint32_t of_cnt, uint32_t led_cnt) {
+    uint8_t major = version_bytes[0];
+    uint8_t minor = version_bytes[1];
+    
+    if(!pt_version_supported(major, minor)) {
+        ESP_LOGE(TAG, "Version mismatch! Expected %d.%d~%d.%d, got %d.%d", 
+                 PT_VERSION_MAJOR, PT_VERSION_MINOR_MIN, PT_VERSION_MAJOR, PT_VERSION_MINOR_MAX, major, minor);
+        return ESP_FAIL;
+    }
+
+    g_checksum_kind = pt_checksum_kind(minor);
+    g_minor = minor;
+    g_records = pt_version_has_records(minor);
+    g_tracks = pt_version_has_tracks(minor);
+    
+    ESP_LOGI(TAG, "frame.dat version: %d.%d (OK, %s%s)", major, minor, g_checksum_kind == PT_CHECKSUM_CRC32 ? "crc32" : "sum", g_tracks ? ", tracks" : (g_records ? ", records" : ""));
+
+    /* -------- calculate frame size  -------- */
+
+    g_payload_size = (of_cnt * 3) +  /* OF GRB */
+                     (led_cnt * 3);  /* LED GRB */
+
+    /* fixed frame, or a KEY record for v1.4+ */
+    g_frame_size = (g_records ? PT_RECORD_HEADER_SIZE : 4 + 1) + /* [type] start_time fade [body_len] */
+                   g_payload_size +
+                   PT_CHECKSUM_SIZE; /* checksum */
+
+    if(g_frame_size > FRAME_RAW_MAX_SIZE) {
+        ESP_LOGE(TAG, "frame_size %u exceeds max", (unsigned)g_frame_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    g_header_size = PT_VERSION_HEADER_SIZE;
+    g_offset = PT_VERSION_HEADER_SIZE;
+    g_have_key = false;
+    g_key_ref = g_key;
+    g_palette_size = 0;
+    g_palette_offset = 0;
+    g_frame_sync = false;
+    g_sync_pending = false;
+    g_seek_ts = 0;
+    ld_ease_set_custom(0, NULL); /* v1.8 shows load theirs with the track table */
+
+#if LD_CFG_PT_READER_PROFILE
+    prof_frames = 0;
+    prof_keys = 0;
+    prof_bytes = 0;
+    prof_decode_us = 0;
+#endif
+
+    ESP_LOGI(TAG, "frame_reader init: frame_size=%u (OF=%u LED=%u)", (unsigned)g_frame_size, (unsigned)of_cnt, (unsigned)led_cnt);
+    return ESP_OK;
+}
+
+/* v1.6+: check [track_count][masks]([curve_count][curves] v1.8)[crc32] (size bytes available),
+ * load the custom curves and start the track merger */
+static esp_err_t setup_tracks(const uint8_t* table, uint32_t size) {
+    uint8_t count = size >= PT_TRACK_TABLE_HEADER_SIZE ? table[0] : 0;
+    uint32_t len = PT_TRACK_TABLE_HEADER_SIZE + (uint32_t)count * PT_TRACK_MASK_SIZE;
+    uint8_t curves = 0;
+
+    if(pt_version_has_easing(g_minor) && size >= len + PT_CURVE_TABLE_HEADER_SIZE) {
+        curves = table[len];
+        len += PT_CURVE_TABLE_HEADER_SIZE + (uint32_t)curves * PT_CURVE_SIZE;
+    }
+    if(count == 0 || count > PT_TRACK_MAX || curves > PT_CURVE_MAX || size < len + PT_CHECKSUM_SIZE) {
+        ESP_LOGE(TAG, "invalid track table (%u tracks, %u curves, %lu bytes)", count, curves, (unsigned long)size);
+        return ESP_FAIL;
+    }
+    if(pt_checksum_update(g_checksum_kind, 0, table, len) != pt_read_u32_le(table + len)) {
+        ESP_LOGE(TAG, "track table checksum mismatch");
+        return ESP_ERR_INVALID_CRC;
+    }
+    if(curves && !ld_ease_set_custom(curves, table + len - (uint32_t)curves * PT_CURVE_SIZE)) {
+        ESP_LOGE(TAG, "custom curve does not map 0 -> 0 and 255 -> 255");
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = track_merge_init(table + PT_TRACK_TABLE_HEADER_SIZE, count, g_payload_size);
+    if(err != ESP_OK)
+        return err;
+
+    g_header_size = PT_VERSION_HEADER_SIZE + len + PT_CHECKSUM_SIZE;
+    g_offset = g_header_size;
+    return ESP_OK;
+}
+
+/* SD source: read the track table that follows the version header */
+static esp_err_t read_track_table(void) {
+    static uint8_t table[TRACK_TABLE_MAX_SIZE];
+    UINT br;
+
+    if(f_read(&fp, table, PT_TRACK_TABLE_HEADER_SIZE, &br) != FR_OK || br != PT_TRACK_TABLE_HEADER_SIZE || table[0] > PT_TRACK_MAX) {
+        ESP_LOGE(TAG, "Failed to read track table");
+        return ESP_FAIL;
+    }
+    uint32_t len = PT_TRACK_TABLE_HEADER_SIZE;
+
+    /* masks, and the curve count in v1.8 */
+    uint32_t rest = (uint32_t)table[0] * PT_TRACK_MASK_SIZE + (pt_version_has_easing(g_minor) ? PT_CURVE_TABLE_HEADER_SIZE : 0);
+    if(f_read(&fp, table + len, rest, &br) != FR_OK || br != rest) {
+        ESP_LOGE(TAG, "Failed to read track table");
+        return ESP_FAIL;
+    }
+    len += rest;
+
+    rest = PT_CHECKSUM_SIZE;
+    if(pt_version_has_easing(g_minor)) {
+        uint8_t curves = table[len - 1];
+        if(curves > PT_CURVE_MAX) {
+            ESP_LOGE(TAG, "%u custom curves, at most %d", curves, PT_CURVE_MAX);
+            return ESP_FAIL;
+        }
+        rest += (uint32_t)curves * PT_CURVE_SIZE;
+    }
+    if(f_read(&fp, table + len, rest, &br) != FR_OK || br != rest) {
+        ESP_LOGE(TAG, "Failed to read track table");
+        return ESP_FAIL;
+    }
+    return setup_tracks(table, len + rest);
+}
+
+esp_err_t frame_reader_init(const char* path) {
+    if(!path){
+        ESP_LOGE(TAG, "path is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* -------- sanity: ch_info must be valid -------- */
+
+    uint32_t of_cnt, led_cnt;
+    esp_err_t err = count_channels(&of_cnt, &led_cnt);
+    if(err != ESP_OK)
+        return err;
 
     /* -------- open file -------- */
 
@@ -72,37 +256,44 @@ esp_err_t frame_reader_init(const char* path) {
         f_close(&fp);
         return ESP_FAIL;
     }
-    
-    uint8_t major = version_bytes[0];
-    uint8_t minor = version_bytes[1];
-    
-    if(major != EXPECTED_VERSION_MAJOR || minor != EXPECTED_VERSION_MINOR) {
-        ESP_LOGE(TAG, "Version mismatch! Expected %d.%d, got %d.%d", 
-                 EXPECTED_VERSION_MAJOR, EXPECTED_VERSION_MINOR, major, minor);
+
+    err = setup_format(version_bytes, of_cnt, led_cnt);
+    if(err == ESP_OK && g_tracks)
+        err = read_track_table();
+    if(err != ESP_OK) {
         f_close(&fp);
-        return ESP_FAIL;
+        return err;
     }
-    
-    ESP_LOGI(TAG, "frame.dat version: %d.%d (OK)", major, minor);
 
-    /* -------- calculate frame size  -------- */
+    g_mem = NULL;
+    opened = true;
 
-    g_frame_size = 4 +             /* start_time */
-                   1 +             /* fade */
-                   (of_cnt * 3) +  /* OF GRB */
-                   (led_cnt * 3) + /* LED GRB */
-                   CHECKSUM_SIZE;  /* checksum */
+    return ESP_OK;
+}
 
-    if(g_frame_size > FRAME_RAW_MAX_SIZE) {
-        ESP_LOGE(TAG, "frame_size %u exceeds max", (unsigned)g_frame_size);
-        f_close(&fp);
-        return ESP_ERR_INVALID_SIZE;
+esp_err_t frame_reader_init_mem(const uint8_t* data, uint32_t size) {
+    if(!data || size < PT_VERSION_HEADER_SIZE) {
+        ESP_LOGE(TAG, "invalid memory source");
+        return ESP_ERR_INVALID_ARG;
     }
 
-    opened = true;
+    uint32_t of_cnt, led_cnt;
+    esp_err_t err = count_channels(&of_cnt, &led_cnt);
+    if(err != ESP_OK)
+        return err;
 
-    ESP_LOGI(TAG, "frame_reader init: frame_size=%u (OF=%u LED=%u)", (unsigned)g_frame_size, (unsigned)of_cnt, (unsigned)led_cnt);
+    err = setup_format(data, of_cnt, led_cnt);
+    if(err == ESP_OK && g_tracks)
+        err = setup_tracks(data + PT_VERSION_HEADER_SIZE, size - PT_VERSION_HEADER_SIZE);
+    if(err != ESP_OK)
+        return err;
+
+    g_mem = data;
+    g_mem_size = size;
+    g_mem_pos = g_header_size;
+    opened = true;
 
+    ESP_LOGI(TAG, "reading frames from memory (%lu bytes)", (unsigned long)size);
     return ESP_OK;
 }
 
@@ -110,7 +301,11 @@ void frame_reader_deinit(void) {
     if(!opened)
         return;
 
-    f_close(&fp);
+    if(!g_mem)
+        f_close(&fp);
+    if(g_tracks)
+        track_merge_deinit();
+    g_mem = NULL;
     opened = false;
 }
 
@@ -120,16 +315,528 @@ esp_err_t frame_reader_reset(void) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    if(f_lseek(&fp, 2) != FR_OK) //skip version header
+    if(g_mem)
+        g_mem_pos = g_header_size;
+    else if(f_lseek(&fp, g_header_size) != FR_OK) //skip version header (and track table)
         return ESP_FAIL;
 
+    g_offset = g_header_size;
+    g_have_key = false; /* first record is always a KEY */
+    g_palette_size = 0; /* and a PALETTE precedes the first INDEXED */
+    g_palette_offset = 0;
+    g_frame_sync = false;
+    g_sync_pending = false;
+    g_seek_ts = 0;
+    if(g_tracks)
+        track_merge_reset();
+
     return ESP_OK;
 }
 
+void frame_reader_set_verify(bool enable) {
+    g_verify = enable;
+}
+
 uint32_t frame_reader_frame_size(void) {
     return g_frame_size;
 }
 
+uint32_t frame_reader_tell(void) {
+    return g_offset;
+}
+
+bool frame_reader_sync_pos(frame_reader_pos_t* pos) {
+    if(!g_frame_sync)
+        return false;
+    pos->offset = g_frame_offset;
+    pos->palette = g_frame_palette;
+    return true;
+}
+
+/* ================= record decoding ================= */
+
+/* next n bytes of the show: SD copies into dst, a memory source returns a pointer into itself */
+static const uint8_t* src_read(uint8_t* dst, uint32_t n) {
+    if(g_mem) {
+        if(g_mem_size - g_mem_pos < n) {
+            g_mem_pos = g_mem_size;
+            return NULL;
+        }
+        const uint8_t* p = g_mem + g_mem_pos;
+        g_mem_pos += n;
+        return p;
+    }
+
+    UINT br;
+#if LD_CFG_PT_READER_SD_LATENCY
+    int64_t t0 = esp_timer_get_time();
+    FRESULT fr = f_read(&fp, dst, n, &br);
+    sd_latency_record((uint32_t)(esp_timer_get_time() - t0), br);
+#else
+    FRESULT fr = f_read(&fp, dst, n, &br);
+#endif
+    if(fr != FR_OK || br != n)
+        return NULL;
+    return dst;
+}
+
+/* move the read position to a record offset, file or memory source */
+static esp_err_t src_seek(uint32_t offset) {
+    if(g_mem) {
+        if(offset > g_mem_size)
+            return ESP_ERR_INVALID_ARG;
+        g_mem_pos = offset;
+    } else if(f_lseek(&fp, offset) != FR_OK) {
+        return ESP_FAIL;
+    }
+    g_offset = offset;
+    return ESP_OK;
+}
+
+static esp_err_t verify_checksum(const uint8_t* raw, uint32_t body_size) {
+    if(!g_verify)
+        return ESP_OK;
+
+    uint32_t sum = pt_checksum_update(g_checksum_kind, 0, raw, body_size);
+    uint32_t read_checksum = pt_read_u32_le(raw + body_size);
+
+    if(read_checksum != sum) {
+        ESP_LOGE(TAG, "checksum mismatch. read=%lu calculate=%lu", (unsigned long)read_checksum, (unsigned long)sum);
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+/* v1.2 / v1.3: fixed-size frame, payload decoded straight from the record */
+static esp_err_t read_fixed(uint8_t* raw, table_frame_t* out, const uint8_t** payload, uint32_t* used) {
+    g_frame_offset = g_offset;
+    g_frame_palette = 0;
+    g_frame_sync = true;
+
+    const uint8_t* rec = src_read(raw, g_frame_size);
+    if(!rec) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = verify_checksum(rec, g_frame_size - PT_CHECKSUM_SIZE);
+    if(err != ESP_OK)
+        return err;
+
+    out->timestamp = pt_read_u32_le(rec);
+    out->fade = (rec[4] != 0);
+    out->fade_mask = out->fade ? LD_FRAME_FADE_ALL : 0;
+
+    *payload = rec + 5;
+    *used = g_frame_size;
+    return ESP_OK;
+}
+
+/* apply [skip][len][xor bytes] runs on top of the reference copied into dst */
+static esp_err_t apply_delta(uint8_t* dst, const uint8_t* body, uint32_t body_len) {
+    uint32_t pos = 0;
+    uint32_t i = 0;
+
+    while(i < body_len) {
+        if(body_len - i < PT_DELTA_RUN_HEADER_SIZE)
+            return ESP_FAIL;
+
+        uint32_t skip = pt_read_u16_le(body + i);
+        uint32_t len = pt_read_u16_le(body + i + 2);
+        i += PT_DELTA_RUN_HEADER_SIZE;
+
+        pos += skip;
+        if(len > body_len - i || pos + len > g_payload_size)
+            return ESP_FAIL;
+
+        for(uint32_t k = 0; k < len; k++) {
+            dst[pos + k] ^= body[i + k];
+        }
+        pos += len;
+        i += len;
+    }
+    return ESP_OK;
+}
+
+/* expand 8-bit or 4-bit (low nibble first) palette indices into g_key */
+static esp_err_t expand_indexed(const uint8_t* body, bool nibbles) {
+    const uint32_t pixels = g_payload_size / 3;
+    uint8_t* dst = g_key;
+
+    for(uint32_t i = 0; i < pixels; i++) {
+        uint8_t idx = nibbles ? ((body[i >> 1] >> ((i & 1) * 4)) & 0x0F) : body[i];
+        if(idx >= g_palette_size)
+            return ESP_FAIL;
+
+        memcpy(dst, &g_palette[idx * 3], 3);
+        dst += 3;
+    }
+    return ESP_OK;
+}
+
+/* v1.4+: next record at g_offset, checked but not decoded; *size is the whole record */
+static esp_err_t read_raw_record(uint8_t* raw, const uint8_t** rec_out, uint32_t* size) {
+    const uint8_t* rec = src_read(raw, PT_RECORD_HEADER_SIZE);
+    if(!rec) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t type = rec[0];
+    uint32_t body_len = pt_read_u16_le(rec + 6);
+    *size = PT_RECORD_HEADER_SIZE + body_len + PT_CHECKSUM_SIZE;
+
+    if(*size > FRAME_RAW_MAX_SIZE) {
+        ESP_LOGE(TAG, "record at %lu too large (%lu bytes)", (unsigned long)g_offset, (unsigned long)*size);
+        return ESP_FAIL;
+    }
+
+    /* body follows the header contiguously in both raw and the memory source */
+    if(!src_read(raw + PT_RECORD_HEADER_SIZE, body_len + PT_CHECKSUM_SIZE)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = verify_checksum(rec, PT_RECORD_HEADER_SIZE + body_len);
+    if(err != ESP_OK)
+        return err;
+
+    if(!pt_record_supported(g_minor, type)) {
+        ESP_LOGE(TAG, "unknown record type %u at %lu", type, (unsigned long)g_offset);
+        return ESP_FAIL;
+    }
+
+    *rec_out = rec;
+    return ESP_OK;
+}
+
+/* v1.5: PALETTE record at g_offset becomes the palette of the INDEXED records after it */
+static esp_err_t load_palette(const uint8_t* rec, uint32_t body_len) {
+    if(body_len == 0 || body_len % 3 != 0 || body_len > sizeof(g_palette)) {
+        ESP_LOGE(TAG, "PALETTE at %lu: invalid size %lu", (unsigned long)g_offset, (unsigned long)body_len);
+        return ESP_FAIL;
+    }
+    memcpy(g_palette, rec + PT_RECORD_HEADER_SIZE, body_len);
+    g_palette_size = body_len / 3;
+    g_palette_offset = g_offset;
+    return ESP_OK;
+}
+
+/* v1.4+: typed record, rebuilt into g_key / g_payload */
+static esp_err_t read_record(uint8_t* raw, table_frame_t* out, const uint8_t** payload, uint32_t* used) {
+    const uint8_t* rec;
+    uint8_t type;
+    uint32_t body_len;
+    uint32_t size;
+
+    /* PALETTE records only update state, keep going until a frame record */
+    for(;;) {
+        esp_err_t err = read_raw_record(raw, &rec, &size);
+        if(err != ESP_OK)
+            return err;
+
+        type = rec[0];
+        body_len = size - PT_RECORD_HEADER_SIZE - PT_CHECKSUM_SIZE;
+
+        if(type != PT_RECORD_PALETTE)
+            break;
+
+        if(load_palette(rec, body_len) != ESP_OK)
+            return ESP_FAIL;
+        g_offset += size;
+    }
+
+    const uint8_t* body = rec + PT_RECORD_HEADER_SIZE;
+    g_frame_offset = g_offset;
+    g_frame_palette = g_palette_offset;
+    g_frame_sync = (type != PT_RECORD_DELTA);
+
+    switch(type) {
+        case PT_RECORD_KEY:
+            if(body_len != g_payload_size) {
+                ESP_LOGE(TAG, "KEY at %lu: body %lu != payload %lu", (unsigned long)g_offset, (unsigned long)body_len, (unsigned long)g_payload_size);
+                return ESP_FAIL;
+            }
+            /* memory source: keep the KEY where it is, zero-copy */
+            if(g_mem) {
+                g_key_ref = body;
+            } else {
+                memcpy(g_key, body, body_len);
+                g_key_ref = g_key;
+            }
+            g_have_key = true;
+            *payload = g_key_ref;
+            break;
+
+        case PT_RECORD_DELTA:
+            if(!g_have_key) {
+                ESP_LOGE(TAG, "DELTA at %lu without preceding KEY", (unsigned long)g_offset);
+                return ESP_FAIL;
+            }
+            memcpy(g_payload, g_key_ref, g_payload_size);
+            if(apply_delta(g_payload, body, body_len) != ESP_OK) {
+                ESP_LOGE(TAG, "DELTA at %lu: run out of range", (unsigned long)g_offset);
+                return ESP_FAIL;
+            }
+            *payload = g_payload;
+            break;
+
+        case PT_RECORD_INDEXED8:
+        case PT_RECORD_INDEXED4: {
+            /* an indexed frame is a KEY, DELTAs may follow it */
+            bool nibbles = (type == PT_RECORD_INDEXED4);
+            uint32_t pixels = g_payload_size / 3;
+            if(body_len != (nibbles ? (pixels + 1) / 2 : pixels)) {
+                ESP_LOGE(TAG, "INDEXED at %lu: body %lu does not match %lu pixels", (unsigned long)g_offset, (unsigned long)body_len, (unsigned long)pixels);
+                return ESP_FAIL;
+            }
+            if(expand_indexed(body, nibbles) != ESP_OK) {
+                ESP_LOGE(TAG, "INDEXED at %lu: index out of palette (%u colors)", (unsigned long)g_offset, (unsigned)g_palette_size);
+                g_have_key = false;
+                return ESP_FAIL;
+            }
+            g_key_ref = g_key;
+            g_have_key = true;
+            *payload = g_key;
+            break;
+        }
+
+        default:
+            ESP_LOGE(TAG, "unexpected record type %u at %lu", type, (unsigned long)g_offset);
+            return ESP_FAIL;
+    }
+
+#if LD_CFG_PT_READER_PROFILE
+    if(type != PT_RECORD_DELTA)
+        prof_keys++;
+#endif
+
+    out->timestamp = pt_read_u32_le(rec + 1);
+    out->fade = (rec[5] != 0);
+    out->fade_mask = out->fade ? LD_FRAME_FADE_ALL : 0;
+
+    *used = size;
+    return ESP_OK;
+}
+
+/* v1.6+: fade flag and easing of a key, v1.8 keeps the easing in the upper bits of the fade byte */
+static esp_err_t key_fade(const uint8_t* rec, uint8_t* fade, uint8_t* ease) {
+    bool on = pt_fade_on(g_minor, rec[5]);
+    *ease = pt_fade_ease(g_minor, rec[5]);
+    /* only a key that fades has a curve */
+    if((*ease && !on) || !ld_ease_valid(*ease)) {
+        ESP_LOGE(TAG, "record at %lu: easing %u not available", (unsigned long)g_offset, *ease);
+        return ESP_FAIL;
+    }
+    *fade = on ? 1 : 0;
+    return ESP_OK;
+}
+
+/* v1.6+: TRACK / EFFECT record into the merger */
+static esp_err_t push_track_key(const uint8_t* rec, uint32_t body_len) {
+    uint32_t start_time = pt_read_u32_le(rec + 1);
+    const uint8_t* body = rec + PT_RECORD_HEADER_SIZE;
+
+    if(rec[0] == PT_RECORD_EFFECT) {
+        /* v1.9: an effect key never fades */
+        if(rec[5] != 0 || track_merge_push_effect(start_time, body, body_len) != ESP_OK) {
+            ESP_LOGE(TAG, "EFFECT at %lu rejected", (unsigned long)g_offset);
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+    if(rec[0] != PT_RECORD_TRACK) {
+        ESP_LOGE(TAG, "record type %u at %lu inside a SYNC group", rec[0], (unsigned long)g_offset);
+        return ESP_FAIL;
+    }
+
+    uint8_t fade, ease;
+    if(key_fade(rec, &fade, &ease) != ESP_OK)
+        return ESP_FAIL;
+    if(track_merge_push(start_time, fade, ease, body, body_len) != ESP_OK) {
+        ESP_LOGE(TAG, "TRACK at %lu rejected", (unsigned long)g_offset);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/* v1.6+: whole-board KEY / DELTA / INDEXED record expanded to a full payload */
+static esp_err_t decode_board(uint8_t type, const uint8_t* body, uint32_t body_len, const uint8_t** board) {
+    const uint32_t pixels = g_payload_size / 3;
+
+    switch(type) {
+        case PT_RECORD_KEY:
+            if(body_len != g_payload_size) {
+                ESP_LOGE(TAG, "KEY at %lu: body %lu != payload %lu", (unsigned long)g_offset, (unsigned long)body_len, (unsigned long)g_payload_size);
+                return ESP_FAIL;
+            }
+            g_have_key = true;
+            *board = body;
+            return ESP_OK;
+
+        case PT_RECORD_DELTA:
+            /* XOR against the latest key of every channel */
+            if(!g_have_key) {
+                ESP_LOGE(TAG, "DELTA at %lu without preceding KEY", (unsigned long)g_offset);
+                return ESP_FAIL;
+            }
+            memcpy(g_key, track_merge_last(), g_payload_size);
+            if(apply_delta(g_key, body, body_len) != ESP_OK) {
+                ESP_LOGE(TAG, "DELTA at %lu: run out of range", (unsigned long)g_offset);
+                return ESP_FAIL;
+            }
+            *board = g_key;
+            return ESP_OK;
+
+        default:
+            if(body_len != (type == PT_RECORD_INDEXED4 ? (pixels + 1) / 2 : pixels)) {
+                ESP_LOGE(TAG, "INDEXED at %lu: body %lu does not match %lu pixels", (unsigned long)g_offset, (unsigned long)body_len, (unsigned long)pixels);
+                return ESP_FAIL;
+            }
+            if(expand_indexed(body, type == PT_RECORD_INDEXED4) != ESP_OK) {
+                ESP_LOGE(TAG, "INDEXED at %lu: index out of palette (%u colors)", (unsigned long)g_offset, (unsigned)g_palette_size);
+                return ESP_FAIL;
+            }
+            g_have_key = true;
+            *board = g_key;
+            return ESP_OK;
+    }
+}
+
+/* v1.6+: step over the keys a SYNC restates, checking them when verifying */
+static esp_err_t skip_group(uint8_t* raw, uint32_t group_bytes) {
+    uint32_t end = g_offset + group_bytes;
+    if(!g_verify)
+        return src_seek(end);
+
+    while(g_offset < end) {
+        const uint8_t* rec;
+        uint32_t size;
+        esp_err_t err = read_raw_record(raw, &rec, &size);
+        if(err != ESP_OK)
+            return err == ESP_ERR_NOT_FOUND ? ESP_FAIL : err;
+        if(rec[0] != PT_RECORD_TRACK && rec[0] != PT_RECORD_EFFECT) {
+            ESP_LOGE(TAG, "record type %u at %lu inside a SYNC group", rec[0], (unsigned long)g_offset);
+            return ESP_FAIL;
+        }
+        g_offset += size;
+    }
+    if(g_offset != end) {
+        ESP_LOGE(TAG, "SYNC group ends inside the record before %lu", (unsigned long)g_offset);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/* v1.6+: one record at g_offset into the merger, or into the palette / seek state */
+static esp_err_t read_track_record(uint8_t* raw) {
+    const uint8_t* rec;
+    uint32_t size;
+    esp_err_t err = read_raw_record(raw, &rec, &size);
+    if(err != ESP_OK)
+        return err;
+
+    uint8_t type = rec[0];
+    uint32_t start_time = pt_read_u32_le(rec + 1);
+    uint32_t body_len = size - PT_RECORD_HEADER_SIZE - PT_CHECKSUM_SIZE;
+    const uint8_t* body = rec + PT_RECORD_HEADER_SIZE;
+
+#if LD_CFG_PT_READER_PROFILE
+    prof_keys++;
+    prof_bytes += size;
+#endif
+
+    switch(type) {
+        case PT_RECORD_PALETTE:
+            err = load_palette(rec, body_len);
+            break;
+
+        case PT_RECORD_SYNC: {
+            if(body_len != PT_SYNC_SIZE || rec[5] != 0) {
+                ESP_LOGE(TAG, "SYNC at %lu: body %lu, fade %u", (unsigned long)g_offset, (unsigned long)body_len, rec[5]);
+                return ESP_FAIL;
+            }
+            /* becomes the sync position of the frame at start_time; one at a time */
+            if(!g_sync_pending) {
+                g_sync_pending = true;
+                g_sync_ts = start_time;
+                g_sync_offset = g_offset;
+                g_sync_palette = g_palette_offset;
+            }
+            uint32_t group_bytes = pt_read_u32_le(body);
+            g_offset += size;
+            return skip_group(raw, group_bytes);
+        }
+
+        case PT_RECORD_KEY:
+        case PT_RECORD_DELTA:
+        case PT_RECORD_INDEXED8:
+        case PT_RECORD_INDEXED4: {
+            /* after a seek: before the SYNC time, only the frames before it use it */
+            if(start_time < g_seek_ts)
+                break;
+
+            uint8_t fade, ease;
+            const uint8_t* board;
+            err = key_fade(rec, &fade, &ease);
+            if(err == ESP_OK)
+                err = decode_board(type, body, body_len, &board);
+            if(err == ESP_OK && track_merge_push_board(start_time, fade, ease, board) != ESP_OK) {
+                ESP_LOGE(TAG, "%s at %lu rejected", type == PT_RECORD_DELTA ? "DELTA" : "KEY", (unsigned long)g_offset);
+                err = ESP_FAIL;
+            }
+            break;
+        }
+
+        default:
+            err = push_track_key(rec, body_len);
+            break;
+    }
+    if(err != ESP_OK)
+        return err;
+
+    g_offset += size;
+    return ESP_OK;
+}
+
+/* v1.6+: feed records to the merger until the next frame is complete */
+static esp_err_t read_tracks(uint8_t* raw, table_frame_t* out, const uint8_t** payload, uint32_t* used) {
+    uint32_t timestamp;
+
+    /* after a seek, the frames before the SYNC time only rebuild the tracks */
+    do {
+        while(track_merge_need_record()) {
+            esp_err_t err = read_track_record(raw);
+            if(err == ESP_ERR_NOT_FOUND) {
+                track_merge_end();
+                break;
+            }
+            if(err != ESP_OK)
+                return err;
+        }
+
+        esp_err_t err = track_merge_emit(g_payload, &timestamp, &out->fade_mask, &out->ease, out->effects, &out->effect_count);
+        if(err != ESP_OK)
+            return err;
+    } while(timestamp < g_seek_ts);
+
+    g_frame_sync = g_sync_pending && g_sync_ts == timestamp;
+    if(g_sync_pending && g_sync_ts <= timestamp) {
+        if(!g_frame_sync) {
+            ESP_LOGE(TAG, "SYNC at %lu ms is not a frame time", (unsigned long)g_sync_ts);
+            return ESP_FAIL;
+        }
+        g_frame_offset = g_sync_offset;
+        g_frame_palette = g_sync_palette;
+        g_sync_pending = false;
+    }
+
+    out->timestamp = timestamp;
+    out->fade = (out->fade_mask != 0);
+
+    /* records were counted as they were read */
+    *payload = g_payload;
+    *used = 0;
+    return ESP_OK;
+}
+
 /* ================= read one frame ================= */
 
 esp_err_t frame_reader_read(table_frame_t* out) {
@@ -144,48 +851,34 @@ esp_err_t frame_reader_read(table_frame_t* out) {
     if(!out)
         return ESP_ERR_INVALID_ARG;
 
-    static uint8_t raw[FRAME_RAW_MAX_SIZE];
-    UINT br;
+    uint8_t* raw = g_raw;
+    const uint8_t* payload = NULL;
+    uint32_t used = 0;
 
     memset(out, 0, sizeof(*out));
 
-    FRESULT fr = f_read(&fp, raw, g_frame_size, &br);
-    if(fr != FR_OK || br != g_frame_size) {
-        return ESP_ERR_NOT_FOUND;
-    }
-
-    uint8_t* p = raw;
-    uint32_t sum = 0;
-
-    /* -------- start_time -------- */
-    out->timestamp = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
-
-    for(int i = 0; i < 4; i++)
-        checksum_add_u8(&sum, p[i]);
+#if LD_CFG_PT_READER_PROFILE
+    int64_t t_start = esp_timer_get_time();
+#endif
 
-    p += 4;
+    esp_err_t err;
+    if(g_tracks)
+        err = read_tracks(raw, out, &payload, &used);
+    else
+        err = g_records ? read_record(raw, out, &payload, &used) : read_fixed(raw, out, &payload, &used);
+    if(err != ESP_OK)
+        return err;
 
-    /* -------- fade -------- */
-    out->fade = (*p != 0);
-    checksum_add_u8(&sum, *p);
-    p += 1;
+    const uint8_t* p = payload;
 
     /* -------- OF GRB (only enabled) -------- */
     for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
         if(!ch_info_snapshot.i2c_leds[ch])
             continue;
 
-        uint8_t g = p[0];
-        uint8_t r = p[1];
-        uint8_t b = p[2];
-
-        checksum_add_u8(&sum, g);
-        checksum_add_u8(&sum, r);
-        checksum_add_u8(&sum, b);
-
-        out->data.pca9955b[ch].g = g;
-        out->data.pca9955b[ch].r = r;
-        out->data.pca9955b[ch].b = b;
+        out->data.pca9955b[ch].g = p[0];
+        out->data.pca9955b[ch].r = p[1];
+        out->data.pca9955b[ch].b = p[2];
 
         p += 3;
     }
@@ -194,42 +887,128 @@ esp_err_t frame_reader_read(table_frame_t* out) {
     for(int strip = 0; strip < LD_BOARD_WS2812B_NUM; strip++) {
         uint16_t cnt = ch_info_snapshot.rmt_strips[strip];
 
-        for(uint16_t i = 0; i < cnt; i++) {
-            uint8_t g = p[0];
-            uint8_t r = p[1];
-            uint8_t b = p[2];
-
-            checksum_add_u8(&sum, g);
-            checksum_add_u8(&sum, r);
-            checksum_add_u8(&sum, b);
+        /* grb8_t is packed g,r,b, identical to the on-disk byte order */
+        memcpy(out->data.ws2812b[strip], p, (size_t)cnt * 3);
+        p += (size_t)cnt * 3;
+    }
 
-            out->data.ws2812b[strip][i].g = g;
-            out->data.ws2812b[strip][i].r = r;
-            out->data.ws2812b[strip][i].b = b;
+    /* -------- final guard -------- */
+    if((uint32_t)(p - payload) != g_payload_size) {
+        ESP_LOGE(TAG, "frame consume mismatch used=%u size=%u", (unsigned)(p - payload), (unsigned)g_payload_size);
+        return ESP_FAIL;
+    }
 
-            p += 3;
-        }
+    g_offset += used;
+
+#if LD_CFG_PT_READER_PROFILE
+    prof_decode_us += esp_timer_get_time() - t_start;
+    prof_bytes += used;
+    if(++prof_frames == LD_CFG_PT_READER_PROFILE_WINDOW) {
+        ESP_LOGI(TAG, "read+decode (%s): %lu frames (%lu key), avg %lu us/frame, avg %lu bytes/frame, payload=%u",
+                 !g_verify ? "skip" : (g_checksum_kind == PT_CHECKSUM_CRC32 ? "crc32" : "sum"),
+                 (unsigned long)prof_frames,
+                 (unsigned long)(g_records ? prof_keys : prof_frames),
+                 (unsigned long)(prof_decode_us / prof_frames),
+                 (unsigned long)(prof_bytes / prof_frames),
+                 (unsigned)g_payload_size);
+        prof_frames = 0;
+        prof_keys = 0;
+        prof_bytes = 0;
+        prof_decode_us = 0;
     }
+#endif
 
-    /* -------- checksum (reserved, consume only) -------- */
-    uint32_t read_checksum = 0;
-    read_checksum |= (uint32_t)p[0];
-    read_checksum |= (uint32_t)p[1] << 8;
-    read_checksum |= (uint32_t)p[2] << 16;
-    read_checksum |= (uint32_t)p[3] << 24;
+    return ESP_OK;
+}
 
-    p += CHECKSUM_SIZE;
+/* ================= seek ================= */
 
-    if(read_checksum != sum){
-        ESP_LOGE(TAG, "checksum mismatch. read=%u calculate=%u", read_checksum, sum);
-        return ESP_ERR_INVALID_CRC;
+bool frame_reader_can_seek(void) {
+    return opened;
+}
+
+/* v1.6+: SYNC record at g_offset, then the keys it restates */
+static esp_err_t seek_tracks(const frame_reader_pos_t* pos) {
+    const uint8_t* rec;
+    uint32_t size;
+    esp_err_t err = read_raw_record(g_raw, &rec, &size);
+    if(err != ESP_OK)
+        return err == ESP_ERR_NOT_FOUND ? ESP_FAIL : err;
+    if(rec[0] != PT_RECORD_SYNC || size != PT_RECORD_HEADER_SIZE + PT_SYNC_SIZE + PT_CHECKSUM_SIZE) {
+        ESP_LOGE(TAG, "seek: no SYNC at %lu", (unsigned long)pos->offset);
+        return ESP_FAIL;
     }
 
-    /* -------- final guard -------- */
-    if((uint32_t)(p - raw) != g_frame_size) {
-        ESP_LOGE(TAG, "frame consume mismatch used=%u size=%u", (unsigned)(p - raw), (unsigned)g_frame_size);
+    uint32_t ts = pt_read_u32_le(rec + 1);
+    uint32_t end = g_offset + size + pt_read_u32_le(rec + PT_RECORD_HEADER_SIZE);
+    g_offset += size;
+
+    track_merge_reset();
+    g_have_key = false;
+    g_seek_ts = 0;
+    while(g_offset < end) {
+        err = read_raw_record(g_raw, &rec, &size);
+        if(err != ESP_OK)
+            return err == ESP_ERR_NOT_FOUND ? ESP_FAIL : err;
+        if(push_track_key(rec, size - PT_RECORD_HEADER_SIZE - PT_CHECKSUM_SIZE) != ESP_OK)
+            return ESP_FAIL;
+        g_offset += size;
+    }
+    if(g_offset != end) {
+        ESP_LOGE(TAG, "SYNC group ends inside the record before %lu", (unsigned long)g_offset);
         return ESP_FAIL;
     }
 
+    /* the records after the group pick up from ts */
+    track_merge_seek(ts);
+    g_seek_ts = ts;
+    g_sync_pending = true;
+    g_sync_ts = ts;
+    g_sync_offset = pos->offset;
+    g_sync_palette = pos->palette;
+    g_frame_sync = false;
+    return ESP_OK;
+}
+
+esp_err_t frame_reader_seek(const frame_reader_pos_t* pos) {
+    if(!opened) {
+        ESP_LOGE(TAG, "frame_reader not opened");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if(!pos)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err;
+    g_palette_size = 0;
+    g_palette_offset = 0;
+
+    /* v1.5: INDEXED frames after pos use the palette that was in effect there */
+    if(pos->palette) {
+        const uint8_t* rec;
+        uint32_t size;
+
+        err = src_seek(pos->palette);
+        if(err != ESP_OK)
+            return err;
+        err = read_raw_record(g_raw, &rec, &size);
+        if(err != ESP_OK)
+            return err == ESP_ERR_NOT_FOUND ? ESP_FAIL : err;
+        if(rec[0] != PT_RECORD_PALETTE) {
+            ESP_LOGE(TAG, "seek: no PALETTE at %lu", (unsigned long)pos->palette);
+            return ESP_FAIL;
+        }
+        if(load_palette(rec, size - PT_RECORD_HEADER_SIZE - PT_CHECKSUM_SIZE) != ESP_OK)
+            return ESP_FAIL;
+    }
+
+    err = src_seek(pos->offset);
+    if(err != ESP_OK)
+        return err;
+    /* v1.6+: pos is a SYNC record */
+    if(g_tracks)
+        return seek_tracks(pos);
+
+    g_have_key = false; /* pos is a KEY / INDEXED record or a fixed frame */
+    g_frame_sync = false;
     return ESP_OK;
 }
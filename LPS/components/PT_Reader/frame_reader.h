@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "esp_err.h"
 #include "ld_frame.h"
@@ -16,12 +17,28 @@ extern "C" {
  *   - global ch_info 已正確初始化
  *
  * frame.dat 格式：
- *   [uint16_t version]
+ *   [uint8 major][uint8 minor]
  *   [frame0][frame1][frame2]...
  *
- * 每個 frame layout 由 ch_info 決定
+ * 每個 frame layout 由 ch_info 決定，結尾為 4-byte checksum
+ *   v1.2: byte 加總    v1.3: CRC32（見 pt_format.h）
+ *   v1.4: typed record（KEY / DELTA），reader 會還原成完整 frame
+ *   v1.6: per-channel TRACK record，reader 合併成完整 frame（track_merge.h），
+ *         table_frame_t.fade_mask 標出要內插的 channel；其他版本 fade_mask 為全部或 0
+ *   v1.8: TRACK key 帶 easing，自訂曲線在 init 時載入 ld_ease（ld_ease_set_custom），
+ *         table_frame_t.ease 為這個 frame 到下一個 frame 的曲線；其他版本為 LD_EASE_LINEAR
+ *   v1.9: EFFECT key 放在 table_frame_t.effects（效果 channel 的 payload 為 0），
+ *         由 Player 每個 tick 計算；其他版本 effect_count 為 0
  * ============================================================ */
 
+/**
+ * @brief  可以直接開始解碼的 frame 位置（frame_reader_sync_pos / frame_reader_seek）
+ */
+typedef struct {
+    uint32_t offset;  /* fixed frame、KEY 或 INDEXED record 的 offset，v1.6+ 為 SYNC record 的 offset */
+    uint32_t palette; /* v1.5+：當時生效的 PALETTE record offset，0 表示沒有 */
+} frame_reader_pos_t;
+
 /**
  * @brief  初始化 frame reader，並開啟 frame.dat
  *
@@ -37,6 +54,18 @@ extern "C" {
  */
 esp_err_t frame_reader_init(const char* path);
 
+/**
+ * @brief  從記憶體（flash mmap 或 RAM）讀取 frame.dat，不經過 FatFs
+ *
+ * data 須在 frame_reader_deinit() 之前保持有效；KEY record 直接引用 data（zero-copy）
+ *
+ * @param  data   frame.dat 完整內容（含 version header）
+ * @param  size   data 長度
+ *
+ * @return 同 frame_reader_init()，data 為 NULL 或過短時回傳 ESP_ERR_INVALID_ARG
+ */
+esp_err_t frame_reader_init_mem(const uint8_t* data, uint32_t size);
+
 /**
  * @brief  關閉 frame.dat 並釋放 reader 狀態
  *
@@ -45,12 +74,26 @@ esp_err_t frame_reader_init(const char* path);
 void frame_reader_deinit(void);
 
 /**
- * @brief  回傳目前 frame 的 byte size
+ * @brief  開關每個 frame 的 checksum 檢查（預設開啟）
+ *
+ * show 已由 show_verify 驗證過時可關閉，減少播放時的運算
+ */
+void frame_reader_set_verify(bool enable);
+
+/**
+ * @brief  回傳目前 frame 的 byte size（v1.4+ 為一個 KEY record 的大小）
  *
  * @return frame size（bytes），若尚未 init 則為 0
  */
 uint32_t frame_reader_frame_size(void);
 
+/**
+ * @brief  回傳下一個 record 在 frame.dat 中的 offset
+ *
+ * 只計入成功讀取的 frame；讀到 EOF 後等於最後一個完整 frame 的結尾
+ */
+uint32_t frame_reader_tell(void);
+
 /**
  * @brief  讀取下一個 frame
  *
@@ -62,11 +105,43 @@ uint32_t frame_reader_frame_size(void);
  *   - ESP_ERR_INVALID_ARG   out 為 NULL
  *   - ESP_ERR_NOT_FOUND     EOF 或無法再讀
  *   - ESP_ERR_INVALID_CRC   checksum mismatch（檔案指標已回復）
+ *   - ESP_FAIL              record 格式錯誤（v1.4+）
  */
 esp_err_t frame_reader_read(table_frame_t* out);
 
 esp_err_t frame_reader_reset(void);
 
+/**
+ * @brief  剛讀到的 frame 是否為 sync point（不依賴前面的 record 即可解碼）
+ *
+ * v1.2 / v1.3 每個 frame 都是，v1.4 / v1.5 為 KEY 與 INDEXED，DELTA 不是；
+ * v1.6+ 為 SYNC record 指定時間的 frame（沒有 SYNC 的 track show 沒有 sync point）
+ *
+ * @param[out] pos  是 sync point 時填入它的位置，之後可交給 frame_reader_seek()
+ *
+ * @return true 表示 pos 有效；reset / seek 後、讀到第一個 frame 之前為 false
+ */
+bool frame_reader_sync_pos(frame_reader_pos_t* pos);
+
+/**
+ * @brief  跳到 frame_reader_sync_pos() 記下的位置，下一次 frame_reader_read() 讀到那個 frame
+ *
+ * v1.5+ 會先重新載入 pos 當時的 PALETTE；v1.6+ 讀入 SYNC 重述的 key，
+ * 之後丟掉 SYNC 時間之前合併出的 frame
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_INVALID_STATE 尚未 init
+ *   - ESP_ERR_INVALID_ARG   pos 為 NULL 或超出記憶體來源
+ *   - ESP_FAIL              I/O 錯誤或 pos 不是 sync point
+ */
+esp_err_t frame_reader_seek(const frame_reader_pos_t* pos);
+
+/**
+ * @brief  frame_reader_seek() 是否可用（已 init；沒有 sync point 的 show 只能 frame_reader_reset()）
+ */
+bool frame_reader_can_seek(void);
+
 #ifdef __cplusplus
 }
 #endif
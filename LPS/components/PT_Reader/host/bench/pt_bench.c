@@ -0,0 +1,765 @@
+/* PT_Reader throughput / latency benchmark on the host build.
+ *
+ * Generates v1.3 shows for a range of frame sizes (or takes an existing
+ * control.dat / frame.dat, or a pt_tool corpus) and reads every frame through either
+ * frame_reader (reader mode) or the full frame system with its prefetch
+ * task (system mode), reporting frames/s, bytes/s and per-frame latency
+ * percentiles. The digest column is a CRC32 over all decoded frames, so
+ * reader changes can be checked for identical output. The compiled cache
+ * source is checked against frame.dat converted the way show_compile does.
+ * Control mode times control.dat parsing per format revision and checks that
+ * every revision decodes to the same channel info and timestamp profile.
+ * Seek mode plays the show once through the frame system, then frame_seek()s
+ * back and forth and checks every seek lands on the right frame.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "control_reader.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "frame_reader.h"
+#include "ld_board.h"
+#include "ld_ease.h"
+#include "ld_gamma_lut.h"
+#include "pt_format.h"
+#include "pt_host.h"
+#include "readframe.h"
+#include "sd_latency.h"
+#include "show_compile.h"
+
+#define PATH_LEN 512
+#define FRAME_INTERVAL_MS 25 /* 40 fps */
+#define SHOW_PARTITION_SIZE 0xF0000
+#define CONTROL_REPEATS 20 /* parses per revision in control mode */
+#define SEEK_PROBES 64     /* frame_seek() calls per show in seek mode */
+
+typedef struct {
+    const char* name;
+    int of_count;     /* enabled PCA9955B channels */
+    int strips;       /* enabled WS2812B strips */
+    int strip_pixels; /* pixels per strip */
+} profile_t;
+
+static const profile_t PROFILES[] = {
+    {"of40", 40, 0, 0},
+    {"s2x50", 40, 2, 50},
+    {"s8x50", 40, 8, 50},
+    {"s8x100", 40, 8, 100},
+};
+
+typedef enum { MODE_READER, MODE_SYSTEM, MODE_CONTROL, MODE_SEEK } bench_mode_t;
+typedef enum { SRC_SD, SRC_MEM, SRC_FLASH, SRC_RAM, SRC_COMPILED } bench_src_t;
+
+typedef struct {
+    const char* dir;
+    const char* control;
+    const char* frame;
+    uint32_t frames;
+    bench_mode_t mode;
+    bench_src_t src;
+    uint32_t fps;
+    bool verify;
+    bool histogram;
+    pt_host_latency_t latency;
+} bench_opts_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t file_bytes;
+    int64_t init_us;
+    int64_t total_us;
+    uint32_t digest;
+    esp_err_t err;
+    uint32_t* lat_us; /* per frame */
+} bench_result_t;
+
+static table_frame_t frame;
+
+/* ================= show generator ================= */
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static int write_file(const char* path, const uint8_t* data, size_t len) {
+    FILE* f = fopen(path, "wb");
+    if(!f) {
+        fprintf(stderr, "cannot create %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    size_t n = fwrite(data, 1, len, f);
+    fclose(f);
+    return n == len ? 0 : -1;
+}
+
+/* v1.7 timestamp delta, unsigned LEB128; returns bytes written */
+static uint32_t put_varint(uint8_t* p, uint32_t v) {
+    uint32_t n = 0;
+    while(v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/* control.dat of revision minor, one frame every FRAME_INTERVAL_MS */
+static int generate_control(const char* path, const profile_t* p, uint32_t frames, uint8_t minor) {
+    size_t ctl_len = PT_VERSION_HEADER_SIZE + LD_BOARD_PCA9955B_CH_NUM + LD_BOARD_WS2812B_NUM + 4 + 4 + (size_t)frames * PT_VARINT_MAX_SIZE + PT_CHECKSUM_SIZE;
+    uint8_t* ctl = (uint8_t*)calloc(1, ctl_len);
+    if(!ctl)
+        return -1;
+
+    uint8_t* c = ctl;
+    *c++ = PT_VERSION_MAJOR;
+    *c++ = minor;
+    for(int i = 0; i < LD_BOARD_PCA9955B_CH_NUM; i++)
+        *c++ = (i < p->of_count) ? 1 : 0;
+    for(int i = 0; i < LD_BOARD_WS2812B_NUM; i++)
+        *c++ = (i < p->strips) ? (uint8_t)p->strip_pixels : 0;
+    put_u32(c, frames);
+    c += 4;
+    if(pt_version_has_varint_times(minor)) {
+        uint8_t* len = c;
+        c += 4;
+        for(uint32_t i = 0; i < frames; i++)
+            c += put_varint(c, i ? FRAME_INTERVAL_MS : 0);
+        put_u32(len, (uint32_t)(c - len - 4));
+    } else {
+        for(uint32_t i = 0; i < frames; i++, c += 4)
+            put_u32(c, i * FRAME_INTERVAL_MS);
+    }
+    put_u32(c, pt_checksum_update(pt_checksum_kind(minor), 0, ctl, (size_t)(c - ctl)));
+    c += PT_CHECKSUM_SIZE;
+
+    int rc = write_file(path, ctl, (size_t)(c - ctl));
+    free(ctl);
+    return rc;
+}
+
+/* v1.3 control.dat + frame.dat with a moving gradient so every frame differs */
+static int generate_show(const char* dir, const profile_t* p, uint32_t frames) {
+    char path[PATH_LEN];
+    uint32_t payload = (uint32_t)(p->of_count + p->strips * p->strip_pixels) * 3;
+    uint32_t record = 4 + 1 + payload + PT_CHECKSUM_SIZE;
+
+    /* control.dat */
+    int rc = -1;
+    if(snprintf(path, sizeof(path), "%s/control.dat", dir) < (int)sizeof(path))
+        rc = generate_control(path, p, frames, PT_VERSION_MINOR_CRC32);
+    if(rc)
+        return rc;
+
+    /* frame.dat */
+    size_t frame_len = PT_VERSION_HEADER_SIZE + (size_t)frames * record;
+    uint8_t* data = (uint8_t*)malloc(frame_len);
+    if(!data)
+        return -1;
+
+    data[0] = PT_VERSION_MAJOR;
+    data[1] = PT_VERSION_MINOR_CRC32;
+    uint8_t* r = data + PT_VERSION_HEADER_SIZE;
+    for(uint32_t i = 0; i < frames; i++, r += record) {
+        put_u32(r, i * FRAME_INTERVAL_MS);
+        r[4] = (uint8_t)(i & 1);
+        for(uint32_t k = 0; k < payload; k++)
+            r[5 + k] = (uint8_t)(k * 7 + i * 3);
+        put_u32(r + 5 + payload, esp_rom_crc32_le(0, r, 5 + payload));
+    }
+
+    rc = -1;
+    if(snprintf(path, sizeof(path), "%s/frame.dat", dir) < (int)sizeof(path))
+        rc = write_file(path, data, frame_len);
+    free(data);
+    return rc;
+}
+
+/* ================= measurement ================= */
+
+static uint32_t hash_frame(uint32_t h, const table_frame_t* f) {
+    uint8_t head[17];
+    memcpy(head, &f->timestamp, 8);
+    head[8] = f->fade ? (uint8_t)(1 | f->ease << 1) : 0; /* fade byte as v1.8 stores it, so linear shows keep their digest */
+    memcpy(head + 9, &f->fade_mask, 8);
+    h = esp_rom_crc32_le(h, head, sizeof(head));
+
+    /* v1.9 effects: [mask][start_ms] then the EFFECT body fields; nothing for older shows */
+    for(uint8_t i = 0; i < f->effect_count; i++) {
+        const ld_frame_effect_t* e = &f->effects[i];
+        uint8_t fx[12 + PT_EFFECT_SIZE] = {e->fx.type, e->fx.param, e->fx.spread};
+        memcpy(fx + 3, &e->fx.period_ms, 2);
+        memcpy(fx + 5, &e->fx.phase, 2);
+        memcpy(fx + 7, &e->fx.a, 3);
+        memcpy(fx + 10, &e->fx.b, 3);
+        memcpy(fx + PT_EFFECT_SIZE, &e->mask, 8);
+        memcpy(fx + PT_EFFECT_SIZE + 8, &e->start_ms, 4);
+        h = esp_rom_crc32_le(h, fx, sizeof(fx));
+    }
+    return esp_rom_crc32_le(h, (const uint8_t*)&f->data, sizeof(f->data));
+}
+
+static void pace(int64_t start_us, uint32_t index, uint32_t fps) {
+    if(!fps)
+        return;
+    int64_t due = start_us + (int64_t)index * 1000000 / fps;
+    int64_t now = esp_timer_get_time();
+    if(due > now) {
+        struct timespec ts = {.tv_sec = (due - now) / 1000000, .tv_nsec = (long)((due - now) % 1000000) * 1000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+static uint8_t* load_file(const char* path, uint32_t* size) {
+    FILE* f = fopen(path, "rb");
+    if(!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    rewind(f);
+
+    uint8_t* data = (uint8_t*)malloc(n > 0 ? (size_t)n : 1);
+    if(data && fread(data, 1, (size_t)n, f) != (size_t)n) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = (uint32_t)n;
+    return data;
+}
+
+/* frame_reader only: the cost of f_read + checksum + decode per frame */
+static void run_reader(const bench_opts_t* o, const char* control, const char* frame_path, const char* host_frame, bench_result_t* res) {
+    uint8_t* mem = NULL;
+    int64_t t0 = esp_timer_get_time();
+
+    res->err = get_channel_info(control, &ch_info_snapshot);
+    if(res->err != ESP_OK)
+        return;
+
+    if(o->src == SRC_MEM) {
+        uint32_t size;
+        mem = load_file(host_frame, &size);
+        res->err = mem ? frame_reader_init_mem(mem, size) : ESP_ERR_NOT_FOUND;
+    } else {
+        res->err = frame_reader_init(frame_path);
+    }
+    if(res->err != ESP_OK) {
+        free(mem);
+        return;
+    }
+    frame_reader_set_verify(o->verify);
+    res->init_us = esp_timer_get_time() - t0;
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t err;
+    for(;;) {
+        int64_t f0 = esp_timer_get_time();
+        err = frame_reader_read(&frame);
+        if(err != ESP_OK)
+            break;
+        res->lat_us[res->frames] = (uint32_t)(esp_timer_get_time() - f0);
+        res->digest = hash_frame(res->digest, &frame);
+        res->frames++;
+    }
+    res->total_us = esp_timer_get_time() - start;
+    res->err = (err == ESP_ERR_NOT_FOUND) ? ESP_OK : err;
+
+    frame_reader_deinit();
+    free(mem);
+}
+
+/* what the compiled cache must deliver: frame.dat through frame_reader, step frames converted like show_compile_run().
+ * plain is the ordinary digest of the same frames, for the corpus check. */
+static esp_err_t compiled_reference(const char* control, const char* frame_path, uint32_t* plain, uint32_t* output) {
+    esp_err_t err = get_channel_info(control, &ch_info_snapshot);
+    if(err == ESP_OK)
+        err = frame_reader_init(frame_path);
+    if(err != ESP_OK)
+        return err;
+
+    uint64_t prev_mask = 0;
+    bool effects = false;
+    *plain = *output = 0;
+    while((err = frame_reader_read(&frame)) == ESP_OK) {
+        *plain = hash_frame(*plain, &frame);
+        effects |= frame.effect_count != 0;
+        if(frame.fade_mask == 0 && prev_mask == 0)
+            show_compile_wire(&frame.data, &frame.wire);
+        prev_mask = frame.fade_mask;
+        *output = hash_frame(*output, &frame);
+    }
+    frame_reader_deinit();
+    /* v1.9 effect shows are not compiled, they play from frame.dat */
+    if(effects)
+        *output = *plain;
+    return err == ESP_ERR_NOT_FOUND ? ESP_OK : err;
+}
+
+/* frame_system_init, plus the cache build the Player asks for with `compile` */
+static esp_err_t open_system(const bench_opts_t* o, const char* control, const char* frame_path) {
+    esp_err_t err = frame_system_init(control, frame_path);
+    if(err == ESP_OK && o->src == SRC_COMPILED) {
+        err = frame_system_compile();
+        if(err == ESP_ERR_NOT_SUPPORTED)
+            err = ESP_OK; /* effect shows keep streaming frame.dat */
+        if(err != ESP_OK)
+            frame_system_deinit();
+    }
+    return err;
+}
+
+/* frame_system_init + read_frame: what the Player sees, prefetch task included */
+static void run_system(const bench_opts_t* o, const char* control, const char* frame_path, bench_result_t* res) {
+    pt_host_set_free_heap(o->src == SRC_RAM ? (size_t)4 * 1024 * 1024 : 0);
+    pt_host_set_partition(o->src == SRC_FLASH ? SHOW_PARTITION_SIZE : 0);
+    show_compile_set_enabled(o->src == SRC_COMPILED);
+
+    int64_t t0 = esp_timer_get_time();
+    res->err = open_system(o, control, frame_path);
+    if(res->err != ESP_OK)
+        return;
+    res->init_us = esp_timer_get_time() - t0;
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t err;
+    for(;;) {
+        pace(start, res->frames, o->fps);
+        int64_t f0 = esp_timer_get_time();
+        err = read_frame(&frame);
+        if(err != ESP_OK)
+            break;
+        res->lat_us[res->frames] = (uint32_t)(esp_timer_get_time() - f0);
+        res->digest = hash_frame(res->digest, &frame);
+        res->frames++;
+    }
+    res->total_us = esp_timer_get_time() - start;
+    res->err = (err == ESP_ERR_NOT_FOUND) ? ESP_OK : err;
+
+    frame_system_deinit();
+    pt_host_set_partition(0);
+}
+
+/* one sequential pass (notes the seek marks), then SEEK_PROBES seeks in a scattered order;
+ * each seek must deliver the last frame at or before its target and then the one after it.
+ * lat_us holds the time from frame_seek() to its first frame. */
+static void run_seek(const bench_opts_t* o, const char* control, const char* frame_path, bench_result_t* res) {
+    pt_host_set_free_heap(o->src == SRC_RAM ? (size_t)4 * 1024 * 1024 : 0);
+    pt_host_set_partition(o->src == SRC_FLASH ? SHOW_PARTITION_SIZE : 0);
+    show_compile_set_enabled(o->src == SRC_COMPILED);
+
+    uint32_t* ts = NULL;
+    uint32_t* hash = NULL;
+    uint32_t count = 0, cap = 0;
+
+    int64_t t0 = esp_timer_get_time();
+    res->err = open_system(o, control, frame_path);
+    if(res->err != ESP_OK)
+        return;
+    res->init_us = esp_timer_get_time() - t0;
+
+    esp_err_t err;
+    while((err = read_frame(&frame)) == ESP_OK) {
+        if(count == cap) {
+            cap = cap ? cap * 2 : 1024;
+            ts = (uint32_t*)realloc(ts, cap * sizeof(uint32_t));
+            hash = (uint32_t*)realloc(hash, cap * sizeof(uint32_t));
+            if(!ts || !hash) {
+                err = ESP_ERR_NO_MEM;
+                break;
+            }
+        }
+        ts[count] = (uint32_t)frame.timestamp;
+        hash[count] = hash_frame(0, &frame);
+        count++;
+    }
+    if(err != ESP_ERR_NOT_FOUND || count == 0) {
+        res->err = (err == ESP_ERR_NOT_FOUND) ? ESP_ERR_INVALID_SIZE : err;
+        goto done;
+    }
+
+    int64_t start = esp_timer_get_time();
+    const uint32_t last_ms = ts[count - 1];
+    for(uint32_t k = 0; k < SEEK_PROBES; k++) {
+        /* scattered targets, including before the first frame and past the last */
+        uint32_t target = (uint32_t)(((uint64_t)(k * 37 % SEEK_PROBES) * (last_ms + 2 * FRAME_INTERVAL_MS)) / (SEEK_PROBES - 1));
+        target = target > FRAME_INTERVAL_MS ? target - FRAME_INTERVAL_MS + k % 3 : k % 3;
+
+        uint32_t i = 0;
+        while(i + 1 < count && ts[i + 1] <= target)
+            i++;
+
+        int64_t f0 = esp_timer_get_time();
+        err = frame_seek(target);
+        if(err == ESP_OK)
+            err = read_frame(&frame);
+        res->lat_us[res->frames] = (uint32_t)(esp_timer_get_time() - f0);
+        if(err != ESP_OK || hash_frame(0, &frame) != hash[i]) {
+            printf("seek %u ms: expected frame %u (%u ms), got %s %u ms\n", (unsigned)target, (unsigned)i, (unsigned)ts[i], esp_err_to_name(err), (unsigned)frame.timestamp);
+            res->err = ESP_FAIL;
+            goto done;
+        }
+        res->digest = hash_frame(res->digest, &frame);
+
+        err = read_frame(&frame);
+        if(i + 1 < count ? (err != ESP_OK || hash_frame(0, &frame) != hash[i + 1]) : err != ESP_ERR_NOT_FOUND) {
+            printf("seek %u ms: frame after %u is wrong (%s)\n", (unsigned)target, (unsigned)i, esp_err_to_name(err));
+            res->err = ESP_FAIL;
+            goto done;
+        }
+        res->frames++;
+    }
+    res->total_us = esp_timer_get_time() - start;
+
+done:
+    free(ts);
+    free(hash);
+    frame_system_deinit();
+    pt_host_set_partition(0);
+}
+
+static int cmp_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const uint32_t* sorted, uint32_t n, double p) {
+    if(n == 0)
+        return 0;
+    uint32_t i = (uint32_t)(p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+static void print_header(void) {
+    printf("%-20s %7s %7s %8s %10s %8s %7s %7s %8s %8s %7s %8s\n", "profile", "frame_B", "frames", "init_ms", "frames/s", "MB/s", "p50_us", "p99_us", "p99.9_us", "max_us", "f_read", "digest");
+}
+
+/* expect: digest listed in the corpus manifest, NULL when there is none */
+static int bench_one(const bench_opts_t* o, const char* name, const char* rel_dir, const uint32_t* expect) {
+    char control[PATH_LEN], frame_path[PATH_LEN], host_frame[PATH_LEN];
+    snprintf(control, sizeof(control), "0:/%s/control.dat", rel_dir);
+    snprintf(frame_path, sizeof(frame_path), "0:/%s/frame.dat", rel_dir);
+    snprintf(host_frame, sizeof(host_frame), "%s/%s/frame.dat", o->dir, rel_dir);
+
+    uint32_t size = 0;
+    struct stat st;
+    if(stat(host_frame, &st) == 0)
+        size = (uint32_t)st.st_size;
+
+    bench_result_t res = {0};
+    res.file_bytes = size;
+    res.lat_us = (uint32_t*)malloc(sizeof(uint32_t) * (size / (PT_RECORD_HEADER_SIZE + PT_CHECKSUM_SIZE) + 1 + SEEK_PROBES));
+    if(!res.lat_us)
+        return -1;
+
+    /* compiled frames carry output bytes, so compare with frame.dat converted the same way */
+    uint32_t plain = 0, output = 0;
+    if(o->mode == MODE_SYSTEM && o->src == SRC_COMPILED) {
+        res.err = compiled_reference(control, frame_path, &plain, &output);
+        if(res.err != ESP_OK) {
+            printf("%-20s reference decode failed: %s\n", name, esp_err_to_name(res.err));
+            free(res.lat_us);
+            return -1;
+        }
+    }
+
+    pt_host_set_latency(&o->latency);
+    pt_host_reset_stats();
+    sd_latency_reset();
+
+    if(o->mode == MODE_READER)
+        run_reader(o, control, frame_path, host_frame, &res);
+    else if(o->mode == MODE_SEEK)
+        run_seek(o, control, frame_path, &res);
+    else
+        run_system(o, control, frame_path, &res);
+
+    pt_host_stats_t stats;
+    pt_host_get_stats(&stats);
+    pt_host_set_latency(NULL);
+
+    if(res.err != ESP_OK) {
+        printf("%-20s failed after %u frames: %s\n", name, (unsigned)res.frames, esp_err_to_name(res.err));
+        free(res.lat_us);
+        return -1;
+    }
+
+    qsort(res.lat_us, res.frames, sizeof(uint32_t), cmp_u32);
+    double secs = res.total_us > 0 ? res.total_us / 1e6 : 1e-6;
+    uint32_t frame_b = (res.frames && o->mode != MODE_SEEK) ? (size - PT_VERSION_HEADER_SIZE) / res.frames : 0;
+
+    printf("%-20s %7u %7u %8.1f %10.0f %8.2f %7u %7u %8u %8u %7u %08x\n", name, (unsigned)frame_b, (unsigned)res.frames, res.init_us / 1000.0, res.frames / secs, (size - PT_VERSION_HEADER_SIZE) / secs / 1e6, (unsigned)percentile(res.lat_us, res.frames, 0.50),
+           (unsigned)percentile(res.lat_us, res.frames, 0.99), (unsigned)percentile(res.lat_us, res.frames, 0.999), (unsigned)(res.frames ? res.lat_us[res.frames - 1] : 0), (unsigned)stats.reads, (unsigned)res.digest);
+
+    free(res.lat_us);
+    if(o->histogram)
+        sd_latency_print();
+    if(o->mode == MODE_SYSTEM && o->src == SRC_COMPILED) {
+        if(output != res.digest) {
+            printf("%-20s digest mismatch, frame.dat compiled on the host gives %08x\n", name, (unsigned)output);
+            return -1;
+        }
+        if(expect && *expect != plain) {
+            printf("%-20s digest mismatch, corpus.txt says %08x, frame.dat gives %08x\n", name, (unsigned)*expect, (unsigned)plain);
+            return -1;
+        }
+        return 0;
+    }
+    if(expect && o->mode != MODE_SEEK && *expect != res.digest) {
+        printf("%-20s digest mismatch, corpus.txt says %08x\n", name, (unsigned)*expect);
+        return -1;
+    }
+    return 0;
+}
+
+/* every show listed in DIR/corpus.txt (pt_tool corpus): "name version layout pattern frames bytes digest" */
+static int bench_corpus(const bench_opts_t* o) {
+    char path[PATH_LEN], line[256], name[128];
+    unsigned digest;
+    if(snprintf(path, sizeof(path), "%s/corpus.txt", o->dir) >= (int)sizeof(path))
+        return -1;
+
+    FILE* f = fopen(path, "r");
+    if(!f) {
+        fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int failed = 0, shows = 0;
+    while(fgets(line, sizeof(line), f)) {
+        if(line[0] == '#' || sscanf(line, "%127s %*s %*s %*s %*s %*s %x", name, &digest) != 2)
+            continue;
+        uint32_t expect = digest;
+        failed |= bench_one(o, name, name, &expect);
+        shows++;
+    }
+    fclose(f);
+    return (failed || shows == 0) ? -1 : 0;
+}
+
+/* ================= control.dat parsing ================= */
+
+/* the same timestamps as v1.2 / v1.3 / v1.7 control.dat: parse time, and every revision must give the same profile */
+static int bench_control(const bench_opts_t* o) {
+    static const uint8_t minors[] = {PT_VERSION_MINOR_MIN, PT_VERSION_MINOR_CRC32, PT_VERSION_MINOR_VARINT_TIMES};
+    const profile_t* layout = &PROFILES[sizeof(PROFILES) / sizeof(PROFILES[0]) - 1];
+    char dir[PATH_LEN];
+    snprintf(dir, sizeof(dir), "%s/control", o->dir);
+    mkdir(dir, 0755);
+
+    printf("%-8s %10s %7s %10s %10s %9s  %s\n", "version", "bytes", "f_read", "min_us", "p50_us", "ns/frame", "profile");
+
+    ch_info_t ref_info = {0};
+    show_profile_t ref = {0};
+    int failed = 0;
+    for(size_t v = 0; v < sizeof(minors); v++) {
+        char host_path[PATH_LEN], path[PATH_LEN];
+        snprintf(path, sizeof(path), "0:/control/v1%u.dat", minors[v]);
+        if(snprintf(host_path, sizeof(host_path), "%s/v1%u.dat", dir, minors[v]) >= (int)sizeof(host_path) || generate_control(host_path, layout, o->frames, minors[v]) != 0) {
+            fprintf(stderr, "cannot generate %s\n", host_path);
+            return -1;
+        }
+        struct stat st;
+        uint32_t size = stat(host_path, &st) == 0 ? (uint32_t)st.st_size : 0;
+
+        uint32_t us[CONTROL_REPEATS];
+        ch_info_t info;
+        show_profile_t prof;
+        pt_host_stats_t stats;
+        pt_host_set_latency(&o->latency);
+        for(int r = 0; r < CONTROL_REPEATS; r++) {
+            pt_host_reset_stats();
+            int64_t t0 = esp_timer_get_time();
+            esp_err_t err = get_channel_info_profile(path, &info, &prof);
+            us[r] = (uint32_t)(esp_timer_get_time() - t0);
+            if(err != ESP_OK) {
+                pt_host_set_latency(NULL);
+                printf("v1.%-6u parse failed: %s\n", minors[v], esp_err_to_name(err));
+                return -1;
+            }
+        }
+        pt_host_get_stats(&stats);
+        pt_host_set_latency(NULL);
+
+        qsort(us, CONTROL_REPEATS, sizeof(uint32_t), cmp_u32);
+        printf("v1.%-6u %10u %7u %10u %10u %9.1f  %u frames, last %u ms, min %u ms, grid %u ms, burst %u\n", minors[v], (unsigned)size, (unsigned)stats.reads, (unsigned)us[0], (unsigned)percentile(us, CONTROL_REPEATS, 0.50),
+               o->frames ? us[0] * 1000.0 / o->frames : 0.0, (unsigned)prof.frames, (unsigned)prof.last_ms, (unsigned)prof.min_interval_ms, (unsigned)prof.grid_ms, (unsigned)prof.burst_frames);
+
+        /* round trip: the first revision is the reference */
+        if(v == 0) {
+            ref_info = info;
+            ref = prof;
+            if(prof.frames != o->frames || (o->frames && prof.last_ms != (o->frames - 1) * FRAME_INTERVAL_MS)) {
+                printf("v1.%-6u timestamps differ from the generated show\n", minors[v]);
+                failed = 1;
+            }
+        } else if(memcmp(&info, &ref_info, sizeof(info)) != 0 || prof.frames != ref.frames || prof.last_ms != ref.last_ms || prof.min_interval_ms != ref.min_interval_ms || prof.grid_ms != ref.grid_ms ||
+                  prof.burst_frames != ref.burst_frames) {
+            printf("v1.%-6u decodes differently from v1.%u\n", minors[v], minors[0]);
+            failed = 1;
+        }
+    }
+    return failed ? -1 : 0;
+}
+
+/* ================= CLI ================= */
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -d DIR     work directory, generated shows go to DIR/<profile>/ (default pt_bench_data)\n"
+            "  -i SUBDIR  benchmark DIR/SUBDIR/control.dat + frame.dat instead of generated shows\n"
+            "  -c         benchmark every show in DIR/corpus.txt (pt_tool corpus) and check its digest\n"
+            "  -n N       frames per generated show (default 2000)\n"
+            "  -m MODE    reader | system | control | seek (default reader)\n"
+            "             control: parse the same timestamps as v1.2 / v1.3 / v1.7 control.dat\n"
+            "             seek: frame_seek() after one pass, latency columns are per seek\n"
+            "  -s SRC     reader: sd | mem, system / seek: sd | flash | ram | compiled (default sd)\n"
+            "  -V         keep per-frame checksum checks (reader mode)\n"
+            "  -H         print the reader's SD f_read latency histogram (sd_latency.h) after each show\n"
+            "  -r FPS     pace read_frame() calls at FPS (system mode, default unpaced)\n"
+            "  -L US      injected latency per f_read / f_lseek\n"
+            "  -K US      injected latency per KiB read\n"
+            "  -S US      latency spike added to every -E'th f_read\n"
+            "  -E N       spike period in f_read calls\n"
+            "  -v         log PT_Reader info messages\n",
+            argv0);
+}
+
+static bool parse_src(const char* s, bench_src_t* out) {
+    static const char* names[] = {"sd", "mem", "flash", "ram", "compiled"};
+    for(int i = 0; i < 5; i++) {
+        if(strcmp(s, names[i]) == 0) {
+            *out = (bench_src_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    bench_opts_t o = {
+        .dir = "pt_bench_data",
+        .frames = 2000,
+        .mode = MODE_READER,
+        .src = SRC_SD,
+    };
+    const char* input = NULL;
+    bool corpus = false;
+    esp_log_level_t level = ESP_LOG_WARN;
+
+    int opt;
+    while((opt = getopt(argc, argv, "d:i:cn:m:s:VHr:L:K:S:E:vh")) != -1) {
+        switch(opt) {
+            case 'd':
+                o.dir = optarg;
+                break;
+            case 'i':
+                input = optarg;
+                break;
+            case 'c':
+                corpus = true;
+                break;
+            case 'n':
+                o.frames = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'm':
+                if(strcmp(optarg, "reader") == 0)
+                    o.mode = MODE_READER;
+                else if(strcmp(optarg, "system") == 0)
+                    o.mode = MODE_SYSTEM;
+                else if(strcmp(optarg, "control") == 0)
+                    o.mode = MODE_CONTROL;
+                else if(strcmp(optarg, "seek") == 0)
+                    o.mode = MODE_SEEK;
+                else {
+                    usage(argv[0]);
+                    return 2;
+                }
+                break;
+            case 's':
+                if(!parse_src(optarg, &o.src)) {
+                    usage(argv[0]);
+                    return 2;
+                }
+                break;
+            case 'V':
+                o.verify = true;
+                break;
+            case 'H':
+                o.histogram = true;
+                break;
+            case 'r':
+                o.fps = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'L':
+                o.latency.base_us = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'K':
+                o.latency.per_kb_us = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'S':
+                o.latency.spike_us = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'E':
+                o.latency.spike_every = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'v':
+                level = ESP_LOG_INFO;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    bool reader_src = (o.src == SRC_SD || o.src == SRC_MEM);
+    bool system_src = (o.src != SRC_MEM);
+    if(o.mode != MODE_CONTROL && (o.mode == MODE_READER ? !reader_src : !system_src)) {
+        fprintf(stderr, "source not available in %s mode\n", o.mode == MODE_READER ? "reader" : (o.mode == MODE_SEEK ? "seek" : "system"));
+        return 2;
+    }
+
+    esp_log_level_set("*", level);
+    calc_gamma_lut();
+    calc_ease_lut();
+    pt_host_set_root(o.dir);
+    mkdir(o.dir, 0755);
+
+    if(o.mode == MODE_CONTROL) {
+        printf("mode=control frames=%u latency: base=%uus per_kb=%uus\n", (unsigned)o.frames, (unsigned)o.latency.base_us, (unsigned)o.latency.per_kb_us);
+        return bench_control(&o) ? 1 : 0;
+    }
+
+    printf("mode=%s latency: base=%uus per_kb=%uus spike=%uus/%u reads%s\n", o.mode == MODE_READER ? "reader" : (o.mode == MODE_SEEK ? "seek" : "system"), (unsigned)o.latency.base_us, (unsigned)o.latency.per_kb_us, (unsigned)o.latency.spike_us, (unsigned)o.latency.spike_every, o.verify ? " verify" : "");
+    print_header();
+
+    if(input)
+        return bench_one(&o, input, input, NULL) ? 1 : 0;
+    if(corpus)
+        return bench_corpus(&o) ? 1 : 0;
+
+    int failed = 0;
+    for(size_t i = 0; i < sizeof(PROFILES) / sizeof(PROFILES[0]); i++) {
+        char dir[PATH_LEN];
+        snprintf(dir, sizeof(dir), "%s/%s", o.dir, PROFILES[i].name);
+        mkdir(dir, 0755);
+
+        if(generate_show(dir, &PROFILES[i], o.frames) != 0) {
+            fprintf(stderr, "cannot generate %s\n", PROFILES[i].name);
+            return 1;
+        }
+        failed |= bench_one(&o, PROFILES[i].name, PROFILES[i].name, NULL);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+/* Host stand-in for ESP-IDF driver/sdmmc_host.h (config structs only, nothing is driven). */
+
+#include "driver/gpio.h"
+
+typedef struct {
+    int flags;
+    int max_freq_khz;
+} sdmmc_host_t;
+
+typedef struct {
+    int width;
+    gpio_num_t gpio_cd;
+    gpio_num_t gpio_wp;
+    int flags;
+} sdmmc_slot_config_t;
+
+#define SDMMC_HOST_FLAG_4BIT (1 << 1)
+#define SDMMC_FREQ_HIGHSPEED 40000
+#define SDMMC_SLOT_FLAG_INTERNAL_PULLUP (1 << 0)
+
+#define SDMMC_HOST_DEFAULT() {.flags = SDMMC_HOST_FLAG_4BIT, .max_freq_khz = 20000}
+#define SDMMC_SLOT_CONFIG_DEFAULT() {.width = 4, .gpio_cd = GPIO_NUM_NC, .gpio_wp = GPIO_NUM_NC, .flags = 0}
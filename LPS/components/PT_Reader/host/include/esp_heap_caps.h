@@ -0,0 +1,18 @@
+#pragma once
+
+/* Host stand-in for ESP-IDF esp_heap_caps.h; the reported heap is set with pt_host_set_free_heap(). */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MALLOC_CAP_8BIT (1 << 2)
+
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+
+/* Host stand-in for ESP-IDF esp_timer.h (only the clock). */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* microseconds since the first call, from CLOCK_MONOTONIC */
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
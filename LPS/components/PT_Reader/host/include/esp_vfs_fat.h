@@ -0,0 +1,27 @@
+#pragma once
+
+/* Host stand-in for ESP-IDF esp_vfs_fat.h: mounting is a no-op, files come from the ff.h shim. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "driver/sdmmc_host.h"
+#include "esp_err.h"
+#include "sdmmc_cmd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    bool format_if_mount_failed;
+    int max_files;
+    size_t allocation_unit_size;
+    bool disk_status_check_enable;
+    bool use_one_fat;
+} esp_vfs_fat_sdmmc_mount_config_t;
+
+esp_err_t esp_vfs_fat_sdmmc_mount(const char* base_path, const sdmmc_host_t* host_config, const void* slot_config, const esp_vfs_fat_sdmmc_mount_config_t* mount_config, sdmmc_card_t** out_card);
+
+#ifdef __cplusplus
+}
+#endif
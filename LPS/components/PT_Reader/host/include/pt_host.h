@@ -0,0 +1,58 @@
+#pragma once
+
+/* ============================================================
+ * PT_Reader host build controls
+ *
+ * Knobs for the FatFs / heap / flash stand-ins that only exist on host:
+ *
+ *   pt_host_set_root("/tmp/show");          // "0:/frame.dat" -> "/tmp/show/frame.dat"
+ *   pt_host_set_latency(&(pt_host_latency_t){.base_us = 300});
+ *   pt_host_set_free_heap(0);               // disable the RAM cache path
+ *   pt_host_set_partition(0xF0000);         // emulate the "show" partition
+ * ============================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Injected per-call latency of the FatFs shim. */
+typedef struct {
+    uint32_t base_us;     /*!< every f_read / f_lseek */
+    uint32_t per_kb_us;   /*!< f_read, per KiB transferred */
+    uint32_t spike_us;    /*!< added to every spike_every-th f_read */
+    uint32_t spike_every; /*!< 0 = no spikes */
+} pt_host_latency_t;
+
+/* FatFs shim counters since the last pt_host_reset_stats(). */
+typedef struct {
+    uint32_t opens;
+    uint32_t reads;
+    uint32_t seeks;
+    uint64_t bytes_read;
+    uint64_t injected_us;
+} pt_host_stats_t;
+
+/** Directory that stands for the "0:/" volume (default "."). */
+void pt_host_set_root(const char* dir);
+
+/** Latency model for f_read / f_lseek; NULL clears it. */
+void pt_host_set_latency(const pt_host_latency_t* latency);
+
+void pt_host_get_stats(pt_host_stats_t* out);
+void pt_host_reset_stats(void);
+
+/** Volume label returned by f_getlabel() (e.g. "LPS07"). */
+void pt_host_set_label(const char* label);
+
+/** Value reported by heap_caps_get_largest_free_block() (default 4 MiB). */
+void pt_host_set_free_heap(size_t bytes);
+
+/** Create (size > 0, erased to 0xFF) or remove (size 0) the emulated "show" partition. */
+void pt_host_set_partition(uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
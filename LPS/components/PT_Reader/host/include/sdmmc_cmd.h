@@ -0,0 +1,13 @@
+#pragma once
+
+/* Host stand-in for ESP-IDF sdmmc_cmd.h. */
+
+typedef struct {
+    char name[8];
+} sdmmc_cid_t;
+
+typedef struct {
+    int host_id;
+    sdmmc_cid_t cid;
+    int real_freq_khz;
+} sdmmc_card_t;
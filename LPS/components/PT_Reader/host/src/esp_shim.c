@@ -0,0 +1,214 @@
+/* ESP-IDF stand-ins: log, error names, clock, ROM CRC, heap query, SD mount and the "show" partition. */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "esp_vfs_fat.h"
+#include "pt_host.h"
+
+/* ================= log ================= */
+
+static esp_log_level_t log_level = ESP_LOG_INFO;
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+    if(tag && strcmp(tag, "*") == 0)
+        log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+    (void)tag;
+    if(level > log_level)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+/* ================= esp_err ================= */
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch(code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:
+            return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:
+            return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:
+            return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION:
+            return "ESP_ERR_INVALID_VERSION";
+        case ESP_ERR_INVALID_MAC:
+            return "ESP_ERR_INVALID_MAC";
+        case ESP_ERR_NOT_FINISHED:
+            return "ESP_ERR_NOT_FINISHED";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+/* ================= esp_timer ================= */
+
+int64_t esp_timer_get_time(void) {
+    static int64_t origin = 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    int64_t now = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    if(origin == 0)
+        origin = now;
+    return now - origin;
+}
+
+/* ================= ROM CRC32 (zlib polynomial, reflected) ================= */
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const* buf, uint32_t len) {
+    static uint32_t table[256];
+    if(table[1] == 0) {
+        for(uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for(int k = 0; k < 8; k++)
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            table[i] = c;
+        }
+    }
+
+    crc = ~crc;
+    for(uint32_t i = 0; i < len; i++)
+        crc = table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+/* ================= heap ================= */
+
+static size_t free_heap = 4 * 1024 * 1024;
+
+void pt_host_set_free_heap(size_t bytes) {
+    free_heap = bytes;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    (void)caps;
+    return free_heap;
+}
+
+/* ================= SD mount ================= */
+
+static sdmmc_card_t host_card = {.cid = {.name = "HOST"}};
+
+esp_err_t esp_vfs_fat_sdmmc_mount(const char* base_path, const sdmmc_host_t* host_config, const void* slot_config, const esp_vfs_fat_sdmmc_mount_config_t* mount_config, sdmmc_card_t** out_card) {
+    (void)base_path;
+    (void)host_config;
+    (void)slot_config;
+    (void)mount_config;
+    if(out_card)
+        *out_card = &host_card;
+    return ESP_OK;
+}
+
+/* ================= "show" partition in RAM ================= */
+
+#define PARTITION_SECTOR_SIZE 0x1000
+
+static esp_partition_t show_part = {
+    .type = ESP_PARTITION_TYPE_DATA,
+    .subtype = 0x40,
+    .address = 0x110000,
+    .erase_size = PARTITION_SECTOR_SIZE,
+    .label = "show",
+};
+static uint8_t* show_data = NULL;
+
+void pt_host_set_partition(uint32_t size) {
+    free(show_data);
+    show_data = NULL;
+    show_part.size = 0;
+
+    if(size == 0)
+        return;
+
+    show_data = (uint8_t*)malloc(size);
+    if(show_data) {
+        memset(show_data, 0xFF, size);
+        show_part.size = size;
+    }
+}
+
+static bool in_range(const esp_partition_t* p, size_t offset, size_t size) {
+    return p == &show_part && show_data && offset <= p->size && size <= p->size - offset;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+    if(!show_data || type != show_part.type)
+        return NULL;
+    if(subtype != show_part.subtype && subtype != 0xff)
+        return NULL;
+    if(label && strcmp(label, show_part.label) != 0)
+        return NULL;
+    return &show_part;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* p, size_t src_offset, void* dst, size_t size) {
+    if(!in_range(p, src_offset, size))
+        return ESP_ERR_INVALID_SIZE;
+    memcpy(dst, show_data + src_offset, size);
+    return ESP_OK;
+}
+
+/* NOR flash semantics: writing can only clear bits */
+esp_err_t esp_partition_write(const esp_partition_t* p, size_t dst_offset, const void* src, size_t size) {
+    if(!in_range(p, dst_offset, size))
+        return ESP_ERR_INVALID_SIZE;
+    const uint8_t* s = (const uint8_t*)src;
+    for(size_t i = 0; i < size; i++)
+        show_data[dst_offset + i] &= s[i];
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t offset, size_t size) {
+    if(!in_range(p, offset, size))
+        return ESP_ERR_INVALID_SIZE;
+    if(offset % PARTITION_SECTOR_SIZE || size % PARTITION_SECTOR_SIZE)
+        return ESP_ERR_INVALID_ARG;
+    memset(show_data + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* p, size_t offset, size_t size, esp_partition_mmap_memory_t memory, const void** out_ptr, esp_partition_mmap_handle_t* out_handle) {
+    (void)memory;
+    if(!in_range(p, offset, size))
+        return ESP_ERR_INVALID_SIZE;
+    *out_ptr = show_data + offset;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle) {
+    (void)handle;
+}
@@ -0,0 +1,253 @@
+/* FatFs stand-in: "0:/path" maps to <root>/path, with optional latency injection. */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "esp_timer.h"
+#include "ff.h"
+#include "pt_host.h"
+
+#define PATH_MAX_LEN 512
+
+static char root[PATH_MAX_LEN] = ".";
+static char label[12] = "";
+static pt_host_latency_t latency;
+static pt_host_stats_t stats;
+
+/* ================= helpers ================= */
+
+static bool map_path(const TCHAR* path, char* out, size_t out_len) {
+    if(strncmp(path, "0:", 2) == 0)
+        path += 2;
+    while(*path == '/')
+        path++;
+    int n = snprintf(out, out_len, "%s/%s", root, path);
+    return n > 0 && (size_t)n < out_len;
+}
+
+static FRESULT errno_to_fr(void) {
+    switch(errno) {
+        case ENOENT:
+            return FR_NO_FILE;
+        case ENOTDIR:
+            return FR_NO_PATH;
+        case EACCES:
+        case EPERM:
+            return FR_DENIED;
+        case EEXIST:
+            return FR_EXIST;
+        default:
+            return FR_DISK_ERR;
+    }
+}
+
+/* sleep for the bulk, spin for the last stretch so short delays stay accurate */
+static void delay_us(uint32_t us) {
+    if(us == 0)
+        return;
+
+    int64_t until = esp_timer_get_time() + us;
+    if(us > 200) {
+        uint32_t sleep_us = us - 100;
+        struct timespec ts = {.tv_sec = sleep_us / 1000000, .tv_nsec = (long)(sleep_us % 1000000) * 1000};
+        nanosleep(&ts, NULL);
+    }
+    while(esp_timer_get_time() < until) {
+    }
+    stats.injected_us += us;
+}
+
+/* ================= host controls ================= */
+
+void pt_host_set_root(const char* dir) {
+    snprintf(root, sizeof(root), "%s", dir);
+}
+
+void pt_host_set_latency(const pt_host_latency_t* l) {
+    if(l)
+        latency = *l;
+    else
+        memset(&latency, 0, sizeof(latency));
+}
+
+void pt_host_get_stats(pt_host_stats_t* out) {
+    *out = stats;
+}
+
+void pt_host_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void pt_host_set_label(const char* l) {
+    snprintf(label, sizeof(label), "%s", l ? l : "");
+}
+
+/* ================= FatFs API ================= */
+
+FRESULT f_open(FIL* fp, const TCHAR* path, BYTE mode) {
+    char host[PATH_MAX_LEN];
+    if(!map_path(path, host, sizeof(host)))
+        return FR_INVALID_NAME;
+
+    const char* fmode = "rb";
+    if(mode & FA_WRITE) {
+        if((mode & FA_CREATE_ALWAYS) == FA_CREATE_ALWAYS)
+            fmode = (mode & FA_READ) ? "w+b" : "wb";
+        else if(mode & (FA_OPEN_ALWAYS | FA_CREATE_NEW))
+            fmode = "a+b";
+        else
+            fmode = "r+b";
+    }
+
+    memset(fp, 0, sizeof(*fp));
+    fp->fh = fopen(host, fmode);
+    if(!fp->fh)
+        return errno_to_fr();
+
+    struct stat st;
+    if(fstat(fileno(fp->fh), &st) == 0)
+        fp->obj.objsize = (FSIZE_t)st.st_size;
+    if((mode & FA_OPEN_APPEND) == FA_OPEN_APPEND)
+        fp->fptr = fp->obj.objsize;
+    else
+        fseek(fp->fh, 0, SEEK_SET);
+
+    stats.opens++;
+    return FR_OK;
+}
+
+FRESULT f_close(FIL* fp) {
+    if(!fp->fh)
+        return FR_INVALID_OBJECT;
+    int rc = fclose(fp->fh);
+    fp->fh = NULL;
+    return rc == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_read(FIL* fp, void* buff, UINT btr, UINT* br) {
+    if(!fp->fh)
+        return FR_INVALID_OBJECT;
+
+    stats.reads++;
+    uint32_t cost = latency.base_us + (uint32_t)(((uint64_t)btr * latency.per_kb_us) / 1024);
+    if(latency.spike_every && stats.reads % latency.spike_every == 0)
+        cost += latency.spike_us;
+    delay_us(cost);
+
+    size_t n = fread(buff, 1, btr, fp->fh);
+    if(n < btr && ferror(fp->fh)) {
+        *br = 0;
+        return FR_DISK_ERR;
+    }
+
+    *br = (UINT)n;
+    fp->fptr += (FSIZE_t)n;
+    stats.bytes_read += n;
+    return FR_OK;
+}
+
+FRESULT f_write(FIL* fp, const void* buff, UINT btw, UINT* bw) {
+    if(!fp->fh)
+        return FR_INVALID_OBJECT;
+
+    size_t n = fwrite(buff, 1, btw, fp->fh);
+    *bw = (UINT)n;
+    fp->fptr += (FSIZE_t)n;
+    if(fp->fptr > fp->obj.objsize)
+        fp->obj.objsize = fp->fptr;
+    return n == btw ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_lseek(FIL* fp, FSIZE_t ofs) {
+    if(!fp->fh)
+        return FR_INVALID_OBJECT;
+
+    stats.seeks++;
+    delay_us(latency.base_us);
+
+    if(fseek(fp->fh, (long)ofs, SEEK_SET) != 0)
+        return FR_DISK_ERR;
+    fp->fptr = ofs;
+    return FR_OK;
+}
+
+FRESULT f_sync(FIL* fp) {
+    if(!fp->fh)
+        return FR_INVALID_OBJECT;
+    return fflush(fp->fh) == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_stat(const TCHAR* path, FILINFO* fno) {
+    char host[PATH_MAX_LEN];
+    if(!map_path(path, host, sizeof(host)))
+        return FR_INVALID_NAME;
+
+    struct stat st;
+    if(stat(host, &st) != 0)
+        return errno_to_fr();
+
+    if(fno) {
+        /* FAT timestamps: 2 s resolution, local time */
+        struct tm tm;
+        localtime_r(&st.st_mtime, &tm);
+        memset(fno, 0, sizeof(*fno));
+        fno->fsize = (FSIZE_t)st.st_size;
+        fno->fdate = (WORD)(((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday);
+        fno->ftime = (WORD)((tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2));
+
+        const char* base = strrchr(host, '/');
+        base = base ? base + 1 : host;
+        size_t len = strlen(base);
+        if(len >= sizeof(fno->fname))
+            len = sizeof(fno->fname) - 1; /* 8.3 names only, like CONFIG_FATFS_LFN_NONE */
+        memcpy(fno->fname, base, len);
+        fno->fname[len] = '\0';
+    }
+    return FR_OK;
+}
+
+FRESULT f_unlink(const TCHAR* path) {
+    char host[PATH_MAX_LEN];
+    if(!map_path(path, host, sizeof(host)))
+        return FR_INVALID_NAME;
+    return remove(host) == 0 ? FR_OK : errno_to_fr();
+}
+
+FRESULT f_rename(const TCHAR* path_old, const TCHAR* path_new) {
+    char from[PATH_MAX_LEN], to[PATH_MAX_LEN];
+    if(!map_path(path_old, from, sizeof(from)) || !map_path(path_new, to, sizeof(to)))
+        return FR_INVALID_NAME;
+    return rename(from, to) == 0 ? FR_OK : errno_to_fr();
+}
+
+FRESULT f_getlabel(const TCHAR* path, TCHAR* out, DWORD* vsn) {
+    (void)path;
+    if(out)
+        strcpy(out, label);
+    if(vsn)
+        *vsn = 0;
+    return FR_OK;
+}
+
+/* FF_USE_STRFUNC 1: no CRLF conversion, like CONFIG_FATFS_USE_STRFUNC_WITHOUT_CRLF_CONV */
+TCHAR* f_gets(TCHAR* buff, int len, FIL* fp) {
+    if(!fp->fh || len < 2)
+        return NULL;
+
+    int n = 0;
+    while(n < len - 1) {
+        int c = fgetc(fp->fh);
+        if(c == EOF)
+            break;
+        buff[n++] = (TCHAR)c;
+        if(c == '\n')
+            break;
+    }
+    fp->fptr += (FSIZE_t)n;
+    buff[n] = '\0';
+    return n ? buff : NULL;
+}
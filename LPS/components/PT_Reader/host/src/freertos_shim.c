@@ -0,0 +1,160 @@
+/* FreeRTOS stand-in: tasks are detached pthreads, semaphores are mutex + condvar counters. */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+static const char* TAG = "freertos_shim";
+
+struct pt_host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void* arg;
+};
+
+struct pt_host_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+/* ================= tasks ================= */
+
+static void* task_entry(void* p) {
+    struct pt_host_task* t = (struct pt_host_task*)p;
+    t->fn(t->arg);
+    return NULL; /* returning from a task is an error on target, but harmless here */
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg, UBaseType_t priority, TaskHandle_t* created) {
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+
+    struct pt_host_task* t = (struct pt_host_task*)calloc(1, sizeof(*t));
+    if(!t)
+        return pdFAIL;
+    t->fn = fn;
+    t->arg = arg;
+
+    if(pthread_create(&t->thread, NULL, task_entry, t) != 0) {
+        free(t);
+        return pdFAIL;
+    }
+    pthread_detach(t->thread);
+
+    if(created)
+        *created = t;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg, UBaseType_t priority, TaskHandle_t* created, BaseType_t core_id) {
+    (void)core_id;
+    return xTaskCreate(fn, name, stack_depth, arg, priority, created);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if(task) {
+        ESP_LOGE(TAG, "vTaskDelete(other task) is not supported on host");
+        return;
+    }
+    /* the task struct is owned by the exiting thread and leaks, like an unreclaimed TCB */
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    uint64_t us = (uint64_t)ticks * 1000000u / configTICK_RATE_HZ;
+    struct timespec ts = {.tv_sec = (time_t)(us / 1000000u), .tv_nsec = (long)(us % 1000000u) * 1000};
+    while(nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t)((uint64_t)ts.tv_sec * configTICK_RATE_HZ + (uint64_t)ts.tv_nsec / (1000000000u / configTICK_RATE_HZ));
+}
+
+/* ================= semaphores ================= */
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    struct pt_host_sem* s = (struct pt_host_sem*)calloc(1, sizeof(*s));
+    if(!s)
+        return NULL;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&s->lock, NULL);
+
+    s->max = max_count;
+    s->count = initial_count;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks) {
+    if(!s)
+        return pdFALSE;
+
+    struct timespec deadline;
+    if(ticks != portMAX_DELAY) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)ticks * (1000000000u / configTICK_RATE_HZ);
+        deadline.tv_sec += (time_t)(ns / 1000000000u);
+        deadline.tv_nsec = (long)(ns % 1000000000u);
+    }
+
+    pthread_mutex_lock(&s->lock);
+    while(s->count == 0) {
+        if(ticks == 0)
+            break;
+        if(ticks == portMAX_DELAY)
+            pthread_cond_wait(&s->cond, &s->lock);
+        else if(pthread_cond_timedwait(&s->cond, &s->lock, &deadline) == ETIMEDOUT)
+            break;
+    }
+
+    bool taken = (s->count > 0);
+    if(taken)
+        s->count--;
+    pthread_mutex_unlock(&s->lock);
+
+    return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+    if(!s)
+        return pdFALSE;
+
+    pthread_mutex_lock(&s->lock);
+    bool given = (s->count < s->max);
+    if(given) {
+        s->count++;
+        pthread_cond_signal(&s->cond);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    return given ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s) {
+    if(!s)
+        return;
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
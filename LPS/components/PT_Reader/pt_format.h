@@ -0,0 +1,309 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_rom_crc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Pattern Table (PT) format revisions
+ *
+ * control.dat 與 frame.dat 共用同一組版本號 [major][minor]
+ *
+ *   v1.2  checksum = 所有 byte 的加總 (uint32, 溢位截斷)
+ *   v1.3  checksum = CRC32 (IEEE 802.3, 與 zlib.crc32 相同)
+ *   v1.4  frame.dat 改為 typed record（KEY / DELTA），control.dat 不變
+ *   v1.5  新增 PALETTE / INDEXED8 / INDEXED4 record
+ *   v1.6  frame.dat 改為 per-channel track（TRACK record，可與整板 record 混用，SYNC 為 seek 點），control.dat 不變
+ *   v1.7  control.dat 的 timestamp 改為 varint delta，frame.dat 與 v1.6 相同
+ *   v1.8  fade byte 帶 easing 曲線，frame.dat header 可帶自訂曲線，control.dat 與 v1.7 相同
+ *   v1.9  新增 EFFECT record（track 的 key 改為程序化效果），其餘與 v1.8 相同
+ *
+ * 除 checksum 演算法外，v1.3 的 layout 與 v1.2 完全相同。
+ *
+ * v1.4 frame.dat record：
+ *   [u8 type][u32 start_time][u8 fade][u16 body_len][body][u32 crc32]
+ *   crc32 涵蓋 type ~ body
+ *
+ *   KEY   body = 完整 payload（OF GRB x enabled + LED GRB x counts）
+ *   DELTA body = 多段 run，對「上一個 KEY」做 XOR：
+ *           [u16 skip][u16 len][len bytes XOR] ...
+ *         skip 為與上一段 run 結尾的距離（bytes），未覆蓋的部分與 KEY 相同
+ *
+ *   PALETTE   body = GRB x N（1 ~ 256 色），設定之後 INDEXED record 用的調色盤，
+ *             本身不是 frame（start_time / fade 忽略）
+ *   INDEXED8  body = 每個 pixel 1 byte index（OF 在前，LED 在後）
+ *   INDEXED4  body = 每個 pixel 4-bit index，低 nibble 先，調色盤最多 16 色
+ *
+ * INDEXED 展開後即為新的 KEY，之後的 DELTA 以它為基準。
+ * 檔案第一個 frame record 必須是 KEY 或 INDEXED；encoder 會定期插入 KEY 以便重新同步。
+ *
+ * v1.6 frame.dat：
+ *   [1][6][u8 track_count][u64 channel_mask x track_count][u32 crc32]
+ *   crc32 涵蓋 track_count ~ 最後一個 mask；之後全部是 TRACK record
+ *
+ *   channel_mask 與 table_frame_t.fade_mask 同一組 bit（ld_frame.h）：
+ *   bit 0~39 為 OF channel，bit 40~47 為 LED strip；各 track 的 mask 不可重疊，
+ *   不屬於任何 track 的 channel 保持全暗
+ *
+ *   TRACK body = [u8 track][該 track 的 payload]
+ *         payload 依 channel 順序只放 mask 內且有啟用的 channel（OF GRB，再 LED GRB x counts）
+ *         start_time 為該 track 的 keyframe 時間（同一 track 內嚴格遞增），
+ *         fade = 1 表示從這個 key 內插到同一 track 的下一個 key
+ *
+ *   record 依 need time 排序（相同時再依 start_time）：
+ *         need = 同 track 上一個 key 有 fade ? 上一個 key 的 start_time : 自己的 start_time
+ *   reader 因此只需往前多讀一個 record，就能合併出任一時間點的完整 frame
+ *
+ *   control.dat 的 timestamp 為所有 track key 時間的聯集（合併後的 frame）
+
+   v1.6 起 KEY / DELTA / PALETTE / INDEXED8 / INDEXED4 與 TRACK 混用，稱為整板 record：
+         在 start_time 給每個 track 一個 key，值為展開後 payload 中該 track 的部分，
+         fade byte 套用到每個 track；need 為各 track need 中最小的一個
+         DELTA 改為對「每個 channel 最後讀到的 key 值」做 XOR（依檔案順序，TRACK 只更新自己的 channel，
+         EFFECT 與還沒有 key 的 channel 為 0），之前（或上一個 SYNC 之後）必須已有整板 KEY / INDEXED
+         PALETTE 仍然不是 frame，排在用到它的 INDEXED 之前
+
+   SYNC body = [u32 group_bytes]，之後緊接 group_bytes 的 TRACK / EFFECT record（group）
+         start_time 為某個合併後 frame 的時間 ts，fade 為 0
+         group 重述「ts 沒有被 SYNC 之後的完整 record（非 DELTA）key 到」的每個已開始的 track：
+         ts 時生效的 key（start_time < ts），以及它有 fade 時 fade 到的下一個 key；依 need 排序
+         SYNC 排在每個 start_time >= ts 且不在 group 中的 record 之前
+   循序讀取時跳過 group；從 SYNC seek 時先讀 group，之後略過 start_time < ts 的 record
+   與 start_time 不晚於該 track 已重述 key 的 record，並丟掉 ts 之前的 frame
+   沒有 SYNC 的檔案只能從頭解碼
+ *
+ * v1.7 control.dat：
+ *   [1][7][PCA flags 40][strip counts 8][u32 frame_num][u32 time_bytes][varint x frame_num][u32 crc32]
+ *
+ *   每個 varint 為與前一個 timestamp 的差（第一個為與 0 的差），unsigned LEB128：
+ *   每 byte 低 7 bit 為資料（低位在前），bit 7 = 1 表示還有下一個 byte，最多 5 bytes
+ *   timestamp 嚴格遞增（同 v1.6 track），一般 show 每個 timestamp 1 ~ 2 bytes
+ *   time_bytes 為 varint 區段的長度，crc32 涵蓋 [1][7] ~ 最後一個 varint
+ *
+ * v1.8 frame.dat：
+ *   [1][8][u8 track_count][u64 channel_mask x track_count][u8 curve_count][256 bytes x curve_count][u32 crc32]
+ *   crc32 涵蓋 track_count ~ 最後一條曲線；之後的 record 與 v1.6 相同
+ *
+ *   record 的 fade byte：bit 0 = fade，bit 1~7 = easing id（ld_ease.h），整板 record 相同
+ *         0 linear，1 ease-in，2 ease-out，3 ease-in-out，4 step，8 + i 為第 i 條自訂曲線
+ *         沒有 fade 的 key easing 必須為 0
+ *   自訂曲線為 256 entry 的 LUT，把線性內插係數 p (0~255) 對應到實際的 p，
+ *   必須 [0] = 0、[255] = 255，最多 PT_CURVE_MAX 條
+ *
+ * v1.9 frame.dat：與 v1.8 相同，track 的 key 可以是 EFFECT record
+ *
+ *   EFFECT body = [u8 track][u8 type][u8 param][u8 spread][u16 period_ms][u16 phase][GRB a][GRB b]
+ *         從 start_time 起到同一 track 的下一個 key 為止，該 track 的 channel 由 Player
+ *         每個 tick 依參數計算（ld_effect.h），效果時間從 start_time 起算
+ *         type：0 rainbow，1 strobe，2 breath，3 sparkle；period_ms 不可為 0
+ *         fade byte 必須為 0，前一個 key 也不可 fade 到 EFFECT
+ *   need time 與 TRACK 相同；同一時間最多 LD_FRAME_EFFECT_MAX（9）個 track 在跑效果
+ *   合併後的 frame 中，效果 channel 的 payload 為 0
+ * ============================================================ */
+
+#define PT_VERSION_MAJOR 1
+
+/** Oldest minor revision still accepted by the readers. */
+#define PT_VERSION_MINOR_MIN 2
+/** First minor revision using CRC32 checksums. */
+#define PT_VERSION_MINOR_CRC32 3
+/** First minor revision using typed frame records (KEY / DELTA). */
+#define PT_VERSION_MINOR_RECORDS 4
+/** First minor revision with PALETTE / INDEXED records. */
+#define PT_VERSION_MINOR_PALETTE 5
+/** First minor revision with per-channel TRACK records. */
+#define PT_VERSION_MINOR_TRACKS 6
+/** First minor revision storing control.dat timestamps as varint deltas. */
+#define PT_VERSION_MINOR_VARINT_TIMES 7
+/** First minor revision with easing ids in the fade byte and custom curves in frame.dat. */
+#define PT_VERSION_MINOR_EASING 8
+/** First minor revision with EFFECT records. */
+#define PT_VERSION_MINOR_EFFECTS 9
+/** Newest minor revision understood by the readers. */
+#define PT_VERSION_MINOR_MAX 9
+
+/** Size of the version header at the start of every PT file. */
+#define PT_VERSION_HEADER_SIZE 2
+/** Size of the trailing checksum of every checksummed block. */
+#define PT_CHECKSUM_SIZE 4
+
+/** [type][start_time][fade][body_len] in front of every v1.4+ record. */
+#define PT_RECORD_HEADER_SIZE 8
+/** [skip][len] in front of every DELTA run. */
+#define PT_DELTA_RUN_HEADER_SIZE 4
+/** Largest palette carried by a PALETTE record. */
+#define PT_PALETTE_MAX_COLORS 256
+/** [track_count] in front of the v1.6 track table; each track adds a u64 channel mask. */
+#define PT_TRACK_TABLE_HEADER_SIZE 1
+#define PT_TRACK_MASK_SIZE 8
+/** Most tracks in one show: one per OF channel and one per LED strip. */
+#define PT_TRACK_MAX 48
+/** [track] in front of every TRACK body. */
+#define PT_TRACK_BODY_HEADER_SIZE 1
+/** Longest varint timestamp delta: 7 bits per byte. */
+#define PT_VARINT_MAX_SIZE 5
+/** v1.8 fade byte: bit 0 fades to the next key, bits 1~7 select the easing curve. */
+#define PT_FADE_FLAG 0x01
+#define PT_FADE_EASE_SHIFT 1
+/** [curve_count] after the v1.8 track masks; each curve adds PT_CURVE_SIZE bytes. */
+#define PT_CURVE_TABLE_HEADER_SIZE 1
+#define PT_CURVE_SIZE 256
+/** Most custom curves in one show (LD_EASE_CUSTOM_MAX). */
+#define PT_CURVE_MAX 8
+/** v1.9 EFFECT body after [track]: [type][param][spread][u16 period_ms][u16 phase][GRB a][GRB b]. */
+#define PT_EFFECT_SIZE 13
+/** v1.6 SYNC body: [u32 group_bytes] of restated TRACK / EFFECT records that follow it. */
+#define PT_SYNC_SIZE 4
+
+typedef enum {
+    PT_RECORD_KEY = 0,  /*!< full payload */
+    PT_RECORD_DELTA,    /*!< XOR runs against the last KEY (v1.6+: the last key of every channel) */
+    PT_RECORD_PALETTE,  /*!< v1.5+: GRB palette for following INDEXED records */
+    PT_RECORD_INDEXED8, /*!< v1.5+: 1-byte palette index per pixel */
+    PT_RECORD_INDEXED4, /*!< v1.5+: 4-bit palette index per pixel */
+    PT_RECORD_TRACK,    /*!< v1.6: keyframe of one channel track */
+    PT_RECORD_EFFECT,   /*!< v1.9: procedural effect key of one channel track */
+    PT_RECORD_SYNC,     /*!< v1.6: seek point, followed by the keys it restates */
+} pt_record_type_t;
+
+typedef enum {
+    PT_CHECKSUM_SUM8 = 0, /*!< v1.2 additive byte sum */
+    PT_CHECKSUM_CRC32,    /*!< v1.3+ CRC32 */
+} pt_checksum_t;
+
+/**
+ * @brief Return true if [major].[minor] is a revision the readers accept.
+ */
+static inline bool pt_version_supported(uint8_t major, uint8_t minor) {
+    return major == PT_VERSION_MAJOR && minor >= PT_VERSION_MINOR_MIN && minor <= PT_VERSION_MINOR_MAX;
+}
+
+/**
+ * @brief Return true if frame.dat of this minor revision uses typed records.
+ */
+static inline bool pt_version_has_records(uint8_t minor) {
+    return minor >= PT_VERSION_MINOR_RECORDS;
+}
+
+/**
+ * @brief Return true if frame.dat of this minor revision holds per-channel tracks.
+ */
+static inline bool pt_version_has_tracks(uint8_t minor) {
+    return minor >= PT_VERSION_MINOR_TRACKS;
+}
+
+/**
+ * @brief Return true if control.dat of this minor revision stores varint timestamp deltas.
+ */
+static inline bool pt_version_has_varint_times(uint8_t minor) {
+    return minor >= PT_VERSION_MINOR_VARINT_TIMES;
+}
+
+/**
+ * @brief Return true if frame.dat of this minor revision carries easing ids and custom curves.
+ */
+static inline bool pt_version_has_easing(uint8_t minor) {
+    return minor >= PT_VERSION_MINOR_EASING;
+}
+
+/**
+ * @brief Return true if frame.dat of this minor revision may hold EFFECT records.
+ */
+static inline bool pt_version_has_effects(uint8_t minor) {
+    return minor >= PT_VERSION_MINOR_EFFECTS;
+}
+
+/**
+ * @brief Return true if a record's fade byte fades to the next key.
+ *
+ * Before v1.8 any non-zero value fades.
+ */
+static inline bool pt_fade_on(uint8_t minor, uint8_t fade) {
+    return pt_version_has_easing(minor) ? (fade & PT_FADE_FLAG) != 0 : fade != 0;
+}
+
+/**
+ * @brief Easing id in a record's fade byte, 0 (linear) before v1.8.
+ */
+static inline uint8_t pt_fade_ease(uint8_t minor, uint8_t fade) {
+    return pt_version_has_easing(minor) ? (uint8_t)(fade >> PT_FADE_EASE_SHIFT) : 0;
+}
+
+/**
+ * @brief Return true if a record type is valid in this minor revision.
+ *
+ * v1.6 frame.dat adds TRACK and SYNC records next to the whole-board ones, v1.9 EFFECT records.
+ */
+static inline bool pt_record_supported(uint8_t minor, uint8_t type) {
+    switch(type) {
+        case PT_RECORD_KEY:
+        case PT_RECORD_DELTA:
+            return minor >= PT_VERSION_MINOR_RECORDS;
+        case PT_RECORD_PALETTE:
+        case PT_RECORD_INDEXED8:
+        case PT_RECORD_INDEXED4:
+            return minor >= PT_VERSION_MINOR_PALETTE;
+        case PT_RECORD_TRACK:
+        case PT_RECORD_SYNC:
+            return minor >= PT_VERSION_MINOR_TRACKS;
+        case PT_RECORD_EFFECT:
+            return minor >= PT_VERSION_MINOR_EFFECTS;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Checksum algorithm used by a given minor revision.
+ */
+static inline pt_checksum_t pt_checksum_kind(uint8_t minor) {
+    return (minor >= PT_VERSION_MINOR_CRC32) ? PT_CHECKSUM_CRC32 : PT_CHECKSUM_SUM8;
+}
+
+/**
+ * @brief Feed a block of bytes into a running checksum.
+ *
+ * Start with sum = 0. Chained calls over consecutive blocks give the same
+ * result as a single call over the concatenated data, for both algorithms.
+ */
+static inline uint32_t pt_checksum_update(pt_checksum_t kind, uint32_t sum, const uint8_t* buf, size_t len) {
+    if(kind == PT_CHECKSUM_CRC32) {
+        return esp_rom_crc32_le(sum, buf, (uint32_t)len);
+    }
+
+    for(size_t i = 0; i < len; i++) {
+        sum += buf[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief Decode a little-endian uint16 from a byte stream.
+ */
+static inline uint16_t pt_read_u16_le(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Decode a little-endian uint32 from a byte stream.
+ */
+static inline uint32_t pt_read_u32_le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Decode a little-endian uint64 from a byte stream.
+ */
+static inline uint64_t pt_read_u64_le(const uint8_t* p) {
+    return (uint64_t)pt_read_u32_le(p) | ((uint64_t)pt_read_u32_le(p + 4) << 32);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,7 +3,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "ff.h"
 
 #include "control_reader.h"
@@ -11,6 +13,13 @@
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "ld_board.h"
+#include "ld_config.h"
+#include "show_compile.h"
+#include "show_flash.h"
+#include "show_library.h"
+#include "show_profile.h"
+#include "show_verify.h"
+#include "sd_latency.h"
 
 /* ========================================================= */
 ch_info_t ch_info_snapshot;
@@ -19,25 +28,97 @@ static const char* TAG = "readframe";
 
 /* ================= runtime state ================= */
 
-static table_frame_t frame_buf; /* single internal buffer */
+/* one prefetched frame; the reader task fills slots in order, read_frame() drains them in order */
+typedef struct {
+    table_frame_t frame;
+    esp_err_t err;    /* ESP_OK, ESP_ERR_NOT_FOUND (EOF) or the read error */
+    uint32_t gen;     /* reset generation the frame was read in */
+} prefetch_slot_t;
 
-static SemaphoreHandle_t sem_free;  /* buffer writable */
-static SemaphoreHandle_t sem_ready; /* buffer readable */
+static prefetch_slot_t* ring = NULL; /* plan.prefetch slots */
+static uint32_t ring_rd = 0;         /* next slot read_frame() takes (reader task keeps its own) */
+
+/* frame_seek(): first frame after the seek target, read ahead to know where to stop */
+static table_frame_t* lookahead = NULL;
+
+static SemaphoreHandle_t sem_free;  /* slots writable */
+static SemaphoreHandle_t sem_ready; /* slots readable */
+static SemaphoreHandle_t sem_cmd;   /* wakes the reader task parked at EOF */
+static SemaphoreHandle_t sem_exit;  /* given by the reader task as it exits; created once, never deleted,
+                                     * so its last give cannot race close_show() freeing it */
 
 static TaskHandle_t sd_task = NULL;
 
 static bool inited = false;
-static bool running = false;
+static volatile bool running = false;
 static bool eof_reached = false;
+static bool sd_mounted = false;
+static bool streaming = false; /* frame.dat read through FatFs */
+static bool compiled = false;  /* playing the compiled cache instead of frame.dat (show_compile.h) */
+static volatile uint32_t gen = 0; /* bumped by frame_reset() / frame_seek(), stale slots are dropped */
+
+static uint8_t current_show = 0;
+static show_plan_t plan;
+static uint32_t show_last_ms = 0; /* timestamp of the last frame (control.dat) */
+
+#define SHOW_CLOSE_WARN_MS 100
 
 /* ================= SD task command ================= */
 
 typedef enum {
     CMD_NONE = 0,
     CMD_RESET,
+    CMD_SEEK,
 } sd_cmd_t;
 
-static sd_cmd_t cmd = CMD_NONE;
+/* what the last gen bump asked for; written before gen, so a task that sees the new gen sees it too */
+static volatile sd_cmd_t cmd = CMD_NONE;
+static volatile uint32_t seek_ms = 0; /* CMD_SEEK target */
+
+/* ================= seek marks ================= */
+
+/* sync points seen while reading (frame_reader_sync_pos), sorted by timestamp; only the reader task touches them */
+typedef struct {
+    uint32_t timestamp;
+    frame_reader_pos_t pos;
+} seek_mark_t;
+
+static seek_mark_t marks[LD_CFG_PT_READER_SEEK_MARKS];
+static uint32_t mark_count = 0;
+static uint32_t mark_spacing_ms = LD_CFG_PT_READER_SEEK_MARK_MS;
+
+static void marks_clear(void) {
+    mark_count = 0;
+    mark_spacing_ms = LD_CFG_PT_READER_SEEK_MARK_MS;
+}
+
+/* after every frame the task reads: keep it when it is a sync point far enough past the last mark */
+static void marks_note(uint32_t timestamp) {
+    if(mark_count && timestamp < marks[mark_count - 1].timestamp + mark_spacing_ms)
+        return;
+
+    frame_reader_pos_t pos;
+    if(compiled) {
+        pos.offset = show_compile_tell() - show_compile_frame_size();
+        pos.palette = 0;
+    } else if(!frame_reader_sync_pos(&pos)) {
+        return;
+    }
+
+    /* full: keep every other mark, twice as far apart */
+    if(mark_count == LD_CFG_PT_READER_SEEK_MARKS) {
+        for(uint32_t i = 1; i < mark_count / 2; i++)
+            marks[i] = marks[i * 2];
+        mark_count /= 2;
+        mark_spacing_ms *= 2;
+        if(timestamp < marks[mark_count - 1].timestamp + mark_spacing_ms)
+            return;
+    }
+
+    marks[mark_count].timestamp = timestamp;
+    marks[mark_count].pos = pos;
+    mark_count++;
+}
 
 /* ================= SD mount ================= */
 
@@ -72,52 +153,380 @@ static esp_err_t mount_sdcard(void) {
         return ret;
     }
 
+    sd_latency_set_card(g_sd_card->cid.name, g_sd_card->real_freq_khz);
     return ESP_OK;
 }
 
+/* ================= frame source ================= */
+
+static uint8_t* show_ram = NULL; /* whole frame.dat when it fits the RAM budget */
+
+#if LD_CFG_PT_READER_RAM_CACHE_BYTES > 0
+static esp_err_t load_show_ram(const char* frame_path, uint32_t* size) {
+    FILINFO fno;
+    if(f_stat(frame_path, &fno) != FR_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    *size = (uint32_t)fno.fsize;
+    if(*size > LD_CFG_PT_READER_RAM_CACHE_BYTES) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) < *size + LD_CFG_PT_READER_RAM_CACHE_HEAP_RESERVE) {
+        ESP_LOGW(TAG, "show fits the RAM budget but heap is short (largest block %u)", (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+        return ESP_ERR_NO_MEM;
+    }
+
+    show_ram = (uint8_t*)malloc(*size);
+    if(!show_ram) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    FIL fp;
+    UINT br = 0;
+    FRESULT fr = f_open(&fp, frame_path, FA_READ);
+    if(fr == FR_OK) {
+        fr = f_read(&fp, show_ram, *size, &br);
+        f_close(&fp);
+    }
+
+    if(fr != FR_OK || br != *size) {
+        free(show_ram);
+        show_ram = NULL;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+#endif
+
+/* prefer a RAM copy, then the flash mapping, then the compiled cache, then streaming from SD.
+ * The cache only stands in for streaming frame.dat: it is read from SD too, and larger.
+ * The partition holds a single show and re-copying it erases the whole
+ * partition, so only the boot show is allowed to use it. */
+static esp_err_t open_frame_source(const char* frame_path, bool use_flash, bool use_cache) {
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+
+    streaming = false;
+    compiled = false;
+
+#if LD_CFG_PT_READER_RAM_CACHE_BYTES > 0
+    uint32_t ram_size;
+    err = load_show_ram(frame_path, &ram_size);
+    if(err == ESP_OK) {
+        ESP_LOGI(TAG, "frame.dat cached in RAM (%lu bytes)", (unsigned long)ram_size);
+        err = frame_reader_init_mem(show_ram, ram_size);
+        if(err != ESP_OK) {
+            free(show_ram);
+            show_ram = NULL;
+        }
+        return err;
+    }
+#endif
+
+#if LD_CFG_ENABLE_SHOW_FLASH
+    if(use_flash) {
+        const uint8_t* data;
+        uint32_t size;
+        err = show_flash_load(frame_path, &data, &size);
+        if(err == ESP_OK) {
+            err = frame_reader_init_mem(data, size);
+            if(err != ESP_OK)
+                show_flash_unload();
+            return err;
+        }
+    }
+#else
+    (void)use_flash;
+#endif
+
+    if(use_cache) {
+        err = show_compile_open(frame_path);
+        if(err == ESP_OK) {
+            ESP_LOGI(TAG, "streaming the compiled cache from SD");
+            streaming = true;
+            compiled = true;
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "compiled cache unavailable (%s)", esp_err_to_name(err));
+    }
+
+    ESP_LOGI(TAG, "streaming frame.dat from SD (%s)", esp_err_to_name(err));
+    streaming = true;
+    return frame_reader_init(frame_path);
+}
+
+static void close_frame_source(void) {
+    show_compile_close();
+    frame_reader_deinit();
+    show_flash_unload();
+    free(show_ram);
+    show_ram = NULL;
+}
+
 /* ================= SD reader task ================= */
 
+/* read the next frame from the open source, noting seek marks on the way */
+static esp_err_t read_source(table_frame_t* out) {
+    esp_err_t err = compiled ? show_compile_read(out) : frame_reader_read(out);
+    if(err == ESP_OK)
+        marks_note(out->timestamp);
+    return err;
+}
+
+/* position the source at the last mark at or before time_ms, frame 0 without one */
+static esp_err_t rewind_source(uint32_t time_ms) {
+    uint32_t i = mark_count;
+    while(i > 0 && marks[i - 1].timestamp > time_ms)
+        i--;
+
+    if(i > 0) {
+        esp_err_t err = compiled ? show_compile_seek(marks[i - 1].pos.offset) : frame_reader_seek(&marks[i - 1].pos);
+        if(err == ESP_OK)
+            return ESP_OK;
+        if(err != ESP_ERR_NOT_SUPPORTED)
+            ESP_LOGW(TAG, "seek mark %lu ms: %s, read from frame 0", (unsigned long)marks[i - 1].timestamp, esp_err_to_name(err));
+    }
+    return compiled ? show_compile_reset() : frame_reader_reset();
+}
+
+/* CMD_SEEK: decode forward into out until it holds the last frame at or before time_ms
+ * (the first frame when time_ms is before it); the frame after it is left in lookahead */
+static esp_err_t seek_source(uint32_t time_ms, uint32_t slot_gen, table_frame_t* out, bool* have_next) {
+    *have_next = false;
+
+    esp_err_t err = rewind_source(time_ms);
+    if(err != ESP_OK)
+        return err;
+
+    err = read_source(out);
+    if(err != ESP_OK)
+        return err;
+
+    /* a newer command or close_show() gives up: this slot carries the old gen and is dropped */
+    while(running && gen == slot_gen) {
+        err = read_source(lookahead);
+        if(err == ESP_ERR_NOT_FOUND)
+            return ESP_OK; /* out is the last frame, EOF follows */
+        if(err != ESP_OK)
+            return err;
+        if(lookahead->timestamp > time_ms) {
+            *have_next = true;
+            return ESP_OK;
+        }
+        memcpy(out, lookahead, sizeof(*out));
+    }
+    return ESP_OK;
+}
+
 static void sd_reader_task(void* arg) {
+    uint32_t wr = 0;
+    uint32_t slot_gen = gen;
+    bool at_eof = false;
+    bool have_next = false; /* lookahead holds the next frame after a seek */
+
     while(running) {
 
-        /* wait until buffer free */
-        if(xSemaphoreTake(sem_free, portMAX_DELAY) != pdTRUE)
+        /* nothing left to read: park until frame_reset() / frame_seek() / close_show() */
+        if(at_eof) {
+            while(running && gen == slot_gen)
+                xSemaphoreTake(sem_cmd, portMAX_DELAY);
+            at_eof = false;
             continue;
+        }
 
-        /* ---- command handling ---- */
-        if (cmd == CMD_RESET) {
-            frame_reader_reset(); //correction
-            cmd = CMD_NONE;
-            xSemaphoreGive(sem_free);
+        /* wait until a slot is free */
+        if(xSemaphoreTake(sem_free, portMAX_DELAY) != pdTRUE)
             continue;
+
+        /* woken by close_show() */
+        if(!running)
+            break;
+
+        /* ---- command handling, then read one frame ---- */
+        prefetch_slot_t* slot = &ring[wr];
+        esp_err_t err;
+        sd_cmd_t c = CMD_NONE;
+
+        /* gen first: a command racing with this one bumps it again and is handled on the next slot */
+        if(gen != slot_gen) {
+            slot_gen = gen;
+            c = cmd;
+            have_next = false;
         }
 
-        /* ---- read one frame ---- */
-        esp_err_t err = frame_reader_read(&frame_buf);
+        if(c == CMD_RESET) {
+            if(compiled)
+                show_compile_reset();
+            else
+                frame_reader_reset();
+        }
 
-        if(err == ESP_ERR_NOT_FOUND) {
-            ESP_LOGI(TAG, "EOF reached");
-            eof_reached = true;
-            
-            xSemaphoreGive(sem_ready);
-            continue;
+        if(c == CMD_SEEK) {
+            err = seek_source(seek_ms, slot_gen, &slot->frame, &have_next);
+        } else if(have_next) {
+            memcpy(&slot->frame, lookahead, sizeof(table_frame_t));
+            have_next = false;
+            err = ESP_OK;
+        } else {
+            err = read_source(&slot->frame);
         }
+        slot->err = err;
+        slot->gen = slot_gen;
+        wr = (wr + 1) % plan.prefetch;
 
-        if(err != ESP_OK) {
+        if(err == ESP_ERR_NOT_FOUND) {
+            ESP_LOGI(TAG, "EOF reached");
+            at_eof = true;
+        } else if(err != ESP_OK) {
             ESP_LOGE(TAG, "frame_reader_read failed: %s", esp_err_to_name(err));
             running = false;
-            xSemaphoreGive(sem_ready);
-            break;
         }
 
-        /* buffer ready */
+        /* slot ready (EOF and errors are delivered in order, after the frames before them) */
         xSemaphoreGive(sem_ready);
     }
 
     ESP_LOGI(TAG, "sd_reader_task exit");
+    /* last touch of shared state: close_show() frees the ring and the source once this is given */
+    xSemaphoreGive(sem_exit);
     vTaskDelete(NULL);
 }
 
+/* ================= show open / close ================= */
+
+/* steps 1-6 of frame_system_init, without touching the SD mount */
+static esp_err_t open_show(const char* control_path, const char* frame_path, bool use_flash) {
+    esp_err_t err;
+
+    /* ---------- 1. load control.dat -> ch_info_snapshot, profile timestamps ---------- */
+    static ch_info_t info;
+    static show_profile_t profile;
+    err = get_channel_info_profile(control_path, &info, &profile);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "get_channel_info failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    ch_info_snapshot = info;
+    show_last_ms = profile.last_ms;
+
+    /* ---------- 2. verify once (first boot / after upload) ---------- */
+    show_verify_info_t vinfo = {.frames = 0, .fade_frames = SHOW_PROFILE_FADE_UNKNOWN};
+    bool verified = (show_verify_check(control_path, frame_path, &vinfo) == ESP_OK);
+    if(!verified) {
+        err = show_verify_run(control_path, frame_path, &vinfo);
+        if(err == ESP_ERR_INVALID_CRC || err == ESP_ERR_INVALID_SIZE) {
+            ESP_LOGE(TAG, "show verification failed: %s", esp_err_to_name(err));
+            return err;
+        }
+        if(err != ESP_OK) {
+            ESP_LOGW(TAG, "show verification incomplete (%s), keep per-frame checksum", esp_err_to_name(err));
+        }
+        verified = (err == ESP_OK);
+    }
+
+    /* ---------- 2b. playback cache built by frame_system_compile() (show_compile.h), no per-frame checksum there ---------- */
+    bool use_cache = verified && !LD_CFG_PT_READER_PARANOID && show_compile_enabled() && show_compile_check(control_path, frame_path) == ESP_OK;
+
+    /* ---------- 3. init frame reader (compiled cache / RAM / flash / SD) ---------- */
+    err = open_frame_source(frame_path, use_flash, use_cache);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "frame_reader_init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    frame_reader_set_verify(LD_CFG_PT_READER_PARANOID || !verified);
+
+    /* ---------- 4. plan: tick period, prefetch depth ---------- */
+    profile.fade_frames = vinfo.fade_frames;
+    show_profile_plan(&profile, streaming, &plan);
+    show_profile_log(&profile, compiled ? show_compile_frame_size() : frame_reader_frame_size(), &plan);
+
+    ring = (prefetch_slot_t*)malloc(plan.prefetch * sizeof(prefetch_slot_t));
+    if(!ring && plan.prefetch > 1) {
+        ESP_LOGW(TAG, "no memory for %u prefetch slots, prefetch 1", (unsigned)plan.prefetch);
+        plan.prefetch = 1;
+        ring = (prefetch_slot_t*)malloc(sizeof(prefetch_slot_t));
+    }
+    lookahead = (table_frame_t*)malloc(sizeof(table_frame_t));
+    marks_clear();
+
+    sem_free = xSemaphoreCreateCounting(plan.prefetch, plan.prefetch); /* all slots initially free */
+    sem_ready = xSemaphoreCreateCounting(plan.prefetch, 0);
+    sem_cmd = xSemaphoreCreateBinary();
+    if(!sem_exit)
+        sem_exit = xSemaphoreCreateBinary();
+
+    if(!ring || !lookahead || !sem_free || !sem_ready || !sem_cmd || !sem_exit) {
+        ESP_LOGE(TAG, "Failed to create prefetch ring / semaphores");
+        err = ESP_ERR_NO_MEM;
+        goto fail;
+    }
+
+    /* ---------- 5. runtime ---------- */
+    running = true;
+    cmd     = CMD_NONE;
+    ring_rd = 0;
+    eof_reached = false;
+
+    /* ---------- 6. create SD reader task ---------- */
+    if(xTaskCreate(sd_reader_task, "sd_reader", 16384, NULL, 5, &sd_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create sd_reader task");
+        running = false;
+        err = ESP_ERR_NO_MEM;
+        goto fail;
+    }
+
+    return ESP_OK;
+
+fail:
+    if(sem_free)
+        vSemaphoreDelete(sem_free);
+    if(sem_ready)
+        vSemaphoreDelete(sem_ready);
+    if(sem_cmd)
+        vSemaphoreDelete(sem_cmd);
+    sem_free = sem_ready = sem_cmd = NULL;
+    free(ring);
+    ring = NULL;
+    free(lookahead);
+    lookahead = NULL;
+    sd_task = NULL;
+    close_frame_source();
+    return err;
+}
+
+/* stop the reader task and release the frame source; the SD card stays mounted */
+static void close_show(void) {
+    running = false;
+
+    if(sd_task) {
+        xSemaphoreGive(sem_free);
+        xSemaphoreGive(sem_cmd);
+        /* the task may be inside f_read() on a stalled card: wait it out, freeing now would pull
+         * the ring and the source from under it */
+        if(xSemaphoreTake(sem_exit, pdMS_TO_TICKS(SHOW_CLOSE_WARN_MS)) != pdTRUE) {
+            ESP_LOGW(TAG, "sd_reader task still busy after %d ms, waiting", SHOW_CLOSE_WARN_MS);
+            xSemaphoreTake(sem_exit, portMAX_DELAY);
+        }
+    }
+
+    if(sem_free)
+        vSemaphoreDelete(sem_free);
+    if(sem_ready)
+        vSemaphoreDelete(sem_ready);
+    if(sem_cmd)
+        vSemaphoreDelete(sem_cmd);
+
+    close_frame_source();
+
+    sem_free = sem_ready = sem_cmd = NULL;
+    free(ring);
+    ring = NULL;
+    free(lookahead);
+    lookahead = NULL;
+    sd_task = NULL;
+    eof_reached = false;
+}
+
 /* ================= public API ================= */
 
 /* ---- initial frame system ---- */
@@ -130,50 +539,165 @@ esp_err_t frame_system_init(const char* control_path, const char* frame_path) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    /* ---------- 0. mount SD ---------- */
-    err = mount_sdcard();
+    /* ---------- 0. mount SD (once, kept across deinit / show switches) ---------- */
+    if(!sd_mounted) {
+        err = mount_sdcard();
+        if(err != ESP_OK)
+            return err;
+        sd_mounted = true;
+    }
+
+    /* show 0 is always control_path / frame_path */
+    err = show_library_load(LD_CFG_SHOW_LIBRARY_PATH, control_path, frame_path);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "show_library_load failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    /* ---------- 1 ~ 6. open show 0 ---------- */
+    err = open_show(control_path, frame_path, true);
     if(err != ESP_OK)
         return err;
 
-    /* ---------- 1. load control.dat -> ch_info ---------- */
-    err = get_channel_info(control_path, &ch_info);
+    ch_info = ch_info_snapshot;
+    current_show = 0;
+    inited = true;
+
+    ESP_LOGI(TAG, "frame system initialized (new channel_info model, %u shows)", (unsigned)show_library_count());
+    return ESP_OK;
+}
+
+/* ---- switch show ---- */
+
+esp_err_t frame_system_open(uint8_t show_id) {
+    if(!inited) {
+        ESP_LOGE(TAG, "frame system not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    show_entry_t next;
+    if(show_library_get(show_id, &next) != ESP_OK) {
+        ESP_LOGE(TAG, "show %u not in library", (unsigned)show_id);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+
+    close_show();
+
+    esp_err_t err = open_show(next.control_path, next.frame_path, show_id == 0);
     if(err != ESP_OK) {
-        ESP_LOGE(TAG, "get_channel_info failed: %s", esp_err_to_name(err));
+        ESP_LOGE(TAG, "open show %u failed: %s, back to show %u", (unsigned)show_id, esp_err_to_name(err), (unsigned)current_show);
+
+        show_entry_t prev;
+        if(show_library_get(current_show, &prev) != ESP_OK || open_show(prev.control_path, prev.frame_path, current_show == 0) != ESP_OK) {
+            ESP_LOGE(TAG, "reopen show %u failed, frame system stopped", (unsigned)current_show);
+            inited = false;
+        }
         return err;
     }
-    ch_info_snapshot = ch_info;  // snapshot
 
-    /* ---------- 2. init frame reader ---------- */
-    err = frame_reader_init(frame_path);
+    current_show = show_id;
+    ESP_LOGI(TAG, "show %u opened in %lld ms (%s)", (unsigned)show_id, (long long)((esp_timer_get_time() - t0) / 1000), next.frame_path);
+    return ESP_OK;
+}
+
+/* ---- reload show 0 after its files were replaced ---- */
+
+esp_err_t frame_system_reload(void) {
+    if(!inited) {
+        ESP_LOGE(TAG, "frame system not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    show_entry_t boot;
+    if(show_library_get(0, &boot) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+
+    close_show();
+
+    /* the upload may have replaced shows.idx too */
+    esp_err_t err = show_library_load(LD_CFG_SHOW_LIBRARY_PATH, boot.control_path, boot.frame_path);
+    if(err == ESP_OK)
+        err = open_show(boot.control_path, boot.frame_path, true);
+
     if(err != ESP_OK) {
-        ESP_LOGE(TAG, "frame_reader_init failed: %s", esp_err_to_name(err));
+        ESP_LOGE(TAG, "reload failed: %s, frame system stopped", esp_err_to_name(err));
+        inited = false;
         return err;
     }
 
-    /* ---------- 3. semaphores ---------- */
-    sem_free = xSemaphoreCreateBinary();
-    sem_ready = xSemaphoreCreateBinary();
+    current_show = 0;
+    ESP_LOGI(TAG, "show reloaded in %lld ms", (long long)((esp_timer_get_time() - t0) / 1000));
+    return ESP_OK;
+}
+
+/* ---- build the compiled cache of the current show ---- */
 
-    if(!sem_free || !sem_ready) {
-        ESP_LOGE(TAG, "Failed to create semaphores");
-        frame_reader_deinit();
-        return ESP_ERR_NO_MEM;
+esp_err_t frame_system_compile(void) {
+    if(!inited) {
+        ESP_LOGE(TAG, "frame system not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if(LD_CFG_PT_READER_PARANOID || !show_compile_enabled()) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    /* a RAM / flash copy never plays the cache, and a cache in use is current: nothing to reopen */
+    if(!streaming || compiled) {
+        return ESP_OK;
     }
 
-    xSemaphoreGive(sem_free); /* buffer initially free */
+    show_entry_t show;
+    if(show_library_get(current_show, &show) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    /* ---------- 4. runtime ---------- */
-    running = true;
-    cmd     = CMD_NONE;
-    eof_reached = false;
+    int64_t t0 = esp_timer_get_time();
+
+    /* show_compile_run() needs frame_reader to itself */
+    close_show();
+
+    esp_err_t err = ESP_OK;
+    if(show_verify_check(show.control_path, show.frame_path, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "show %u is not verified, not compiled", (unsigned)current_show);
+        err = ESP_ERR_INVALID_STATE;
+    } else if(show_compile_check(show.control_path, show.frame_path) != ESP_OK) {
+        err = show_compile_run(show.control_path, show.frame_path);
+        if(err == ESP_ERR_NOT_SUPPORTED)
+            ESP_LOGI(TAG, "show runs effects, play frame.dat");
+        else if(err != ESP_OK)
+            ESP_LOGW(TAG, "show compile failed: %s", esp_err_to_name(err));
+    }
 
-    /* ---------- 5. create SD reader task ---------- */
-    xTaskCreate(sd_reader_task, "sd_reader", 16384, NULL, 5, &sd_task);
+    esp_err_t open_err = open_show(show.control_path, show.frame_path, current_show == 0);
+    if(open_err != ESP_OK) {
+        ESP_LOGE(TAG, "reopen show %u failed: %s, frame system stopped", (unsigned)current_show, esp_err_to_name(open_err));
+        inited = false;
+        return open_err;
+    }
 
-    inited = true;
+    ESP_LOGI(TAG, "show %u compile: %s in %lld ms", (unsigned)current_show, esp_err_to_name(err), (long long)((esp_timer_get_time() - t0) / 1000));
+    return err;
+}
 
-    ESP_LOGI(TAG, "frame system initialized (new channel_info model)");
-    return ESP_OK;
+uint8_t frame_system_current_show(void) {
+    return current_show;
+}
+
+uint32_t frame_system_tick_us(void) {
+    return inited ? plan.tick_us : 1000000 / LD_CFG_PLAYER_FPS;
+}
+
+uint32_t frame_system_duration_ms(void) {
+    return inited ? show_last_ms : 0;
+}
+
+bool frame_system_can_seek(void) {
+    /* every compiled cache record is a sync point; track shows in frame.dat have them at SYNC records */
+    return inited && (compiled || frame_reader_can_seek());
 }
 
 /* ---- sequential read ---- */
@@ -187,40 +711,89 @@ esp_err_t read_frame(table_frame_t* playerbuffer) {
         ESP_LOGE(TAG, "playerbuffer is NULL");
         return ESP_ERR_INVALID_ARG;
     }
-    if (eof_reached) 
+    if(eof_reached)
         return ESP_ERR_NOT_FOUND;
 
-    if(xSemaphoreTake(sem_ready, portMAX_DELAY) != pdTRUE){
-        ESP_LOGE(TAG, "Failed to take sem_ready");
-        return ESP_FAIL;
+    for(;;) {
+        /* once the reader task stopped, only the slots it already filled are left */
+        if(xSemaphoreTake(sem_ready, running ? portMAX_DELAY : 0) != pdTRUE) {
+            ESP_LOGE(TAG, "frame system not running");
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        prefetch_slot_t* slot = &ring[ring_rd];
+        ring_rd = (ring_rd + 1) % plan.prefetch;
+
+        /* read before the last frame_reset() */
+        if(slot->gen != gen) {
+            xSemaphoreGive(sem_free);
+            continue;
+        }
+
+        esp_err_t err = slot->err;
+        if(err == ESP_OK)
+            memcpy(playerbuffer, &slot->frame, sizeof(table_frame_t));
+        else if(err == ESP_ERR_NOT_FOUND)
+            eof_reached = true;
+
+        xSemaphoreGive(sem_free);
+        return err;
     }
+}
 
-    if(!running){
-        ESP_LOGE(TAG, "frame system not running");
+/* hand a command to the reader task and drop every frame read before it */
+static void post_cmd(sd_cmd_t c, uint32_t time_ms) {
+    cmd = c;
+    seek_ms = time_ms;
+
+    /* a slot the reader task is filling right now carries the old gen and is dropped by read_frame() */
+    gen++;
+
+    /* drain ready slots; the task may already be filling freed ones for this command, those stay */
+    while(xSemaphoreTake(sem_ready, 0) == pdTRUE) {
+        if(ring[ring_rd].gen == gen) {
+            xSemaphoreGive(sem_ready);
+            break;
+        }
+        ring_rd = (ring_rd + 1) % plan.prefetch;
+        xSemaphoreGive(sem_free);
+    }
+
+    eof_reached = false;
+    xSemaphoreGive(sem_cmd);
+}
+
+/* ---- reset to frame 0 ---- */
+
+esp_err_t frame_reset(void) {
+    if(!inited){
+        ESP_LOGE(TAG, "frame system not initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
-    memcpy(playerbuffer, &frame_buf, sizeof(table_frame_t));
+    if(!running) {
+        ESP_LOGE(TAG, "frame system not running");
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    xSemaphoreGive(sem_free);
+    post_cmd(CMD_RESET, 0);
     return ESP_OK;
 }
 
-/* ---- reset to frame 0 ---- */
+/* ---- seek ---- */
 
-esp_err_t frame_reset(void) {
+esp_err_t frame_seek(uint32_t time_ms) {
     if(!inited){
         ESP_LOGE(TAG, "frame system not initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
-    /* drain ready semaphore */
-    while(xSemaphoreTake(sem_ready, 0) == pdTRUE) {}
-    
-    running = true;
-    eof_reached = false;
-    cmd = CMD_RESET;
-    xSemaphoreGive(sem_free);
+    if(!running) {
+        ESP_LOGE(TAG, "frame system not running");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    post_cmd(CMD_SEEK, time_ms);
     return ESP_OK;
 }
 
@@ -232,24 +805,8 @@ esp_err_t frame_system_deinit(void) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    running = false;
-
-    if(sd_task) {
-        xSemaphoreGive(sem_free);
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
-
-    if(sem_free)
-        vSemaphoreDelete(sem_free);
-    if(sem_ready)
-        vSemaphoreDelete(sem_ready);
-
-    frame_reader_deinit();
-
-    sem_free = sem_ready = NULL;
-    sd_task = NULL;
+    close_show();
     inited = false;
-    eof_reached = false;
 
     ESP_LOGI(TAG, "frame system deinit");
     return ESP_OK;
@@ -21,7 +21,10 @@ extern ch_info_t ch_info_snapshot;
  *       // play frame
  *   }
  *
- *   frame_reset();   // optional
+ *   frame_reset();          // optional
+ *   frame_seek(12000);      // optional, 從 12 s 附近的 frame 繼續
+ *   frame_system_open(1);   // optional, 切換到 shows.idx 的 show 1
+ *   frame_system_compile(); // optional, 閒置時建立目前 show 的 compiled cache
  *
  *   frame_system_deinit();
  * ============================================================ */
@@ -30,10 +33,16 @@ extern ch_info_t ch_info_snapshot;
  * @brief 初始化整個 frame system
  *
  * 會完成：
- *   - SD card mount
+ *   - SD card mount（只 mount 一次）
+ *   - 讀取 show library index（show_library.h），show 0 為本次傳入的路徑
  *   - 讀取 control.dat → ch_info
- *   - 初始化 frame_reader
- *   - 建立 SD reader task
+ *   - 首次開機 / 上傳後完整驗證 show 並寫 marker（show_verify.h）
+ *   - 已由 frame_system_compile() 建好且仍有效的 cache 會被採用（show_compile.h）
+ *   - 由 timestamp 與 fade 統計決定 tick 週期與 prefetch 深度（show_profile.h）
+ *   - 初始化 frame_reader（已驗證的 show 播放時不再檢查 checksum）
+ *     來源依序為：frame.dat 整個載入 RAM → flash partition mmap → compiled cache → SD
+ *     （cache 一樣從 SD 讀且比 frame.dat 大，只取代從 SD 串流 frame.dat）
+ *   - 建立 SD reader task，預讀 prefetch 個 frame
  *
  * @param control_path  control.dat 路徑（例如 "0:/control.dat"）
  * @param frame_path    frame.dat 路徑（例如 "0:/frame.dat"）
@@ -42,11 +51,88 @@ extern ch_info_t ch_info_snapshot;
  *   - ESP_OK
  *   - ESP_ERR_INVALID_STATE  已初始化
  *   - ESP_ERR_NOT_FOUND      SD / 檔案不存在
- *   - ESP_ERR_NO_MEM         semaphore / task 建立失敗
+ *   - ESP_ERR_NO_MEM         prefetch buffer / semaphore / task 建立失敗
+ *   - ESP_ERR_INVALID_CRC    show 驗證失敗（checksum 錯誤）
+ *   - ESP_ERR_INVALID_SIZE   show 驗證失敗（frame.dat 截斷）
  *   - ESP_FAIL               其他錯誤
  */
 esp_err_t frame_system_init(const char* control_path, const char* frame_path);
 
+/**
+ * @brief 切換到 show library 中的另一個 show（不重新 mount SD）
+ *
+ * 停止 SD reader task、關閉目前的 frame source，再以新的 control / frame
+ * 重跑 init 的步驟 1 ~ 6。ch_info（LED driver 設定）不變。
+ * 開啟失敗時會重新開啟原本的 show。只能由讀 frame 的 task（Player）呼叫。
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_INVALID_STATE  尚未 init
+ *   - ESP_ERR_NOT_FOUND      library 中沒有這個 id
+ *   - 其他                   同 frame_system_init
+ */
+esp_err_t frame_system_open(uint8_t show_id);
+
+/**
+ * @brief 上傳新檔案後重新載入 show 0（不重開機、不重新 mount SD）
+ *
+ * 重新讀取 shows.idx、control.dat → ch_info_snapshot，並重新開啟 frame source
+ * （marker 已被 invalidate 時會重新驗證，flash partition 內的舊 show 會重新複製）。
+ * ch_info（LED driver 設定）不變。呼叫時不可有 task 正在 read_frame。
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_INVALID_STATE  尚未 init
+ *   - 其他                   同 frame_system_init，失敗後 frame system 停止
+ */
+esp_err_t frame_system_reload(void);
+
+/**
+ * @brief 為目前的 show 建立 compiled cache（show_compile.h），完成後重新開啟 show（回到 frame 0）
+ *
+ * init / open / reload 本身不會 compile：cache 約為每 frame 一個完整 frame_data，
+ * 長 show 要寫入上百 MB。main 在開機 init 後與上傳後的 hot reload 中（LED 維持綠色）呼叫；
+ * 之後開啟這個 show 時，若它原本要從 SD 串流 frame.dat，就改播 cache。
+ * show 在 RAM / flash 或已在播放有效的 cache 時直接回傳 ESP_OK，不重新開啟。
+ * 呼叫時不可有 task 正在 read_frame（main 在 Player 進入 READY 前，或由 Player 在 READY 時呼叫）。
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_INVALID_STATE  尚未 init，或 show 尚未驗證
+ *   - ESP_ERR_NOT_SUPPORTED  LD_CFG_PT_READER_PARANOID、compile 已關閉，或 show 含 v1.9 effect
+ *   - 其他                   show_compile_run() 的錯誤；重新開啟失敗時 frame system 停止
+ */
+esp_err_t frame_system_compile(void);
+
+/**
+ * @brief 目前載入的 show id
+ */
+uint8_t frame_system_current_show(void);
+
+/**
+ * @brief 目前 show 建議的 Player tick 週期（show_profile.h），每次開啟 show 時重新計算
+ *
+ * @return tick 週期（us），尚未 init 時為 1000000 / LD_CFG_PLAYER_FPS
+ */
+uint32_t frame_system_tick_us(void);
+
+/**
+ * @brief 目前 show 最後一個 frame 的 timestamp（control.dat），即 show 的長度
+ *
+ * @return ms，尚未 init 時為 0
+ */
+uint32_t frame_system_duration_ms(void);
+
+/**
+ * @brief frame_seek 能否從 seek mark 開始解碼
+ *
+ * v1.6+ track show 直接播 frame.dat 時以 SYNC record 為 sync point；沒有 SYNC 的舊檔每次 seek
+ * 都從 frame 0 解碼到目標，長 show 會 block read_frame 數秒（重新用 pt_tool 輸出，或建立 compiled cache）。
+ *
+ * @return true 表示可以 seek；尚未 init 時為 false
+ */
+bool frame_system_can_seek(void);
+
 /**
  * @brief 讀取下一個 frame（blocking）
  *
@@ -54,23 +140,40 @@ esp_err_t frame_system_init(const char* control_path, const char* frame_path);
  *
  * @return
  *   - ESP_OK                成功
- *   - ESP_ERR_INVALID_STATE 尚未 init
+ *   - ESP_ERR_INVALID_STATE 尚未 init，或 reader task 已停止
  *   - ESP_ERR_INVALID_ARG   out 為 NULL
  *   - ESP_ERR_NOT_FOUND     EOF（沒有 frame 了）
+ *   - 其他                  reader task 讀取失敗（frame_reader_read 的錯誤），之後回傳 ESP_ERR_INVALID_STATE
  */
 esp_err_t read_frame(table_frame_t* out);
 
 /**
  * @brief 重置播放位置到 frame 0
  *
- * 非同步命令，實際 reset 由 SD reader task 處理
+ * 非同步命令，實際 reset 由 SD reader task 處理；已預讀的 frame 會被丟棄
  *
  * @return
  *   - ESP_OK
- *   - ESP_ERR_INVALID_STATE 尚未 init
+ *   - ESP_ERR_INVALID_STATE 尚未 init，或 reader task 已因讀取錯誤停止
  */
 esp_err_t frame_reset(void);
 
+/**
+ * @brief 跳到 time_ms，之後 read_frame 從 timestamp <= time_ms 的最後一個 frame 開始
+ *        （time_ms 在第一個 frame 之前時從 frame 0 開始）
+ *
+ * 非同步命令，與 frame_reset 相同：已預讀的 frame 會被丟棄，由 SD reader task 處理。
+ * reader task 播放時記下 sync point（LD_CFG_PT_READER_SEEK_MARK_MS 間隔，最多
+ * LD_CFG_PT_READER_SEEK_MARKS 個），seek 從 time_ms 之前最近的一個開始解碼，
+ * 沒有記錄時（尚未播到、沒有 SYNC 的 v1.6+ track show）從 frame 0 解碼到 time_ms。
+ * 解碼期間 read_frame 會 block，要避免停頓請提早呼叫。
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_INVALID_STATE 尚未 init，或 reader task 已因讀取錯誤停止
+ */
+esp_err_t frame_seek(uint32_t time_ms);
+
 /**
  * @brief 關閉 frame system 並釋放所有資源
  *
@@ -0,0 +1,164 @@
+#include "sd_latency.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "ff.h"
+#include "ld_config.h"
+
+/* ================= static ================= */
+
+static const char* TAG = "sd_latency";
+
+static uint32_t hist[SD_LATENCY_BUCKETS];
+static uint32_t count = 0;
+static uint64_t bytes = 0;
+static uint64_t total_us = 0;
+static uint32_t max_us = 0;
+static uint32_t stalls = 0;
+
+static char card_name[16] = "?";
+static int card_khz = 0;
+
+/* ================= buckets ================= */
+
+/* 0 ~ 7 us: one bucket per us; above: 4 buckets per power of two */
+static uint32_t bucket_of(uint32_t us) {
+    if(us < 8)
+        return us;
+
+    uint32_t msb = 31 - (uint32_t)__builtin_clz(us);
+    uint32_t sub = (us >> (msb - 2)) & 3;
+    uint32_t b = (msb - 1) * 4 + sub;
+    return b < SD_LATENCY_BUCKETS ? b : SD_LATENCY_BUCKETS - 1;
+}
+
+static uint32_t bucket_lo(uint32_t b) {
+    if(b < 8)
+        return b;
+    return (4 + (b & 3)) << (b / 4 - 1);
+}
+
+/* exclusive upper bound, the last bucket is open ended */
+static uint32_t bucket_hi(uint32_t b) {
+    if(b == SD_LATENCY_BUCKETS - 1)
+        return UINT32_MAX;
+    return bucket_lo(b + 1);
+}
+
+/* upper bound of the bucket holding the p-th read, capped at the observed max */
+static uint32_t percentile(uint32_t n, uint32_t per_mille) {
+    if(n == 0)
+        return 0;
+
+    uint64_t rank = ((uint64_t)n * per_mille + 999) / 1000;
+    uint64_t seen = 0;
+    for(uint32_t b = 0; b < SD_LATENCY_BUCKETS; b++) {
+        seen += hist[b];
+        if(seen >= rank) {
+            uint32_t hi = bucket_hi(b) - 1;
+            return hi < max_us ? hi : max_us;
+        }
+    }
+    return max_us;
+}
+
+/* ================= API ================= */
+
+void sd_latency_record(uint32_t us, uint32_t n) {
+    hist[bucket_of(us)]++;
+    count++;
+    bytes += n;
+    total_us += us;
+    if(us > max_us)
+        max_us = us;
+    if(us > LD_CFG_PT_READER_SD_STALL_US)
+        stalls++;
+}
+
+void sd_latency_get(sd_latency_stats_t* out) {
+    if(!out)
+        return;
+
+    out->count = count;
+    out->bytes = bytes;
+    out->total_us = total_us;
+    out->max_us = max_us;
+    out->p50_us = percentile(count, 500);
+    out->p99_us = percentile(count, 990);
+    out->p999_us = percentile(count, 999);
+    out->stalls = stalls;
+}
+
+void sd_latency_reset(void) {
+    memset(hist, 0, sizeof(hist));
+    count = 0;
+    bytes = 0;
+    total_us = 0;
+    max_us = 0;
+    stalls = 0;
+}
+
+void sd_latency_set_card(const char* name, int freq_khz) {
+    /* sdmmc_cid_t.name is a fixed 8-byte field */
+    snprintf(card_name, sizeof(card_name), "%.8s", (name && name[0]) ? name : "?");
+    card_khz = freq_khz;
+}
+
+/* the summary line shared by print and dump */
+static int format_summary(char* buf, size_t len) {
+    sd_latency_stats_t s;
+    sd_latency_get(&s);
+    return snprintf(buf, len, "reads %lu bytes %llu avg_us %lu max_us %lu p50_us %lu p99_us %lu p999_us %lu stalls %lu stall_us %lu\n", (unsigned long)s.count, (unsigned long long)s.bytes,
+                    (unsigned long)(s.count ? s.total_us / s.count : 0), (unsigned long)s.max_us, (unsigned long)s.p50_us, (unsigned long)s.p99_us, (unsigned long)s.p999_us, (unsigned long)s.stalls,
+                    (unsigned long)LD_CFG_PT_READER_SD_STALL_US);
+}
+
+void sd_latency_print(void) {
+    char line[256];
+    format_summary(line, sizeof(line));
+    printf("card %s %d kHz\n%s", card_name, card_khz, line);
+
+    for(uint32_t b = 0; b < SD_LATENCY_BUCKETS; b++) {
+        if(!hist[b])
+            continue;
+        printf("  %8lu ~ %-8lu us %8lu\n", (unsigned long)bucket_lo(b), (unsigned long)bucket_hi(b), (unsigned long)hist[b]);
+    }
+}
+
+esp_err_t sd_latency_dump(const char* path) {
+    if(!path)
+        return ESP_ERR_INVALID_ARG;
+
+    FIL fp;
+    if(f_open(&fp, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        ESP_LOGE(TAG, "create %s failed", path);
+        return ESP_FAIL;
+    }
+
+    char line[256];
+    UINT bw;
+    bool ok = true;
+    int n = snprintf(line, sizeof(line), "# sd read latency, card %s %d kHz\n", card_name, card_khz);
+    ok &= f_write(&fp, line, (UINT)n, &bw) == FR_OK && bw == (UINT)n;
+    n = format_summary(line, sizeof(line));
+    ok &= f_write(&fp, line, (UINT)n, &bw) == FR_OK && bw == (UINT)n;
+    n = snprintf(line, sizeof(line), "# lo_us hi_us count\n");
+    ok &= f_write(&fp, line, (UINT)n, &bw) == FR_OK && bw == (UINT)n;
+
+    for(uint32_t b = 0; ok && b < SD_LATENCY_BUCKETS; b++) {
+        if(!hist[b])
+            continue;
+        n = snprintf(line, sizeof(line), "%lu %lu %lu\n", (unsigned long)bucket_lo(b), (unsigned long)bucket_hi(b), (unsigned long)hist[b]);
+        ok &= f_write(&fp, line, (UINT)n, &bw) == FR_OK && bw == (UINT)n;
+    }
+    ok &= f_close(&fp) == FR_OK;
+
+    if(!ok) {
+        ESP_LOGE(TAG, "write %s failed", path);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "latency histogram written to %s", path);
+    return ESP_OK;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * SD Read Latency Profiler
+ *
+ * frame_reader 從 SD 讀取時，記錄每次 f_read 的耗時（LD_CFG_PT_READER_SD_LATENCY）：
+ *
+ *   - log-scale histogram：每個 2 倍區間分 4 格（0 ~ 7 us 每 us 一格），
+ *     最大約 16 s，誤差 < 25%
+ *   - count / bytes / 平均 / max，以及由 histogram 估計的 p50 / p99 / p99.9
+ *   - stall：超過 LD_CFG_PT_READER_SD_STALL_US（預設一個 frame 週期）的次數
+ *
+ * 統計從開機（或上次 sd_latency_reset()）累積，包含 verify 那一次完整讀取。
+ * 只有 reader task 寫入；console 讀取時不上鎖，數值可能差一筆，僅供診斷。
+ * flash / RAM 來源不經過 f_read，不會記錄。
+ * ============================================================ */
+
+/** Bucket count of the latency histogram. */
+#define SD_LATENCY_BUCKETS 92
+
+typedef struct {
+    uint32_t count;    /*!< f_read calls recorded */
+    uint64_t bytes;    /*!< bytes returned by those calls */
+    uint64_t total_us; /*!< sum of all latencies */
+    uint32_t max_us;
+    uint32_t p50_us; /*!< histogram estimates, at most max_us */
+    uint32_t p99_us;
+    uint32_t p999_us;
+    uint32_t stalls; /*!< reads longer than LD_CFG_PT_READER_SD_STALL_US */
+} sd_latency_stats_t;
+
+/**
+ * @brief 記錄一次 f_read（frame_reader 內部呼叫）
+ *
+ * @param  us     耗時（microseconds）
+ * @param  bytes  實際讀到的 bytes
+ */
+void sd_latency_record(uint32_t us, uint32_t bytes);
+
+/**
+ * @brief 取得目前統計
+ */
+void sd_latency_get(sd_latency_stats_t* out);
+
+/**
+ * @brief 清除所有統計
+ */
+void sd_latency_reset(void);
+
+/**
+ * @brief 記下卡片型號與時脈，會寫進 dump 的第一行（mount 後由 readframe 呼叫）
+ */
+void sd_latency_set_card(const char* name, int freq_khz);
+
+/**
+ * @brief 以 printf 輸出統計與非空的 histogram 區間（console 用）
+ */
+void sd_latency_print(void);
+
+/**
+ * @brief 將統計與完整 histogram 以文字寫入 SD（例如 "0:/sdlat.txt"），覆蓋舊檔
+ *
+ * 格式：
+ *   # sd read latency, card <name> <freq> kHz
+ *   reads <n> bytes <n> avg_us <n> max_us <n> p50_us <n> p99_us <n> p999_us <n> stalls <n> stall_us <n>
+ *   # lo_us hi_us count        （只列非空區間，lo <= t < hi）
+ *
+ * @return
+ *   - ESP_OK               成功
+ *   - ESP_ERR_INVALID_ARG  path 為 NULL
+ *   - ESP_FAIL             開檔或寫入失敗
+ */
+esp_err_t sd_latency_dump(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,487 @@
+#include "show_compile.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "ff.h"
+
+#include "frame_reader.h"
+#include "ld_config.h"
+#include "ld_ease.h"
+#include "ld_gamma_lut.h"
+#include "ld_led_ops.h"
+#include "readframe.h"  // ch_info_snapshot
+#include "sd_latency.h"
+
+static const char* TAG = "show_compile";
+
+#define CACHE_MAGIC 0x43505450u /* "PTPC" little-endian */
+#define CACHE_VERSION 2
+#define CACHE_EXT ".pfc"
+#define CACHE_PATH_MAX 64
+
+/* [u32 timestamp][u8 wire][u8 ease][reserved x2][u64 fade_mask], native byte order like the header */
+typedef struct {
+    uint32_t timestamp;
+    uint8_t wire;
+    uint8_t ease;
+    uint8_t reserved[2];
+    uint64_t fade_mask;
+} record_header_t;
+
+#define RECORD_HEADER_SIZE sizeof(record_header_t)
+#define RECORD_PCA_SIZE (LD_BOARD_PCA9955B_CH_NUM * 3)
+
+typedef struct {
+    uint32_t size;
+    uint16_t fdate;
+    uint16_t ftime;
+} cache_stamp_t;
+
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t curves; /* custom easing curves between the header and the first record */
+    uint8_t reserved[2];
+    cache_stamp_t control;
+    cache_stamp_t frame;
+    uint32_t output;
+    uint32_t frames;
+    uint32_t wire_frames;
+    uint32_t record_size;
+    uint32_t crc32;
+} cache_header_t;
+
+static bool g_enabled = LD_CFG_PT_READER_COMPILE;
+
+static FIL fp;
+static bool opened = false;
+static uint8_t* g_record = NULL;
+static uint32_t g_record_size = 0;
+static uint32_t g_data_offset = 0;
+
+/* ================= helpers ================= */
+
+/* "0:/frame.dat" -> "0:/frame.pfc" (8.3 names, no LFN) */
+static esp_err_t cache_path(const char* frame_path, char* out, size_t out_len) {
+    const char* slash = strrchr(frame_path, '/');
+    const char* dot = strrchr(frame_path, '.');
+    size_t stem_len = (dot && (!slash || dot > slash)) ? (size_t)(dot - frame_path) : strlen(frame_path);
+
+    if(stem_len + strlen(CACHE_EXT) + 1 > out_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memcpy(out, frame_path, stem_len);
+    strcpy(out + stem_len, CACHE_EXT);
+    return ESP_OK;
+}
+
+static esp_err_t stat_file(const char* path, cache_stamp_t* out) {
+    FILINFO fno;
+    FRESULT fr = f_stat(path, &fno);
+    if(fr != FR_OK) {
+        return (fr == FR_NO_FILE || fr == FR_NO_PATH) ? ESP_ERR_NOT_FOUND : ESP_FAIL;
+    }
+
+    out->size = (uint32_t)fno.fsize;
+    out->fdate = fno.fdate;
+    out->ftime = fno.ftime;
+    return ESP_OK;
+}
+
+static uint32_t data_offset(const cache_header_t* h) {
+    return (uint32_t)sizeof(cache_header_t) + (uint32_t)h->curves * LD_EASE_LUT_SIZE;
+}
+
+static bool stamp_matches(const cache_stamp_t* a, const cache_stamp_t* b) {
+    return a->size == b->size && a->fdate == b->fdate && a->ftime == b->ftime;
+}
+
+static uint32_t header_crc(const cache_header_t* h) {
+    return esp_rom_crc32_le(0, (const uint8_t*)h, offsetof(cache_header_t, crc32));
+}
+
+/* everything that changes the bytes of a wire record besides the show itself */
+static uint32_t output_crc(void) {
+    const uint8_t* luts[] = {GAMMA_OF_R_lut, GAMMA_OF_G_lut, GAMMA_OF_B_lut, GAMMA_LED_R_lut, GAMMA_LED_G_lut, GAMMA_LED_B_lut};
+    const uint8_t brightness[] = {LD_CFG_PCA9955B_MAX_BRIGHTNESS_R, LD_CFG_PCA9955B_MAX_BRIGHTNESS_G, LD_CFG_PCA9955B_MAX_BRIGHTNESS_B, LD_CFG_WS2812B_MAX_BRIGHTNESS};
+
+    uint32_t crc = 0;
+    for(size_t i = 0; i < sizeof(luts) / sizeof(luts[0]); i++)
+        crc = esp_rom_crc32_le(crc, luts[i], 256);
+    return esp_rom_crc32_le(crc, brightness, sizeof(brightness));
+}
+
+static uint32_t record_size(void) {
+    uint32_t size = RECORD_HEADER_SIZE + RECORD_PCA_SIZE;
+    for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++)
+        size += (uint32_t)ch_info_snapshot.rmt_strips[s] * 3;
+    return size;
+}
+
+/* the Player's step frame: lerp at p = 0 (an HSV round trip), gamma, brightness */
+static inline grb8_t output_color(grb8_t c, led_type_t type) {
+    return grb_set_brightness(grb_gamma_u8(grb_lerp_hsv_u8(c, c, 0), type), type);
+}
+
+/* ================= public API ================= */
+
+void show_compile_set_enabled(bool enable) {
+    g_enabled = enable;
+}
+
+bool show_compile_enabled(void) {
+    return g_enabled;
+}
+
+void show_compile_wire(const frame_data* data, frame_wire* wire) {
+    /* every pixel keeps its byte offset, so reading a pixel before writing it is enough when data == wire */
+    for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
+        grb8_t c = output_color(data->pca9955b[ch], LED_PCA9955B);
+        uint8_t* dst = &wire->pca9955b[ch / LD_BOARD_PCA9955B_RGB_PER_IC][(ch % LD_BOARD_PCA9955B_RGB_PER_IC) * 3];
+        dst[0] = c.r;
+        dst[1] = c.g;
+        dst[2] = c.b;
+    }
+
+    for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+        for(int i = 0; i < LD_BOARD_WS2812B_MAX_PIXEL_NUM; i++) {
+            grb8_t c = output_color(data->ws2812b[s][i], LED_WS2812B);
+            uint8_t* dst = &wire->ws2812b[s][i * 3];
+            dst[0] = c.g;
+            dst[1] = c.r;
+            dst[2] = c.b;
+        }
+    }
+}
+
+esp_err_t show_compile_check(const char* control_path, const char* frame_path) {
+    if(!control_path || !frame_path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char path[CACHE_PATH_MAX];
+    if(cache_path(frame_path, path, sizeof(path)) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FIL f;
+    UINT br;
+    cache_header_t h;
+    cache_stamp_t cache;
+
+    if(stat_file(path, &cache) != ESP_OK || f_open(&f, path, FA_READ) != FR_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    FRESULT fr = f_read(&f, &h, sizeof(h), &br);
+    f_close(&f);
+
+    if(fr != FR_OK || br != sizeof(h) || h.magic != CACHE_MAGIC || h.crc32 != header_crc(&h)) {
+        ESP_LOGW(TAG, "cache %s unreadable or interrupted", path);
+        return ESP_ERR_INVALID_CRC;
+    }
+    if(h.version != CACHE_VERSION || h.output != output_crc() || h.record_size != record_size()) {
+        ESP_LOGI(TAG, "cache %s was built for another firmware output or layout", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if(h.curves > LD_EASE_CUSTOM_MAX || cache.size != data_offset(&h) + h.frames * h.record_size) {
+        ESP_LOGW(TAG, "cache %s is %lu bytes, expected %lu", path, (unsigned long)cache.size, (unsigned long)(data_offset(&h) + h.frames * h.record_size));
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    cache_stamp_t control, frame;
+    if(stat_file(control_path, &control) != ESP_OK || stat_file(frame_path, &frame) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if(!stamp_matches(&control, &h.control) || !stamp_matches(&frame, &h.frame)) {
+        ESP_LOGI(TAG, "cache %s is stale", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ESP_LOGI(TAG, "cache %s: %lu frames, %lu wire", path, (unsigned long)h.frames, (unsigned long)h.wire_frames);
+    return ESP_OK;
+}
+
+esp_err_t show_compile_run(const char* control_path, const char* frame_path) {
+    if(!control_path || !frame_path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(GAMMA_OF_R_lut[255] == 0 && GAMMA_LED_R_lut[255] == 0) {
+        ESP_LOGE(TAG, "gamma LUT not built (calc_gamma_lut)");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    char path[CACHE_PATH_MAX];
+    if(cache_path(frame_path, path, sizeof(path)) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err;
+    cache_header_t h;
+    memset(&h, 0, sizeof(h));
+    h.magic = CACHE_MAGIC;
+    h.version = CACHE_VERSION;
+    h.output = output_crc();
+    h.record_size = record_size();
+
+    err = stat_file(control_path, &h.control);
+    if(err == ESP_OK)
+        err = stat_file(frame_path, &h.frame);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    table_frame_t* frame = (table_frame_t*)malloc(sizeof(table_frame_t));
+    uint8_t* rec = (uint8_t*)malloc(h.record_size);
+    if(!frame || !rec) {
+        free(frame);
+        free(rec);
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    ESP_LOGI(TAG, "compiling %s -> %s ...", frame_path, path);
+
+    FIL f;
+    UINT bw;
+    bool written = false;
+    uint64_t prev_mask = 0;
+    if(f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        ESP_LOGE(TAG, "create %s failed", path);
+        free(frame);
+        free(rec);
+        return ESP_FAIL;
+    }
+
+    /* the header stays zero (invalid) until every record is written */
+    err = frame_reader_init(frame_path);
+    if(err != ESP_OK)
+        goto done;
+    frame_reader_set_verify(false); /* show_verify ran already */
+
+    /* frame_reader_init loaded the show's custom curves; playback from the cache reloads them */
+    h.curves = ld_ease_custom_count();
+    if(f_write(&f, &h, sizeof(h), &bw) != FR_OK || bw != sizeof(h)) {
+        err = ESP_FAIL;
+        goto done;
+    }
+    for(uint8_t c = 0; c < h.curves; c++) {
+        if(f_write(&f, ld_ease_lut[LD_EASE_BUILTIN_NUM + c], LD_EASE_LUT_SIZE, &bw) != FR_OK || bw != LD_EASE_LUT_SIZE) {
+            err = ESP_FAIL;
+            goto done;
+        }
+    }
+
+    while((err = frame_reader_read(frame)) == ESP_OK) {
+        /* v1.9 effects run on every tick; such a show is a few KB and plays from frame.dat */
+        if(frame->effect_count) {
+            ESP_LOGI(TAG, "frame %lu runs an effect, not compiled", (unsigned long)h.frames);
+            err = ESP_ERR_NOT_SUPPORTED;
+            break;
+        }
+
+        /* the Player interpolates from a fading frame, and into the frame after it */
+        bool wire = (frame->fade_mask == 0 && prev_mask == 0);
+        prev_mask = frame->fade_mask;
+        if(wire) {
+            show_compile_wire(&frame->data, &frame->wire);
+            h.wire_frames++;
+        }
+
+        record_header_t rh = {.timestamp = (uint32_t)frame->timestamp, .wire = wire ? 1 : 0, .ease = frame->ease, .fade_mask = frame->fade_mask};
+        memcpy(rec, &rh, sizeof(rh));
+
+        uint8_t* p = rec + RECORD_HEADER_SIZE;
+        memcpy(p, frame->data.pca9955b, RECORD_PCA_SIZE);
+        p += RECORD_PCA_SIZE;
+        for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+            size_t n = (size_t)ch_info_snapshot.rmt_strips[s] * 3;
+            memcpy(p, frame->data.ws2812b[s], n);
+            p += n;
+        }
+
+        if(f_write(&f, rec, h.record_size, &bw) != FR_OK || bw != h.record_size) {
+            ESP_LOGE(TAG, "write %s failed at frame %lu (card full?)", path, (unsigned long)h.frames);
+            err = ESP_FAIL;
+            break;
+        }
+        h.frames++;
+    }
+    if(err != ESP_ERR_NOT_FOUND)
+        goto done;
+
+    /* -------- header last -------- */
+    h.crc32 = header_crc(&h);
+    if(f_lseek(&f, 0) != FR_OK || f_write(&f, &h, sizeof(h), &bw) != FR_OK || bw != sizeof(h)) {
+        err = ESP_FAIL;
+        goto done;
+    }
+    err = ESP_OK;
+    written = true;
+
+done:
+    frame_reader_deinit();
+    if(f_close(&f) != FR_OK && written) {
+        err = ESP_FAIL;
+        written = false;
+    }
+    if(!written)
+        f_unlink(path);
+    free(frame);
+    free(rec);
+
+    if(err != ESP_OK) {
+        if(err != ESP_ERR_NOT_SUPPORTED)
+            ESP_LOGE(TAG, "compile failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "compiled %lu frames (%lu wire, %lu bytes each) in %lld ms", (unsigned long)h.frames, (unsigned long)h.wire_frames, (unsigned long)h.record_size,
+             (long long)((esp_timer_get_time() - t0) / 1000));
+    return ESP_OK;
+}
+
+esp_err_t show_compile_invalidate(const char* frame_path) {
+    if(!frame_path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char path[CACHE_PATH_MAX];
+    if(cache_path(frame_path, path, sizeof(path)) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FRESULT fr = f_unlink(path);
+    if(fr != FR_OK && fr != FR_NO_FILE) {
+        ESP_LOGW(TAG, "unlink %s failed (fr=%d)", path, fr);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/* ================= playback ================= */
+
+esp_err_t show_compile_open(const char* frame_path) {
+    if(opened) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    char path[CACHE_PATH_MAX];
+    if(!frame_path || cache_path(frame_path, path, sizeof(path)) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(f_open(&fp, path, FA_READ) != FR_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    UINT br;
+    cache_header_t h;
+    if(f_read(&fp, &h, sizeof(h), &br) != FR_OK || br != sizeof(h)) {
+        f_close(&fp);
+        return ESP_FAIL;
+    }
+
+    if(h.curves > LD_EASE_CUSTOM_MAX) {
+        f_close(&fp);
+        return ESP_FAIL;
+    }
+
+    /* the record buffer doubles as the curve buffer while it is still free */
+    uint32_t curves_size = (uint32_t)h.curves * LD_EASE_LUT_SIZE;
+    g_record = (uint8_t*)malloc(h.record_size > curves_size ? h.record_size : curves_size);
+    if(!g_record) {
+        f_close(&fp);
+        return ESP_ERR_NO_MEM;
+    }
+    if((curves_size > 0 && (f_read(&fp, g_record, curves_size, &br) != FR_OK || br != curves_size)) || !ld_ease_set_custom(h.curves, g_record)) {
+        free(g_record);
+        g_record = NULL;
+        f_close(&fp);
+        return ESP_FAIL;
+    }
+
+    g_record_size = h.record_size;
+    g_data_offset = data_offset(&h);
+    opened = true;
+    ESP_LOGI(TAG, "playing %s (%lu bytes per frame)", path, (unsigned long)g_record_size);
+    return ESP_OK;
+}
+
+esp_err_t show_compile_read(table_frame_t* out) {
+    if(!opened) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    UINT br;
+#if LD_CFG_PT_READER_SD_LATENCY
+    int64_t t0 = esp_timer_get_time();
+    FRESULT fr = f_read(&fp, g_record, g_record_size, &br);
+    sd_latency_record((uint32_t)(esp_timer_get_time() - t0), br);
+#else
+    FRESULT fr = f_read(&fp, g_record, g_record_size, &br);
+#endif
+    if(fr != FR_OK) {
+        return ESP_FAIL;
+    }
+    if(br != g_record_size) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    record_header_t rh;
+    memcpy(&rh, g_record, sizeof(rh));
+
+    memset(out, 0, sizeof(*out));
+    out->timestamp = rh.timestamp;
+    out->compiled = (rh.wire != 0);
+    out->fade_mask = rh.fade_mask;
+    out->fade = (rh.fade_mask != 0);
+    out->ease = rh.ease;
+
+    /* raw and wire records share the byte layout of frame_data / frame_wire */
+    const uint8_t* p = g_record + RECORD_HEADER_SIZE;
+    memcpy(out->data.pca9955b, p, RECORD_PCA_SIZE);
+    p += RECORD_PCA_SIZE;
+    for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+        size_t n = (size_t)ch_info_snapshot.rmt_strips[s] * 3;
+        memcpy(out->data.ws2812b[s], p, n);
+        p += n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t show_compile_reset(void) {
+    if(!opened) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return f_lseek(&fp, g_data_offset) == FR_OK ? ESP_OK : ESP_FAIL;
+}
+
+uint32_t show_compile_tell(void) {
+    return opened ? (uint32_t)f_tell(&fp) : 0;
+}
+
+esp_err_t show_compile_seek(uint32_t offset) {
+    if(!opened) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return f_lseek(&fp, offset) == FR_OK ? ESP_OK : ESP_FAIL;
+}
+
+void show_compile_close(void) {
+    if(!opened)
+        return;
+
+    f_close(&fp);
+    free(g_record);
+    g_record = NULL;
+    g_record_size = 0;
+    g_data_offset = 0;
+    opened = false;
+}
+
+uint32_t show_compile_frame_size(void) {
+    return g_record_size;
+}
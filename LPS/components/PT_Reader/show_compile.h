@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#include "ld_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Show Compile（播放用 cache，compile once, play many）
+ *
+ * show 驗證通過後（show_verify.h），由 frame_system_compile() 把 frame.dat 解碼一次寫成 cache，
+ * 放在 frame.dat 旁（例如 "0:/frame.pfc"）：
+ *
+ *   header: [magic "PTPC"][version][u8 curve_count][reserved x2]
+ *           control.dat: [size][fdate][ftime]
+ *           frame.dat  : [size][fdate][ftime]
+ *           [output crc32]  gamma LUT + LD_CFG_*_MAX_BRIGHTNESS
+ *           [frames][wire frames][record size]
+ *           [crc32 of all previous bytes]
+ *   curves: curve_count x 256 bytes，show 的自訂 easing curve（v1.8），開啟時載入 ld_ease
+ *   record: [u32 timestamp][u8 wire][u8 ease][reserved x2][u64 fade_mask]
+ *           [PCA9955B 40 x 3][WS2812B strip 0 ~ 7, 每條 pixel 數 x 3]
+ *
+ * 每個 record 大小固定，payload 的 byte 位置與 frame_data / frame_wire 相同，
+ * 播放時一次 f_read 後直接複製進 table_frame_t，不必解碼。
+ *
+ *   - wire record：自己與前一個 frame 都沒有 fade（Player 不會內插它），
+ *     存成 frame_wire（已做 gamma / brightness，PCA 為 RGB），Player 直接寫進
+ *     LedController 的傳輸 buffer
+ *   - 其他 record 存原本的 GRB，Player 照常內插與修正
+ *
+ * header 最後寫入，中斷時下次會重新 compile。檔案或輸出設定變動時 cache 失效。
+ * ============================================================ */
+
+/**
+ * @brief 開關 compile 與 cache 播放（預設 LD_CFG_PT_READER_COMPILE），下次開啟 show 時生效
+ */
+void show_compile_set_enabled(bool enable);
+
+bool show_compile_enabled(void);
+
+/**
+ * @brief 檢查 cache 是否存在且與目前的檔案、ch_info_snapshot、輸出設定相符
+ *
+ * @return
+ *   - ESP_OK                cache 有效
+ *   - ESP_ERR_NOT_FOUND     cache 不存在或已過期
+ *   - ESP_ERR_INVALID_CRC   cache header 損毀或長度不符
+ *   - ESP_ERR_INVALID_ARG   path 為 NULL
+ */
+esp_err_t show_compile_check(const char* control_path, const char* frame_path);
+
+/**
+ * @brief 解碼整個 frame.dat 並寫入 cache
+ *
+ * 前置條件：show 已驗證、ch_info_snapshot 已由 control.dat 載入、frame_reader 未開啟、
+ * gamma LUT 已由 calc_gamma_lut() 建好。
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_INVALID_STATE  gamma LUT 尚未建立
+ *   - ESP_ERR_NO_MEM
+ *   - ESP_ERR_NOT_SUPPORTED  show 含 v1.9 effect（每個 tick 都要計算），直接播放 frame.dat
+ *   - 其他                   frame_reader 的錯誤，或 ESP_FAIL（寫入失敗，cache 會被刪除）
+ */
+esp_err_t show_compile_run(const char* control_path, const char* frame_path);
+
+/**
+ * @brief 刪除 cache（上傳新檔案時呼叫），不存在時也回傳 ESP_OK
+ */
+esp_err_t show_compile_invalidate(const char* frame_path);
+
+/**
+ * @brief 開啟已通過 show_compile_check() 的 cache 準備播放
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_INVALID_STATE  已開啟
+ *   - ESP_ERR_NOT_FOUND      cache 不存在
+ *   - ESP_ERR_NO_MEM
+ *   - ESP_FAIL               header 讀取失敗
+ */
+esp_err_t show_compile_open(const char* frame_path);
+
+/**
+ * @brief 讀取下一個 frame（wire record 會設定 out->compiled）
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_NOT_FOUND      EOF
+ *   - ESP_ERR_INVALID_STATE  尚未開啟
+ *   - ESP_FAIL               讀取失敗
+ */
+esp_err_t show_compile_read(table_frame_t* out);
+
+esp_err_t show_compile_reset(void);
+
+/**
+ * @brief 下一個 record 的 offset（每個 record 都可以直接 seek 過去）
+ */
+uint32_t show_compile_tell(void);
+
+/**
+ * @brief 跳到 show_compile_tell() 回傳過的 offset
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_INVALID_STATE  尚未開啟
+ *   - ESP_FAIL               seek 失敗
+ */
+esp_err_t show_compile_seek(uint32_t offset);
+
+/**
+ * @brief 關閉 cache（未開啟時呼叫不會出錯）
+ */
+void show_compile_close(void);
+
+/**
+ * @brief 一個 record 的 bytes，未開啟時為 0
+ */
+uint32_t show_compile_frame_size(void);
+
+/**
+ * @brief 依 Player 處理 step frame 的方式（p = 0 的 HSV 內插、gamma、brightness）轉成 frame_wire
+ *
+ * data 與 wire 可以是同一塊記憶體（table_frame_t 的 union）。
+ */
+void show_compile_wire(const frame_data* data, frame_wire* wire);
+
+#ifdef __cplusplus
+}
+#endif
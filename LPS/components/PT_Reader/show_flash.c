@@ -0,0 +1,179 @@
+#include "show_flash.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "ff.h"
+
+#include "show_verify.h"
+
+static const char* TAG = "show_flash";
+
+#define SHOW_PARTITION_LABEL "show"
+#define SHOW_PARTITION_SUBTYPE 0x40
+
+#define HEADER_MAGIC 0x46535450u /* "PTSF" little-endian */
+#define HEADER_VERSION 1
+#define SECTOR_SIZE 0x1000
+#define DATA_OFFSET SECTOR_SIZE /* one erase sector for the header */
+#define COPY_CHUNK_SIZE 4096
+
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t reserved[3];
+    show_file_stamp_t frame;
+    uint32_t crc32;
+} show_flash_header_t;
+
+static const esp_partition_t* part = NULL;
+static esp_partition_mmap_handle_t map_handle;
+static bool mapped = false;
+
+/* ================= helpers ================= */
+
+static uint32_t header_crc(const show_flash_header_t* h) {
+    return esp_rom_crc32_le(0, (const uint8_t*)h, offsetof(show_flash_header_t, crc32));
+}
+
+static bool header_matches(const show_flash_header_t* h, const FILINFO* fno) {
+    return h->magic == HEADER_MAGIC && h->version == HEADER_VERSION && h->crc32 == header_crc(h) && h->frame.size == (uint32_t)fno->fsize &&
+           h->frame.fdate == fno->fdate && h->frame.ftime == fno->ftime;
+}
+
+/* copy frame.dat behind the header, header is written last */
+static esp_err_t copy_from_sd(const char* frame_path, const FILINFO* fno, show_flash_header_t* h) {
+    uint32_t size = (uint32_t)fno->fsize;
+    uint32_t erase_size = (DATA_OFFSET + size + SECTOR_SIZE - 1) & ~(SECTOR_SIZE - 1);
+
+    esp_err_t err = esp_partition_erase_range(part, 0, erase_size);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "erase failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    uint8_t* chunk = (uint8_t*)malloc(COPY_CHUNK_SIZE);
+    if(!chunk) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    FIL fp;
+    if(f_open(&fp, frame_path, FA_READ) != FR_OK) {
+        free(chunk);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t crc = 0;
+    uint32_t done = 0;
+    while(done < size) {
+        UINT br;
+        if(f_read(&fp, chunk, COPY_CHUNK_SIZE, &br) != FR_OK || br == 0) {
+            err = ESP_FAIL;
+            break;
+        }
+        err = esp_partition_write(part, DATA_OFFSET + done, chunk, br);
+        if(err != ESP_OK)
+            break;
+
+        crc = esp_rom_crc32_le(crc, chunk, br);
+        done += br;
+    }
+
+    f_close(&fp);
+    free(chunk);
+
+    if(err != ESP_OK || done != size) {
+        ESP_LOGE(TAG, "copy failed at %lu/%lu bytes", (unsigned long)done, (unsigned long)size);
+        return ESP_FAIL;
+    }
+
+    memset(h, 0, sizeof(*h));
+    h->magic = HEADER_MAGIC;
+    h->version = HEADER_VERSION;
+    h->frame.size = size;
+    h->frame.fdate = fno->fdate;
+    h->frame.ftime = fno->ftime;
+    h->frame.crc32 = crc;
+    h->crc32 = header_crc(h);
+
+    return esp_partition_write(part, 0, h, sizeof(*h));
+}
+
+/* ================= public API ================= */
+
+esp_err_t show_flash_load(const char* frame_path, const uint8_t** data, uint32_t* size) {
+    if(!frame_path || !data || !size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(mapped) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, SHOW_PARTITION_SUBTYPE, SHOW_PARTITION_LABEL);
+    if(!part) {
+        ESP_LOGW(TAG, "no \"%s\" partition", SHOW_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    FILINFO fno;
+    if(f_stat(frame_path, &fno) != FR_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if(DATA_OFFSET + (uint32_t)fno.fsize > part->size) {
+        ESP_LOGW(TAG, "%s (%lu bytes) does not fit in %lu byte partition", frame_path, (unsigned long)fno.fsize, (unsigned long)(part->size - DATA_OFFSET));
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    /* -------- 1. copy when stale -------- */
+    show_flash_header_t h;
+    esp_err_t err = esp_partition_read(part, 0, &h, sizeof(h));
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    bool copied = false;
+    if(!header_matches(&h, &fno)) {
+        ESP_LOGI(TAG, "copying %s to flash (%lu bytes) ...", frame_path, (unsigned long)fno.fsize);
+        err = copy_from_sd(frame_path, &fno, &h);
+        if(err != ESP_OK) {
+            return err;
+        }
+        copied = true;
+    }
+
+    /* -------- 2. map -------- */
+    const void* ptr;
+    err = esp_partition_mmap(part, DATA_OFFSET, h.frame.size, ESP_PARTITION_MMAP_DATA, &ptr, &map_handle);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "mmap failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    mapped = true;
+
+    /* -------- 3. read back once after copying -------- */
+    if(copied && esp_rom_crc32_le(0, (const uint8_t*)ptr, h.frame.size) != h.frame.crc32) {
+        ESP_LOGE(TAG, "flash copy crc mismatch");
+        show_flash_unload();
+        esp_partition_erase_range(part, 0, SECTOR_SIZE);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    *data = (const uint8_t*)ptr;
+    *size = h.frame.size;
+
+    ESP_LOGI(TAG, "frame.dat mapped from flash (%lu bytes, crc32=%08lx)", (unsigned long)h.frame.size, (unsigned long)h.frame.crc32);
+    return ESP_OK;
+}
+
+void show_flash_unload(void) {
+    if(!mapped)
+        return;
+
+    esp_partition_munmap(map_handle);
+    mapped = false;
+}
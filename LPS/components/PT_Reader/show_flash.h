@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Show Flash (frame.dat 複製到 flash data partition 並 mmap 播放)
+ *
+ * partition（label "show"，見 partitions.csv）layout：
+ *
+ *   0x0000  header: [magic "PTSF"][version][reserved x3]
+ *                   frame.dat: [size][fdate][ftime][crc32]
+ *                   [crc32 of all previous bytes]
+ *   0x1000  frame.dat 原始內容
+ *
+ * SD 上的 frame.dat 與 header 記錄的 size / fdate / ftime 不同時重新複製，
+ * header 最後寫入，複製中斷時下次開機會再複製一次。
+ * 放不下或沒有 partition 時回傳錯誤，由 caller 改用 SD 播放。
+ * ============================================================ */
+
+/**
+ * @brief 確認 partition 內的 frame.dat 為最新（必要時從 SD 複製），並 mmap
+ *
+ * @param frame_path  SD 上的 frame.dat 路徑（例如 "0:/frame.dat"）
+ * @param[out] data   mmap 後 frame.dat 的起始位址（含 version header）
+ * @param[out] size   frame.dat 長度
+ *
+ * @return
+ *   - ESP_OK                成功
+ *   - ESP_ERR_NOT_FOUND     沒有 show partition 或 SD 上沒有 frame.dat
+ *   - ESP_ERR_INVALID_SIZE  frame.dat 放不下
+ *   - ESP_ERR_INVALID_CRC   複製後 CRC 不符
+ *   - ESP_ERR_INVALID_STATE 已經 mmap
+ *   - ESP_FAIL              其他 I/O 錯誤
+ */
+esp_err_t show_flash_load(const char* frame_path, const uint8_t** data, uint32_t* size);
+
+/**
+ * @brief 解除 mmap（未 load 時呼叫不會出錯）
+ */
+void show_flash_unload(void);
+
+#ifdef __cplusplus
+}
+#endif
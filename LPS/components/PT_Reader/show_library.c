@@ -0,0 +1,116 @@
+#include "show_library.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "ff.h"
+#include "ld_config.h"
+
+static const char* TAG = "show_library";
+
+#define LINE_MAX_LEN 128
+
+static show_entry_t entries[LD_CFG_SHOW_LIBRARY_MAX];
+static uint8_t entry_count = 0;
+
+/* ================= helpers ================= */
+
+static show_entry_t* find(uint8_t id) {
+    for(int i = 0; i < entry_count; i++) {
+        if(entries[i].id == id)
+            return &entries[i];
+    }
+    return NULL;
+}
+
+static esp_err_t put(uint8_t id, const char* control_path, const char* frame_path) {
+    if(strlen(control_path) >= SHOW_LIBRARY_PATH_MAX || strlen(frame_path) >= SHOW_LIBRARY_PATH_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    show_entry_t* e = find(id);
+    if(!e) {
+        if(entry_count >= LD_CFG_SHOW_LIBRARY_MAX)
+            return ESP_ERR_NO_MEM;
+        e = &entries[entry_count++];
+    }
+
+    e->id = id;
+    strcpy(e->control_path, control_path);
+    strcpy(e->frame_path, frame_path);
+    return ESP_OK;
+}
+
+/* "<id> <control> <frame>", returns false for blank / comment / malformed lines */
+static bool parse_line(char* line, int lineno) {
+    char* save = NULL;
+    char* id_str = strtok_r(line, " \t\r\n", &save);
+    if(!id_str || id_str[0] == '#')
+        return false;
+
+    char* control_path = strtok_r(NULL, " \t\r\n", &save);
+    char* frame_path = strtok_r(NULL, " \t\r\n", &save);
+    char* end = NULL;
+    long id = strtol(id_str, &end, 10);
+
+    if(!control_path || !frame_path || *end != '\0' || id < 0 || id > UINT8_MAX) {
+        ESP_LOGW(TAG, "line %d malformed, skipped", lineno);
+        return false;
+    }
+    if(id == 0) {
+        ESP_LOGW(TAG, "line %d: show 0 is the boot show, skipped", lineno);
+        return false;
+    }
+
+    esp_err_t err = put((uint8_t)id, control_path, frame_path);
+    if(err != ESP_OK) {
+        ESP_LOGW(TAG, "line %d: show %ld not added (%s)", lineno, id, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+/* ================= public API ================= */
+
+esp_err_t show_library_load(const char* index_path, const char* default_control, const char* default_frame) {
+    if(!index_path || !default_control || !default_frame) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    entry_count = 0;
+    if(put(0, default_control, default_frame) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FIL fp;
+    if(f_open(&fp, index_path, FA_READ) != FR_OK) {
+        ESP_LOGI(TAG, "no %s, single show library", index_path);
+        return ESP_OK;
+    }
+
+    char line[LINE_MAX_LEN];
+    int lineno = 0;
+    while(f_gets(line, sizeof(line), &fp)) {
+        parse_line(line, ++lineno);
+    }
+    f_close(&fp);
+
+    ESP_LOGI(TAG, "%u shows in %s", (unsigned)entry_count, index_path);
+    return ESP_OK;
+}
+
+esp_err_t show_library_get(uint8_t id, show_entry_t* out) {
+    show_entry_t* e = find(id);
+    if(!e || !out) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    *out = *e;
+    return ESP_OK;
+}
+
+uint8_t show_library_count(void) {
+    return entry_count;
+}
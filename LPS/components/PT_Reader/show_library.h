@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Show Library
+ *
+ * SD 上的 index 檔（預設 "0:/shows.idx"，見 LD_CFG_SHOW_LIBRARY_PATH）
+ * 每行一個 show，以空白分隔：
+ *
+ *   # id  control              frame
+ *   1     0:/song1/control.dat 0:/song1/frame.dat
+ *   2     0:/song2/control.dat 0:/song2/frame.dat
+ *
+ * '#' 開頭為註解。show 0 固定為 frame_system_init 的路徑，index 內的 0 會被略過；
+ * 沒有 index 檔時只有 show 0。
+ * FatFs 未開 LFN，路徑須為 8.3 格式。
+ * ============================================================ */
+
+#define SHOW_LIBRARY_PATH_MAX 48
+
+typedef struct {
+    uint8_t id;
+    char control_path[SHOW_LIBRARY_PATH_MAX];
+    char frame_path[SHOW_LIBRARY_PATH_MAX];
+} show_entry_t;
+
+/**
+ * @brief 讀取 index 檔；show 0 預設為 default_control / default_frame
+ *
+ * @return
+ *   - ESP_OK               成功（index 不存在也算成功，只有 show 0）
+ *   - ESP_ERR_INVALID_ARG  參數為 NULL 或 default 路徑過長
+ */
+esp_err_t show_library_load(const char* index_path, const char* default_control, const char* default_frame);
+
+/**
+ * @brief 查詢 show
+ *
+ * @return
+ *   - ESP_OK             成功
+ *   - ESP_ERR_NOT_FOUND  沒有這個 id
+ */
+esp_err_t show_library_get(uint8_t id, show_entry_t* out);
+
+/**
+ * @brief 目前 library 內的 show 數量
+ */
+uint8_t show_library_count(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,114 @@
+#include "show_profile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "ld_config.h"
+
+static const char* TAG = "show_profile";
+
+#define FPS_TICK_MS (1000 / LD_CFG_PLAYER_FPS)
+
+/* ================= helpers ================= */
+
+static uint32_t gcd_u32(uint32_t a, uint32_t b) {
+    while(b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* largest d <= limit dividing n, 1 if none is larger */
+static uint32_t divisor_at_most(uint32_t n, uint32_t limit) {
+    for(uint32_t d = limit; d > 1; d--) {
+        if(n % d == 0)
+            return d;
+    }
+    return 1;
+}
+
+static uint32_t clamp_u32(uint32_t v, uint32_t lo, uint32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+/* ================= statistics ================= */
+
+void show_profile_begin(show_profile_t* p) {
+    memset(p, 0, sizeof(*p));
+    p->fade_frames = SHOW_PROFILE_FADE_UNKNOWN;
+}
+
+void show_profile_add(show_profile_t* p, uint32_t ts_ms) {
+    if(p->frames > 0) {
+        uint32_t gap = ts_ms >= p->last_ms ? ts_ms - p->last_ms : 0;
+        if(p->frames == 1 || gap < p->min_interval_ms)
+            p->min_interval_ms = gap;
+    }
+    p->grid_ms = gcd_u32(p->grid_ms, ts_ms);
+
+    p->ring[p->head] = ts_ms;
+    p->head = (p->head + 1) % SHOW_PROFILE_BURST_MAX;
+
+    /* frames in (ts - cover, ts], newest first */
+    uint32_t kept = p->frames + 1 < SHOW_PROFILE_BURST_MAX ? p->frames + 1 : SHOW_PROFILE_BURST_MAX;
+    uint32_t in_window = 0;
+    for(uint32_t i = 0; i < kept; i++) {
+        uint32_t t = p->ring[(p->head + SHOW_PROFILE_BURST_MAX - 1 - i) % SHOW_PROFILE_BURST_MAX];
+        if(t > ts_ms || ts_ms - t >= LD_CFG_PT_READER_PREFETCH_COVER_MS)
+            break;
+        in_window++;
+    }
+    if(in_window > p->burst_frames)
+        p->burst_frames = in_window;
+
+    p->last_ms = ts_ms;
+    p->frames++;
+}
+
+/* ================= plan ================= */
+
+static uint32_t plan_tick_ms(const show_profile_t* p) {
+#if LD_CFG_PLAYER_AUTO_TICK
+    /* an unread show may fade anywhere */
+    bool fades = p->fade_frames != 0;
+    uint32_t limit = fades ? FPS_TICK_MS : LD_CFG_PLAYER_TICK_MAX_MS;
+
+    /* every frame lands on a tick */
+    if(p->grid_ms >= LD_CFG_PLAYER_TICK_MIN_MS) {
+        uint32_t tick = p->grid_ms <= limit ? p->grid_ms : divisor_at_most(p->grid_ms, limit);
+        if(tick >= LD_CFG_PLAYER_TICK_MIN_MS)
+            return tick;
+    }
+
+    /* irregular timestamps: the default rate, faster if frames come closer than that */
+    if(p->frames > 1 && p->min_interval_ms < FPS_TICK_MS)
+        return clamp_u32(p->min_interval_ms, LD_CFG_PLAYER_TICK_MIN_MS, FPS_TICK_MS);
+#else
+    (void)p;
+#endif
+    return FPS_TICK_MS;
+}
+
+void show_profile_plan(const show_profile_t* p, bool streaming, show_plan_t* out) {
+    out->tick_us = plan_tick_ms(p) * 1000;
+    /* above 100% tempo the window holds more show time, round up */
+    uint32_t burst = (p->burst_frames * LD_CFG_PLAYER_TEMPO_MAX_PCT + 99) / 100;
+    out->prefetch = streaming ? (uint8_t)clamp_u32(burst, 1, LD_CFG_PT_READER_PREFETCH_MAX) : 1;
+}
+
+void show_profile_log(const show_profile_t* p, uint32_t frame_bytes, const show_plan_t* plan) {
+    /* worst case: every frame in the densest window is a full KEY frame */
+    uint32_t burst_kbps = (uint32_t)((uint64_t)p->burst_frames * frame_bytes * 1000 / LD_CFG_PT_READER_PREFETCH_COVER_MS / 1024);
+
+    char fades[24];
+    if(p->fade_frames == SHOW_PROFILE_FADE_UNKNOWN)
+        strcpy(fades, "?");
+    else
+        snprintf(fades, sizeof(fades), "%lu", (unsigned long)p->fade_frames);
+
+    ESP_LOGI(TAG, "%lu frames over %lu ms, min interval %lu ms, grid %lu ms, fades %s, burst %lu frames / %d ms (%lu KB/s) -> tick %lu us, prefetch %u", (unsigned long)p->frames,
+             (unsigned long)p->last_ms, (unsigned long)p->min_interval_ms, (unsigned long)p->grid_ms, fades, (unsigned long)p->burst_frames, LD_CFG_PT_READER_PREFETCH_COVER_MS,
+             (unsigned long)burst_kbps, (unsigned long)plan->tick_us, (unsigned)plan->prefetch);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Show Profile (load-time tuning)
+ *
+ * 開啟 show 時 control_reader 逐一餵入 control.dat 的 timestamp，統計：
+ *
+ *   - min interval：相鄰兩個 frame 的最短間隔
+ *   - grid：所有 timestamp 的最大公因數（frame 都落在 grid 的整數倍上）
+ *   - burst：任一 LD_CFG_PT_READER_PREFETCH_COVER_MS 區間內最多有幾個 frame
+ *   - fade：需要內插的 frame 數（由 show_verify 的完整讀取計算並存在 marker）
+ *
+ * 再由 show_profile_plan() 決定：
+ *
+ *   - tick：Player metronome 週期，盡量取 grid 的因數讓 frame 準時出現；
+ *           有 fade 時不超過 LD_CFG_PLAYER_FPS 的週期，沒有 fade 時最多
+ *           LD_CFG_PLAYER_TICK_MAX_MS
+ *   - prefetch：SD reader task 預讀的 frame 數，要能撐過一次
+ *           LD_CFG_PT_READER_PREFETCH_COVER_MS 的 SD 停頓；依最快的 tempo
+ *           （LD_CFG_PLAYER_TEMPO_MAX_PCT）放大，較慢的 tempo 可撐更久
+ *           （RAM / flash 來源沒有停頓，固定為 1）
+ * ============================================================ */
+
+/** Timestamps kept for the burst window; bursts are counted up to this many frames. */
+#define SHOW_PROFILE_BURST_MAX 64
+
+/** fade_frames value when the frames were not read (no verify pass). */
+#define SHOW_PROFILE_FADE_UNKNOWN UINT32_MAX
+
+typedef struct {
+    uint32_t frames;
+    uint32_t last_ms;         /*!< timestamp of the last frame */
+    uint32_t min_interval_ms; /*!< shortest gap between two frames, 0 with fewer than 2 frames */
+    uint32_t grid_ms;         /*!< gcd of all timestamps, 0 when they are all 0 */
+    uint32_t burst_frames;    /*!< most frames in any LD_CFG_PT_READER_PREFETCH_COVER_MS window */
+    uint32_t fade_frames;     /*!< frames with fade set or an effect running, or SHOW_PROFILE_FADE_UNKNOWN */
+
+    /* burst window, oldest entry at ring[head] once full */
+    uint32_t ring[SHOW_PROFILE_BURST_MAX];
+    uint32_t head;
+} show_profile_t;
+
+typedef struct {
+    uint32_t tick_us;  /*!< Player metronome period */
+    uint8_t prefetch;  /*!< frames the reader task buffers ahead */
+} show_plan_t;
+
+/**
+ * @brief 清空統計（fade_frames 設為 unknown）
+ */
+void show_profile_begin(show_profile_t* p);
+
+/**
+ * @brief 加入下一個 frame 的 timestamp（依 control.dat 順序）
+ */
+void show_profile_add(show_profile_t* p, uint32_t ts_ms);
+
+/**
+ * @brief 由統計決定 tick 與 prefetch（LD_CFG_PLAYER_AUTO_TICK 為 0 時 tick 固定為 LD_CFG_PLAYER_FPS）
+ *
+ * @param  streaming  frame.dat 是否從 SD 串流
+ */
+void show_profile_plan(const show_profile_t* p, bool streaming, show_plan_t* out);
+
+/**
+ * @brief 以一行 log 輸出統計、最壞情況的讀取頻寬與選定的 plan
+ *
+ * @param  frame_bytes  每個 frame 最多讀取的 bytes（frame_reader_frame_size()）
+ */
+void show_profile_log(const show_profile_t* p, uint32_t frame_bytes, const show_plan_t* plan);
+
+#ifdef __cplusplus
+}
+#endif
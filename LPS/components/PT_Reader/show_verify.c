@@ -0,0 +1,254 @@
+#include "show_verify.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "ff.h"
+
+#include "frame_reader.h"
+#include "pt_format.h"
+
+static const char* TAG = "show_verify";
+
+#define MARKER_MAGIC 0x46565450u /* "PTVF" little-endian */
+#define MARKER_VERSION 2
+#define MARKER_EXT ".vfy"
+#define MARKER_PATH_MAX 64
+#define CRC_CHUNK_SIZE 4096
+
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t reserved[3];
+    show_file_stamp_t control;
+    show_file_stamp_t frame;
+    show_verify_info_t info;
+    uint32_t crc32;
+} show_marker_t;
+
+/* ================= helpers ================= */
+
+/* "0:/frame.dat" -> "0:/frame.vfy" (8.3 names, no LFN) */
+static esp_err_t marker_path(const char* frame_path, char* out, size_t out_len) {
+    const char* slash = strrchr(frame_path, '/');
+    const char* dot = strrchr(frame_path, '.');
+    size_t stem_len = (dot && (!slash || dot > slash)) ? (size_t)(dot - frame_path) : strlen(frame_path);
+
+    if(stem_len + strlen(MARKER_EXT) + 1 > out_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memcpy(out, frame_path, stem_len);
+    strcpy(out + stem_len, MARKER_EXT);
+    return ESP_OK;
+}
+
+static esp_err_t stat_file(const char* path, show_file_stamp_t* out) {
+    FILINFO fno;
+    FRESULT fr = f_stat(path, &fno);
+    if(fr != FR_OK) {
+        return (fr == FR_NO_FILE || fr == FR_NO_PATH) ? ESP_ERR_NOT_FOUND : ESP_FAIL;
+    }
+
+    out->size = (uint32_t)fno.fsize;
+    out->fdate = fno.fdate;
+    out->ftime = fno.ftime;
+    return ESP_OK;
+}
+
+static esp_err_t crc_file(const char* path, uint8_t* chunk, uint32_t* out) {
+    FIL fp;
+    UINT br;
+    uint32_t crc = 0;
+
+    if(f_open(&fp, path, FA_READ) != FR_OK) {
+        ESP_LOGE(TAG, "open %s failed", path);
+        return ESP_FAIL;
+    }
+
+    do {
+        if(f_read(&fp, chunk, CRC_CHUNK_SIZE, &br) != FR_OK) {
+            f_close(&fp);
+            return ESP_FAIL;
+        }
+        crc = esp_rom_crc32_le(crc, chunk, br);
+    } while(br == CRC_CHUNK_SIZE);
+
+    f_close(&fp);
+    *out = crc;
+    return ESP_OK;
+}
+
+static uint32_t marker_crc(const show_marker_t* m) {
+    return esp_rom_crc32_le(0, (const uint8_t*)m, offsetof(show_marker_t, crc32));
+}
+
+static bool stamp_matches(const show_file_stamp_t* a, const show_file_stamp_t* b) {
+    return a->size == b->size && a->fdate == b->fdate && a->ftime == b->ftime;
+}
+
+/* ================= public API ================= */
+
+esp_err_t show_verify_check(const char* control_path, const char* frame_path, show_verify_info_t* info) {
+    if(!control_path || !frame_path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char path[MARKER_PATH_MAX];
+    if(marker_path(frame_path, path, sizeof(path)) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FIL fp;
+    UINT br;
+    show_marker_t m;
+
+    if(f_open(&fp, path, FA_READ) != FR_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    FRESULT fr = f_read(&fp, &m, sizeof(m), &br);
+    f_close(&fp);
+
+    if(fr != FR_OK || br != sizeof(m) || m.magic != MARKER_MAGIC || m.version != MARKER_VERSION) {
+        ESP_LOGW(TAG, "marker %s unreadable", path);
+        return ESP_ERR_INVALID_CRC;
+    }
+    if(m.crc32 != marker_crc(&m)) {
+        ESP_LOGW(TAG, "marker %s corrupted", path);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    show_file_stamp_t control, frame;
+    if(stat_file(control_path, &control) != ESP_OK || stat_file(frame_path, &frame) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if(!stamp_matches(&control, &m.control) || !stamp_matches(&frame, &m.frame)) {
+        ESP_LOGI(TAG, "marker %s is stale", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if(info)
+        *info = m.info;
+
+    ESP_LOGI(TAG, "show verified (frame.dat crc32=%08lx)", (unsigned long)m.frame.crc32);
+    return ESP_OK;
+}
+
+esp_err_t show_verify_run(const char* control_path, const char* frame_path, show_verify_info_t* info) {
+    if(!control_path || !frame_path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char path[MARKER_PATH_MAX];
+    if(marker_path(frame_path, path, sizeof(path)) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err;
+    show_marker_t m;
+    memset(&m, 0, sizeof(m));
+    m.magic = MARKER_MAGIC;
+    m.version = MARKER_VERSION;
+
+    ESP_LOGI(TAG, "verifying %s + %s ...", control_path, frame_path);
+
+    /* -------- 1. whole-file stamps -------- */
+    uint8_t* chunk = (uint8_t*)malloc(CRC_CHUNK_SIZE);
+    if(!chunk) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    err = stat_file(control_path, &m.control);
+    if(err == ESP_OK)
+        err = stat_file(frame_path, &m.frame);
+    if(err == ESP_OK)
+        err = crc_file(control_path, chunk, &m.control.crc32);
+    if(err == ESP_OK)
+        err = crc_file(frame_path, chunk, &m.frame.crc32);
+    free(chunk);
+
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "stamp failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    /* -------- 2. per-frame checksums -------- */
+    table_frame_t* scratch = (table_frame_t*)malloc(sizeof(table_frame_t));
+    if(!scratch) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    err = frame_reader_init(frame_path);
+    if(err != ESP_OK) {
+        free(scratch);
+        return err;
+    }
+    frame_reader_set_verify(true);
+
+    uint32_t frames = 0;
+    while((err = frame_reader_read(scratch)) == ESP_OK) {
+        frames++;
+        if(scratch->fade || scratch->effect_count)
+            m.info.fade_frames++;
+    }
+    m.info.frames = frames;
+
+    uint32_t end = frame_reader_tell();
+    frame_reader_deinit();
+    free(scratch);
+
+    if(err != ESP_ERR_NOT_FOUND) {
+        ESP_LOGE(TAG, "frame %lu failed: %s", (unsigned long)frames, esp_err_to_name(err));
+        return err;
+    }
+
+    if(end != m.frame.size) {
+        ESP_LOGE(TAG, "frame.dat size %lu != %lu bytes in %lu frames (truncated?)", (unsigned long)m.frame.size, (unsigned long)end, (unsigned long)frames);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    /* the show itself is fine from here on, even if the marker cannot be written */
+    if(info)
+        *info = m.info;
+
+    /* -------- 3. write marker -------- */
+    m.crc32 = marker_crc(&m);
+
+    FIL fp;
+    UINT bw;
+    if(f_open(&fp, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        ESP_LOGE(TAG, "create %s failed", path);
+        return ESP_FAIL;
+    }
+    FRESULT fr = f_write(&fp, &m, sizeof(m), &bw);
+    f_close(&fp);
+
+    if(fr != FR_OK || bw != sizeof(m)) {
+        ESP_LOGE(TAG, "write %s failed", path);
+        f_unlink(path);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "show verified: %lu frames, frame.dat crc32=%08lx, marker %s", (unsigned long)frames, (unsigned long)m.frame.crc32, path);
+    return ESP_OK;
+}
+
+esp_err_t show_verify_invalidate(const char* frame_path) {
+    if(!frame_path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char path[MARKER_PATH_MAX];
+    if(marker_path(frame_path, path, sizeof(path)) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FRESULT fr = f_unlink(path);
+    if(fr != FR_OK && fr != FR_NO_FILE) {
+        ESP_LOGW(TAG, "unlink %s failed (fr=%d)", path, fr);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
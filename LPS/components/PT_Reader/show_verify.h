@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Show Verification (verify once, play many)
+ *
+ * 第一次開機（或上傳新光表後）對 control.dat / frame.dat 做一次
+ * 完整檢查，成功後在 frame.dat 旁寫入 marker（例如 "0:/frame.vfy"）：
+ *
+ *   [magic "PTVF"][version][reserved x3]
+ *   control.dat: [size][fdate][ftime][crc32]
+ *   frame.dat  : [size][fdate][ftime][crc32]
+ *   [frames][fade frames]
+ *   [crc32 of all previous bytes]
+ *
+ * 之後開機只比對 size / fdate / ftime，相符即視為已驗證，
+ * 播放時 frame_reader 跳過每個 frame 的 checksum。
+ * frame / fade 數量給 show_profile 使用，不必再讀一次 frame.dat。
+ * ============================================================ */
+
+/** Per-file stamp stored in the marker. */
+typedef struct {
+    uint32_t size;  /*!< file size in bytes */
+    uint16_t fdate; /*!< FatFs modified date */
+    uint16_t ftime; /*!< FatFs modified time */
+    uint32_t crc32; /*!< CRC32 of the whole file */
+} show_file_stamp_t;
+
+/** Frame statistics gathered by the verification pass and kept in the marker. */
+typedef struct {
+    uint32_t frames;      /*!< frames in frame.dat */
+    uint32_t fade_frames; /*!< frames with fade set or an effect running (v1.9), both need every tick */
+} show_verify_info_t;
+
+/**
+ * @brief 檢查 marker 是否存在且與目前檔案相符
+ *
+ * @param[out] info  marker 內的 frame 統計（可為 NULL），只在 ESP_OK 時填入
+ *
+ * @return
+ *   - ESP_OK                marker 有效，show 已驗證
+ *   - ESP_ERR_NOT_FOUND     marker 不存在或已過期（檔案有變動）
+ *   - ESP_ERR_INVALID_CRC   marker 本身損毀
+ *   - ESP_ERR_INVALID_ARG   path 為 NULL
+ */
+esp_err_t show_verify_check(const char* control_path, const char* frame_path, show_verify_info_t* info);
+
+/**
+ * @brief 完整驗證 show 並寫入 marker
+ *
+ * 前置條件：ch_info_snapshot 已由 control.dat 載入，frame_reader 未開啟。
+ * 會逐 frame 驗證 checksum，並計算兩個檔案的 whole-file CRC32。
+ *
+ * @param[out] info  frame 統計（可為 NULL），所有 frame 通過後即填入，
+ *                   即使之後 marker 寫入失敗（ESP_FAIL）
+ *
+ * @return
+ *   - ESP_OK                驗證通過且 marker 已寫入
+ *   - ESP_ERR_INVALID_CRC   某個 frame checksum 錯誤
+ *   - ESP_ERR_INVALID_SIZE  frame.dat 長度與讀到的 frame 不符（檔案截斷）
+ *   - ESP_ERR_NO_MEM        記憶體不足
+ *   - ESP_FAIL              I/O 錯誤
+ */
+esp_err_t show_verify_run(const char* control_path, const char* frame_path, show_verify_info_t* info);
+
+/**
+ * @brief 刪除 marker（上傳新檔案時呼叫），不存在時也回傳 ESP_OK
+ */
+esp_err_t show_verify_invalidate(const char* frame_path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,485 @@
+#include "track_merge.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "ld_board.h"
+#include "ld_ease.h"
+#include "ld_frame.h"
+#include "ld_led_ops.h"
+#include "pt_format.h"
+#include "readframe.h"  // ch_info_snapshot
+
+static const char* TAG = "track_merge";
+
+/* current key + pending keys */
+#define TRACK_SLOTS (1 + TRACK_MERGE_PENDING_MAX)
+
+typedef struct {
+    uint32_t ts;
+    uint8_t fade;
+    uint8_t ease; /* v1.8 curve of the fade, ld_ease.h */
+    uint8_t slot;
+    bool effect;    /* v1.9 EFFECT key: fx instead of the values in slot */
+    ld_effect_t fx;
+} track_key_t;
+
+/* bytes [offset, offset + len) of the payload */
+typedef struct {
+    uint16_t offset;
+    uint16_t len;
+} range_t;
+
+typedef struct {
+    uint64_t mask;
+    uint32_t len;          /* payload bytes owned by this track */
+    uint8_t first_range;
+    uint8_t range_count;
+    uint8_t* vals;         /* TRACK_SLOTS x len */
+
+    track_key_t active;
+    bool has_active;
+    track_key_t pending[TRACK_MERGE_PENDING_MAX];
+    uint8_t pending_count;
+
+    /* last key pushed, for the need time of the next one */
+    bool has_last;
+    uint32_t last_ts;
+    uint8_t last_fade;
+
+    /* after a seek: keys up to last_ts were restated by the SYNC group */
+    bool restated;
+} track_t;
+
+static track_t g_tracks[PT_TRACK_MAX];
+static range_t g_ranges[PT_TRACK_MAX];
+static uint8_t g_track_count = 0;
+static uint32_t g_payload_size = 0;
+static uint8_t* g_vals = NULL;
+static uint8_t* g_last = NULL; /* latest key value of every channel, g_payload_size bytes */
+
+static bool g_pushed = false;
+static uint32_t g_last_need = 0;
+static bool g_eof = false;
+static uint32_t g_floor = 0; /* after a seek: keys before the SYNC time are skipped */
+
+/* ================= init / deinit ================= */
+
+/* append [offset, offset + len) to track t, merging with its previous range */
+static void add_range(track_t* t, uint8_t* range_count, uint32_t offset, uint32_t len) {
+    if(len == 0)
+        return;
+    if(t->range_count) {
+        range_t* last = &g_ranges[t->first_range + t->range_count - 1];
+        if(last->offset + last->len == offset) {
+            last->len += len;
+            t->len += len;
+            return;
+        }
+    }
+    g_ranges[*range_count] = (range_t){.offset = (uint16_t)offset, .len = (uint16_t)len};
+    (*range_count)++;
+    t->range_count++;
+    t->len += len;
+}
+
+esp_err_t track_merge_init(const uint8_t* masks, uint8_t track_count, uint32_t payload_size) {
+    track_merge_deinit();
+
+    if(track_count == 0 || track_count > PT_TRACK_MAX) {
+        ESP_LOGE(TAG, "invalid track count %u", track_count);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint64_t seen = 0;
+    for(uint8_t i = 0; i < track_count; i++) {
+        uint64_t mask = pt_read_u64_le(masks + i * PT_TRACK_MASK_SIZE);
+        if((mask & ~LD_FRAME_FADE_ALL) || (mask & seen)) {
+            ESP_LOGE(TAG, "track %u: mask %016llx overlaps another track or names no channel", i, (unsigned long long)mask);
+            return ESP_ERR_INVALID_ARG;
+        }
+        seen |= mask;
+        memset(&g_tracks[i], 0, sizeof(g_tracks[i]));
+        g_tracks[i].mask = mask;
+    }
+
+    /* channel ranges in payload order, grouped per track */
+    uint8_t range_count = 0;
+    for(uint8_t i = 0; i < track_count; i++) {
+        track_t* t = &g_tracks[i];
+        uint32_t offset = 0;
+        t->first_range = range_count;
+
+        for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
+            if(!ch_info_snapshot.i2c_leds[ch])
+                continue;
+            if(t->mask & LD_FRAME_FADE_PCA9955B(ch))
+                add_range(t, &range_count, offset, 3);
+            offset += 3;
+        }
+        for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+            uint32_t len = (uint32_t)ch_info_snapshot.rmt_strips[s] * 3;
+            if(t->mask & LD_FRAME_FADE_WS2812B(s))
+                add_range(t, &range_count, offset, len);
+            offset += len;
+        }
+    }
+
+    /* every channel belongs to at most one track: TRACK_SLOTS x payload at most, plus g_last */
+    uint32_t total = payload_size;
+    for(uint8_t i = 0; i < track_count; i++)
+        total += g_tracks[i].len * TRACK_SLOTS;
+
+    g_vals = malloc(total ? total : 1);
+    if(!g_vals) {
+        ESP_LOGE(TAG, "no memory for %u tracks (%lu bytes)", track_count, (unsigned long)total);
+        return ESP_ERR_NO_MEM;
+    }
+    g_last = g_vals;
+    uint8_t* p = g_vals + payload_size;
+    for(uint8_t i = 0; i < track_count; i++) {
+        g_tracks[i].vals = p;
+        p += g_tracks[i].len * TRACK_SLOTS;
+    }
+
+    g_track_count = track_count;
+    g_payload_size = payload_size;
+    track_merge_reset();
+
+    ESP_LOGI(TAG, "%u tracks, %lu bytes of key buffers", track_count, (unsigned long)total);
+    return ESP_OK;
+}
+
+void track_merge_deinit(void) {
+    free(g_vals);
+    g_vals = NULL;
+    g_last = NULL;
+    g_track_count = 0;
+}
+
+void track_merge_reset(void) {
+    for(uint8_t i = 0; i < g_track_count; i++) {
+        track_t* t = &g_tracks[i];
+        t->has_active = false;
+        t->pending_count = 0;
+        t->has_last = false;
+        t->restated = false;
+    }
+    if(g_last)
+        memset(g_last, 0, g_payload_size);
+    g_pushed = false;
+    g_last_need = 0;
+    g_eof = false;
+    g_floor = 0;
+}
+
+void track_merge_seek(uint32_t ts) {
+    for(uint8_t i = 0; i < g_track_count; i++)
+        g_tracks[i].restated = g_tracks[i].has_last;
+    g_floor = ts;
+}
+
+const uint8_t* track_merge_last(void) {
+    return g_last;
+}
+
+/* ================= merge ================= */
+
+/* earliest pending key over all tracks */
+static bool next_time(uint32_t* ts) {
+    bool found = false;
+    for(uint8_t i = 0; i < g_track_count; i++) {
+        const track_t* t = &g_tracks[i];
+        if(t->pending_count && (!found || t->pending[0].ts < *ts)) {
+            *ts = t->pending[0].ts;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool track_merge_need_record(void) {
+    if(g_eof)
+        return false;
+
+    /* a record not read yet has need time >= g_last_need, so it cannot start before then */
+    uint32_t ts = 0;
+    if(!g_pushed || !next_time(&ts))
+        return true;
+    return g_last_need <= ts;
+}
+
+static uint8_t free_slot(const track_t* t) {
+    uint8_t used = t->has_active ? (uint8_t)(1u << t->active.slot) : 0;
+    for(uint8_t i = 0; i < t->pending_count; i++)
+        used |= (uint8_t)(1u << t->pending[i].slot);
+
+    uint8_t slot = 0;
+    while(used & (1u << slot))
+        slot++;
+    return slot;
+}
+
+/* after a seek: a key the SYNC group already gave, or one from before the SYNC time */
+static bool seek_skips(const track_t* t, uint32_t start_time) {
+    return start_time < g_floor || (t->restated && start_time <= t->last_ts);
+}
+
+/* room and time order of a new key on t; *need is its need time */
+static bool check_key(const track_t* t, uint8_t index, uint32_t start_time, uint32_t* need) {
+    if(t->has_last && start_time <= t->last_ts) {
+        ESP_LOGE(TAG, "track %u: key at %lu after %lu", index, (unsigned long)start_time, (unsigned long)t->last_ts);
+        return false;
+    }
+    if(t->pending_count == TRACK_MERGE_PENDING_MAX) {
+        ESP_LOGE(TAG, "track %u: key at %lu out of order", index, (unsigned long)start_time);
+        return false;
+    }
+    *need = (t->has_last && t->last_fade) ? t->last_ts : start_time;
+    return true;
+}
+
+/* append a checked key to t */
+static track_key_t* add_key(track_t* t, uint32_t start_time, uint8_t fade) {
+    uint8_t slot = free_slot(t);
+    track_key_t* k = &t->pending[t->pending_count++];
+    memset(k, 0, sizeof(*k));
+    k->ts = start_time;
+    k->fade = fade;
+    k->slot = slot;
+
+    t->has_last = true;
+    t->last_ts = start_time;
+    t->last_fade = fade;
+    t->restated = false;
+    return k;
+}
+
+/* checks shared by TRACK and EFFECT keys; the new key is t->pending[t->pending_count - 1] */
+static track_key_t* push_key(track_t* t, uint8_t index, uint32_t start_time, uint8_t fade) {
+    uint32_t need;
+    if(!check_key(t, index, start_time, &need))
+        return NULL;
+    if(g_pushed && need < g_last_need) {
+        ESP_LOGE(TAG, "track %u: key at %lu out of order", index, (unsigned long)start_time);
+        return NULL;
+    }
+
+    track_key_t* k = add_key(t, start_time, fade);
+    g_pushed = true;
+    g_last_need = need;
+    return k;
+}
+
+/* copy a track's values into (or clear) its channels of g_last */
+static void set_last(const track_t* t, const uint8_t* vals) {
+    for(uint8_t r = 0; r < t->range_count; r++) {
+        const range_t* range = &g_ranges[t->first_range + r];
+        if(vals) {
+            memcpy(g_last + range->offset, vals, range->len);
+            vals += range->len;
+        } else {
+            memset(g_last + range->offset, 0, range->len);
+        }
+    }
+}
+
+esp_err_t track_merge_push(uint32_t start_time, uint8_t fade, uint8_t ease, const uint8_t* body, uint32_t body_len) {
+    if(body_len < PT_TRACK_BODY_HEADER_SIZE || body[0] >= g_track_count) {
+        ESP_LOGE(TAG, "TRACK names no track (%u tracks)", g_track_count);
+        return ESP_FAIL;
+    }
+
+    uint8_t index = body[0];
+    track_t* t = &g_tracks[index];
+    if(body_len - PT_TRACK_BODY_HEADER_SIZE != t->len) {
+        ESP_LOGE(TAG, "track %u: body %lu != %lu", index, (unsigned long)(body_len - PT_TRACK_BODY_HEADER_SIZE), (unsigned long)t->len);
+        return ESP_FAIL;
+    }
+
+    if(seek_skips(t, start_time))
+        return ESP_OK;
+
+    track_key_t* k = push_key(t, index, start_time, fade);
+    if(!k)
+        return ESP_FAIL;
+    k->ease = ease;
+    memcpy(t->vals + (uint32_t)k->slot * t->len, body + PT_TRACK_BODY_HEADER_SIZE, t->len);
+    set_last(t, body + PT_TRACK_BODY_HEADER_SIZE);
+    return ESP_OK;
+}
+
+esp_err_t track_merge_push_board(uint32_t start_time, uint8_t fade, uint8_t ease, const uint8_t* payload) {
+    if(start_time < g_floor)
+        return ESP_OK;
+
+    /* one key on every track: needed as soon as the earliest of them */
+    uint32_t need = start_time;
+    for(uint8_t i = 0; i < g_track_count; i++) {
+        uint32_t track_need;
+        if(!check_key(&g_tracks[i], i, start_time, &track_need))
+            return ESP_FAIL;
+        if(track_need < need)
+            need = track_need;
+    }
+    if(g_pushed && need < g_last_need) {
+        ESP_LOGE(TAG, "board key at %lu out of order", (unsigned long)start_time);
+        return ESP_FAIL;
+    }
+
+    for(uint8_t i = 0; i < g_track_count; i++) {
+        track_t* t = &g_tracks[i];
+        track_key_t* k = add_key(t, start_time, fade);
+        k->ease = ease;
+
+        uint8_t* dst = t->vals + (uint32_t)k->slot * t->len;
+        for(uint8_t r = 0; r < t->range_count; r++) {
+            const range_t* range = &g_ranges[t->first_range + r];
+            memcpy(dst, payload + range->offset, range->len);
+            dst += range->len;
+        }
+    }
+    memcpy(g_last, payload, g_payload_size);
+    g_pushed = true;
+    g_last_need = need;
+    return ESP_OK;
+}
+
+esp_err_t track_merge_push_effect(uint32_t start_time, const uint8_t* body, uint32_t body_len) {
+    if(body_len != PT_TRACK_BODY_HEADER_SIZE + PT_EFFECT_SIZE || body[0] >= g_track_count) {
+        ESP_LOGE(TAG, "EFFECT names no track (%u tracks) or has %lu bytes", g_track_count, (unsigned long)body_len);
+        return ESP_FAIL;
+    }
+
+    uint8_t index = body[0];
+    track_t* t = &g_tracks[index];
+    const uint8_t* p = body + PT_TRACK_BODY_HEADER_SIZE;
+    ld_effect_t fx;
+    memset(&fx, 0, sizeof(fx));
+    fx.type = p[0];
+    fx.param = p[1];
+    fx.spread = p[2];
+    fx.period_ms = pt_read_u16_le(p + 3);
+    fx.phase = pt_read_u16_le(p + 5);
+    fx.a = (grb8_t){.g = p[7], .r = p[8], .b = p[9]};
+    fx.b = (grb8_t){.g = p[10], .r = p[11], .b = p[12]};
+    if(!ld_effect_valid(&fx)) {
+        ESP_LOGE(TAG, "track %u: effect type %u, period %u ms", index, fx.type, fx.period_ms);
+        return ESP_FAIL;
+    }
+    if(seek_skips(t, start_time))
+        return ESP_OK;
+    /* a fade needs a color to land on */
+    if(t->has_last && t->last_fade) {
+        ESP_LOGE(TAG, "track %u: key at %lu fades into an effect", index, (unsigned long)t->last_ts);
+        return ESP_FAIL;
+    }
+
+    track_key_t* k = push_key(t, index, start_time, 0);
+    if(!k)
+        return ESP_FAIL;
+    k->effect = true;
+    k->fx = fx;
+    set_last(t, NULL);
+    return ESP_OK;
+}
+
+void track_merge_end(void) {
+    g_eof = true;
+}
+
+/* same p as the Player's calc_lerp_p, t1 <= ts < t2 */
+static uint8_t lerp_p(uint32_t ts, uint32_t t1, uint32_t t2) {
+    return (uint8_t)(((uint64_t)(ts - t1) * 255) / (t2 - t1));
+}
+
+/* write a track's value (or from -> to at p when to is set) into its payload ranges */
+static void scatter(const track_t* t, const uint8_t* from, const uint8_t* to, uint8_t p, uint8_t* payload) {
+    for(uint8_t r = 0; r < t->range_count; r++) {
+        const range_t* range = &g_ranges[t->first_range + r];
+        uint8_t* dst = payload + range->offset;
+
+        if(!to) {
+            memcpy(dst, from, range->len);
+        } else {
+            for(uint32_t i = 0; i < range->len; i += 3) {
+                grb8_t a = {.g = from[i], .r = from[i + 1], .b = from[i + 2]};
+                grb8_t b = {.g = to[i], .r = to[i + 1], .b = to[i + 2]};
+                grb8_t c = grb_lerp_hsv_u8(a, b, p);
+                dst[i] = c.g;
+                dst[i + 1] = c.r;
+                dst[i + 2] = c.b;
+            }
+            to += range->len;
+        }
+        from += range->len;
+    }
+}
+
+esp_err_t track_merge_emit(uint8_t* payload, uint32_t* timestamp, uint64_t* fade_mask, uint8_t* ease, ld_frame_effect_t* effects, uint8_t* effect_count) {
+    uint32_t ts = 0;
+    if(!next_time(&ts))
+        return ESP_ERR_NOT_FOUND;
+
+    uint64_t mask = 0;
+    uint8_t frame_ease = LD_EASE_LINEAR;
+    bool mixed = false;
+    uint8_t fx_count = 0;
+    memset(payload, 0, g_payload_size);
+
+    for(uint8_t i = 0; i < g_track_count; i++) {
+        track_t* t = &g_tracks[i];
+
+        if(t->pending_count && t->pending[0].ts == ts) {
+            t->active = t->pending[0];
+            t->has_active = true;
+            t->pending_count--;
+            memmove(&t->pending[0], &t->pending[1], t->pending_count * sizeof(track_key_t));
+        }
+        if(!t->has_active)
+            continue;
+
+        /* v1.9: the Player renders the effect, its channels stay 0 here */
+        if(t->active.effect) {
+            if(fx_count == LD_FRAME_EFFECT_MAX) {
+                ESP_LOGE(TAG, "more than %d effects at %lu", LD_FRAME_EFFECT_MAX, (unsigned long)ts);
+                return ESP_FAIL;
+            }
+            ld_frame_effect_t* e = &effects[fx_count++];
+            memset(e, 0, sizeof(*e));
+            e->mask = t->mask;
+            e->start_ms = t->active.ts;
+            e->fx = t->active.fx;
+            continue;
+        }
+
+        const uint8_t* from = t->vals + (uint32_t)t->active.slot * t->len;
+        if(!t->active.fade || !t->pending_count) {
+            scatter(t, from, NULL, 0, payload);
+            continue;
+        }
+
+        /* fading towards the next key: bake the point reached at ts, on the key's curve */
+        uint8_t key_ease = LD_EASE_LINEAR;
+        if(t->active.ts == ts) {
+            scatter(t, from, NULL, 0, payload);
+            key_ease = t->active.ease;
+        } else {
+            const uint8_t* to = t->vals + (uint32_t)t->pending[0].slot * t->len;
+            scatter(t, from, to, ld_ease_apply(t->active.ease, lerp_p(ts, t->active.ts, t->pending[0].ts)), payload);
+        }
+
+        /* one curve per frame: the fading tracks' own curve when they all start it here, else linear */
+        if(!mask)
+            frame_ease = key_ease;
+        else if(frame_ease != key_ease)
+            mixed = true;
+        mask |= t->mask;
+    }
+
+    *timestamp = ts;
+    *fade_mask = mask;
+    *ease = mixed ? LD_EASE_LINEAR : frame_ease;
+    *effect_count = fx_count;
+    return ESP_OK;
+}
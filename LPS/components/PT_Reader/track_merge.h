@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "ld_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Track Merge (v1.6+ frame.dat)
+ *
+ * v1.6 的每個 track 只負責一部分 channel，各自有 keyframe 與 fade（pt_format.h）。
+ * frame_reader 依序把 TRACK record 交給 track_merge_push()（整板 record 展開後交給
+ * track_merge_push_board()），再由 track_merge_emit() 合併出 control.dat 上的下一個完整 frame：
+ *
+ *   - frame 時間 = 所有 track 尚未輸出的 key 中最早的時間
+ *   - 在該時間有 key 的 track 換成新的 key
+ *   - 正在 fade 的 track 若下一個 key 在更後面，於此時間點先內插
+ *     （與 Player 相同的 grb_lerp_hsv_u8 與 p 算法，v1.8 再套用該 key 的 easing）
+ *   - fade_mask 標記從這個 frame 到下一個 frame 要內插的 channel
+ *   - ease 為這段內插的曲線：所有正在 fade 的 track 都在此時間開始 fade 且曲線相同時
+ *     用該曲線，否則為 linear（frame 時間點的值都已照曲線算好，之間以直線連接）
+ *   - 還沒有任何 key 的 track 輸出 0
+ *   - v1.9 目前的 key 為 EFFECT 的 track 輸出 0，並在 effects 加一筆
+ *     {track mask, key 時間, 參數}，由 Player 每個 tick 計算
+ *
+ * 每個 track 最多保留 1 個目前的 key + TRACK_MERGE_PENDING_MAX 個未輸出的 key，
+ * 數值存在 init 時依 track 大小配置的 buffer（約 5 x payload，含整板 DELTA 的基準），只有 v1.6 會配置。
+ *
+ * 從 SYNC seek 時：track_merge_reset()，push group 內重述的 key，再呼叫 track_merge_seek()，
+ * 之後的 push 會略過 SYNC 之前與已重述的 key。
+ * ============================================================ */
+
+/** Keys read ahead per track; records sorted by need time never exceed this. */
+#define TRACK_MERGE_PENDING_MAX 3
+
+/**
+ * @brief 依 track table 建立各 track 的 channel 範圍並配置 buffer
+ *
+ * 使用 ch_info_snapshot 決定 payload layout，必須在 get_channel_info() 之後呼叫。
+ *
+ * @param  masks         track_count 個 u64 channel mask（little-endian，即檔案內容）
+ * @param  track_count   1 ~ PT_TRACK_MAX
+ * @param  payload_size  完整 frame payload 的 bytes
+ *
+ * @return ESP_OK
+ *         ESP_ERR_INVALID_ARG  track 數不合法或 mask 重疊
+ *         ESP_ERR_NO_MEM
+ */
+esp_err_t track_merge_init(const uint8_t* masks, uint8_t track_count, uint32_t payload_size);
+
+/**
+ * @brief 釋放 buffer
+ */
+void track_merge_deinit(void);
+
+/**
+ * @brief 回到檔案開頭的狀態（丟掉所有 key）
+ */
+void track_merge_reset(void);
+
+/**
+ * @brief 是否還要再讀一個 record 才能輸出下一個 frame
+ *
+ * 已讀到 EOF（track_merge_end）後永遠回傳 false。
+ */
+bool track_merge_need_record(void);
+
+/**
+ * @brief 加入一個 TRACK record
+ *
+ * @param  fade  1 = 內插到同一 track 的下一個 key
+ * @param  ease  fade 的 easing id（ld_ease.h），v1.8 之前為 LD_EASE_LINEAR
+ * @param  body  [u8 track][track payload]
+ *
+ * @return ESP_OK
+ *         ESP_FAIL  track 不存在、body 長度不符、時間沒有遞增或 record 順序錯誤
+ */
+esp_err_t track_merge_push(uint32_t start_time, uint8_t fade, uint8_t ease, const uint8_t* body, uint32_t body_len);
+
+/**
+ * @brief 加入一個 v1.9 EFFECT record
+ *
+ * 效果沒有 fade；同一 track 的上一個 key 不可 fade 到 EFFECT。
+ *
+ * @param  body  [u8 track][PT_EFFECT_SIZE bytes 參數]（pt_format.h）
+ *
+ * @return ESP_OK
+ *         ESP_FAIL  track 不存在、參數不合法、上一個 key 有 fade、時間沒有遞增或 record 順序錯誤
+ */
+esp_err_t track_merge_push_effect(uint32_t start_time, const uint8_t* body, uint32_t body_len);
+
+/**
+ * @brief 加入一個整板 record（KEY / DELTA / INDEXED 展開後）
+ *
+ * 每個 track 在 start_time 得到一個 key，值為 payload 中該 track 的部分。
+ *
+ * @param  payload  payload_size bytes
+ *
+ * @return ESP_OK
+ *         ESP_FAIL  某個 track 的時間沒有遞增或 record 順序錯誤
+ */
+esp_err_t track_merge_push_board(uint32_t start_time, uint8_t fade, uint8_t ease, const uint8_t* payload);
+
+/**
+ * @brief 每個 channel 最後 push 的 key 值（EFFECT 與還沒有 key 的 channel 為 0），v1.6 DELTA 的基準
+ *
+ * @return payload_size bytes
+ */
+const uint8_t* track_merge_last(void);
+
+/**
+ * @brief 從 ts 的 SYNC seek：group 已 push 完，之後略過 start_time < ts 與已重述的 key
+ */
+void track_merge_seek(uint32_t ts);
+
+/**
+ * @brief 標記 frame.dat 已讀完
+ */
+void track_merge_end(void);
+
+/**
+ * @brief 輸出下一個合併後的 frame
+ *
+ * @param  payload       payload_size bytes，與 v1.4 KEY 相同 layout
+ * @param  effects       LD_FRAME_EFFECT_MAX 個 entry
+ * @param  effect_count  用到的 entry 數
+ *
+ * @return ESP_OK
+ *         ESP_ERR_NOT_FOUND  所有 key 都已輸出
+ *         ESP_FAIL           同時跑效果的 track 超過 LD_FRAME_EFFECT_MAX
+ */
+esp_err_t track_merge_emit(uint8_t* payload, uint32_t* timestamp, uint64_t* fade_mask, uint8_t* ease, ld_frame_effect_t* effects, uint8_t* effect_count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,6 +8,7 @@
 #include "ld_led_ops.h"
 #include "ld_led_types.h"
 
+#include "layer_stack.hpp"
 #include "player_protocal.h"
 
 enum class FbTestMode : uint8_t {
@@ -42,14 +43,57 @@ class FrameBuffer {
 
     void fill(grb8_t color);
 
+    /* overlay / override layers composited over every computed frame (layer_stack.hpp) */
+    void set_layer(const LayerData& data);
+
+    /* A-B loop for rehearsals, b_ms == 0 turns it off. The Player moves the clock back
+     * at B and calls loop_jump(); reset() starts at A while a loop is set. Refused with
+     * ESP_ERR_NOT_SUPPORTED when the show cannot seek (frame_system_can_seek()), and
+     * dropped by reset() when a show switch lands on such a show. */
+    esp_err_t set_loop(uint32_t a_ms, uint32_t b_ms);
+    bool loop_on() const {
+        return loop_b_ != 0;
+    }
+    uint32_t loop_a() const {
+        return loop_a_;
+    }
+    uint32_t loop_b() const {
+        return loop_b_;
+    }
+    /* B, or the last frame when B is past the end of the show */
+    uint32_t loop_end_ms() const;
+    /* where reset() leaves the show: A with a loop, else 0 */
+    uint32_t start_ms() const {
+        return loop_b_ ? loop_a_ : 0;
+    }
+    /* current / next back to the frames at A */
+    esp_err_t loop_jump();
+
+    /* adaptive tick: the output changes every tick (fade, effect, blinking layer, test) */
+    bool animating() const;
+    /* show time the held output changes next: the next keyframe, B of a loop at the latest */
+    uint64_t next_key_ms(uint64_t time_ms) const;
+    /* esp_timer time a layer expires next, 0 when none does (LayerStack::next_expire_us) */
+    int64_t next_expire_us() const {
+        return layers_.next_expire_us();
+    }
+
     void print_buffer();
     frame_data* get_buffer();
+    /* Output-ready frame from the compiled cache, nullptr when get_buffer() holds this tick's output. */
+    const frame_wire* get_wire() const;
 
   private:
     FbComputeStatus handle_frames(uint64_t time_ms);
+    esp_err_t read_next(table_frame_t* f);
+    void loop_keep();
+    void loop_seek();
+    void loop_track();
     void lerp(uint8_t p);
+    void render_effects(uint64_t time_ms);
     void gamma_correction();
     void brightness_correction();
+    void composite_layers();
 
     table_frame_t frame0{}, frame1{};
 
@@ -57,6 +101,16 @@ class FrameBuffer {
     table_frame_t* next;
 
     frame_data buffer;
+    const frame_wire* wire_ = nullptr;
+    LayerStack layers_;
+
+    /* A-B loop: the frames at A are kept, so the jump back never waits for the reader */
+    uint32_t loop_a_ = 0;
+    uint32_t loop_b_ = 0;        // 0: no loop
+    bool loop_kept_ = false;     // loop_frame0_ / loop_frame1_ hold the frames in effect at A
+    bool loop_seeked_ = false;   // reader already moved back for the next jump
+    bool loop_skip_ = false;     // reader restarts at loop_frame1_, which is already here
+    table_frame_t loop_frame0_{}, loop_frame1_{};
 
     FbTestMode test_mode_ = FbTestMode::OFF;
     grb8_t test_color_ = {0, 0, 0};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ld_frame.h"
+#include "player_protocal.h"
+
+/*
+ * Overlay and override layers on top of the show frame, composited by FrameBuffer
+ * in output form (after gamma / brightness), so compiled wire frames take them too.
+ *
+ *   show -> LAYER_OVERLAY -> LAYER_OVERRIDE
+ *
+ * Each layer is one color over a channel mask (LD_FRAME_FADE_* bits) with a blend mode,
+ * an optional blink and an optional expiry. Expiry and blink run on esp_timer time,
+ * not show time, so they keep going across seek / stop / restart.
+ * Only the player task touches it (set through EVENT_LAYER).
+ */
+class LayerStack {
+  public:
+    void clear();
+    /* mask == 0 clears the layer */
+    void set(const LayerData& data);
+
+    /* false when every layer is off or expired: compute() does nothing more */
+    bool active() const {
+        return active_ != 0;
+    }
+
+    /* composite onto an output buffer; pca_rgb: PCA9955B bytes are R G B (frame_wire), else G R B */
+    void composite(uint8_t* out, bool pca_rgb);
+
+    /* a layer blinks, so the output changes every tick between keyframes (adaptive tick) */
+    bool animated() const;
+    /* esp_timer time the first active layer expires, 0 when none does: a hold wakes for it */
+    int64_t next_expire_us() const;
+
+  private:
+    struct Layer {
+        LayerData data;
+        uint8_t ws[3];  // WS2812B color, G R B, output form (MULTIPLY: raw factors)
+        uint8_t pca[3]; // PCA9955B color, G R B, output form (MULTIPLY: raw factors)
+        int64_t start_us;
+        int64_t expire_us; // 0: never
+    };
+
+    static void blend(uint8_t* px, const uint8_t* c, uint8_t mode, uint8_t alpha);
+
+    Layer layers_[LAYER_NUM] = {};
+    uint8_t active_ = 0; // bit per layer
+};
@@ -12,6 +12,24 @@
 
 #define SHOW_TRANSITION 0
 
+/* lateness histogram of PlayerTickStats: bucket b counts ticks less than (128 << b) us late, the last is open ended */
+#define PLAYER_LATE_BUCKETS 12
+
+/* wall time between PLAYING ticks, by what the earlier tick planned (adaptive tick),
+ * and how late each tick ran after its metronome alarm (deadline monitor) */
+struct PlayerTickStats {
+    uint64_t rate_us; // periodic: fades, effects, blinking layers (every tick without LD_CFG_PLAYER_ADAPTIVE_TICK)
+    uint64_t hold_us; // asleep until a keyframe
+    uint32_t rate_ticks;
+    uint32_t hold_ticks;
+
+    uint32_t missed;        // ticks run a metronome period or more after their alarm, or folded
+    uint32_t folded;        // alarms that came while the task was busy, rendered as one later tick
+    uint32_t max_late_us;   // alarm to the start of its render
+    uint32_t max_render_us; // one tick: compute, LED output and planning the next
+    uint32_t late_hist[PLAYER_LATE_BUCKETS];
+};
+
 class Player {
   public:
     // ===== Singleton =====
@@ -26,6 +44,8 @@ class Player {
     // ===== External Commands (thread-safe) =====
 
     esp_err_t play();
+    // start at esp_timer time start_us (BLE sync target), ticks phase-locked to it
+    esp_err_t play(int64_t start_us);
     esp_err_t pause();
     esp_err_t stop();
     esp_err_t release();
@@ -33,9 +53,29 @@ class Player {
     esp_err_t test();
     esp_err_t test(uint8_t, uint8_t, uint8_t);
     esp_err_t exit();
+    esp_err_t select(uint8_t show_id);
+    // load the first frame (0, or A of a loop) into the LED drivers ahead of a scheduled play (BLE prep window)
+    esp_err_t preroll();
+    // show speed in percent (rehearsal), in any state, kept until changed
+    esp_err_t setTempo(uint16_t pct);
+    // A-B loop for rehearsals: play a_ms ~ b_ms over and over, in any state, kept until cleared
+    esp_err_t setLoop(uint32_t a_ms, uint32_t b_ms);
+    esp_err_t clearLoop();
+    // build the compiled cache of the loaded show (frame_system_compile), READY only, blocks the Player while it runs
+    esp_err_t compile();
+    // overlay / override layer over the show, in any state (layer_stack.hpp)
+    esp_err_t setLayer(const LayerData& data);
+    esp_err_t clearLayer(uint8_t layer);
     uint8_t getState() {
         return (uint8_t)m_state;
     }
+    // since boot or resetTickStats(), read without a lock (diagnostics)
+    PlayerTickStats getTickStats() const {
+        return m_tick_stats;
+    }
+    void resetTickStats() {
+        m_tick_reset = true;
+    }
 
   private:
     // ===== Called by State =====
@@ -44,7 +84,16 @@ class Player {
     esp_err_t pausePlayback();
     esp_err_t resetPlayback();
     esp_err_t updatePlayback();
+    esp_err_t renderPlayback();
     esp_err_t testPlayback(TestData);
+    esp_err_t selectShow(uint8_t show_id);
+    esp_err_t compileShow();
+    esp_err_t prerollPlayback();
+    esp_err_t writeOutput();
+    esp_err_t loopBack(uint64_t& time_ms, uint64_t end_ms);
+    void countTick(int64_t now_us);
+    esp_err_t planTick(uint64_t time_ms);
+    void wakeTick();
 
     // ===== FSM =====
 
@@ -83,6 +132,20 @@ class Player {
 
     PlayerState m_state = PlayerState::UNLOADED;
     TestData m_test_data = {};
+    int64_t m_play_at_us = 0; // EVENT_PLAY start_us, read by startPlayback()
+    bool m_prerolled = false;       // driver buffers hold the first frame, the first tick only transmits
+
+    // ===== Adaptive tick =====
+
+    enum class TickMode : uint8_t {
+        RATE, // periodic at the show's tick (frame_system_tick_us)
+        HOLD, // one-shot at the next keyframe
+    };
+
+    TickMode m_tick_mode = TickMode::RATE; // planned by the last PLAYING tick
+    int64_t m_tick_last_us = 0;           // esp_timer time of that tick, 0 before the first
+    PlayerTickStats m_tick_stats = {};
+    volatile bool m_tick_reset = false; // set by resetTickStats(), cleared by the player task
 
     // ===== Resources =====
 
@@ -24,19 +24,37 @@ class PlayerMetronome {
     esp_err_t deinit();
 
     esp_err_t start();
+    /* first tick after delay_us (one-shot alarm), then every period from there */
+    esp_err_t start_at(uint32_t delay_us);
+    /* running: next tick after delay_us instead, then every period_us from there (adaptive tick) */
+    esp_err_t restart_in(uint32_t delay_us, uint32_t period_us);
     esp_err_t stop();
     esp_err_t reset();
 
     esp_err_t set_period_us(uint32_t period_us);
+    uint32_t get_period_us() const {
+        return period_us;
+    }
 
     bool is_running() const;
 
+    /* alarms since the last call and the esp_timer time of the latest (deadline monitor), last_us may be NULL */
+    uint32_t take_alarms(int64_t* last_us);
+
   private:
+    static bool on_alarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t* edata, void* user_ctx);
+    esp_err_t set_alarm(uint64_t alarm_count, uint64_t reload_count, bool periodic);
+
     gptimer_handle_t timer = nullptr;
     TaskHandle_t task = nullptr;
 
     uint32_t period_us = 0;
+    volatile bool one_shot = false; // start_at() alarm pending, the ISR switches to periodic
     MetronomeState state = MetronomeState::UNINIT;
+
+    portMUX_TYPE alarm_lock = portMUX_INITIALIZER_UNLOCKED;
+    uint32_t alarms = 0;   // under alarm_lock, written by the ISR
+    int64_t alarm_us = 0;  // under alarm_lock, written by the ISR
 };
 
 enum class ClockState {
@@ -55,18 +73,37 @@ class PlayerClock {
     esp_err_t deinit();
 
     esp_err_t start();
+    /* start (or resume) with the timeline anchored at esp_timer time start_us, ticks phase-locked to it */
+    esp_err_t start_at(int64_t start_us);
     esp_err_t pause();
     esp_err_t reset();
 
     esp_err_t set_time_us(int64_t target_us);
+    /* move the timeline by delta_us in any state; running, the ticks keep their phase (A-B loop) */
+    esp_err_t shift_us(int64_t delta_us);
+    esp_err_t set_period_us(uint32_t period_us);
+    /* show time per wall time, LD_CFG_PLAYER_TEMPO_MIN_PCT ~ LD_CFG_PLAYER_TEMPO_MAX_PCT; no jump when running */
+    esp_err_t set_tempo_pct(uint16_t pct);
+
+    /* running: next tick after delay_us, then every period_us from there (adaptive tick) */
+    esp_err_t tick_in(uint32_t delay_us, uint32_t period_us);
+    /* wall time until the timeline reaches show_us at the current tempo, <= 0 once it has */
+    int64_t until_us(int64_t show_us) const;
+    /* metronome alarms since the last call, see PlayerMetronome::take_alarms() */
+    uint32_t take_alarms(int64_t* last_us);
+    uint32_t period_us() const;
 
     int64_t now_us() const;
 
   private:
+    /* show time since last_start_us, scaled by the tempo */
+    int64_t elapsed_us(int64_t now) const;
+
     ClockState state = ClockState::UNINIT;
 
     int64_t accumulated_us = 0;
     int64_t last_start_us = 0;
+    uint32_t tempo_q16 = 1u << 16; // 16.16 fixed point, 1.0 = real time
 
     bool with_metronome = false;
     PlayerMetronome metronome;
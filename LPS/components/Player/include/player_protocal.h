@@ -13,6 +13,12 @@ typedef enum {
     EVENT_RELEASE,
     EVENT_LOAD,
     EVENT_EXIT,
+    EVENT_SELECT,
+    EVENT_LAYER,
+    EVENT_PREROLL,
+    EVENT_TEMPO,
+    EVENT_LOOP,
+    EVENT_COMPILE,
 } event_t;
 
 typedef enum {
@@ -27,11 +33,46 @@ typedef struct {
     uint8_t b;
 } TestData;
 
+/* layers composited over the show frame, bottom to top (layer_stack.hpp) */
+typedef enum {
+    LAYER_OVERLAY = 0,
+    LAYER_OVERRIDE,
+    LAYER_NUM,
+} LayerId;
+
+typedef enum {
+    BLEND_REPLACE = 0,
+    BLEND_ALPHA,    // color over the frame with alpha / 255
+    BLEND_ADD,      // saturating add
+    BLEND_MULTIPLY, // scale the frame by color / 255 per component
+} BlendMode;
+
+typedef struct {
+    uint64_t mask;        // LD_FRAME_FADE_* channels covered, 0 clears the layer
+    uint32_t duration_ms; // 0: until replaced or cleared
+    uint16_t blink_ms;    // on / off half period, 0: steady
+    uint8_t layer;        // LayerId
+    uint8_t blend;        // BlendMode
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t alpha; // BLEND_ALPHA only
+} LayerData;
+
+/* A-B loop region, b_ms == 0: loop off */
+typedef struct {
+    uint32_t a_ms;
+    uint32_t b_ms;
+} LoopData;
+
 struct Event {
     event_t type;
 
     union {
-        uint32_t data;
+        uint32_t data; // EVENT_SELECT: show id, EVENT_TEMPO: percent
+        int64_t start_us; // EVENT_PLAY: esp_timer time of the first tick, 0 = now
         TestData test_data;
+        LayerData layer_data;
+        LoopData loop_data;
     };
 };
@@ -3,10 +3,14 @@
 #include <string.h>
 #include "algorithm"
 #include "esp_log.h"
+#include "ld_ease.h"
+#include "ld_effect.h"
 #include "readframe.h"
 
 static const char* TAG = "fb";
 
+static_assert(sizeof(frame_data) == sizeof(frame_wire), "a wire frame is composited in buffer");
+
 static int count = 0;
 
 // p = 0..255
@@ -31,6 +35,7 @@ FrameBuffer::~FrameBuffer() {}
 esp_err_t FrameBuffer::init() {
     test_mode_ = FbTestMode::OFF;
     eof_reported_ = false;
+    wire_ = nullptr;
 
     current = &frame0;
     next = &frame1;
@@ -40,6 +45,7 @@ esp_err_t FrameBuffer::init() {
     memset(&buffer, 0, sizeof(buffer));
 
     count = 0;
+    layers_.clear();
 #if LD_CFG_ENABLE_SD
     read_frame(current);
     // print_table_frame(*current);
@@ -58,6 +64,7 @@ esp_err_t FrameBuffer::init() {
 esp_err_t FrameBuffer::reset() {
     test_mode_ = FbTestMode::OFF;
     eof_reported_ = false;
+    wire_ = nullptr;
 
     current = &frame0;
     next = &frame1;
@@ -67,13 +74,30 @@ esp_err_t FrameBuffer::reset() {
     memset(&buffer, 0, sizeof(buffer));
 
 #if LD_CFG_ENABLE_SD
-    frame_reset();
+    loop_kept_ = false;
+    loop_seeked_ = false;
+    loop_skip_ = false;
+
+    /* kept from a show that could seek */
+    if(loop_b_ && !frame_system_can_seek()) {
+        ESP_LOGW(TAG, "loop off: show %u cannot seek", (unsigned)frame_system_current_show());
+        loop_a_ = 0;
+        loop_b_ = 0;
+    }
+
+    /* with an A-B loop the show starts at A */
+    if(loop_b_)
+        frame_seek(loop_a_);
+    else
+        frame_reset();
 
     read_frame(current);
     // print_table_frame(*current);
     read_frame(next);
     // print_table_frame(*next);
 
+    if(loop_b_)
+        loop_keep();
 #else
     count = 0;
     test_read_frame(current);
@@ -115,6 +139,8 @@ grb8_t FrameBuffer::get_test_color() const {
 
 FbComputeStatus FrameBuffer::compute(uint64_t time_ms) {
 
+    wire_ = nullptr;
+
     // ---- Test path ----
     if(test_mode_ != FbTestMode::OFF) {
         grb8_t c = test_color_;
@@ -124,6 +150,7 @@ FbComputeStatus FrameBuffer::compute(uint64_t time_ms) {
         fill(c);
         gamma_correction();
         brightness_correction();
+        composite_layers();
 
         return FbComputeStatus::OK;
     }
@@ -134,18 +161,40 @@ FbComputeStatus FrameBuffer::compute(uint64_t time_ms) {
         return status;
     }
 
+    // ---- Compiled step frame: lerp / gamma / brightness applied at load time (show_compile.h) ----
+    if(current->compiled) {
+        wire_ = &current->wire;
+        composite_layers();
+        return status;
+    }
+
     if(status == FbComputeStatus::OK) {
-        uint8_t p = (current->fade) ? calc_lerp_p(time_ms, current->timestamp, next->timestamp) : 0;
+        uint8_t p = (current->fade) ? ld_ease_apply(current->ease, calc_lerp_p(time_ms, current->timestamp, next->timestamp)) : 0;
 
         lerp(p);
     }
+    if(status != FbComputeStatus::ERROR) {
+        render_effects(time_ms);
+    }
 
     gamma_correction();
     brightness_correction();
+    composite_layers();
 
     return status;
 }
 
+bool FrameBuffer::animating() const {
+    return test_mode_ != FbTestMode::OFF || current->fade || current->effect_count || layers_.animated();
+}
+
+uint64_t FrameBuffer::next_key_ms(uint64_t time_ms) const {
+    uint64_t key = (time_ms < current->timestamp) ? current->timestamp : next->timestamp;
+    if(loop_b_ && time_ms < loop_b_ && loop_b_ < key)
+        key = loop_b_;
+    return key;
+}
+
 void FrameBuffer::fill(grb8_t color) {
     for(int ch = 0; ch < LD_BOARD_WS2812B_NUM; ch++) {
         for(int i = 0; i < LD_BOARD_WS2812B_MAX_PIXEL_NUM; i++) {
@@ -175,7 +224,7 @@ FbComputeStatus FrameBuffer::handle_frames(uint64_t time_ms) {
         std::swap(current, next);
 
 #if LD_CFG_ENABLE_SD
-        esp_err_t err = read_frame(next);
+        esp_err_t err = read_next(next);
         if(err == ESP_ERR_NOT_FOUND) {
             buffer = current->data;
             if(!eof_reported_) {
@@ -202,18 +251,169 @@ FbComputeStatus FrameBuffer::handle_frames(uint64_t time_ms) {
         }
     }
 
+#if LD_CFG_ENABLE_SD
+    loop_track();
+#endif
+
     return FbComputeStatus::OK;
 }
 
+#if LD_CFG_ENABLE_SD
+esp_err_t FrameBuffer::read_next(table_frame_t* f) {
+    esp_err_t err = read_frame(f);
+    if(err == ESP_OK && loop_skip_) {
+        loop_skip_ = false;
+        err = read_frame(f);
+    }
+    return err;
+}
+
+void FrameBuffer::loop_keep() {
+    memcpy(&loop_frame0_, current, sizeof(table_frame_t));
+    memcpy(&loop_frame1_, next, sizeof(table_frame_t));
+    loop_kept_ = true;
+}
+
+/* move the reader to what follows the frames at A: with them kept, only loop_frame1_ onwards
+ * (read_next() drops loop_frame1_ itself), else to A for a blocking read */
+void FrameBuffer::loop_seek() {
+    loop_skip_ = loop_kept_;
+    frame_seek(loop_kept_ ? (uint32_t)loop_frame1_.timestamp : loop_a_);
+    loop_seeked_ = true;
+}
+
+// after every advance while a loop is set
+void FrameBuffer::loop_track() {
+    if(!loop_b_) {
+        return;
+    }
+
+    // passing A: keep its frames for every later jump
+    if(!loop_kept_ && current->timestamp <= loop_a_ && next->timestamp > loop_a_) {
+        loop_keep();
+    }
+
+    // every frame up to B is loaded: move the reader now, it has until B to get there
+    if(!loop_seeked_ && next->timestamp >= loop_b_) {
+        loop_seek();
+    }
+}
+
+esp_err_t FrameBuffer::set_loop(uint32_t a_ms, uint32_t b_ms) {
+    // every pass seeks back to A: without sync points that decodes from frame 0 each time
+    if(b_ms && !frame_system_can_seek()) {
+        ESP_LOGW(TAG, "loop %lu ~ %lu ms refused: show %u cannot seek (not loaded)", (unsigned long)a_ms, (unsigned long)b_ms,
+                 (unsigned)frame_system_current_show());
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // the reader already went back for the old loop: return it to where playback is
+    if(loop_seeked_) {
+        frame_seek((uint32_t)next->timestamp);
+        loop_skip_ = true;
+        loop_seeked_ = false;
+    }
+
+    loop_a_ = a_ms;
+    loop_b_ = b_ms;
+    loop_kept_ = false;
+
+    if(b_ms) {
+        ESP_LOGI(TAG, "loop %lu ~ %lu ms", (unsigned long)a_ms, (unsigned long)b_ms);
+    } else {
+        ESP_LOGI(TAG, "loop off");
+    }
+    return ESP_OK;
+}
+
+uint32_t FrameBuffer::loop_end_ms() const {
+    return std::min(loop_b_, frame_system_duration_ms());
+}
+
+esp_err_t FrameBuffer::loop_jump() {
+    eof_reported_ = false;
+    wire_ = nullptr;
+
+    // B came before the reader could be moved early (loop set late, or B past the end)
+    if(!loop_seeked_) {
+        loop_seek();
+    }
+    loop_seeked_ = false;
+
+    current = &frame0;
+    next = &frame1;
+
+    if(loop_kept_) {
+        memcpy(current, &loop_frame0_, sizeof(table_frame_t));
+        memcpy(next, &loop_frame1_, sizeof(table_frame_t));
+        return ESP_OK;
+    }
+
+    // first pass, nothing kept yet: wait for the reader
+    esp_err_t err = read_frame(current);
+    if(err == ESP_OK) {
+        err = read_frame(next);
+    }
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "loop: no frames at %lu ms: %s", (unsigned long)loop_a_, esp_err_to_name(err));
+        return err;
+    }
+    loop_keep();
+    return ESP_OK;
+}
+#else
+esp_err_t FrameBuffer::set_loop(uint32_t, uint32_t) {
+    ESP_LOGW(TAG, "A-B loop needs the SD frame source");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+uint32_t FrameBuffer::loop_end_ms() const {
+    return loop_b_;
+}
+
+esp_err_t FrameBuffer::loop_jump() {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif
+
 void FrameBuffer::lerp(uint8_t p) {
+    // only the channels in fade_mask move towards next, the rest hold (v1.6 tracks fade per channel)
+    const uint64_t mask = current->fade_mask;
+
     for(int ch = 0; ch < LD_BOARD_WS2812B_NUM; ch++) {
+        const uint8_t pc = (mask & LD_FRAME_FADE_WS2812B(ch)) ? p : 0;
         for(int i = 0; i < LD_BOARD_WS2812B_MAX_PIXEL_NUM; i++) {
-            buffer.ws2812b[ch][i] = grb_lerp_hsv_u8(current->data.ws2812b[ch][i], next->data.ws2812b[ch][i], p);
+            buffer.ws2812b[ch][i] = grb_lerp_hsv_u8(current->data.ws2812b[ch][i], next->data.ws2812b[ch][i], pc);
         }
     }
 
     for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
-        buffer.pca9955b[ch] = grb_lerp_hsv_u8(current->data.pca9955b[ch], next->data.pca9955b[ch], p);
+        const uint8_t pc = (mask & LD_FRAME_FADE_PCA9955B(ch)) ? p : 0;
+        buffer.pca9955b[ch] = grb_lerp_hsv_u8(current->data.pca9955b[ch], next->data.pca9955b[ch], pc);
+    }
+}
+
+// v1.9 effects (ld_effect.h) own their channels until the next frame, evaluated on every tick
+void FrameBuffer::render_effects(uint64_t time_ms) {
+    if(current->effect_count == 0 || time_ms < current->timestamp) {
+        return;
+    }
+
+    for(uint8_t i = 0; i < current->effect_count; i++) {
+        const ld_frame_effect_t& e = current->effects[i];
+        const uint32_t t = (uint32_t)(time_ms - e.start_ms);
+
+        for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
+            if(e.mask & LD_FRAME_FADE_PCA9955B(ch)) {
+                ld_effect_render(&e.fx, t, (uint16_t)ch, &buffer.pca9955b[ch], 1);
+            }
+        }
+        for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+            if(e.mask & LD_FRAME_FADE_WS2812B(s)) {
+                const int n = std::min<int>(ch_info.rmt_strips[s], LD_BOARD_WS2812B_MAX_PIXEL_NUM);
+                ld_effect_render(&e.fx, t, 0, buffer.ws2812b[s], (uint16_t)n);
+            }
+        }
     }
 }
 
@@ -241,14 +441,43 @@ void FrameBuffer::brightness_correction() {
     }
 }
 
+void FrameBuffer::set_layer(const LayerData& data) {
+    layers_.set(data);
+}
+
+// layers go on top of the output form; a compiled frame is copied first, the next tick may show it again
+void FrameBuffer::composite_layers() {
+    if(!layers_.active()) {
+        return;
+    }
+
+    if(wire_) {
+        memcpy(&buffer, wire_, sizeof(buffer));
+        layers_.composite((uint8_t*)&buffer, true);
+        wire_ = reinterpret_cast<const frame_wire*>(&buffer);
+    } else {
+        layers_.composite((uint8_t*)&buffer, false);
+    }
+}
+
 frame_data* FrameBuffer::get_buffer() {
     return &buffer;
 }
 
+const frame_wire* FrameBuffer::get_wire() const {
+    return wire_;
+}
+
 void print_table_frame(const table_frame_t& frame) {
     ESP_LOGI(TAG, "=== table_frame_t ===");
     ESP_LOGI(TAG, "timestamp : %" PRIu64 " ms", frame.timestamp);
     ESP_LOGI(TAG, "fade      : %s", frame.fade ? "true" : "false");
+    ESP_LOGI(TAG, "fade_mask : %012" PRIx64, frame.fade_mask);
+    ESP_LOGI(TAG, "ease      : %u", frame.ease);
+    for(uint8_t i = 0; i < frame.effect_count; i++) {
+        const ld_frame_effect_t& e = frame.effects[i];
+        ESP_LOGI(TAG, "effect %u  : type %u mask %012" PRIx64 " from %" PRIu32 " ms, period %u ms", i, e.fx.type, e.mask, e.start_ms, e.fx.period_ms);
+    }
     print_frame_data(frame.data);
     ESP_LOGI(TAG, "=====================");
 }
@@ -296,6 +525,7 @@ static grb8_t color_pool[3] = {red, green, blue};
 void test_read_frame(table_frame_t* p) {
     p->timestamp = (uint64_t)count * LD_CFG_PLAYER_TEST_FRAME_INTERVAL_MS;
     p->fade = true;
+    p->fade_mask = LD_FRAME_FADE_ALL;
     for(int ch_idx = 0; ch_idx < LD_BOARD_WS2812B_NUM; ch_idx++) {
         for(int i = 0; i < ch_info.rmt_strips[ch_idx]; i++) {
             p->data.ws2812b[ch_idx][i] = grb_lerp_hsv_u8(color_pool[count % 3], color_pool[(count + 1) % 3], i * 255 / ch_info.rmt_strips[ch_idx]);
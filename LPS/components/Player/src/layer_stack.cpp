@@ -0,0 +1,120 @@
+#include "layer_stack.hpp"
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ld_board.h"
+#include "ld_led_ops.h"
+#include "ld_math_u8.h"
+
+static const char* TAG = "layers";
+
+/* byte offsets shared by frame_data and frame_wire (ld_frame.h) */
+#define PCA_OFFSET(ch) ((ch) * 3)
+#define WS_OFFSET(s) (sizeof(((frame_data*)0)->pca9955b) + (s) * 3 * LD_BOARD_WS2812B_MAX_PIXEL_NUM)
+
+static void to_output(grb8_t c, led_type_t type, uint8_t mode, uint8_t out[3]) {
+    if(mode != BLEND_MULTIPLY)
+        c = grb_set_brightness(grb_gamma_u8(c, type), type);
+    out[0] = c.g;
+    out[1] = c.r;
+    out[2] = c.b;
+}
+
+void LayerStack::clear() {
+    memset(layers_, 0, sizeof(layers_));
+    active_ = 0;
+}
+
+void LayerStack::set(const LayerData& data) {
+    if(data.layer >= LAYER_NUM) {
+        ESP_LOGW(TAG, "no layer %u", data.layer);
+        return;
+    }
+
+    Layer& l = layers_[data.layer];
+    const uint8_t bit = 1u << data.layer;
+    if(data.mask == 0) {
+        active_ &= ~bit;
+        return;
+    }
+
+    l.data = data;
+    l.data.mask &= LD_FRAME_FADE_ALL;
+    grb8_t c = grb8(data.r, data.g, data.b);
+    to_output(c, LED_WS2812B, data.blend, l.ws);
+    to_output(c, LED_PCA9955B, data.blend, l.pca);
+    l.start_us = esp_timer_get_time();
+    l.expire_us = data.duration_ms ? l.start_us + (int64_t)data.duration_ms * 1000 : 0;
+    active_ |= bit;
+}
+
+void LayerStack::blend(uint8_t* px, const uint8_t* c, uint8_t mode, uint8_t alpha) {
+    for(int k = 0; k < 3; k++) {
+        switch(mode) {
+            case BLEND_ALPHA:
+                px[k] = lerp_u8(px[k], c[k], alpha);
+                break;
+            case BLEND_ADD:
+                px[k] = u8_add_sat(px[k], c[k]);
+                break;
+            case BLEND_MULTIPLY:
+                px[k] = mul255_u8(px[k], c[k]);
+                break;
+            default:
+                px[k] = c[k];
+                break;
+        }
+    }
+}
+
+void LayerStack::composite(uint8_t* out, bool pca_rgb) {
+    const int64_t now = esp_timer_get_time();
+
+    for(int i = 0; i < LAYER_NUM; i++) {
+        Layer& l = layers_[i];
+        if(!(active_ & (1u << i)))
+            continue;
+        if(l.expire_us && now >= l.expire_us) {
+            active_ &= ~(1u << i);
+            continue;
+        }
+        if(l.data.blink_ms && ((now - l.start_us) / 1000 / l.data.blink_ms) & 1)
+            continue;
+
+        const uint64_t mask = l.data.mask;
+        const uint8_t pca_rgb_color[3] = {l.pca[1], l.pca[0], l.pca[2]};
+        const uint8_t* pca = pca_rgb ? pca_rgb_color : l.pca;
+
+        for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
+            if(mask & LD_FRAME_FADE_PCA9955B(ch))
+                blend(out + PCA_OFFSET(ch), pca, l.data.blend, l.data.alpha);
+        }
+        for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+            if(!(mask & LD_FRAME_FADE_WS2812B(s)))
+                continue;
+            uint8_t* px = out + WS_OFFSET(s);
+            const int n = (ch_info.rmt_strips[s] < LD_BOARD_WS2812B_MAX_PIXEL_NUM) ? ch_info.rmt_strips[s] : LD_BOARD_WS2812B_MAX_PIXEL_NUM;
+            for(int p = 0; p < n; p++, px += 3)
+                blend(px, l.ws, l.data.blend, l.data.alpha);
+        }
+    }
+}
+
+bool LayerStack::animated() const {
+    for(int i = 0; i < LAYER_NUM; i++) {
+        if((active_ & (1u << i)) && layers_[i].data.blink_ms)
+            return true;
+    }
+    return false;
+}
+
+int64_t LayerStack::next_expire_us() const {
+    int64_t first = 0;
+    for(int i = 0; i < LAYER_NUM; i++) {
+        const int64_t e = layers_[i].expire_us;
+        if((active_ & (1u << i)) && e && (!first || e < first))
+            first = e;
+    }
+    return first;
+}
@@ -2,6 +2,8 @@
 
 #include "esp_check.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "readframe.h"
 
 static const char* TAG = "Player";
 
@@ -31,8 +33,13 @@ esp_err_t Player::deinit() {
 /* ================= External commands ================= */
 
 esp_err_t Player::play() {
+    return play(0);
+}
+
+esp_err_t Player::play(int64_t start_us) {
     Event e{};
     e.type = EVENT_PLAY;
+    e.start_us = start_us;
     return sendEvent(e);
 }
 
@@ -84,9 +91,84 @@ esp_err_t Player::exit() {
     return sendEvent(e);
 }
 
+esp_err_t Player::select(uint8_t show_id) {
+    Event e{};
+    e.type = EVENT_SELECT;
+    e.data = show_id;
+    return sendEvent(e);
+}
+
+esp_err_t Player::preroll() {
+    Event e{};
+    e.type = EVENT_PREROLL;
+    return sendEvent(e);
+}
+
+esp_err_t Player::setTempo(uint16_t pct) {
+    ESP_RETURN_ON_FALSE(pct >= LD_CFG_PLAYER_TEMPO_MIN_PCT && pct <= LD_CFG_PLAYER_TEMPO_MAX_PCT, ESP_ERR_INVALID_ARG, TAG, "tempo %u%% out of %d ~ %d", pct,
+                        LD_CFG_PLAYER_TEMPO_MIN_PCT, LD_CFG_PLAYER_TEMPO_MAX_PCT);
+    Event e{};
+    e.type = EVENT_TEMPO;
+    e.data = pct;
+    return sendEvent(e);
+}
+
+esp_err_t Player::setLoop(uint32_t a_ms, uint32_t b_ms) {
+    ESP_RETURN_ON_FALSE(b_ms > a_ms, ESP_ERR_INVALID_ARG, TAG, "loop end %lu ms not after start %lu ms", (unsigned long)b_ms, (unsigned long)a_ms);
+    Event e{};
+    e.type = EVENT_LOOP;
+    e.loop_data.a_ms = a_ms;
+    e.loop_data.b_ms = b_ms;
+    return sendEvent(e);
+}
+
+esp_err_t Player::clearLoop() {
+    Event e{};
+    e.type = EVENT_LOOP;
+    return sendEvent(e);
+}
+
+esp_err_t Player::compile() {
+    Event e{};
+    e.type = EVENT_COMPILE;
+    return sendEvent(e);
+}
+
+esp_err_t Player::setLayer(const LayerData& data) {
+    ESP_RETURN_ON_FALSE(data.layer < LAYER_NUM, ESP_ERR_INVALID_ARG, TAG, "invalid layer %u", data.layer);
+    Event e{};
+    e.type = EVENT_LAYER;
+    e.layer_data = data;
+    return sendEvent(e);
+}
+
+esp_err_t Player::clearLayer(uint8_t layer) {
+    LayerData data{};
+    data.layer = layer;
+    return setLayer(data);
+}
+
 /* ================= Playback control (called by State) ================= */
 
+// tick period picked for the loaded show (show_profile.h), LD_CFG_PLAYER_FPS without SD
+static uint32_t show_tick_us() {
+#if LD_CFG_ENABLE_SD
+    return frame_system_tick_us();
+#else
+    return 1000000 / LD_CFG_PLAYER_FPS;
+#endif
+}
+
 esp_err_t Player::startPlayback() {
+    m_tick_mode = TickMode::RATE;
+    m_tick_last_us = 0;
+    clock.take_alarms(nullptr); // alarms from before (TEST, or before the pause) are not this playback's
+    /* tick chosen for the loaded show; with the adaptive tick, the periodic rate until the first tick plans */
+    ESP_RETURN_ON_ERROR(clock.set_period_us(show_tick_us()), TAG, "Failed to set tick period");
+    if(m_play_at_us) {
+        /* every board renders its first frame at the same instant (PlayerClock::start_at) */
+        return clock.start_at(m_play_at_us);
+    }
     return clock.start();
 }
 
@@ -95,9 +177,14 @@ esp_err_t Player::pausePlayback() {
 }
 
 esp_err_t Player::resetPlayback() {
+    m_prerolled = false;
     ESP_RETURN_ON_ERROR(clock.pause(), TAG, "Failed to pause clock");
     ESP_RETURN_ON_ERROR(clock.reset(), TAG, "Failed to reset clock");
     ESP_RETURN_ON_ERROR(fb.reset(), TAG, "Failed to reset framebuffer");
+    /* an A-B loop starts at A, where fb.reset() left the reader */
+    if(fb.start_ms()) {
+        ESP_RETURN_ON_ERROR(clock.set_time_us((int64_t)fb.start_ms() * 1000), TAG, "Failed to set loop start");
+    }
 
     controller.fill(GRB_BLACK);
     controller.show();
@@ -106,7 +193,40 @@ esp_err_t Player::resetPlayback() {
 }
 
 esp_err_t Player::updatePlayback() {
-    const uint64_t time_ms = clock.now_us() / 1000;
+    const int64_t start_us = esp_timer_get_time();
+    countTick(start_us);
+
+    /* always the frame at the current time: ticks missed while busy are not replayed */
+    esp_err_t err = renderPlayback();
+
+    if(m_state == PlayerState::PLAYING) {
+        const uint32_t render_us = (uint32_t)(esp_timer_get_time() - start_us);
+        if(render_us > m_tick_stats.max_render_us) {
+            m_tick_stats.max_render_us = render_us;
+        }
+    }
+    return err;
+}
+
+esp_err_t Player::renderPlayback() {
+    uint64_t time_ms = clock.now_us() / 1000;
+
+    if(m_prerolled) {
+        m_prerolled = false;
+        /* the first frame is already in the driver buffers (prerollPlayback) */
+        if(time_ms == fb.start_ms()) {
+            ESP_RETURN_ON_ERROR(controller.show(), TAG, "preroll show failed");
+            return planTick(time_ms);
+        }
+    }
+
+    /* A-B loop: past B, carry on from A as far as the clock went past B */
+    if(m_state == PlayerState::PLAYING && fb.loop_on() && time_ms >= fb.loop_b() && loopBack(time_ms, fb.loop_b()) != ESP_OK) {
+        Event e{};
+        e.type = EVENT_STOP;
+        ESP_RETURN_ON_ERROR(sendEvent(e), TAG, "stop event on loop failure");
+        return ESP_FAIL;
+    }
 
     FbComputeStatus fb_status = fb.compute(time_ms);
     if(fb_status == FbComputeStatus::ERROR) {
@@ -117,19 +237,161 @@ esp_err_t Player::updatePlayback() {
         // return ESP_FAIL;
     }
 
-    frame_data* buf = fb.get_buffer();
-    controller.write_frame(buf);
+    writeOutput();
 
-    // print_frame_data(*buf);
+    // print_frame_data(*fb.get_buffer());
 
     controller.show();
 
     if(fb_status == FbComputeStatus::EOF_REACHED) {
+        /* a loop that ends past the show wraps at its last frame */
+        if(m_state == PlayerState::PLAYING && fb.loop_on() && fb.loop_end_ms() > fb.loop_a() && loopBack(time_ms, fb.loop_end_ms()) == ESP_OK) {
+            return planTick(time_ms);
+        }
         Event e{};
         e.type = EVENT_STOP;
         ESP_RETURN_ON_ERROR(sendEvent(e), TAG, "failed to enqueue stop event on EOF");
+        return ESP_OK;
     }
 
+    return (fb_status == FbComputeStatus::ERROR) ? ESP_OK : planTick(time_ms);
+}
+
+static uint8_t late_bucket(uint32_t late_us) {
+    uint8_t b = 0;
+    while(b + 1 < PLAYER_LATE_BUCKETS && late_us >= (128u << b)) {
+        b++;
+    }
+    return b;
+}
+
+// deadline monitor: how late this tick runs after its alarm; then the wall time since the
+// last PLAYING tick goes to the mode that tick planned
+void Player::countTick(int64_t now) {
+    if(m_state != PlayerState::PLAYING) {
+        return;
+    }
+
+    if(m_tick_reset) {
+        m_tick_reset = false;
+        m_tick_stats = {};
+    }
+
+    /* no alarm: an update notified by wakeTick(), which has no deadline */
+    int64_t alarm_us = 0;
+    const uint32_t alarms = clock.take_alarms(&alarm_us);
+    if(alarms) {
+        const uint32_t late_us = (now > alarm_us) ? (uint32_t)(now - alarm_us) : 0;
+        m_tick_stats.late_hist[late_bucket(late_us)]++;
+        if(late_us > m_tick_stats.max_late_us) {
+            m_tick_stats.max_late_us = late_us;
+        }
+        m_tick_stats.folded += alarms - 1;
+        if(alarms > 1 || late_us >= clock.period_us()) {
+            m_tick_stats.missed++;
+        }
+    }
+
+    if(m_tick_last_us) {
+        if(m_tick_mode == TickMode::HOLD) {
+            m_tick_stats.hold_us += now - m_tick_last_us;
+            m_tick_stats.hold_ticks++;
+        } else {
+            m_tick_stats.rate_us += now - m_tick_last_us;
+            m_tick_stats.rate_ticks++;
+        }
+    }
+    m_tick_last_us = now;
+}
+
+// adaptive tick: periodic while the output animates, else asleep until it changes.
+// Ticks still land on show time through the clock, so only how often they come changes.
+esp_err_t Player::planTick(uint64_t time_ms) {
+#if LD_CFG_PLAYER_ADAPTIVE_TICK
+    if(m_state != PlayerState::PLAYING) {
+        return ESP_OK;
+    }
+
+    const int64_t period_us = show_tick_us();
+    const TickMode prev = m_tick_mode;
+    int64_t delay_us = clock.until_us((int64_t)fb.next_key_ms(time_ms) * 1000);
+
+    /* a layer running out changes the output once, wake for it like for a keyframe */
+    const int64_t expire_us = fb.next_expire_us();
+    if(expire_us && expire_us - esp_timer_get_time() < delay_us) {
+        delay_us = expire_us - esp_timer_get_time();
+    }
+
+    if(fb.animating()) {
+        m_tick_mode = TickMode::RATE;
+        /* the metronome keeps its period; only the tick before a keyframe moves onto it */
+        if(prev == TickMode::RATE && delay_us >= period_us) {
+            return ESP_OK;
+        }
+        if(delay_us > period_us) {
+            delay_us = period_us;
+        }
+    } else {
+        m_tick_mode = TickMode::HOLD;
+    }
+
+    /* cuts closer than LD_CFG_PLAYER_MAX_FPS allows merge into one tick */
+    const int64_t min_us = 1000000 / LD_CFG_PLAYER_MAX_FPS - (esp_timer_get_time() - m_tick_last_us);
+    if(delay_us < min_us) {
+        delay_us = min_us;
+    }
+    if(delay_us < 0) {
+        delay_us = 0;
+    }
+    if(delay_us > UINT32_MAX) {
+        delay_us = UINT32_MAX;
+    }
+    return clock.tick_in((uint32_t)delay_us, (uint32_t)period_us);
+#else
+    (void)time_ms;
+    return ESP_OK;
+#endif
+}
+
+// a change between keyframes (layer, tempo, loop): a hold may sleep past it, so tick now
+void Player::wakeTick() {
+#if LD_CFG_PLAYER_ADAPTIVE_TICK
+    if(m_state == PlayerState::PLAYING && m_tick_mode == TickMode::HOLD) {
+        xTaskNotify(taskHandle, NOTIFICATION_UPDATE, eSetBits);
+    }
+#endif
+}
+
+// move the clock back by whole loop lengths (A ~ end_ms) and the frames to A; the metronome keeps running
+esp_err_t Player::loopBack(uint64_t& time_ms, uint64_t end_ms) {
+    const uint64_t len = end_ms - fb.loop_a();
+    const uint64_t back_ms = (time_ms - fb.loop_a()) / len * len;
+
+    ESP_RETURN_ON_ERROR(clock.shift_us(-(int64_t)back_ms * 1000), TAG, "loop: clock shift failed");
+    time_ms -= back_ms;
+    return fb.loop_jump();
+}
+
+esp_err_t Player::writeOutput() {
+    const frame_wire* wire = fb.get_wire();
+    if(wire) {
+        return controller.write_wire(wire);
+    }
+    return controller.write_frame(fb.get_buffer());
+}
+
+esp_err_t Player::prerollPlayback() {
+    /* resetPlayback() already seeked the reader and loaded frame0 / frame1; resend the
+     * black frame on the LEDs so the RMT and I2C paths are warm, then stage the first
+     * frame (frame 0, or A with a loop) */
+    controller.fill(GRB_BLACK);
+    ESP_RETURN_ON_ERROR(controller.show(), TAG, "preroll: LED warm-up failed");
+
+    ESP_RETURN_ON_FALSE(fb.compute(fb.start_ms()) != FbComputeStatus::ERROR, ESP_FAIL, TAG, "preroll: first frame compute failed");
+    ESP_RETURN_ON_ERROR(writeOutput(), TAG, "preroll: driver write failed");
+
+    m_prerolled = true;
+    ESP_LOGI(TAG, "frame at %lu ms prerolled", (unsigned long)fb.start_ms());
     return ESP_OK;
 }
 
@@ -142,11 +404,31 @@ esp_err_t Player::testPlayback(TestData data) {
         fb.set_test_mode(FbTestMode::BREATH);
     }
 
+    /* the breath effect needs the full rate whatever the show's tick is */
+    clock.set_period_us(1000000 / LD_CFG_PLAYER_FPS);
     clock.start();
 
     return ESP_OK;
 }
 
+esp_err_t Player::selectShow(uint8_t show_id) {
+    ESP_RETURN_ON_ERROR(clock.pause(), TAG, "Failed to pause clock");
+#if LD_CFG_ENABLE_SD
+    ESP_RETURN_ON_ERROR(frame_system_open(show_id), TAG, "Failed to open show %u", (unsigned)show_id);
+#endif
+    return ESP_OK;
+}
+
+esp_err_t Player::compileShow() {
+#if LD_CFG_ENABLE_SD
+    /* reopens the show at frame 0, READY is re-entered afterwards to reload the frame buffer */
+    ESP_RETURN_ON_ERROR(frame_system_compile(), TAG, "show not compiled");
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
 /* ================= RTOS ================= */
 
 esp_err_t Player::createTask() {
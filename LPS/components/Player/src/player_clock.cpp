@@ -13,17 +13,51 @@ PlayerMetronome::~PlayerMetronome() {
     deinit();
 }
 
-static bool IRAM_ATTR timer_on_alarm_cb(gptimer_handle_t timer, const gptimer_alarm_event_data_t* edata, void* user_ctx) {
-    TaskHandle_t task = static_cast<TaskHandle_t>(user_ctx);
+bool IRAM_ATTR PlayerMetronome::on_alarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t* edata, void* user_ctx) {
+    PlayerMetronome* m = static_cast<PlayerMetronome*>(user_ctx);
     BaseType_t hp_task_woken = pdFALSE;
 
-    if(task) {
-        xTaskNotifyFromISR(task, NOTIFICATION_UPDATE, eSetBits, &hp_task_woken);
+    /* when this tick was due, for the player's deadline monitor */
+    portENTER_CRITICAL_ISR(&m->alarm_lock);
+    m->alarms++;
+    m->alarm_us = esp_timer_get_time();
+    portEXIT_CRITICAL_ISR(&m->alarm_lock);
+
+    if(m->one_shot) {
+        /* first tick of start_at(): keep the phase, reload back to this count every period */
+        m->one_shot = false;
+        gptimer_alarm_config_t alarm_cfg = {
+            .alarm_count = edata->alarm_value + m->period_us,
+            .reload_count = edata->alarm_value,
+            .flags =
+                {
+                    .auto_reload_on_alarm = true,
+                },
+        };
+        gptimer_set_alarm_action(timer, &alarm_cfg);
+    }
+
+    if(m->task) {
+        xTaskNotifyFromISR(m->task, NOTIFICATION_UPDATE, eSetBits, &hp_task_woken);
     }
 
     return hp_task_woken == pdTRUE;
 }
 
+esp_err_t PlayerMetronome::set_alarm(uint64_t alarm_count, uint64_t reload_count, bool periodic) {
+    gptimer_alarm_config_t alarm_cfg = {
+        .alarm_count = alarm_count,
+        .reload_count = reload_count,
+        .flags =
+            {
+                .auto_reload_on_alarm = periodic,
+            },
+    };
+    one_shot = !periodic;
+
+    return gptimer_set_alarm_action(timer, &alarm_cfg);
+}
+
 esp_err_t PlayerMetronome::init(TaskHandle_t _task, uint32_t _period_us) {
     if(state != MetronomeState::UNINIT) {
         return ESP_OK;
@@ -46,24 +80,15 @@ esp_err_t PlayerMetronome::init(TaskHandle_t _task, uint32_t _period_us) {
     ESP_RETURN_ON_ERROR(ret, TAG, "new timer failed");
 
     gptimer_event_callbacks_t cbs = {
-        .on_alarm = timer_on_alarm_cb,  // Call the user callback function when the alarm event occurs
+        .on_alarm = on_alarm,  // Call the user callback function when the alarm event occurs
     };
-    ret = gptimer_register_event_callbacks(timer, &cbs, task);
+    ret = gptimer_register_event_callbacks(timer, &cbs, this);
     if(ret != ESP_OK) {
         deinit();
         return ret;
     }
 
-    gptimer_alarm_config_t alarm_cfg = {
-        .alarm_count = period_us,
-        .reload_count = 0,
-        .flags =
-            {
-                .auto_reload_on_alarm = true,
-            },
-    };
-
-    ret = gptimer_set_alarm_action(timer, &alarm_cfg);
+    ret = set_alarm(period_us, 0, true);
     if(ret != ESP_OK) {
         deinit();
         return ret;
@@ -121,6 +146,43 @@ esp_err_t PlayerMetronome::start() {
     return ESP_OK;
 }
 
+esp_err_t PlayerMetronome::start_at(uint32_t delay_us) {
+    ESP_RETURN_ON_FALSE(state != MetronomeState::UNINIT, ESP_ERR_INVALID_STATE, TAG, "start before init");
+
+    ESP_RETURN_ON_ERROR(stop(), TAG, "stop failed");
+
+    /* an alarm at count 0 would wait for a full wrap */
+    gptimer_set_raw_count(timer, 0);
+    ESP_RETURN_ON_ERROR(set_alarm(delay_us > 0 ? delay_us : 1, 0, false), TAG, "set alarm failed");
+
+    esp_err_t ret = gptimer_start(timer);
+    ESP_RETURN_ON_ERROR(ret, TAG, "gptimer_start failed");
+
+    state = MetronomeState::RUNNING;
+    return ESP_OK;
+}
+
+esp_err_t PlayerMetronome::restart_in(uint32_t delay_us, uint32_t new_period_us) {
+    ESP_RETURN_ON_FALSE(state == MetronomeState::RUNNING, ESP_ERR_INVALID_STATE, TAG, "restart while stopped");
+    ESP_RETURN_ON_FALSE(new_period_us > 0, ESP_ERR_INVALID_ARG, TAG, "invalid period");
+
+    /* the one-shot of start_at(), whose first alarm goes periodic at the new period */
+    period_us = new_period_us;
+    return start_at(delay_us);
+}
+
+uint32_t PlayerMetronome::take_alarms(int64_t* last_us) {
+    portENTER_CRITICAL(&alarm_lock);
+    const uint32_t n = alarms;
+    alarms = 0;
+    if(last_us) {
+        *last_us = alarm_us;
+    }
+    portEXIT_CRITICAL(&alarm_lock);
+
+    return n;
+}
+
 esp_err_t PlayerMetronome::stop() {
     if(state != MetronomeState::RUNNING) {
         return ESP_OK;
@@ -140,7 +202,8 @@ esp_err_t PlayerMetronome::reset() {
     stop();
     gptimer_set_raw_count(timer, 0);
 
-    return ESP_OK;
+    /* drop a phase set by start_at() */
+    return set_alarm(period_us, 0, true);
 }
 
 esp_err_t PlayerMetronome::set_period_us(uint32_t new_period_us) {
@@ -158,16 +221,7 @@ esp_err_t PlayerMetronome::set_period_us(uint32_t new_period_us) {
 
     period_us = new_period_us;
 
-    gptimer_alarm_config_t alarm_config = {
-        .alarm_count = period_us,
-        .reload_count = 0,
-        .flags =
-            {
-                .auto_reload_on_alarm = true,
-            },
-    };
-
-    esp_err_t ret = gptimer_set_alarm_action(timer, &alarm_config);
+    esp_err_t ret = set_alarm(period_us, 0, true);
     ESP_RETURN_ON_ERROR(ret, TAG, "set alarm failed");
 
     if(was_running) {
@@ -253,14 +307,41 @@ esp_err_t PlayerClock::start() {
     return ESP_OK;
 }
 
+esp_err_t PlayerClock::start_at(int64_t start_us) {
+    ESP_RETURN_ON_FALSE(state != ClockState::UNINIT, ESP_ERR_INVALID_STATE, TAG, "start before init");
+
+    if(state == ClockState::RUNNING) {
+        return ESP_OK;
+    }
+
+    const int64_t now = esp_timer_get_time();
+    last_start_us = start_us;
+
+    if(with_metronome) {
+        /* first tick at start_us; when it already passed, at the next tick of the grid it starts */
+        const int64_t period = metronome.get_period_us();
+        int64_t delay_us = start_us - now;
+        if(delay_us < 0) {
+            delay_us = (period - (-delay_us) % period) % period;
+        }
+        esp_err_t ret = metronome.start_at((uint32_t)delay_us);
+        if(ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    state = ClockState::RUNNING;
+
+    return ESP_OK;
+}
+
 esp_err_t PlayerClock::pause() {
     ESP_RETURN_ON_FALSE(state != ClockState::UNINIT, ESP_ERR_INVALID_STATE, TAG, "pause before init");
     if(state != ClockState::RUNNING) {
         return ESP_OK;
     }
 
-    int64_t now = esp_timer_get_time();
-    accumulated_us += (now - last_start_us);
+    accumulated_us += elapsed_us(esp_timer_get_time());
 
     if(with_metronome) {
         metronome.stop();
@@ -299,6 +380,70 @@ esp_err_t PlayerClock::set_time_us(int64_t target_us) {
     return ESP_OK;
 }
 
+esp_err_t PlayerClock::shift_us(int64_t delta_us) {
+    ESP_RETURN_ON_FALSE(state != ClockState::UNINIT, ESP_ERR_INVALID_STATE, TAG, "shift before init");
+
+    accumulated_us += delta_us;
+
+    return ESP_OK;
+}
+
+esp_err_t PlayerClock::set_tempo_pct(uint16_t pct) {
+    ESP_RETURN_ON_FALSE(state != ClockState::UNINIT, ESP_ERR_INVALID_STATE, TAG, "set tempo before init");
+    ESP_RETURN_ON_FALSE(pct >= LD_CFG_PLAYER_TEMPO_MIN_PCT && pct <= LD_CFG_PLAYER_TEMPO_MAX_PCT, ESP_ERR_INVALID_ARG, TAG, "tempo %u%% out of range", pct);
+
+    /* fold the time so far in at the old tempo, continue from here at the new one */
+    if(state == ClockState::RUNNING) {
+        int64_t now = esp_timer_get_time();
+        if(now > last_start_us) {
+            accumulated_us += elapsed_us(now);
+            last_start_us = now;
+        }
+    }
+    tempo_q16 = ((uint32_t)pct << 16) / 100;
+
+    ESP_LOGI(TAG, "tempo %u%%", pct);
+    return ESP_OK;
+}
+
+esp_err_t PlayerClock::set_period_us(uint32_t period_us) {
+    ESP_RETURN_ON_FALSE(state != ClockState::UNINIT, ESP_ERR_INVALID_STATE, TAG, "set period before init");
+
+    if(!with_metronome) {
+        return ESP_OK;
+    }
+
+    return metronome.set_period_us(period_us);
+}
+
+esp_err_t PlayerClock::tick_in(uint32_t delay_us, uint32_t period_us) {
+    ESP_RETURN_ON_FALSE(state == ClockState::RUNNING && with_metronome, ESP_ERR_INVALID_STATE, TAG, "tick_in while stopped");
+
+    return metronome.restart_in(delay_us, period_us);
+}
+
+int64_t PlayerClock::until_us(int64_t show_us) const {
+    const int64_t d = show_us - accumulated_us;
+    if(d <= 0) {
+        return d;
+    }
+
+    /* inverse of elapsed_us(), rounded up so now_us() has reached show_us by then */
+    const int64_t wall = ((d << 16) + tempo_q16 - 1) / tempo_q16;
+    return last_start_us + wall - esp_timer_get_time();
+}
+
+uint32_t PlayerClock::take_alarms(int64_t* last_us) {
+    if(!with_metronome) {
+        return 0;
+    }
+    return metronome.take_alarms(last_us);
+}
+
+uint32_t PlayerClock::period_us() const {
+    return with_metronome ? metronome.get_period_us() : 0;
+}
+
 int64_t PlayerClock::now_us() const {
     if(state == ClockState::UNINIT) {
         return 0;
@@ -308,6 +453,13 @@ int64_t PlayerClock::now_us() const {
         return accumulated_us;
     }
 
-    int64_t now = esp_timer_get_time();
-    return accumulated_us + (now - last_start_us);
+    return accumulated_us + elapsed_us(esp_timer_get_time());
+}
+
+int64_t PlayerClock::elapsed_us(int64_t now) const {
+    /* start_at() in the future: the timeline holds until then */
+    if(now <= last_start_us) {
+        return 0;
+    }
+    return ((now - last_start_us) * tempo_q16) >> 16;
 }
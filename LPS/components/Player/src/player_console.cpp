@@ -1,14 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "esp_console.h"
 #include "esp_log.h"
 
 #include "player.hpp"
+#include "sd_latency.h"
 
 /* ================= config ================= */
 
 #define PROMPT_STR "cmd"
+#define SDLAT_DUMP_PATH "0:/sdlat.txt"
 
 /* ================= static state (ONLY HERE) ================= */
 
@@ -93,6 +96,155 @@ static int cmd_test(int argc, char** argv) {
     return 0;
 }
 
+static int cmd_show(int argc, char** argv) {
+    if(argc < 2) {
+        printf("Usage: show <id>\n");
+        return 1;
+    }
+
+    int id = atoi(argv[1]);
+    if(id < 0 || id > 255) {
+        printf("show id must be 0..255\n");
+        return 1;
+    }
+
+    Player::getInstance().select((uint8_t)id);
+    return 0;
+}
+
+static int cmd_compile(int argc, char** argv) {
+    return Player::getInstance().compile() == ESP_OK ? 0 : 1;
+}
+
+static int cmd_tempo(int argc, char** argv) {
+    if(argc < 2) {
+        printf("Usage: tempo <%d..%d percent>\n", LD_CFG_PLAYER_TEMPO_MIN_PCT, LD_CFG_PLAYER_TEMPO_MAX_PCT);
+        return 1;
+    }
+
+    int pct = atoi(argv[1]);
+    if(pct < LD_CFG_PLAYER_TEMPO_MIN_PCT || pct > LD_CFG_PLAYER_TEMPO_MAX_PCT) {
+        printf("tempo must be %d..%d\n", LD_CFG_PLAYER_TEMPO_MIN_PCT, LD_CFG_PLAYER_TEMPO_MAX_PCT);
+        return 1;
+    }
+
+    return Player::getInstance().setTempo((uint16_t)pct) == ESP_OK ? 0 : 1;
+}
+
+static int cmd_loop(int argc, char** argv) {
+    if(argc == 2 && strcmp(argv[1], "off") == 0) {
+        return Player::getInstance().clearLoop() == ESP_OK ? 0 : 1;
+    }
+    if(argc < 3) {
+        printf("Usage: loop <a_ms> <b_ms> | off\n");
+        return 1;
+    }
+
+    long a = atol(argv[1]);
+    long b = atol(argv[2]);
+    if(a < 0 || b <= a) {
+        printf("loop needs 0 <= a_ms < b_ms\n");
+        return 1;
+    }
+
+    return Player::getInstance().setLoop((uint32_t)a, (uint32_t)b) == ESP_OK ? 0 : 1;
+}
+
+static int cmd_tick(int argc, char** argv) {
+    if(argc == 2 && strcmp(argv[1], "reset") == 0) {
+        Player::getInstance().resetTickStats();
+        return 0;
+    }
+    if(argc != 1) {
+        printf("Usage: tick [reset]\n");
+        return 1;
+    }
+
+    const PlayerTickStats s = Player::getInstance().getTickStats();
+    const uint64_t total_us = s.rate_us + s.hold_us;
+    printf("periodic %llu ms %lu ticks, hold %llu ms %lu ticks (%llu%% of the time)\n", (unsigned long long)(s.rate_us / 1000), (unsigned long)s.rate_ticks,
+           (unsigned long long)(s.hold_us / 1000), (unsigned long)s.hold_ticks, (unsigned long long)(total_us ? s.hold_us * 100 / total_us : 0));
+    printf("%lu ticks, a fixed %d Hz tick takes %llu\n", (unsigned long)(s.rate_ticks + s.hold_ticks), LD_CFG_PLAYER_FPS, (unsigned long long)(total_us * LD_CFG_PLAYER_FPS / 1000000));
+    printf("missed %lu folded %lu max_late_us %lu max_render_us %lu\n", (unsigned long)s.missed, (unsigned long)s.folded, (unsigned long)s.max_late_us, (unsigned long)s.max_render_us);
+
+    for(int b = 0; b < PLAYER_LATE_BUCKETS; b++) {
+        if(!s.late_hist[b])
+            continue;
+        if(b + 1 < PLAYER_LATE_BUCKETS)
+            printf("  late < %-8lu us %8lu\n", (unsigned long)(128u << b), (unsigned long)s.late_hist[b]);
+        else
+            printf("  late >= %-7lu us %8lu\n", (unsigned long)(128u << (b - 1)), (unsigned long)s.late_hist[b]);
+    }
+    return 0;
+}
+
+static bool parse_blend(const char* s, uint8_t* out) {
+    static const char* const names[] = {"replace", "alpha", "add", "mul"};
+    for(uint8_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if(strcmp(s, names[i]) == 0) {
+            *out = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int cmd_layer(int argc, char** argv) {
+    LayerData d = {};
+    if(argc >= 2 && strcmp(argv[1], "overlay") == 0) {
+        d.layer = LAYER_OVERLAY;
+    } else if(argc >= 2 && strcmp(argv[1], "override") == 0) {
+        d.layer = LAYER_OVERRIDE;
+    } else {
+        argc = 0;
+    }
+
+    if(argc == 3 && strcmp(argv[2], "off") == 0) {
+        return Player::getInstance().clearLayer(d.layer) == ESP_OK ? 0 : 1;
+    }
+    if(argc < 5) {
+        printf("Usage: layer <overlay|override> <r> <g> <b> [ms] [replace|alpha|add|mul] [alpha] [blink_ms] [mask_hex]\n"
+               "       layer <overlay|override> off\n");
+        return 1;
+    }
+
+    d.r = (uint8_t)atoi(argv[2]);
+    d.g = (uint8_t)atoi(argv[3]);
+    d.b = (uint8_t)atoi(argv[4]);
+    d.duration_ms = (argc > 5) ? (uint32_t)strtoul(argv[5], NULL, 10) : 0;
+    if(argc > 6 && !parse_blend(argv[6], &d.blend)) {
+        printf("unknown blend %s\n", argv[6]);
+        return 1;
+    }
+    d.alpha = (argc > 7) ? (uint8_t)atoi(argv[7]) : 255;
+    d.blink_ms = (argc > 8) ? (uint16_t)strtoul(argv[8], NULL, 10) : 0;
+    d.mask = (argc > 9) ? strtoull(argv[9], NULL, 16) : LD_FRAME_FADE_ALL;
+
+    return Player::getInstance().setLayer(d) == ESP_OK ? 0 : 1;
+}
+
+static int cmd_sdlat(int argc, char** argv) {
+    if(argc == 1) {
+        sd_latency_print();
+        return 0;
+    }
+
+    if(strcmp(argv[1], "reset") == 0) {
+        sd_latency_reset();
+        return 0;
+    }
+
+    if(strcmp(argv[1], "dump") == 0) {
+        const char* path = (argc > 2) ? argv[2] : SDLAT_DUMP_PATH;
+        esp_err_t err = sd_latency_dump(path);
+        printf("%s: %s\n", path, esp_err_to_name(err));
+        return err == ESP_OK ? 0 : 1;
+    }
+
+    printf("Usage: sdlat [reset | dump [path]]\n");
+    return 1;
+}
+
 /* ================= register commands ================= */
 
 static void register_cmd(const char* name, const char* help, esp_console_cmd_func_t func) {
@@ -115,6 +267,13 @@ static void register_all_commands(void) {
     register_cmd("release", "release player", &cmd_release);
     // register_cmd("load", "load frames", &cmd_load);
     register_cmd("test", "test rgb output", &cmd_test);
+    register_cmd("show", "switch to show <id> from the show library", &cmd_show);
+    register_cmd("compile", "build the compiled cache of the loaded show, READY only", &cmd_compile);
+    register_cmd("tempo", "show speed in percent for rehearsals: tempo <pct>", &cmd_tempo);
+    register_cmd("loop", "A-B loop for rehearsals: loop <a_ms> <b_ms> | off", &cmd_loop);
+    register_cmd("tick", "ticks and time periodic / asleep, tick deadlines while playing: tick [reset]", &cmd_tick);
+    register_cmd("layer", "overlay / override color over the show: layer <overlay|override> <r> <g> <b> [ms] [blend] [alpha] [blink_ms] [mask] | off", &cmd_layer);
+    register_cmd("sdlat", "SD read latency histogram: sdlat [reset | dump [path]]", &cmd_sdlat);
     register_cmd("exit", "exit player", &cmd_exit);
 }
 
@@ -19,6 +19,18 @@ const char* getEventName(int type) {
             return "TEST";
         case EVENT_EXIT:
             return "EXIT";
+        case EVENT_SELECT:
+            return "SELECT";
+        case EVENT_LAYER:
+            return "LAYER";
+        case EVENT_PREROLL:
+            return "PREROLL";
+        case EVENT_TEMPO:
+            return "TEMPO";
+        case EVENT_LOOP:
+            return "LOOP";
+        case EVENT_COMPILE:
+            return "COMPILE";
         default:
             return "UNKNOWN";
     }
@@ -63,6 +75,7 @@ void Player::switchState(PlayerState newState) {
 #if SHOW_TRANSITION
             ESP_LOGI("state.cpp", "Enter Unloaded!");
 #endif
+            m_prerolled = false;
             if(releaseResources() == ESP_OK) {
                 ESP_LOGI(TAG, "resources released");
                 vTaskDelay(pdMS_TO_TICKS(LD_CFG_PLAYER_BOOT_RELOAD_DELAY_MS));
@@ -121,6 +134,29 @@ void Player::switchState(PlayerState newState) {
 
 void Player::processEvent(Event& e) {
 
+    // layers sit on top of every state and never change it
+    if(e.type == EVENT_LAYER) {
+        fb.set_layer(e.layer_data);
+        m_prerolled = false; // the staged frame 0 has the old layers
+        wakeTick();
+        return;
+    }
+
+    // tempo scales the clock from now on, in every state
+    if(e.type == EVENT_TEMPO) {
+        clock.set_tempo_pct((uint16_t)e.data);
+        wakeTick();
+        return;
+    }
+
+    // the loop region holds in every state; READY moves to its new start (A, or 0 without a loop)
+    if(e.type == EVENT_LOOP) {
+        if(fb.set_loop(e.loop_data.a_ms, e.loop_data.b_ms) == ESP_OK && m_state == PlayerState::READY)
+            switchState(PlayerState::READY);
+        wakeTick();
+        return;
+    }
+
     switch(m_state) {
         case PlayerState::UNLOADED:
             if(e.type == EVENT_LOAD) {
@@ -140,15 +176,28 @@ void Player::processEvent(Event& e) {
             break;
 
         case PlayerState::READY:
-            if(e.type == EVENT_PLAY)
+            if(e.type == EVENT_PLAY) {
+                m_play_at_us = e.start_us;
                 switchState(PlayerState::PLAYING);
+            }
             else if(e.type == EVENT_RELEASE)
                 switchState(PlayerState::UNLOADED);
             else if(e.type == EVENT_TEST) {
                 m_test_data = e.test_data;
 
                 switchState(PlayerState::TEST);
-            } else
+            } else if(e.type == EVENT_SELECT) {
+                selectShow(e.data);
+                switchState(PlayerState::READY);
+            } else if(e.type == EVENT_PREROLL)
+                prerollPlayback();
+            else if(e.type == EVENT_STOP)
+                m_prerolled = false; // scheduled play cancelled
+            else if(e.type == EVENT_COMPILE) {
+                compileShow();
+                switchState(PlayerState::READY);
+            }
+            else
                 ESP_LOGW(TAG, "ReadyState: ignoring event %s", getEventName(e.type));
             break;
 
@@ -159,18 +208,26 @@ void Player::processEvent(Event& e) {
                 switchState(PlayerState::READY);
             else if(e.type == EVENT_RELEASE)
                 switchState(PlayerState::UNLOADED);
-            else
+            else if(e.type == EVENT_SELECT) {
+                selectShow(e.data);
+                switchState(PlayerState::READY);
+            } else
                 ESP_LOGW(TAG, "PlayingState: ignoring event %s", getEventName(e.type));
             break;
 
         case PlayerState::PAUSE:
-            if(e.type == EVENT_PLAY)
+            if(e.type == EVENT_PLAY) {
+                m_play_at_us = e.start_us;
                 switchState(PlayerState::PLAYING);
+            }
             else if(e.type == EVENT_STOP)
                 switchState(PlayerState::READY);
             else if(e.type == EVENT_RELEASE)
                 switchState(PlayerState::UNLOADED);
-            else
+            else if(e.type == EVENT_SELECT) {
+                selectShow(e.data);
+                switchState(PlayerState::READY);
+            } else
                 ESP_LOGW(TAG, "PauseState: ignoring event %s", getEventName(e.type));
             break;
 
@@ -182,6 +239,9 @@ void Player::processEvent(Event& e) {
                 switchState(PlayerState::READY);
             else if(e.type == EVENT_RELEASE) {
                 switchState(PlayerState::UNLOADED);
+            } else if(e.type == EVENT_SELECT) {
+                selectShow(e.data);
+                switchState(PlayerState::READY);
             } else
                 ESP_LOGW(TAG, "TestState: ignoring event %s", getEventName(e.type));
             break;
@@ -42,6 +42,68 @@
 #define LD_CFG_PLAYER_DEBUG_DUMP_PIXELS 5
 #define LD_CFG_PLAYER_GPTIMER_RESOLUTION_HZ 1000000
 
+/* Player: pick the tick period per show from its timestamps (see show_profile.h), 0 keeps LD_CFG_PLAYER_FPS;
+ * the auto tick stays within LD_CFG_PLAYER_TICK_MIN_MS ~ LD_CFG_PLAYER_TICK_MAX_MS */
+#define LD_CFG_PLAYER_AUTO_TICK 1
+#define LD_CFG_PLAYER_TICK_MIN_MS 10
+#define LD_CFG_PLAYER_TICK_MAX_MS 100
+
+/* Player: adaptive tick, the period follows the frames (see Player/docs/04-clock-and-task.md):
+ * fades, effects and blinking layers tick at the per-show tick above, holds sleep until their next
+ * keyframe or layer expiry, and two ticks are never closer than LD_CFG_PLAYER_MAX_FPS allows;
+ * 0 runs every tick at the per-show tick */
+#define LD_CFG_PLAYER_ADAPTIVE_TICK 1
+#define LD_CFG_PLAYER_MAX_FPS 100
+
+/* Player: a BLE PLAY is handed to the player this long before its target time, so the metronome
+ * can arm its first tick at the target itself instead of one event round trip after it */
+#define LD_CFG_PLAYER_SYNC_LEAD_US 10000
+
+/* Player: tempo range for rehearsals (show time per wall time, percent); PT_Reader sizes the
+ * prefetch ring for the fastest tempo, so a maximum above 100 costs prefetch slots */
+#define LD_CFG_PLAYER_TEMPO_MIN_PCT 25
+#define LD_CFG_PLAYER_TEMPO_MAX_PCT 100
+
+/* PT_Reader: keep per-frame checksum checks during playback even when the show is verified */
+#define LD_CFG_PT_READER_PARANOID 0
+
+/* PT_Reader: allow a playback cache next to frame.dat (see show_compile.h), built by
+ * frame_system_compile() at boot and after an upload, and used instead of streaming frame.dat
+ * from SD; step frames are stored
+ * gamma / brightness corrected in LedController wire order */
+#define LD_CFG_PT_READER_COMPILE 1
+
+/* PT_Reader: copy frame.dat into the "show" flash partition and play it via mmap (SD fallback) */
+#define LD_CFG_ENABLE_SHOW_FLASH 1
+
+/* PT_Reader: load frame.dat into RAM at init when it is at most this many bytes (0 disables),
+ * as long as the heap keeps LD_CFG_PT_READER_RAM_CACHE_HEAP_RESERVE bytes free afterwards */
+#define LD_CFG_PT_READER_RAM_CACHE_BYTES (64 * 1024)
+#define LD_CFG_PT_READER_RAM_CACHE_HEAP_RESERVE (32 * 1024)
+
+/* PT_Reader: frames the SD reader task may buffer ahead (about 2.5 KB each), sized per show
+ * to ride out an SD stall of LD_CFG_PT_READER_PREFETCH_COVER_MS at its densest frame rate */
+#define LD_CFG_PT_READER_PREFETCH_MAX 8
+#define LD_CFG_PT_READER_PREFETCH_COVER_MS 100
+
+/* PT_Reader: sync points noted while a show plays, frame_seek() decodes from the nearest one;
+ * at least LD_CFG_PT_READER_SEEK_MARK_MS apart, a full table keeps every other one at twice the spacing */
+#define LD_CFG_PT_READER_SEEK_MARKS 64
+#define LD_CFG_PT_READER_SEEK_MARK_MS 1000
+
+/* PT_Reader profiling: log average per-frame read + decode time every N frames */
+#define LD_CFG_PT_READER_PROFILE 0
+#define LD_CFG_PT_READER_PROFILE_WINDOW 200
+
+/* PT_Reader: histogram of every SD f_read during playback (see sd_latency.h);
+ * a read longer than LD_CFG_PT_READER_SD_STALL_US counts as a stall (default: one frame period) */
+#define LD_CFG_PT_READER_SD_LATENCY 1
+#define LD_CFG_PT_READER_SD_STALL_US (1000000 / LD_CFG_PLAYER_FPS)
+
+/* PT_Reader: show library index on SD (see show_library.h) and max number of shows */
+#define LD_CFG_SHOW_LIBRARY_PATH "0:/shows.idx"
+#define LD_CFG_SHOW_LIBRARY_MAX 16
+
 /* Behavior controls */
 #define LD_CFG_IGNORE_DRIVER_INIT_FAIL 1
 #define LD_CFG_SHOW_TIME_PER_FRAME 0
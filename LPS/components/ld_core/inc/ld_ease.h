@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ld_ease.h
+ * @brief Easing curves for fades, applied to the 0..255 interpolation factor.
+ *
+ * A curve maps the linear factor p to the factor passed to the lerp, so it costs
+ * one table lookup per frame, not per pixel. Every curve maps 0 to 0 and 255 to 255,
+ * so a fade still starts and ends exactly on its keyframes.
+ */
+
+/** Built-in curves; ids 5 ~ 7 are reserved. */
+typedef enum {
+    LD_EASE_LINEAR = 0, /*!< p */
+    LD_EASE_IN,         /*!< p^2, slow start */
+    LD_EASE_OUT,        /*!< 1 - (1 - p)^2, slow end */
+    LD_EASE_IN_OUT,     /*!< smoothstep 3p^2 - 2p^3 */
+    LD_EASE_STEP,       /*!< hold the first half, then jump to the next key */
+    LD_EASE_BUILTIN_NUM,
+} ld_ease_t;
+
+/** Id of the first custom curve; custom curve i has id LD_EASE_CUSTOM(i). */
+#define LD_EASE_CUSTOM_FIRST 8
+/** Custom curves a show can carry. */
+#define LD_EASE_CUSTOM_MAX 8
+#define LD_EASE_CUSTOM(i) (LD_EASE_CUSTOM_FIRST + (i))
+
+/** Size of one curve table. */
+#define LD_EASE_LUT_SIZE 256
+
+/** Built-in curves, then the custom curves of the current show. */
+extern uint8_t ld_ease_lut[LD_EASE_BUILTIN_NUM + LD_EASE_CUSTOM_MAX][LD_EASE_LUT_SIZE];
+
+/**
+ * @brief Build the built-in curve tables.
+ *
+ * Call once during startup, next to calc_gamma_lut().
+ */
+void calc_ease_lut(void);
+
+/**
+ * @brief Load the custom curves of a show, count x LD_EASE_LUT_SIZE bytes.
+ *
+ * Ids past count become invalid and play linear. count = 0 clears them.
+ *
+ * @return false if count is too large or a curve does not map 0 to 0 and 255 to 255
+ */
+bool ld_ease_set_custom(uint8_t count, const uint8_t* curves);
+
+/**
+ * @brief Number of custom curves loaded; curve i is ld_ease_lut[LD_EASE_BUILTIN_NUM + i].
+ */
+uint8_t ld_ease_custom_count(void);
+
+/**
+ * @brief Return true if ease is a built-in curve or a loaded custom curve.
+ */
+bool ld_ease_valid(uint8_t ease);
+
+/**
+ * @brief Apply curve ease to p; ids that are not valid leave p linear.
+ */
+static inline uint8_t ld_ease_apply(uint8_t ease, uint8_t p) {
+    if(ease == LD_EASE_LINEAR || (ease >= LD_EASE_BUILTIN_NUM && ease < LD_EASE_CUSTOM_FIRST))
+        return p;
+    uint8_t slot = (ease < LD_EASE_CUSTOM_FIRST) ? ease : (uint8_t)(ease - LD_EASE_CUSTOM_FIRST + LD_EASE_BUILTIN_NUM);
+    if(slot >= LD_EASE_BUILTIN_NUM + LD_EASE_CUSTOM_MAX)
+        return p;
+    return ld_ease_lut[slot][p];
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ld_led_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ld_effect.h
+ * @brief Procedural effects evaluated per tick, instead of baked keyframes.
+ *
+ * An effect is a few parameters; the Player evaluates it every tick in fixed point
+ * over the channels of its track (PT v1.9 EFFECT records, pt_format.h). Output is
+ * pre-gamma GRB like any keyframe value.
+ *
+ * Time runs in 1/65536 cycles: pos = phase + t * 65536 / period_ms. With spread,
+ * pixel i lags pixel 0 by i * spread / 256 of a cycle, so the pattern travels
+ * along the strip (a chase). PCA9955B channel ch counts as pixel ch.
+ */
+
+/** Effect types. */
+typedef enum {
+    LD_EFFECT_RAINBOW = 0, /*!< hue wheel, one turn per period, value = param */
+    LD_EFFECT_STROBE,      /*!< a for param / 256 of the period, then b */
+    LD_EFFECT_BREATH,      /*!< b -> a -> b once per period, smoothstep */
+    LD_EFFECT_SPARKLE,     /*!< each period, param / 256 of the pixels flash a and fade back to b */
+    LD_EFFECT_NUM,
+} ld_effect_type_t;
+
+/** Parameters of one effect. */
+typedef struct {
+    uint8_t type;       /*!< ld_effect_type_t */
+    uint8_t param;      /*!< rainbow: value, strobe: duty, sparkle: density; unused by breath */
+    uint8_t spread;     /*!< per-pixel lag, 1/256 cycle per pixel; unused by sparkle */
+    uint16_t period_ms; /*!< one cycle, never 0 */
+    uint16_t phase;     /*!< cycle position at t = 0, 1/65536 cycle */
+    grb8_t a;           /*!< palette: main color */
+    grb8_t b;           /*!< palette: background color */
+} ld_effect_t;
+
+/**
+ * @brief Return true if the type is known and the period is not 0.
+ */
+static inline bool ld_effect_valid(const ld_effect_t* fx) {
+    return fx->type < LD_EFFECT_NUM && fx->period_ms != 0;
+}
+
+/**
+ * @brief Write n pixels of an effect t_ms after it started.
+ *
+ * @param first  index of px[0] along the effect's pixels, for spread and sparkle
+ *
+ * Uses the easing tables, so calc_ease_lut() must have run.
+ */
+void ld_effect_render(const ld_effect_t* fx, uint32_t t_ms, uint16_t first, grb8_t* px, uint16_t n);
+
+#ifdef __cplusplus
+}
+#endif
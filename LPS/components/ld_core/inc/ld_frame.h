@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include "ld_board.h"
+#include "ld_effect.h"
 #include "ld_led_types.h"
 
 /**
@@ -21,14 +22,63 @@ typedef struct {
     grb8_t ws2812b[LD_BOARD_WS2812B_NUM][LD_BOARD_WS2812B_MAX_PIXEL_NUM];
 } frame_data;
 
+/**
+ * @brief Output-ready payload in LedController transmit-buffer order, gamma and brightness applied.
+ *
+ * Same size as frame_data, and every pixel keeps its byte offset, so a frame_data can be
+ * converted in place.
+ */
+typedef struct {
+    /** PCA9955B PWM registers per IC, R G B per channel. */
+    uint8_t pca9955b[LD_BOARD_PCA9955B_NUM][LD_BOARD_PCA9955B_BUFFER_DATA_LEN];
+    /** WS2812B bytes per strip, G R B per pixel. */
+    uint8_t ws2812b[LD_BOARD_WS2812B_NUM][3 * LD_BOARD_WS2812B_MAX_PIXEL_NUM];
+} frame_wire;
+
+/** fade_mask bit of PCA9955B channel ch. */
+#define LD_FRAME_FADE_PCA9955B(ch) (1ULL << (ch))
+/** fade_mask bit of WS2812B strip s. */
+#define LD_FRAME_FADE_WS2812B(s) (1ULL << (LD_BOARD_PCA9955B_CH_NUM + (s)))
+/** fade_mask with every channel fading. */
+#define LD_FRAME_FADE_ALL ((1ULL << (LD_BOARD_PCA9955B_CH_NUM + LD_BOARD_WS2812B_NUM)) - 1)
+
+/** Effects one frame can carry: the OF group and every strip running one at the same time. */
+#define LD_FRAME_EFFECT_MAX (LD_BOARD_WS2812B_NUM + 1)
+
+/**
+ * @brief Procedural effect running over some channels (PT v1.9 EFFECT records).
+ */
+typedef struct {
+    /** Channels driven by the effect, LD_FRAME_FADE_* bits; their payload bytes are 0. */
+    uint64_t mask;
+    /** Time of the effect key; the effect runs on time - start_ms. */
+    uint32_t start_ms;
+    /** Effect parameters. */
+    ld_effect_t fx;
+} ld_frame_effect_t;
+
 /**
  * @brief Time-tagged frame entry loaded from pattern tables.
  */
 typedef struct {
     /** Playback timestamp in microseconds or stream-defined unit. */
     uint64_t timestamp;
-    /** Whether transition to this frame should use fading. */
+    /** Whether any channel fades from this frame to the next one (fade_mask != 0). */
     bool fade;
-    /** Full frame payload. */
-    frame_data data;
+    /** Channels that fade to the next frame, LD_FRAME_FADE_* bits; whole-board formats set all or none. */
+    uint64_t fade_mask;
+    /** Easing curve of the fade to the next frame (ld_ease.h); LD_EASE_LINEAR before PT v1.8. */
+    uint8_t ease;
+    /** Set when the frame comes from the compiled playback cache as wire (show_compile.h). */
+    bool compiled;
+    /** Number of entries in effects; 0 before PT v1.9. */
+    uint8_t effect_count;
+    /** Effects rendered over the payload until the next frame. */
+    ld_frame_effect_t effects[LD_FRAME_EFFECT_MAX];
+    union {
+        /** Full frame payload. */
+        frame_data data;
+        /** Output-ready payload, valid when compiled is set (never for a fading frame). */
+        frame_wire wire;
+    };
 } table_frame_t;
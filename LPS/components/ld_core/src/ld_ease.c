@@ -0,0 +1,77 @@
+#include "ld_ease.h"
+
+#include <string.h>
+
+/**
+ * @file ld_ease.c
+ * @brief Easing curve LUT generation and the custom curves of the current show.
+ */
+
+enum {
+    U8_MAX = 255,
+};
+
+uint8_t ld_ease_lut[LD_EASE_BUILTIN_NUM + LD_EASE_CUSTOM_MAX][LD_EASE_LUT_SIZE];
+
+static uint8_t custom_count = 0;
+
+/**
+ * @brief Round y in [0,1] to 0..255.
+ */
+static uint8_t to_u8(float y) {
+    int yi = (int)(y * (float)U8_MAX + 0.5f);
+    if(yi < 0)
+        yi = 0;
+    if(yi > U8_MAX)
+        yi = U8_MAX;
+    return (uint8_t)yi;
+}
+
+static void build_identity(uint8_t dst[LD_EASE_LUT_SIZE]) {
+    for(int i = 0; i < LD_EASE_LUT_SIZE; ++i)
+        dst[i] = (uint8_t)i;
+}
+
+void calc_ease_lut(void) {
+    for(int i = 0; i < LD_EASE_LUT_SIZE; ++i) {
+        float t = (float)i / (float)U8_MAX;
+        float u = 1.0f - t;
+
+        ld_ease_lut[LD_EASE_LINEAR][i] = (uint8_t)i;
+        ld_ease_lut[LD_EASE_IN][i] = to_u8(t * t);
+        ld_ease_lut[LD_EASE_OUT][i] = to_u8(1.0f - u * u);
+        ld_ease_lut[LD_EASE_IN_OUT][i] = to_u8(t * t * (3.0f - 2.0f * t));
+        ld_ease_lut[LD_EASE_STEP][i] = (i < 128) ? 0 : U8_MAX;
+    }
+    ld_ease_set_custom(0, NULL);
+}
+
+bool ld_ease_set_custom(uint8_t count, const uint8_t* curves) {
+    if(count > LD_EASE_CUSTOM_MAX)
+        return false;
+    for(uint8_t c = 0; c < count; c++) {
+        const uint8_t* lut = curves + (uint32_t)c * LD_EASE_LUT_SIZE;
+        if(lut[0] != 0 || lut[LD_EASE_LUT_SIZE - 1] != U8_MAX)
+            return false;
+    }
+
+    for(uint8_t c = 0; c < LD_EASE_CUSTOM_MAX; c++) {
+        uint8_t* dst = ld_ease_lut[LD_EASE_BUILTIN_NUM + c];
+        if(c < count)
+            memcpy(dst, curves + (uint32_t)c * LD_EASE_LUT_SIZE, LD_EASE_LUT_SIZE);
+        else
+            build_identity(dst);
+    }
+    custom_count = count;
+    return true;
+}
+
+uint8_t ld_ease_custom_count(void) {
+    return custom_count;
+}
+
+bool ld_ease_valid(uint8_t ease) {
+    if(ease < LD_EASE_BUILTIN_NUM)
+        return true;
+    return ease >= LD_EASE_CUSTOM_FIRST && ease < LD_EASE_CUSTOM_FIRST + custom_count;
+}
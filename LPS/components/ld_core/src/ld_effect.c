@@ -0,0 +1,76 @@
+#include "ld_effect.h"
+
+#include "ld_ease.h"
+#include "ld_led_ops.h"
+
+/**
+ * @file ld_effect.c
+ * @brief Fixed-point evaluation of procedural effects.
+ */
+
+enum {
+    HUE_RANGE = 1536,
+};
+
+/**
+ * @brief Integer hash for sparkle, the same on every platform.
+ */
+static uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * @brief Color of a periodic effect at cycle position pos (1/65536 cycle).
+ */
+static grb8_t color_at(const ld_effect_t* fx, uint16_t pos) {
+    switch(fx->type) {
+        case LD_EFFECT_RAINBOW:
+            return hsv_to_grb_u8(hsv8((uint16_t)(((uint32_t)pos * HUE_RANGE) >> 16), 255, fx->param));
+        case LD_EFFECT_STROBE:
+            return ((pos >> 8) < fx->param) ? fx->a : fx->b;
+        case LD_EFFECT_BREATH: {
+            uint8_t tri = (uint8_t)((pos < 0x8000) ? pos >> 7 : (0xFFFF - pos) >> 7);
+            return grb_lerp_u8(fx->b, fx->a, ld_ease_apply(LD_EASE_IN_OUT, tri));
+        }
+        default:
+            return fx->b;
+    }
+}
+
+void ld_effect_render(const ld_effect_t* fx, uint32_t t_ms, uint16_t first, grb8_t* px, uint16_t n) {
+    if(!ld_effect_valid(fx)) {
+        for(uint16_t i = 0; i < n; i++)
+            px[i] = fx->b;
+        return;
+    }
+
+    /* 1/65536 cycles since the effect started; one division per call, none per pixel */
+    const uint64_t cycles = (((uint64_t)t_ms << 16) / fx->period_ms) + fx->phase;
+    const uint16_t pos = (uint16_t)cycles;
+
+    if(fx->type == LD_EFFECT_SPARKLE) {
+        /* a new set of pixels every cycle, each fading from a back to b over it */
+        const uint32_t seed = (uint32_t)(cycles >> 16) * 0x9E3779B1u;
+        const grb8_t flash = grb_lerp_u8(fx->a, fx->b, (uint8_t)(pos >> 8));
+        for(uint16_t i = 0; i < n; i++)
+            px[i] = ((hash32(seed + first + i) >> 24) < fx->param) ? flash : fx->b;
+        return;
+    }
+
+    if(fx->spread == 0) {
+        const grb8_t c = color_at(fx, pos);
+        for(uint16_t i = 0; i < n; i++)
+            px[i] = c;
+        return;
+    }
+
+    const uint16_t step = (uint16_t)(fx->spread << 8);
+    uint16_t p = (uint16_t)(pos - (uint32_t)first * step);
+    for(uint16_t i = 0; i < n; i++, p -= step)
+        px[i] = color_at(fx, p);
+}
@@ -5,8 +5,10 @@
 
 #include "bt_receiver.h"
 #include "esp_err.h"
+#include "esp_timer.h"
 #include "ld_board.h"
 #include "ld_config.h"
+#include "ld_ease.h"
 #include "ld_gamma_lut.h"
 #include "nvs_flash.h"
 
@@ -22,6 +24,57 @@ static const char* TAG = "APP";
 static bool frame_sys_ready = false;
 QueueHandle_t sys_cmd_queue = NULL;
 
+#if LD_CFG_ENABLE_BT
+static bt_receiver_config_t rx_cfg;
+
+/* Start the BLE receiver with rx_cfg (boot and after an upload) */
+static void start_bt_receiver(void) {
+    esp_err_t err = bt_receiver_init(&rx_cfg);
+    if(err == ESP_OK) err = bt_receiver_start();
+    if(err != ESP_OK) ESP_LOGE(TAG, "BLE receiver start failed: %s", esp_err_to_name(err));
+}
+#endif
+
+#if LD_CFG_ENABLE_SD
+/* * Build the compiled cache of the loaded show (PT_Reader show_compile.h).
+ * Returns at once when the cache is current or the show plays from RAM / flash.
+ * Must run while no task is inside read_frame(): before Player init, or with the Player held in TEST.
+ */
+static void compile_show(void) {
+    esp_err_t err = frame_system_compile();
+    if(err != ESP_OK && err != ESP_ERR_NOT_SUPPORTED) { // NOT_SUPPORTED: effect show, cache off or PARANOID
+        ESP_LOGW(TAG, "show compile: %s, streaming frame.dat", esp_err_to_name(err));
+    }
+}
+#endif
+
+/* * Apply uploaded files in place instead of rebooting.
+ * The Player has been held in TEST (green) since UPLOAD, so no task is inside read_frame().
+ */
+static esp_err_t hot_reload(void) {
+    int64_t t0 = esp_timer_get_time();
+
+#if LD_CFG_ENABLE_SD
+    if(!frame_sys_ready) return ESP_ERR_INVALID_STATE; // Nothing to reload, first show needs a boot
+
+    esp_err_t err = frame_system_reload();
+    if(err != ESP_OK) {
+        frame_sys_ready = false;
+        return err;
+    }
+    compile_show(); // LEDs stay green until the new show is compiled
+#endif
+
+    Player::getInstance().stop(); // TEST -> READY, rewinds to frame 0 of the new show
+
+#if LD_CFG_ENABLE_BT
+    start_bt_receiver();
+#endif
+
+    ESP_LOGI("SYS_TASK", "hot reload done in %lld ms", (long long)((esp_timer_get_time() - t0) / 1000));
+    return ESP_OK;
+}
+
 /* * Background task to handle system-level commands asynchronously.
  * Receives messages from BLE receiver or TCP client.
  */
@@ -49,12 +102,16 @@ static void sys_cmd_task(void* arg) {
                     esp_restart();
                     break;
 
-                case UPLOAD_SUCCESS:
-                    ESP_LOGD("SYS_TASK", ">>> [RESET] Download Completed! Rebooting in 1s...");
-                    Player::getInstance().stop(); // Turn off LEDs before reboot
-                    vTaskDelay(pdMS_TO_TICKS(1000));
-                    esp_restart(); // Reboot to apply new files and restore clean memory state
-                    break;
+                case UPLOAD_SUCCESS: {
+                    ESP_LOGD("SYS_TASK", ">>> [UPLOAD_SUCCESS] Download Completed! Reloading show...");
+                    esp_err_t err = hot_reload();
+                    if(err != ESP_OK) {
+                        ESP_LOGE("SYS_TASK", "hot reload failed (%s), rebooting in 1s...", esp_err_to_name(err));
+                        Player::getInstance().stop(); // Turn off LEDs before reboot
+                        vTaskDelay(pdMS_TO_TICKS(1000));
+                        esp_restart(); // Fall back to a clean boot
+                    }
+                } break;
 
                 default:
                     break;
@@ -70,8 +127,12 @@ static void sys_cmd_task(void* arg) {
 static void app_task(void* arg) {
     ESP_LOGI(TAG, "app_task start, HWM=%u", uxTaskGetStackHighWaterMark(NULL));
 
+    // 1. Pre-calculate Gamma Lookup Table for LED color correction (the show compile pass uses it)
+    calc_gamma_lut();
+    calc_ease_lut();
+
 #if LD_CFG_ENABLE_SD
-    // 1. Initialize SD Card and frame reading system
+    // 2. Initialize SD Card and frame reading system
     esp_err_t sd_err = frame_system_init("0:/control.dat", "0:/frame.dat");
     ESP_LOGI(TAG, "frame_system_init=%s", esp_err_to_name(sd_err));
     ESP_LOGI(TAG, "HWM after frame_system_init=%u", uxTaskGetStackHighWaterMark(NULL));
@@ -85,9 +146,10 @@ static void app_task(void* arg) {
         ESP_LOGE(TAG, "frame system init failed, halt");
     } else {
         frame_sys_ready = true;
+        compile_show(); // No-op once the cache of this show is built
 
 #if LD_CFG_ENABLE_LOGGER
-        // 2. Initialize SD Logger (Optional)
+        // 3. Initialize SD Logger (Optional)
         esp_err_t log_err = sd_logger_init("/sd/LOGGER.log");
         if(log_err != ESP_OK) {
             ESP_LOGE(TAG, "SD Logger init failed: %s", esp_err_to_name(log_err));
@@ -97,9 +159,6 @@ static void app_task(void* arg) {
     }
 #endif
 
-    // 3. Pre-calculate Gamma Lookup Table for LED color correction
-    calc_gamma_lut();
-
     // 4. Hardware Configuration (Temporary mapping for LED strips and I2C channels)
     for(int i = 0; i < LD_BOARD_WS2812B_NUM; i++) {
         ch_info.rmt_strips[i] = LD_BOARD_WS2812B_MAX_PIXEL_NUM;
@@ -134,16 +193,15 @@ static void app_task(void* arg) {
 
     if(player_id == 0) ESP_LOGW(TAG,"get_sd_card_id() return 0.");
 
-    // Configure and start the BLE Receiver
-    bt_receiver_config_t rx_cfg = {
+    // Configure and start the BLE Receiver (config kept for the restart after an upload)
+    rx_cfg = {
         .feedback_gpio_num = -1,
         .manufacturer_id = 0xFFFF,
         .my_player_id = player_id, 
         .sync_window_us = 500000,
         .queue_size = 20,
     };
-    bt_receiver_init(&rx_cfg);
-    bt_receiver_start();
+    start_bt_receiver();
 #else
     // Fallback to console testing if BT is disabled
     console_test();
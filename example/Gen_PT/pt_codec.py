@@ -0,0 +1,610 @@
+import argparse
+import bisect
+import os
+import struct
+import zlib
+
+# v1.4+ frame.dat record: [type][start_time][fade][body_len][body][crc32]
+RECORD_KEY = 0
+RECORD_DELTA = 1
+RECORD_PALETTE = 2
+RECORD_INDEXED8 = 3
+RECORD_INDEXED4 = 4
+RECORD_TRACK = 5
+RECORD_EFFECT = 6
+RECORD_SYNC = 7
+RECORD_NAMES = ['KEY', 'DELTA', 'PALETTE', 'INDEXED8', 'INDEXED4', 'TRACK', 'EFFECT', 'SYNC']
+RECORD_HEADER = struct.Struct('<BIBH')
+RUN_HEADER = struct.Struct('<HH')
+VERSION_RECORDS = 4
+VERSION_PALETTE = 5
+VERSION_TRACKS = 6
+VERSION_VARINT_TIMES = 7
+VERSION_EASING = 8
+VERSION_EFFECTS = 9
+
+# v1.8 fade byte: bit 0 = fade, bit 1~7 = easing id (ld_ease.h); custom curves are 256-byte LUTs
+EASE_NAMES = ['linear', 'in', 'out', 'in-out', 'step']
+CURVE_SIZE = 256
+CURVE_MAX = 8
+
+# v1.9 EFFECT body after the track index: [type][param][spread][period_ms u16][phase u16][GRB a][GRB b] (ld_effect.h)
+EFFECT_NAMES = ['rainbow', 'strobe', 'breath', 'sparkle']
+EFFECT = struct.Struct('<BBBHH3s3s')
+
+# v1.6 track masks: bit 0~39 OF channel, bit 40~47 LED strip (table_frame_t.fade_mask)
+OF_CHANNELS = 40
+STRIPS = 8
+
+def crc32(data):
+    return zlib.crc32(bytes(data)) & 0xFFFFFFFF
+
+def calculate_checksum(data, version_minor):
+    # v1.2: byte sum, v1.3+: CRC32 (same as esp_rom_crc32_le on device)
+    if version_minor >= 3:
+        return crc32(data)
+    return sum(data) & 0xFFFFFFFF
+
+def payload_size(of_channel, strip_channel):
+    return (sum(of_channel) + sum(strip_channel)) * 3
+
+def encode_delta(payload, key):
+    # XOR runs against the last KEY, gaps shorter than a run header are merged
+    diff = [i for i in range(len(payload)) if payload[i] != key[i]]
+    runs = []
+    for i in diff:
+        if runs and i - runs[-1][1] <= RUN_HEADER.size:
+            runs[-1][1] = i + 1
+        else:
+            runs.append([i, i + 1])
+
+    body = bytearray()
+    pos = 0
+    for start, end in runs:
+        while start < end:
+            n = min(end - start, 0xFFFF)
+            body.extend(RUN_HEADER.pack(start - pos, n))
+            body.extend(payload[k] ^ key[k] for k in range(start, start + n))
+            pos = start = start + n
+    return body
+
+def make_record(rtype, start_time, fade, body):
+    data = bytearray(RECORD_HEADER.pack(rtype, start_time, fade, len(body)))
+    data.extend(body)
+    data.extend(struct.pack('<I', crc32(data)))
+    return data
+
+def pixels_of(payload):
+    return [bytes(payload[i:i + 3]) for i in range(0, len(payload), 3)]
+
+def plan_palettes(frames):
+    """Split frames into segments sharing one palette: 16 colors if possible, else 256.
+    Returns list of (start, end, palette or None)."""
+    segments = []
+    i = 0
+    while i < len(frames):
+        colors = set(pixels_of(frames[i][2]))
+        if len(colors) > 256:
+            segments.append((i, i + 1, None))
+            i += 1
+            continue
+
+        limit = 16 if len(colors) <= 16 else 256
+        j = i + 1
+        while j < len(frames):
+            merged = colors | set(pixels_of(frames[j][2]))
+            if len(merged) > limit:
+                break
+            colors = merged
+            j += 1
+        segments.append((i, j, sorted(colors)))
+        i = j
+    return segments
+
+def encode_indexed(payload, palette):
+    lut = {c: i for i, c in enumerate(palette)}
+    idx = [lut[c] for c in pixels_of(payload)]
+    if len(palette) > 16:
+        return RECORD_INDEXED8, bytes(idx)
+    if len(idx) % 2:
+        idx.append(0)
+    return RECORD_INDEXED4, bytes(idx[i] | (idx[i + 1] << 4) for i in range(0, len(idx), 2))
+
+def encode_records(frames, keyframe_interval, palette=False):
+    """frames: list of (start_time, fade, payload). Returns list of records."""
+    records = []
+    key = None
+    since_key = 0
+    segments = plan_palettes(frames) if palette else [(0, len(frames), None)]
+    for start, end, colors in segments:
+        if colors:
+            records.append(make_record(RECORD_PALETTE, 0, 0, b''.join(colors)))
+
+        for start_time, fade, payload in frames[start:end]:
+            key_type, key_body = encode_indexed(payload, colors) if colors else (RECORD_KEY, bytes(payload))
+
+            body = None
+            if key is not None and since_key < keyframe_interval:
+                body = encode_delta(payload, key)
+                # drifted too far from the KEY: a fresh KEY makes the following DELTAs smaller
+                if len(body) >= len(key_body) // 2:
+                    body = None
+
+            if body is None:
+                key = bytes(payload)
+                since_key = 1
+                records.append(make_record(key_type, start_time, fade, key_body))
+            else:
+                since_key += 1
+                records.append(make_record(RECORD_DELTA, start_time, fade, body))
+    return records
+
+def decode_board(rtype, body, size, palette, key):
+    """KEY / INDEXED body, or DELTA body XORed onto key, to a whole-board payload."""
+    if rtype == RECORD_KEY:
+        return bytes(body)
+    if rtype in (RECORD_INDEXED8, RECORD_INDEXED4):
+        if rtype == RECORD_INDEXED4:
+            idx = [(body[i >> 1] >> ((i & 1) * 4)) & 0x0F for i in range(size // 3)]
+        else:
+            idx = list(body)
+        return b''.join(palette[i] for i in idx)
+    payload = bytearray(key)
+    pos = i = 0
+    while i < len(body):
+        skip, n = RUN_HEADER.unpack_from(body, i)
+        i += RUN_HEADER.size
+        pos += skip
+        for k in range(n):
+            payload[pos + k] ^= body[i + k]
+        pos += n
+        i += n
+    return bytes(payload)
+
+def decode_records(data, size):
+    """data: frame.dat without version header. Yields (type, start_time, fade, payload, crc_ok)."""
+    key = None
+    palette = []
+    offset = 0
+    while offset + RECORD_HEADER.size <= len(data):
+        rtype, start_time, fade, body_len = RECORD_HEADER.unpack_from(data, offset)
+        end = offset + RECORD_HEADER.size + body_len
+        if end + 4 > len(data):
+            break
+        body = data[offset + RECORD_HEADER.size:end]
+        crc_ok = struct.unpack_from('<I', data, end)[0] == crc32(data[offset:end])
+        next_offset = end + 4
+
+        if rtype == RECORD_PALETTE:
+            palette = pixels_of(body)
+            offset = next_offset
+            continue
+        elif rtype in (RECORD_KEY, RECORD_INDEXED8, RECORD_INDEXED4):
+            key = payload = decode_board(rtype, body, size, palette, None)
+        elif rtype == RECORD_DELTA:
+            payload = decode_board(rtype, body, size, palette, key)
+        else:
+            raise ValueError(f"unknown record type {rtype} at {offset + 2}")
+
+        if len(payload) != size:
+            raise ValueError(f"record at {offset + 2}: payload {len(payload)} != {size}")
+
+        yield rtype, start_time, fade, bytes(payload), crc_ok
+        offset = next_offset
+
+def channel_ranges(of_channel, strip_channel, mask):
+    """Payload byte ranges [(offset, len)] of the channels in a track mask."""
+    ranges = []
+    offset = 0
+    sizes = [(i, 3) for i in range(OF_CHANNELS) if of_channel[i]]
+    sizes += [(OF_CHANNELS + s, n * 3) for s, n in enumerate(strip_channel)]
+    for bit, n in sizes:
+        if n and mask >> bit & 1:
+            if ranges and sum(ranges[-1]) == offset:
+                ranges[-1] = (ranges[-1][0], ranges[-1][1] + n)
+            else:
+                ranges.append((offset, n))
+        offset += n
+    return ranges
+
+def track_masks(of_channel, strip_channel, grouping):
+    """strip: all OF in one track + one per strip, channel: one per OF channel and strip."""
+    of_bits = [1 << i for i in range(OF_CHANNELS) if of_channel[i]]
+    masks = of_bits if grouping == 'channel' else ([sum(of_bits)] if of_bits else [])
+    return masks + [1 << (OF_CHANNELS + s) for s, n in enumerate(strip_channel) if n]
+
+def gather(payload, ranges):
+    return b''.join(bytes(payload[o:o + n]) for o, n in ranges)
+
+def split_tracks(frames, of_channel, strip_channel, grouping='strip'):
+    """frames: list of (start_time, fade, payload). Returns [(mask, [(start_time, fade, data)])].
+    A key is dropped when its track neither changes nor fades around it; fade is kept
+    only when the next value differs. First and last frame stay in every track."""
+    for (t0, _, _), (t1, _, _) in zip(frames, frames[1:]):
+        if t1 <= t0:
+            raise ValueError(f"tracks need strictly increasing timestamps ({t0} then {t1})")
+
+    tracks = []
+    for mask in track_masks(of_channel, strip_channel, grouping):
+        ranges = channel_ranges(of_channel, strip_channel, mask)
+        values = [gather(p, ranges) for _, _, p in frames]
+        fades = [bool(f) and i + 1 < len(frames) and values[i + 1] != values[i] for i, (_, f, _) in enumerate(frames)]
+        keys = []
+        for i, (start_time, _, _) in enumerate(frames):
+            if 0 < i < len(frames) - 1 and not fades[i - 1] and not fades[i] and values[i] == values[i - 1]:
+                continue
+            keys.append((start_time, int(fades[i]), values[i]))
+        tracks.append((mask, keys))
+    return tracks
+
+def track_times(tracks):
+    """Merged frame times: every distinct key time, as listed in control.dat."""
+    return sorted({t for _, keys in tracks for t, _, _ in keys})
+
+def key_record(j, key):
+    """TRACK record of key (start_time, fade, data) on track j, EFFECT when fade is None."""
+    start_time, fade, data = key
+    return make_record(RECORD_TRACK if fade is not None else RECORD_EFFECT, start_time, fade or 0, bytes([j]) + data)
+
+def key_record_size(key):
+    return RECORD_HEADER.size + 1 + len(key[2]) + 4
+
+def restate_cost(tracks, t):
+    """Bytes a SYNC at t restates: per track not keyed at t, the key in effect and the key it fades to."""
+    cost = 0
+    for _, keys in tracks:
+        k = bisect.bisect_left([key[0] for key in keys], t)
+        if k == 0 or (k < len(keys) and keys[k][0] == t):
+            continue
+        cost += key_record_size(keys[k - 1])
+        if keys[k - 1][1] and k < len(keys):
+            cost += key_record_size(keys[k])
+    return cost
+
+def encode_tracks(tracks, frames, of_channel, strip_channel, keyframe_interval, version_minor=VERSION_TRACKS):
+    """v1.6 frame.dat after the version header: track table, then records by need time.
+    frames: the merged frames (start_time, fade, payload), one per track_times(tracks).
+    A frame where every track can take one shared key (same fade, none mid-fade or in an effect)
+    becomes a whole-board KEY / DELTA / INDEXED record when that is smaller than its TRACK records;
+    one SYNC per keyframe_interval frames restates the keys a seek there needs.
+    v1.8 adds an empty custom curve table; every fade stays linear (easing id 0).
+    v1.9: a key with fade None is an effect, its data the EFFECT body after the track index."""
+    table = bytearray([len(tracks)])
+    for mask, _ in tracks:
+        table.extend(struct.pack('<Q', mask))
+    if version_minor >= VERSION_EASING:
+        table.append(0)
+    table.extend(struct.pack('<I', crc32(table)))
+
+    times = [t for t, _, _ in frames]
+    n = len(frames)
+    ranges = [channel_ranges(of_channel, strip_channel, mask) for mask, _ in tracks]
+    segments = plan_palettes(frames)
+    seg_of = [s for s, (start, end, _) in enumerate(segments) for _ in range(start, end)]
+    palette_sent = [False] * len(segments)
+
+    # one SYNC per keyframe_interval frames, where the fewest keys need restating
+    sync_at = [False] * n
+    if keyframe_interval:
+        for w in range(keyframe_interval, n, keyframe_interval):
+            costs = [restate_cost(tracks, times[i]) for i in range(w, min(w + keyframe_interval, n))]
+            sync_at[w + costs.index(min(costs))] = True
+
+    # sorted by (need, start_time, order, track): SYNC, PALETTE ahead of its INDEXED, board, keys
+    refs = []
+    nxt = [0] * len(tracks)
+    cur = [None] * len(tracks)  # key in effect before the frame, as the reader has it
+    have_key = False
+    for i, (t, _, payload) in enumerate(frames):
+        keyed = [None] * len(tracks)
+        need = t
+        board = True
+        fade = -1
+        key_cost = 0
+        for j, (_, keys) in enumerate(tracks):
+            if nxt[j] < len(keys) and keys[nxt[j]][0] == t:
+                keyed[j] = keys[nxt[j]]
+                nxt[j] += 1
+            if keyed[j] is None:
+                continue
+            key_cost += key_record_size(keyed[j])
+            if cur[j] and cur[j][1]:
+                need = min(need, cur[j][0])
+                # a board record is read with the frame before it, not earlier
+                if cur[j][0] != times[i - 1]:
+                    board = False
+            f = keyed[j][1] or 0
+            if keyed[j][1] is None or (fade >= 0 and f != fade):
+                board = False
+            fade = f
+        # the others keep their value: a fresh key holding it, never mid-fade
+        if any(keyed[j] is None and (fade or (cur[j] and cur[j][1] != 0)) for j in range(len(tracks))):
+            board = False
+
+        restated = 0
+        if sync_at[i]:
+            have_key = False
+            for j, (_, keys) in enumerate(tracks):
+                if keyed[j] is None and cur[j]:
+                    restated += key_record_size(cur[j])
+                    if cur[j][1] and nxt[j] < len(keys):
+                        restated += key_record_size(keys[nxt[j]])
+
+        use_board = use_palette = False
+        if board:
+            colors = segments[seg_of[i]][2]
+            board_type, body = encode_indexed(payload, colors) if colors else (RECORD_KEY, bytes(payload))
+            board_cost = RECORD_HEADER.size + len(body) + 4
+            use_palette = bool(colors) and not palette_sent[seg_of[i]]
+            if use_palette:
+                board_cost += RECORD_HEADER.size + len(colors) * 3 + 4
+            # against the frame before: the latest key of every channel
+            if have_key:
+                delta = encode_delta(payload, frames[i - 1][2])
+                if len(delta) < len(body) // 2:
+                    board_type, body = RECORD_DELTA, delta
+                    board_cost = RECORD_HEADER.size + len(body) + 4
+                    use_palette = False
+            use_board = board_cost < key_cost + restated
+
+        if sync_at[i]:
+            group = []
+            if not use_board:
+                for _, j in sorted((cur[j][0], j) for j in range(len(tracks)) if keyed[j] is None and cur[j]):
+                    group.append(key_record(j, cur[j]))
+                    if cur[j][1] and nxt[j] < len(tracks[j][1]):
+                        group.append(key_record(j, tracks[j][1][nxt[j]]))
+            sync = make_record(RECORD_SYNC, t, 0, struct.pack('<I', sum(len(r) for r in group)))
+            refs.append((need, t, 0, 0, [sync] + group))
+
+        if use_board:
+            if use_palette:
+                refs.append((need, t, 1, 0, [make_record(RECORD_PALETTE, 0, 0, b''.join(colors))]))
+                palette_sent[seg_of[i]] = True
+            if board_type != RECORD_DELTA:
+                have_key = True
+            refs.append((need, t, 2, 0, [make_record(board_type, t, max(fade, 0), body)]))
+
+        for j in range(len(tracks)):
+            if keyed[j] is not None:
+                if not use_board:
+                    key_need = cur[j][0] if cur[j] and cur[j][1] else t
+                    refs.append((key_need, t, 3, j, [key_record(j, keyed[j])]))
+                cur[j] = keyed[j]
+            elif use_board:
+                # the board record keys every track
+                cur[j] = (t, 0, gather(payload, ranges[j]))
+
+    refs.sort(key=lambda r: r[:4])
+    return table, [record for r in refs for record in r[4]]
+
+def decode_tracks(data, of_channel, strip_channel, version_minor=VERSION_TRACKS):
+    """v1.6 frame.dat without version header. Returns [(mask, [(start_time, fade, data)])],
+    every key a whole-board record gives its tracks included; SYNC groups are skipped.
+    Raises ValueError on a bad table, a bad record or records out of need order.
+    v1.8: the custom curves are skipped and fade is the raw byte, easing id included.
+    v1.9: EFFECT records give keys with fade None (see encode_tracks)."""
+    count = data[0]
+    table = 1 + count * 8
+    if version_minor >= VERSION_EASING:
+        if data[table] > CURVE_MAX:
+            raise ValueError(f"{data[table]} custom curves, at most {CURVE_MAX}")
+        table += 1 + data[table] * CURVE_SIZE
+    if struct.unpack_from('<I', data, table)[0] != crc32(data[:table]):
+        raise ValueError("track table checksum mismatch")
+    tracks = [(struct.unpack_from('<Q', data, 1 + j * 8)[0], []) for j in range(count)]
+    ranges = [channel_ranges(of_channel, strip_channel, mask) for mask, _ in tracks]
+    size = payload_size(of_channel, strip_channel)
+
+    # v1.6 DELTA: XOR against the latest key of every channel, in file order
+    last = bytearray(size)
+    palette = []
+    have_key = False
+    last_need = 0
+    offset = table + 4
+    while offset < len(data):
+        at = offset + 2
+        rtype, start_time, fade, body_len = RECORD_HEADER.unpack_from(data, offset)
+        end = offset + RECORD_HEADER.size + body_len
+        body = data[offset + RECORD_HEADER.size:end]
+        effect = rtype == RECORD_EFFECT and version_minor >= VERSION_EFFECTS
+        if rtype > RECORD_SYNC or (rtype == RECORD_EFFECT and not effect) or struct.unpack_from('<I', data, end)[0] != crc32(data[offset:end]):
+            raise ValueError(f"bad record at {at}")
+        offset = end + 4
+
+        if rtype == RECORD_PALETTE:
+            palette = pixels_of(body)
+            continue
+        if rtype == RECORD_SYNC:
+            # the group restates keys already read; a seek starts from it
+            offset += struct.unpack_from('<I', body)[0]
+            have_key = False
+            continue
+        if rtype in (RECORD_KEY, RECORD_DELTA, RECORD_INDEXED8, RECORD_INDEXED4):
+            if rtype == RECORD_DELTA and not have_key:
+                raise ValueError(f"DELTA record at {at} without a KEY since the last SYNC")
+            have_key = True
+            payload = decode_board(rtype, body, size, palette, last)
+            need = min([start_time] + [keys[-1][0] for _, keys in tracks if keys and keys[-1][1]])
+            if need < last_need or any(keys and start_time <= keys[-1][0] for _, keys in tracks):
+                raise ValueError(f"record at {at} out of order")
+            last_need = need
+            for (_, keys), r in zip(tracks, ranges):
+                keys.append((start_time, fade, gather(payload, r)))
+            last[:] = payload
+            continue
+
+        if effect and (fade or body_len != 1 + EFFECT.size):
+            raise ValueError(f"bad EFFECT record at {at}")
+        keys = tracks[body[0]][1]
+        if effect and keys and keys[-1][1]:
+            raise ValueError(f"EFFECT record at {at} follows a fade")
+        need = keys[-1][0] if keys and keys[-1][1] else start_time
+        if need < last_need or (keys and start_time <= keys[-1][0]):
+            raise ValueError(f"record at {at} out of order")
+        last_need = need
+        keys.append((start_time, None if effect else fade, bytes(body[1:])))
+        # an effect leaves its channels black as a DELTA base
+        value = bytes(body[1:]) if not effect else bytes(sum(n for _, n in ranges[body[0]]))
+        pos = 0
+        for o, n in ranges[body[0]]:
+            last[o:o + n] = value[pos:pos + n]
+            pos += n
+    return tracks
+
+def decode_fixed(data, size):
+    """v1.2 / v1.3 frame.dat without version header. Yields (start_time, fade, payload)."""
+    frame_size = 4 + 1 + size + 4
+    for offset in range(0, len(data) - frame_size + 1, frame_size):
+        start_time, fade = struct.unpack_from('<IB', data, offset)
+        yield start_time, fade, data[offset + 5:offset + 5 + size]
+
+def encode_varint(value):
+    """v1.7 timestamp delta: unsigned LEB128, low 7 bits first."""
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return out
+
+def encode_times(timestamps):
+    """v1.7 control.dat after frame_num: [time_bytes][delta from the previous timestamp x frames]."""
+    deltas = bytearray()
+    prev = 0
+    for t in timestamps:
+        deltas.extend(encode_varint(t - prev))
+        prev = t
+    return struct.pack('<I', len(deltas)) + deltas
+
+def decode_times(data, offset, frame_num):
+    """v1.7: returns (timestamps, offset after the varints)."""
+    time_bytes = struct.unpack_from('<I', data, offset)[0]
+    offset += 4
+    end = offset + time_bytes
+    timestamps = []
+    t = 0
+    for _ in range(frame_num):
+        delta, shift = 0, 0
+        while True:
+            b = data[offset]
+            offset += 1
+            delta |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                break
+        t += delta
+        timestamps.append(t)
+    assert offset == end, f"time_bytes={time_bytes}, varints end at {offset - end + time_bytes}"
+    return timestamps, offset
+
+def write_control(path, version_minor, of_channel, strip_channel, timestamps):
+    data = bytearray(struct.pack('<BB', 1, version_minor))
+    data.extend(bytes(of_channel))
+    data.extend(bytes(strip_channel))
+    data.extend(struct.pack('<I', len(timestamps)))
+    if version_minor >= VERSION_VARINT_TIMES:
+        data.extend(encode_times(timestamps))
+    else:
+        for t in timestamps:
+            data.extend(struct.pack('<I', t))
+    data.extend(struct.pack('<I', calculate_checksum(data, version_minor)))
+    with open(path, "wb") as f:
+        f.write(data)
+
+def write_frames(path, version_minor, of_channel, strip_channel, frames, keyframe_interval, tracks=None):
+    """Writes frame.dat: fixed frames for v1.2/1.3, KEY/DELTA records for v1.4,
+    plus PALETTE/INDEXED records for v1.5, TRACK records (from split_tracks, frames merged
+    to track_times) plus whole-board records and SYNC for v1.6 ~ v1.9.
+    Returns record count per type name."""
+    with open(path, "wb") as f:
+        f.write(struct.pack('<BB', 1, version_minor))
+        if version_minor >= VERSION_TRACKS:
+            table, records = encode_tracks(tracks, frames, of_channel, strip_channel, keyframe_interval, version_minor)
+            f.write(table)
+            counts = {}
+            for r in records:
+                f.write(r)
+                counts[RECORD_NAMES[r[0]]] = counts.get(RECORD_NAMES[r[0]], 0) + 1
+            return counts
+        if version_minor >= VERSION_RECORDS:
+            records = encode_records(frames, keyframe_interval, version_minor >= VERSION_PALETTE)
+            counts = {}
+            for r in records:
+                f.write(r)
+                counts[RECORD_NAMES[r[0]]] = counts.get(RECORD_NAMES[r[0]], 0) + 1
+            return counts
+
+        for start_time, fade, payload in frames:
+            frame = bytearray(struct.pack('<IB', start_time, fade))
+            frame.extend(payload)
+            f.write(frame)
+            f.write(struct.pack('<I', calculate_checksum(frame, version_minor)))
+        return {'FRAME': len(frames)}
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert v1.2/v1.3 pattern files to compressed v1.4 ~ v1.9')
+    parser.add_argument('-i', '--input', default='.', help='directory with control.dat / frame.dat')
+    parser.add_argument('-o', '--output', default='out', help='output directory')
+    parser.add_argument('-k', '--keyframe', type=int, default=32, help='max frames between KEY records; v1.6+: between SYNC seek points, 0 for none')
+    parser.add_argument('-v', '--version', choices=['1.4', '1.5', '1.6', '1.7', '1.8', '1.9'], default='1.5',
+                        help='1.4=KEY/DELTA, 1.5=+palette, 1.6=per-channel tracks, 1.7=+varint control.dat timestamps, 1.8=+easing (linear fades), 1.9=+effect records (none from baked input)')
+    parser.add_argument('-T', '--tracks', choices=['strip', 'channel'], default='strip', help='v1.6+: all OF + one track per strip, or one per channel')
+    args = parser.parse_args()
+    version_minor = int(args.version.split('.')[1])
+
+    with open(os.path.join(args.input, "control.dat"), "rb") as f:
+        control = f.read()
+    with open(os.path.join(args.input, "frame.dat"), "rb") as f:
+        frame = f.read()
+
+    if control[0] != 1 or frame[0:2] != control[0:2] or control[1] >= VERSION_RECORDS:
+        raise SystemExit(f"expected v1.2/v1.3 input, got control {control[0]}.{control[1]} frame {frame[0]}.{frame[1]}")
+
+    of_channel = list(control[2:42])
+    strip_channel = list(control[42:50])
+    frame_num = struct.unpack_from('<I', control, 50)[0]
+    timestamps = list(struct.unpack_from(f'<{frame_num}I', control, 54))
+    size = payload_size(of_channel, strip_channel)
+
+    frames = list(decode_fixed(frame[2:], size))
+    if len(frames) != frame_num:
+        raise SystemExit(f"frame.dat has {len(frames)} frames, control.dat says {frame_num}")
+
+    tracks = None
+    merged = frames
+    if version_minor >= VERSION_TRACKS:
+        tracks = split_tracks(frames, of_channel, strip_channel, args.tracks)
+        timestamps = track_times(tracks)
+        kept = set(timestamps)
+        merged = [f for f in frames if f[0] in kept]
+
+    os.makedirs(args.output, exist_ok=True)
+    out_frame = os.path.join(args.output, "frame.dat")
+    write_control(os.path.join(args.output, "control.dat"), version_minor, of_channel, strip_channel, timestamps)
+    counts = write_frames(out_frame, version_minor, of_channel, strip_channel, merged, args.keyframe, tracks)
+
+    # round trip before reporting
+    if version_minor >= VERSION_VARINT_TIMES:
+        with open(os.path.join(args.output, "control.dat"), "rb") as f:
+            assert decode_times(f.read(), 54, len(timestamps))[0] == timestamps
+    with open(out_frame, "rb") as f:
+        data = f.read()[2:]
+    if tracks is not None:
+        # every source frame: each track's last key at or before it holds the frame's value
+        decoded = decode_tracks(data, of_channel, strip_channel, version_minor)
+        assert track_times(decoded) == timestamps
+        for start_time, _, payload in frames:
+            for mask, keys in decoded:
+                value = [d for t, _, d in keys if t <= start_time][-1]
+                assert value == gather(payload, channel_ranges(of_channel, strip_channel, mask))
+    else:
+        decoded = list(decode_records(data, size))
+        assert [(t, fd, p) for _, t, fd, p, _ in decoded] == [(t, fd, bytes(p)) for t, fd, p in frames]
+
+    new_size = os.path.getsize(out_frame)
+    print(f"{frame_num} frames" + (f" -> {len(timestamps)} merged, {len(tracks)} tracks" if tracks else "") + ", " + ", ".join(f"{n} {name}" for name, n in counts.items()))
+    print(f"frame.dat: {len(frame)} -> {new_size} bytes ({100.0 * new_size / len(frame):.1f}%)")
+
+if __name__ == "__main__":
+    main()
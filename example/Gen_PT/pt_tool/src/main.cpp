@@ -0,0 +1,496 @@
+/* pt_tool: generate, validate and convert pattern tables, and build the benchmark corpus.
+ *
+ *   pt_tool gen -o DIR [-p PATTERN] [-l LAYOUT] [-n FRAMES] [-t MS] [-v 1.x] [-k N] [-T GROUPING] [-s SEED]
+ *   pt_tool check DIR...
+ *   pt_tool convert -i DIR -o DIR [-v 1.x] [-k N] [-T GROUPING]
+ *   pt_tool corpus -o DIR [-n FRAMES] [-s SEED]
+ *
+ * check decodes both files with the rules in pt_format.h, reports every
+ * problem with its file offset, then reads the show again through the
+ * firmware frame_reader (host build) and compares every decoded frame.
+ */
+
+#include <getopt.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "pt_gen.hpp"
+#include "pt_show.hpp"
+
+extern "C" {
+#include "control_reader.h"
+}
+#include "esp_log.h"
+#include "frame_reader.h"
+#include "pt_host.h"
+#include "readframe.h"
+
+using namespace pt;
+
+static const char* const CORPUS_LAYOUTS[] = {"of40", "s2x50", "s8x50", "s8x100"};
+static const uint8_t CORPUS_VERSIONS[] = {PT_VERSION_MINOR_CRC32, PT_VERSION_MINOR_RECORDS, PT_VERSION_MINOR_PALETTE, PT_VERSION_MINOR_TRACKS, PT_VERSION_MINOR_VARINT_TIMES,
+                                       PT_VERSION_MINOR_EASING, PT_VERSION_MINOR_EFFECTS};
+static const char* const CORPUS_MANIFEST = "corpus.txt";
+
+static const uint32_t DEFAULT_KEYFRAME = 32;
+
+static double now_ms() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool make_dir(const std::string& dir) {
+    if(mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST)
+        return true;
+    fprintf(stderr, "cannot create %s: %s\n", dir.c_str(), strerror(errno));
+    return false;
+}
+
+static bool parse_grouping(const char* s, TrackGrouping& out) {
+    if(!strcmp(s, "strip"))
+        out = TrackGrouping::Strip;
+    else if(!strcmp(s, "channel"))
+        out = TrackGrouping::Channel;
+    else
+        return false;
+    return true;
+}
+
+/* frames with only some channels fading cannot be written before v1.6 */
+static bool whole_board_fades(const Show& show) {
+    for(size_t i = 0; i < show.frames(); i++) {
+        uint64_t m = show.fade_mask(i);
+        if(m != 0 && m != LD_FRAME_FADE_ALL)
+            return false;
+    }
+    return true;
+}
+
+static uint64_t file_size(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+static void print_summary(const std::string& dir, const Show& show, const RecordCounts& counts) {
+    uint32_t duration = show.frames() ? show.timestamps.back() : 0;
+    printf("%s: v1.%u %s, %zu frames, %u.%03u s, frame.dat %llu bytes (%s)\n", dir.c_str(), show.minor, show.layout.name().c_str(), show.frames(), duration / 1000, duration % 1000,
+           (unsigned long long)file_size(dir + "/frame.dat"), counts.str().c_str());
+}
+
+/* ================= firmware cross-check ================= */
+
+/* read dir through get_channel_info + frame_reader, compare with show; empty string when identical */
+static std::string firmware_check(const std::string& dir, const Show& show) {
+    static table_frame_t fw, ref;
+    char msg[128];
+
+    pt_host_set_root(dir.c_str());
+    show_profile_t profile;
+    esp_err_t err = get_channel_info_profile("0:/control.dat", &ch_info_snapshot, &profile);
+    if(err == ESP_OK)
+        err = frame_reader_init("0:/frame.dat");
+    if(err != ESP_OK) {
+        snprintf(msg, sizeof(msg), "init failed: %s", esp_err_to_name(err));
+        return msg;
+    }
+
+    /* control.dat timestamps as the firmware decoded them */
+    uint32_t last = show.frames() ? show.timestamps.back() : 0;
+    if(profile.frames != show.frames() || profile.last_ms != last) {
+        snprintf(msg, sizeof(msg), "control.dat gives %u frames up to %u ms, expected %zu up to %u ms", profile.frames, profile.last_ms, show.frames(), last);
+        frame_reader_deinit();
+        return msg;
+    }
+    frame_reader_set_verify(true);
+
+    std::string result;
+    size_t i = 0;
+    for(;; i++) {
+        err = frame_reader_read(&fw);
+        if(err != ESP_OK)
+            break;
+        if(i >= show.frames()) {
+            result = "returned more frames than control.dat lists";
+            break;
+        }
+        show.to_table_frame(i, ref);
+        if(memcmp(&fw, &ref, sizeof(fw)) != 0) {
+            snprintf(msg, sizeof(msg), "frame %zu differs", i);
+            result = msg;
+            break;
+        }
+    }
+    if(result.empty() && err != ESP_ERR_NOT_FOUND) {
+        snprintf(msg, sizeof(msg), "frame %zu: %s", i, esp_err_to_name(err));
+        result = msg;
+    } else if(result.empty() && i != show.frames()) {
+        snprintf(msg, sizeof(msg), "stopped after %zu of %zu frames", i, show.frames());
+        result = msg;
+    }
+    frame_reader_deinit();
+    return result;
+}
+
+/* ================= commands ================= */
+
+static int cmd_gen(int argc, char** argv) {
+    GenParams p;
+    Layout::parse("s8x100", p.layout);
+    std::string out;
+    uint32_t keyframe = DEFAULT_KEYFRAME;
+    TrackGrouping grouping = TrackGrouping::Strip;
+
+    int opt;
+    while((opt = getopt(argc, argv, "o:p:l:n:t:v:k:T:s:")) != -1) {
+        switch(opt) {
+            case 'o':
+                out = optarg;
+                break;
+            case 'p':
+                if(!parse_pattern(optarg, p.pattern)) {
+                    fprintf(stderr, "unknown pattern %s (random | gradient | sparse | fade | tracks | effects)\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'l':
+                if(!Layout::parse(optarg, p.layout)) {
+                    fprintf(stderr, "bad layout %s (of<N> | s<strips>x<pixels> | <of>:<n>,<n>,...)\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'n':
+                p.frames = (uint32_t)strtoul(optarg, nullptr, 10);
+                break;
+            case 't':
+                p.interval_ms = (uint32_t)strtoul(optarg, nullptr, 10);
+                break;
+            case 'v':
+                if(!(p.minor = parse_version(optarg))) {
+                    fprintf(stderr, "unsupported version %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'k':
+                keyframe = (uint32_t)strtoul(optarg, nullptr, 10);
+                break;
+            case 'T':
+                if(!parse_grouping(optarg, grouping)) {
+                    fprintf(stderr, "bad track grouping %s (strip | channel)\n", optarg);
+                    return 2;
+                }
+                break;
+            case 's':
+                p.seed = strtoull(optarg, nullptr, 0);
+                break;
+            default:
+                return 2;
+        }
+    }
+    if(out.empty() || !make_dir(out)) {
+        fprintf(stderr, "gen: -o DIR is required\n");
+        return 2;
+    }
+
+    if(p.minor < pattern_min_minor(p.pattern)) {
+        fprintf(stderr, "gen: pattern %s needs -v 1.%u\n", pattern_name(p.pattern), pattern_min_minor(p.pattern));
+        return 2;
+    }
+
+    double t0 = now_ms();
+    Show show;
+    generate(p, show);
+    std::string error;
+    if(pt_version_has_tracks(p.minor) && show.tracks.empty() && !make_tracks(show, grouping, error)) {
+        fprintf(stderr, "gen: %s\n", error.c_str());
+        return 1;
+    }
+    double t1 = now_ms();
+    RecordCounts counts;
+    if(!save_show(out, show, keyframe, &counts)) {
+        fprintf(stderr, "cannot write %s\n", out.c_str());
+        return 1;
+    }
+    double t2 = now_ms();
+
+    print_summary(out, show, counts);
+    printf("  generate %.1f ms, encode + write %.1f ms, digest %08x\n", t1 - t0, t2 - t1, show.digest());
+    return 0;
+}
+
+static int check_one(const std::string& dir) {
+    Show show;
+    Diag diag;
+    RecordCounts counts;
+    bool ok = load_show(dir, show, diag, &counts);
+
+    print_summary(dir, show, counts);
+    for(const std::string& e : diag.errors)
+        printf("  error: %s\n", e.c_str());
+    if(diag.full())
+        printf("  (stopped after %zu errors)\n", diag.errors.size());
+    if(!ok)
+        return 1;
+
+    std::string fw = firmware_check(dir, show);
+    if(!fw.empty()) {
+        printf("  error: firmware frame_reader: %s\n", fw.c_str());
+        return 1;
+    }
+    printf("  OK, digest %08x\n", show.digest());
+    return 0;
+}
+
+static int cmd_check(int argc, char** argv) {
+    if(optind >= argc) {
+        fprintf(stderr, "check: no show directory given\n");
+        return 2;
+    }
+    int failed = 0;
+    for(int i = optind; i < argc; i++)
+        failed |= check_one(argv[i]);
+    return failed;
+}
+
+static int cmd_convert(int argc, char** argv) {
+    std::string in, out;
+    uint8_t minor = PT_VERSION_MINOR_PALETTE;
+    uint32_t keyframe = DEFAULT_KEYFRAME;
+    TrackGrouping grouping = TrackGrouping::Strip;
+    bool regroup = false;
+
+    int opt;
+    while((opt = getopt(argc, argv, "i:o:v:k:T:")) != -1) {
+        switch(opt) {
+            case 'i':
+                in = optarg;
+                break;
+            case 'o':
+                out = optarg;
+                break;
+            case 'v':
+                if(!(minor = parse_version(optarg))) {
+                    fprintf(stderr, "unsupported version %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'k':
+                keyframe = (uint32_t)strtoul(optarg, nullptr, 10);
+                break;
+            case 'T':
+                if(!parse_grouping(optarg, grouping)) {
+                    fprintf(stderr, "bad track grouping %s (strip | channel)\n", optarg);
+                    return 2;
+                }
+                regroup = true;
+                break;
+            default:
+                return 2;
+        }
+    }
+    if(in.empty() || out.empty()) {
+        fprintf(stderr, "convert: -i DIR and -o DIR are required\n");
+        return 2;
+    }
+
+    Show show;
+    Diag diag;
+    if(!load_show(in, show, diag)) {
+        for(const std::string& e : diag.errors)
+            fprintf(stderr, "%s: %s\n", in.c_str(), e.c_str());
+        return 1;
+    }
+    uint32_t digest = show.digest();
+    uint64_t in_size = file_size(in + "/frame.dat");
+
+    /* effect keys only exist as tracks from v1.9 on; regrouping rebuilds tracks from the frames */
+    if(show.has_effects() && (!pt_version_has_effects(minor) || regroup)) {
+        fprintf(stderr, "%s: some tracks run effects, which needs v1.%u and the original tracks\n", in.c_str(), PT_VERSION_MINOR_EFFECTS);
+        return 1;
+    }
+
+    /* splitting into tracks drops keys and fades that change nothing, so compare the output instead of the frames */
+    Show source = show;
+    bool split = pt_version_has_tracks(minor) && (show.tracks.empty() || regroup);
+    std::string error;
+    if(split && !make_tracks(show, grouping, error)) {
+        fprintf(stderr, "%s: %s\n", in.c_str(), error.c_str());
+        return 1;
+    }
+    if(!pt_version_has_tracks(minor)) {
+        if(!whole_board_fades(show)) {
+            fprintf(stderr, "%s: some frames fade only part of the channels, which needs v1.%u\n", in.c_str(), PT_VERSION_MINOR_TRACKS);
+            return 1;
+        }
+        show.tracks.clear();
+        show.fade_masks.clear();
+    }
+    if(!pt_version_has_easing(minor)) {
+        if(show.eased()) {
+            fprintf(stderr, "%s: some fades use an easing curve, which needs v1.%u\n", in.c_str(), PT_VERSION_MINOR_EASING);
+            return 1;
+        }
+        show.eases.clear();
+        show.curves.clear();
+    }
+
+    show.minor = minor;
+    RecordCounts counts;
+    if(!make_dir(out) || !save_show(out, show, keyframe, &counts)) {
+        fprintf(stderr, "cannot write %s\n", out.c_str());
+        return 1;
+    }
+
+    /* round trip before reporting */
+    Show back;
+    if(!load_show(out, back, diag) || (split ? !same_playback(source, back, error) : back.digest() != digest)) {
+        fprintf(stderr, "%s: round trip mismatch %s\n", out.c_str(), error.c_str());
+        return 1;
+    }
+
+    uint64_t out_size = file_size(out + "/frame.dat");
+    print_summary(out, back, counts);
+    printf("  frame.dat: %llu -> %llu bytes (%.1f%%)\n", (unsigned long long)in_size, (unsigned long long)out_size, in_size ? 100.0 * out_size / in_size : 0.0);
+    return 0;
+}
+
+static int cmd_corpus(int argc, char** argv) {
+    std::string out;
+    GenParams p;
+
+    int opt;
+    while((opt = getopt(argc, argv, "o:n:s:")) != -1) {
+        switch(opt) {
+            case 'o':
+                out = optarg;
+                break;
+            case 'n':
+                p.frames = (uint32_t)strtoul(optarg, nullptr, 10);
+                break;
+            case 's':
+                p.seed = strtoull(optarg, nullptr, 0);
+                break;
+            default:
+                return 2;
+        }
+    }
+    if(out.empty() || !make_dir(out)) {
+        fprintf(stderr, "corpus: -o DIR is required\n");
+        return 2;
+    }
+
+    FILE* manifest = fopen((out + "/" + CORPUS_MANIFEST).c_str(), "w");
+    if(!manifest) {
+        fprintf(stderr, "cannot create %s/%s\n", out.c_str(), CORPUS_MANIFEST);
+        return 1;
+    }
+    fprintf(manifest, "# pt_tool corpus: %u frames per show, seed %llu\n", (unsigned)p.frames, (unsigned long long)p.seed);
+    fprintf(manifest, "# name version layout pattern frames frame_bytes digest\n");
+
+    double t0 = now_ms();
+    uint64_t total = 0;
+    size_t shows = 0;
+    int rc = 0;
+    for(const char* layout : CORPUS_LAYOUTS) {
+        Layout::parse(layout, p.layout);
+        for(Pattern pattern : ALL_PATTERNS) {
+            p.pattern = pattern;
+            p.minor = pattern_min_minor(pattern);
+            Show source;
+            generate(p, source);
+
+            for(uint8_t minor : CORPUS_VERSIONS) {
+                if(minor < pattern_min_minor(pattern))
+                    continue;
+                Show show = source;
+                if(pattern_needs_tracks(pattern) && pt_version_has_easing(minor)) {
+                    /* eased fades only exist from v1.8 on */
+                    p.minor = minor;
+                    generate(p, show);
+                }
+                std::string error;
+                if(pt_version_has_tracks(minor) && show.tracks.empty() && !make_tracks(show, TrackGrouping::Strip, error)) {
+                    fprintf(stderr, "%s: %s\n", layout, error.c_str());
+                    rc = 1;
+                    continue;
+                }
+                show.minor = minor;
+                uint32_t digest = show.digest();
+                std::string name = std::string(layout) + "-" + pattern_name(pattern) + "-v1" + std::to_string(minor);
+                std::string dir = out + "/" + name;
+                if(!make_dir(dir) || !save_show(dir, show, DEFAULT_KEYFRAME)) {
+                    fprintf(stderr, "cannot write %s\n", dir.c_str());
+                    rc = 1;
+                    continue;
+                }
+                uint64_t size = file_size(dir + "/frame.dat");
+                total += size;
+                shows++;
+                fprintf(manifest, "%s 1.%u %s %s %zu %llu %08x\n", name.c_str(), minor, layout, pattern_name(pattern), show.frames(), (unsigned long long)size, digest);
+                printf("%-22s %10llu bytes\n", name.c_str(), (unsigned long long)size);
+            }
+        }
+    }
+    fclose(manifest);
+    printf("%zu shows, %.1f MB in %.0f ms, manifest %s/%s\n", shows, total / 1e6, now_ms() - t0, out.c_str(), CORPUS_MANIFEST);
+    return rc;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s <command> [options]\n"
+            "  gen -o DIR      generate a show\n"
+            "      -p PATTERN  random | gradient | sparse | fade | tracks | effects (default gradient)\n"
+            "      -l LAYOUT   of<N> | s<strips>x<pixels> | <of>:<n>,<n>,... (default s8x100)\n"
+            "      -n FRAMES   default 2000\n"
+            "      -t MS       frame interval (default 25, fade 1000, tracks 250, effects 2000)\n"
+            "      -v 1.x      format version 1.2 ~ 1.9 (default 1.3, tracks needs 1.6+, effects 1.9)\n"
+            "      -k N        max frames between KEY records v1.4 / 1.5, between SYNC records v1.6+ (default 32)\n"
+            "      -T GROUPING v1.6+ tracks: strip (all OF + one per strip, default) | channel\n"
+            "      -s SEED     random seed (default 1)\n"
+            "  check DIR...    validate control.dat + frame.dat and cross-check with the firmware reader\n"
+            "  convert -i DIR -o DIR [-v 1.x] [-k N] [-T GROUPING]\n"
+            "                  re-encode a show in another version (default 1.5)\n"
+            "  corpus -o DIR [-n FRAMES] [-s SEED]\n"
+            "                  every layout x pattern x v1.3 ~ 1.9 (tracks: v1.6+, effects: v1.9 only), listed in DIR/corpus.txt\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    calc_ease_lut();
+
+    std::string cmd = argv[1];
+    /* getopt on the arguments after the command */
+    argv[1] = argv[0];
+    argc -= 1;
+    argv += 1;
+    optind = 1;
+
+    int rc;
+    if(cmd == "gen")
+        rc = cmd_gen(argc, argv);
+    else if(cmd == "check")
+        rc = cmd_check(argc, argv);
+    else if(cmd == "convert")
+        rc = cmd_convert(argc, argv);
+    else if(cmd == "corpus")
+        rc = cmd_corpus(argc, argv);
+    else {
+        usage(argv[-1]);
+        return 2;
+    }
+    if(rc == 2)
+        usage(argv[0]);
+    return rc;
+}
@@ -0,0 +1,274 @@
+#include "pt_gen.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "ld_led_ops.h"
+
+namespace pt {
+
+/* xorshift64*: fast and identical on every platform, unlike std:: distributions */
+class Rng {
+  public:
+    explicit Rng(uint64_t seed) : s_(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+    uint64_t next() {
+        s_ ^= s_ >> 12;
+        s_ ^= s_ << 25;
+        s_ ^= s_ >> 27;
+        return s_ * 0x2545F4914F6CDD1Dull;
+    }
+    uint32_t below(uint32_t n) { return (uint32_t)((next() >> 32) % n); }
+
+    void fill(uint8_t* p, size_t n) {
+        for(; n >= 8; n -= 8, p += 8) {
+            uint64_t v = next();
+            memcpy(p, &v, 8);
+        }
+        uint64_t v = next();
+        memcpy(p, &v, n);
+    }
+
+  private:
+    uint64_t s_;
+};
+
+static void put_grb(uint8_t* p, grb8_t c) {
+    p[0] = c.g;
+    p[1] = c.r;
+    p[2] = c.b;
+}
+
+static grb8_t hue(uint32_t h) {
+    hsv8_t c = {(uint16_t)(h % 1536), 255, 255};
+    return hsv_to_grb_u8(c);
+}
+
+const char* pattern_name(Pattern p) {
+    switch(p) {
+        case Pattern::Random:
+            return "random";
+        case Pattern::Gradient:
+            return "gradient";
+        case Pattern::Sparse:
+            return "sparse";
+        case Pattern::Fade:
+            return "fade";
+        case Pattern::Tracks:
+            return "tracks";
+        case Pattern::Effects:
+            return "effects";
+    }
+    return "?";
+}
+
+bool pattern_needs_tracks(Pattern p) {
+    return p == Pattern::Tracks || p == Pattern::Effects;
+}
+
+uint8_t pattern_min_minor(Pattern p) {
+    if(p == Pattern::Effects)
+        return PT_VERSION_MINOR_EFFECTS;
+    return p == Pattern::Tracks ? PT_VERSION_MINOR_TRACKS : PT_VERSION_MINOR_CRC32;
+}
+
+bool parse_pattern(const std::string& s, Pattern& out) {
+    for(Pattern p : ALL_PATTERNS) {
+        if(s == pattern_name(p)) {
+            out = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t default_interval_ms(Pattern p) {
+    if(p == Pattern::Effects)
+        return 2000;
+    if(p == Pattern::Tracks)
+        return 250;
+    return p == Pattern::Fade ? 1000 : 1000 / LD_CFG_PLAYER_FPS;
+}
+
+static void gen_random(Show& show, Rng& rng) {
+    rng.fill(show.payloads.data(), show.payloads.size());
+    for(uint8_t& f : show.fades)
+        f = (uint8_t)(rng.next() & 1);
+}
+
+static void gen_gradient(Show& show) {
+    uint32_t pixels = show.layout.pixels();
+    for(size_t i = 0; i < show.frames(); i++) {
+        uint8_t* p = show.payload(i);
+        for(uint32_t k = 0; k < pixels; k++)
+            put_grb(p + k * 3, hue(k * 16 + (uint32_t)i * 24));
+    }
+}
+
+static void gen_sparse(Show& show, Rng& rng) {
+    static constexpr uint32_t COLORS = 8;
+    uint32_t pixels = show.layout.pixels();
+    uint32_t changes = pixels / 50 ? pixels / 50 : 1;
+
+    grb8_t palette[COLORS];
+    for(uint32_t c = 0; c < COLORS; c++)
+        palette[c] = hue(c * 1536 / COLORS);
+
+    uint8_t* p = show.payload(0);
+    for(uint32_t k = 0; k < pixels; k++)
+        put_grb(p + k * 3, palette[rng.below(COLORS)]);
+
+    for(size_t i = 1; i < show.frames(); i++) {
+        memcpy(show.payload(i), show.payload(i - 1), show.layout.payload_size());
+        p = show.payload(i);
+        for(uint32_t c = 0; c < changes; c++)
+            put_grb(p + rng.below(pixels) * 3, palette[rng.below(COLORS)]);
+    }
+}
+
+/* every channel (OF or strip) is one solid color, stepping around a 12-hue wheel */
+static void gen_fade(Show& show) {
+    for(size_t i = 0; i < show.frames(); i++) {
+        uint8_t* p = show.payload(i);
+        uint32_t channel = 0;
+        for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++, channel++) {
+            if(!show.layout.of[ch])
+                continue;
+            put_grb(p, hue((channel + (uint32_t)i) % 12 * 128));
+            p += 3;
+        }
+        for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++, channel++) {
+            grb8_t c = hue((channel + (uint32_t)i) % 12 * 128);
+            for(uint32_t k = 0; k < show.layout.strips[s]; k++, p += 3)
+                put_grb(p, c);
+        }
+        show.fades[i] = 1;
+    }
+}
+
+/* v1.8: the fades cycle through every built-in curve and one custom curve, sqrt(t) */
+static const uint8_t TRACK_EASES[] = {LD_EASE_LINEAR, LD_EASE_IN, LD_EASE_OUT, LD_EASE_IN_OUT, LD_EASE_STEP, LD_EASE_CUSTOM(0)};
+
+/* track j keys every (j + 2) / 2 intervals; two of every three keys fade into the next one */
+static void gen_tracks(Show& show, uint32_t keys, uint32_t interval) {
+    uint32_t duration = keys ? (keys - 1) * interval : 0;
+    std::vector<uint64_t> masks = track_masks(show.layout, TrackGrouping::Strip);
+    bool easing = pt_version_has_easing(show.minor);
+    if(easing) {
+        show.curves.resize(LD_EASE_LUT_SIZE);
+        for(int i = 0; i < LD_EASE_LUT_SIZE; i++)
+            show.curves[i] = (uint8_t)std::lround(std::sqrt(i / 255.0) * 255.0);
+    }
+
+    for(uint32_t j = 0; j < masks.size(); j++) {
+        Track track{masks[j], {}};
+        uint32_t size = 0;
+        for(const auto& r : show.layout.ranges(masks[j]))
+            size += r.second;
+
+        uint32_t period = interval * (j + 2) / 2;
+        for(uint32_t k = 0; keys && (uint64_t)k * period <= duration; k++) {
+            TrackKey key{k * period, (uint8_t)(k % 3 != 2), std::vector<uint8_t>(size)};
+            if(easing && key.fade)
+                key.ease = TRACK_EASES[(j + k) % sizeof(TRACK_EASES)];
+            grb8_t c = hue((j * 5 + k) % 12 * 128);
+            for(uint32_t b = 0; b < size; b += 3)
+                put_grb(&key.data[b], c);
+            track.keys.push_back(std::move(key));
+        }
+        show.tracks.push_back(std::move(track));
+    }
+    merge_tracks(show);
+}
+
+/* track j keys every (j + 2) / 2 intervals: an effect, then a color fading into a second color */
+static void gen_effects(Show& show, uint32_t keys, uint32_t interval) {
+    uint32_t duration = keys ? (keys - 1) * interval : 0;
+    std::vector<uint64_t> masks = track_masks(show.layout, TrackGrouping::Strip);
+
+    for(uint32_t j = 0; j < masks.size(); j++) {
+        Track track{masks[j], {}};
+        uint32_t size = 0;
+        for(const auto& r : show.layout.ranges(masks[j]))
+            size += r.second;
+
+        uint32_t period = interval * (j + 2) / 2;
+        for(uint32_t k = 0; keys && (uint64_t)k * period <= duration; k++) {
+            grb8_t c = hue((j * 5 + k) % 12 * 128);
+            TrackKey key{k * period, (uint8_t)(k % 3 == 1), {}};
+            if(k % 3 == 0) {
+                key.effect = true;
+                key.fx.type = (uint8_t)((j + k / 3) % LD_EFFECT_NUM);
+                key.fx.period_ms = (uint16_t)(400 + 200 * ((j + k) % 4));
+                key.fx.phase = (uint16_t)(j * 0x2000);
+                key.fx.a = c;
+                switch(key.fx.type) {
+                    case LD_EFFECT_RAINBOW:
+                        key.fx.param = 255;
+                        key.fx.spread = 6;
+                        break;
+                    case LD_EFFECT_STROBE:
+                        key.fx.param = 64;
+                        key.fx.spread = 24;
+                        break;
+                    case LD_EFFECT_BREATH:
+                        key.fx.b = {(uint8_t)(c.g / 8), (uint8_t)(c.r / 8), (uint8_t)(c.b / 8)};
+                        break;
+                    default:
+                        key.fx.param = 32;
+                        break;
+                }
+            } else {
+                key.data.resize(size);
+                for(uint32_t b = 0; b < size; b += 3)
+                    put_grb(&key.data[b], c);
+            }
+            track.keys.push_back(std::move(key));
+        }
+        show.tracks.push_back(std::move(track));
+    }
+    merge_tracks(show);
+}
+
+void generate(const GenParams& params, Show& show) {
+    show = Show();
+    show.minor = params.minor;
+    show.layout = params.layout;
+
+    uint32_t interval = params.interval_ms ? params.interval_ms : default_interval_ms(params.pattern);
+    if(params.pattern == Pattern::Tracks) {
+        gen_tracks(show, params.frames, interval);
+        return;
+    }
+    if(params.pattern == Pattern::Effects) {
+        gen_effects(show, params.frames, interval);
+        return;
+    }
+    show.resize(params.frames);
+
+    for(uint32_t i = 0; i < params.frames; i++)
+        show.timestamps[i] = i * interval;
+    if(params.frames == 0 || show.layout.payload_size() == 0)
+        return;
+
+    Rng rng(params.seed);
+    switch(params.pattern) {
+        case Pattern::Random:
+            gen_random(show, rng);
+            break;
+        case Pattern::Gradient:
+            gen_gradient(show);
+            break;
+        case Pattern::Sparse:
+            gen_sparse(show, rng);
+            break;
+        case Pattern::Fade:
+            gen_fade(show);
+            break;
+        case Pattern::Tracks:
+        case Pattern::Effects:
+            break;
+    }
+}
+
+} // namespace pt
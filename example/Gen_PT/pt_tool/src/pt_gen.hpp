@@ -0,0 +1,46 @@
+#pragma once
+
+/* Synthetic show profiles for benchmarks and format tests.
+ *
+ *   random    every byte random: worst case for DELTA and palette records
+ *   gradient  moving hue gradient: every pixel changes, many colors
+ *   sparse    8-color base frame with ~2% of pixels changing per frame: DELTA friendly
+ *   fade      one solid color per channel, 1 s apart with fade: palette friendly
+ *   tracks    v1.6+ only: OF and every strip keep their own key rhythm, mixing fades and steps
+ *             (v1.8: the fades cycle through every easing curve)
+ *   effects   v1.9 only: like tracks, but every third key of a track starts a procedural
+ *             effect (rainbow chase, strobe, breath, sparkle) that runs until its next key
+ */
+
+#include <cstdint>
+#include <string>
+
+#include "pt_show.hpp"
+
+namespace pt {
+
+enum class Pattern { Random, Gradient, Sparse, Fade, Tracks, Effects };
+
+static constexpr Pattern ALL_PATTERNS[] = {Pattern::Random, Pattern::Gradient, Pattern::Sparse, Pattern::Fade, Pattern::Tracks, Pattern::Effects};
+
+struct GenParams {
+    Pattern pattern = Pattern::Gradient;
+    Layout layout;
+    uint32_t frames = 2000; /* tracks / effects: keys of the fastest track */
+    uint32_t interval_ms = 0; /* 0: pattern default */
+    uint8_t minor = PT_VERSION_MINOR_CRC32;
+    uint64_t seed = 1;
+};
+
+const char* pattern_name(Pattern p);
+/* the pattern is authored as tracks and needs v1.6+ */
+bool pattern_needs_tracks(Pattern p);
+/* oldest minor revision that can hold the pattern */
+uint8_t pattern_min_minor(Pattern p);
+bool parse_pattern(const std::string& s, Pattern& out);
+uint32_t default_interval_ms(Pattern p);
+
+/* deterministic for a given GenParams */
+void generate(const GenParams& params, Show& out);
+
+} // namespace pt
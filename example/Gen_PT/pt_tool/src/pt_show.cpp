@@ -0,0 +1,1585 @@
+#include "pt_show.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "ld_led_ops.h"
+
+namespace pt {
+
+static const char* RECORD_NAMES[] = {"KEY", "DELTA", "PALETTE", "INDEXED8", "INDEXED4", "TRACK", "EFFECT", "SYNC"};
+
+/* [skip][len] runs never cover more than this many bytes */
+static constexpr uint32_t DELTA_RUN_MAX = 0xFFFF;
+
+/* ================= helpers ================= */
+
+static void put_u16(std::vector<uint8_t>& v, uint16_t x) {
+    v.push_back((uint8_t)x);
+    v.push_back((uint8_t)(x >> 8));
+}
+
+static void put_u32(std::vector<uint8_t>& v, uint32_t x) {
+    for(int i = 0; i < 4; i++)
+        v.push_back((uint8_t)(x >> (8 * i)));
+}
+
+static void put_u64(std::vector<uint8_t>& v, uint64_t x) {
+    put_u32(v, (uint32_t)x);
+    put_u32(v, (uint32_t)(x >> 32));
+}
+
+/* v1.7 timestamp delta: unsigned LEB128, low 7 bits first */
+static void put_varint(std::vector<uint8_t>& v, uint32_t x) {
+    while(x >= 0x80) {
+        v.push_back((uint8_t)(x | 0x80));
+        x >>= 7;
+    }
+    v.push_back((uint8_t)x);
+}
+
+static uint32_t checksum(uint8_t minor, const uint8_t* p, size_t len) {
+    return pt_checksum_update(pt_checksum_kind(minor), 0, p, len);
+}
+
+/* g,r,b packed so that numeric order matches pt_codec.py's sorted(bytes) */
+static uint32_t color_key(const uint8_t* p) {
+    return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+/* ================= Layout / Show ================= */
+
+uint32_t Layout::pixels() const {
+    uint32_t n = 0;
+    for(uint8_t f : of)
+        n += f;
+    for(uint8_t c : strips)
+        n += c;
+    return n;
+}
+
+std::string Layout::name() const {
+    uint32_t of_count = 0, strip_count = 0;
+    for(uint8_t f : of)
+        of_count += f;
+    for(uint8_t c : strips)
+        strip_count += c ? 1 : 0;
+
+    /* uniform strips print as s<N>x<pixels> */
+    char buf[64];
+    if(strip_count == 0) {
+        snprintf(buf, sizeof(buf), "of%u", (unsigned)of_count);
+        return buf;
+    }
+    bool uniform = true;
+    for(uint32_t i = 0; i < LD_BOARD_WS2812B_NUM; i++)
+        uniform &= (i < strip_count) ? strips[i] == strips[0] : strips[i] == 0;
+    if(uniform && of_count == LD_BOARD_PCA9955B_CH_NUM) {
+        snprintf(buf, sizeof(buf), "s%ux%u", (unsigned)strip_count, (unsigned)strips[0]);
+        return buf;
+    }
+
+    std::string s = std::to_string(of_count) + ":";
+    for(uint32_t i = 0; i < LD_BOARD_WS2812B_NUM; i++)
+        s += (i ? "," : "") + std::to_string(strips[i]);
+    return s;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> Layout::ranges(uint64_t mask) const {
+    std::vector<std::pair<uint32_t, uint32_t>> out;
+    uint32_t offset = 0;
+    auto add = [&](uint32_t len) {
+        if(len && !out.empty() && out.back().first + out.back().second == offset)
+            out.back().second += len;
+        else if(len)
+            out.push_back({offset, len});
+    };
+    for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
+        if(!of[ch])
+            continue;
+        if(mask & LD_FRAME_FADE_PCA9955B(ch))
+            add(3);
+        offset += 3;
+    }
+    for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+        if(mask & LD_FRAME_FADE_WS2812B(s))
+            add((uint32_t)strips[s] * 3);
+        offset += (uint32_t)strips[s] * 3;
+    }
+    return out;
+}
+
+bool Layout::parse(const std::string& spec, Layout& out) {
+    out = Layout();
+    unsigned a = 0, b = 0;
+    char tail;
+
+    if(sscanf(spec.c_str(), "of%u%c", &a, &tail) == 1) {
+        if(a > LD_BOARD_PCA9955B_CH_NUM)
+            return false;
+        std::fill(out.of, out.of + a, 1);
+        return true;
+    }
+
+    if(sscanf(spec.c_str(), "s%ux%u%c", &a, &b, &tail) == 2) {
+        if(a > LD_BOARD_WS2812B_NUM || b > LD_BOARD_WS2812B_MAX_PIXEL_NUM)
+            return false;
+        std::fill(out.of, out.of + LD_BOARD_PCA9955B_CH_NUM, 1);
+        std::fill(out.strips, out.strips + a, (uint8_t)b);
+        return true;
+    }
+
+    /* <of>:<n>,<n>,... */
+    size_t colon = spec.find(':');
+    if(colon == std::string::npos || sscanf(spec.c_str(), "%u", &a) != 1 || a > LD_BOARD_PCA9955B_CH_NUM)
+        return false;
+    std::fill(out.of, out.of + a, 1);
+
+    size_t pos = colon + 1;
+    for(uint32_t i = 0; i < LD_BOARD_WS2812B_NUM && pos <= spec.size(); i++) {
+        size_t end = spec.find(',', pos);
+        std::string item = spec.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        if(sscanf(item.c_str(), "%u%c", &b, &tail) != 1 || b > LD_BOARD_WS2812B_MAX_PIXEL_NUM)
+            return false;
+        out.strips[i] = (uint8_t)b;
+        if(end == std::string::npos)
+            return true;
+        pos = end + 1;
+    }
+    return false;
+}
+
+void Show::resize(size_t n) {
+    timestamps.resize(n);
+    fades.resize(n);
+    payloads.resize(n * layout.payload_size());
+    if(!eases.empty())
+        eases.resize(n);
+    if(!effects.empty())
+        effects.resize(n);
+}
+
+bool Show::eased() const {
+    for(uint8_t e : eases)
+        if(e != LD_EASE_LINEAR)
+            return true;
+    for(const Track& t : tracks)
+        for(const TrackKey& k : t.keys)
+            if(k.ease != LD_EASE_LINEAR)
+                return true;
+    return false;
+}
+
+bool Show::has_effects() const {
+    for(const Track& t : tracks)
+        for(const TrackKey& k : t.keys)
+            if(k.effect)
+                return true;
+    return false;
+}
+
+uint8_t Show::apply_ease(uint8_t ease, uint8_t p) const {
+    if(ease < LD_EASE_BUILTIN_NUM)
+        return ld_ease_apply(ease, p);
+    size_t c = (size_t)ease - LD_EASE_CUSTOM_FIRST;
+    return (ease >= LD_EASE_CUSTOM_FIRST && c < curve_count()) ? curves[c * LD_EASE_LUT_SIZE + p] : p;
+}
+
+void Show::to_table_frame(size_t i, table_frame_t& out) const {
+    memset(&out, 0, sizeof(out));
+    out.timestamp = timestamps[i];
+    out.fade_mask = fade_mask(i);
+    out.fade = out.fade_mask != 0;
+    out.ease = ease(i);
+    if(!effects.empty()) {
+        out.effect_count = (uint8_t)std::min<size_t>(effects[i].size(), LD_FRAME_EFFECT_MAX);
+        memcpy(out.effects, effects[i].data(), out.effect_count * sizeof(ld_frame_effect_t));
+    }
+
+    const uint8_t* p = payload(i);
+    for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
+        if(!layout.of[ch])
+            continue;
+        out.data.pca9955b[ch] = {p[0], p[1], p[2]};
+        p += 3;
+    }
+    for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+        memcpy(out.data.ws2812b[s], p, (size_t)layout.strips[s] * 3);
+        p += (size_t)layout.strips[s] * 3;
+    }
+}
+
+uint32_t Show::digest() const {
+    static table_frame_t f;
+    uint32_t h = 0;
+    for(size_t i = 0; i < frames(); i++) {
+        to_table_frame(i, f);
+        uint8_t head[17];
+        memcpy(head, &f.timestamp, 8);
+        head[8] = f.fade ? (uint8_t)(1 | f.ease << 1) : 0;
+        memcpy(head + 9, &f.fade_mask, 8);
+        h = esp_rom_crc32_le(h, head, sizeof(head));
+        /* v1.9 effects as pt_bench hashes them */
+        for(uint8_t k = 0; k < f.effect_count; k++) {
+            const ld_frame_effect_t& e = f.effects[k];
+            uint8_t fx[12 + PT_EFFECT_SIZE] = {e.fx.type, e.fx.param, e.fx.spread};
+            memcpy(fx + 3, &e.fx.period_ms, 2);
+            memcpy(fx + 5, &e.fx.phase, 2);
+            memcpy(fx + 7, &e.fx.a, 3);
+            memcpy(fx + 10, &e.fx.b, 3);
+            memcpy(fx + PT_EFFECT_SIZE, &e.mask, 8);
+            memcpy(fx + PT_EFFECT_SIZE + 8, &e.start_ms, 4);
+            h = esp_rom_crc32_le(h, fx, sizeof(fx));
+        }
+        h = esp_rom_crc32_le(h, (const uint8_t*)&f.data, sizeof(f.data));
+    }
+    return h;
+}
+
+/* pixel-wise grb_lerp_hsv_u8 over n bytes */
+static void lerp_bytes(const uint8_t* a, const uint8_t* b, uint8_t p, uint32_t n, uint8_t* out) {
+    for(uint32_t k = 0; k < n; k += 3) {
+        grb8_t c = grb_lerp_hsv_u8({a[k], a[k + 1], a[k + 2]}, {b[k], b[k + 1], b[k + 2]}, p);
+        out[k] = c.g;
+        out[k + 1] = c.r;
+        out[k + 2] = c.b;
+    }
+}
+
+/* the Player's calc_lerp_p */
+static uint8_t lerp_p(uint64_t time_ms, uint64_t t1, uint64_t t2) {
+    if(t2 <= t1 || time_ms >= t2)
+        return 255;
+    return (uint8_t)((time_ms - t1) * 255 / (t2 - t1));
+}
+
+void Show::render(uint32_t time_ms, std::vector<uint8_t>& out) const {
+    uint32_t size = layout.payload_size();
+    out.assign(size, 0);
+    if(!frames())
+        return;
+
+    /* before the first frame and after the last one the Player holds the frame as is, effects keep running after it */
+    size_t i = std::upper_bound(timestamps.begin(), timestamps.end(), time_ms) - timestamps.begin();
+    if(i == 0 || i == frames()) {
+        memcpy(out.data(), payload(i ? i - 1 : 0), size);
+        if(i)
+            render_effects(i - 1, time_ms, out.data());
+        return;
+    }
+    i--;
+
+    uint64_t mask = fade_mask(i);
+    uint8_t p = mask ? apply_ease(ease(i), lerp_p(time_ms, timestamps[i], timestamps[i + 1])) : 0;
+    const uint8_t* cur = payload(i);
+    const uint8_t* next = payload(i + 1);
+    uint32_t offset = 0;
+    for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
+        if(!layout.of[ch])
+            continue;
+        lerp_bytes(cur + offset, next + offset, (mask & LD_FRAME_FADE_PCA9955B(ch)) ? p : 0, 3, out.data() + offset);
+        offset += 3;
+    }
+    for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+        uint32_t n = (uint32_t)layout.strips[s] * 3;
+        lerp_bytes(cur + offset, next + offset, (mask & LD_FRAME_FADE_WS2812B(s)) ? p : 0, n, out.data() + offset);
+        offset += n;
+    }
+    render_effects(i, time_ms, out.data());
+}
+
+void Show::render_effects(size_t i, uint32_t time_ms, uint8_t* out) const {
+    if(effects.empty())
+        return;
+    for(const ld_frame_effect_t& e : effects[i]) {
+        uint32_t t = time_ms - e.start_ms;
+        uint32_t offset = 0;
+        for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
+            if(!layout.of[ch])
+                continue;
+            if(e.mask & LD_FRAME_FADE_PCA9955B(ch))
+                ld_effect_render(&e.fx, t, (uint16_t)ch, reinterpret_cast<grb8_t*>(out + offset), 1);
+            offset += 3;
+        }
+        for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+            if(e.mask & LD_FRAME_FADE_WS2812B(s))
+                ld_effect_render(&e.fx, t, 0, reinterpret_cast<grb8_t*>(out + offset), layout.strips[s]);
+            offset += (uint32_t)layout.strips[s] * 3;
+        }
+    }
+}
+
+bool same_playback(const Show& a, const Show& b, std::string& where) {
+    std::vector<uint32_t> times;
+    for(const Show* s : {&a, &b}) {
+        for(size_t i = 0; i < s->frames(); i++) {
+            times.push_back(s->timestamps[i]);
+            if(i + 1 < s->frames())
+                times.push_back(s->timestamps[i] + (s->timestamps[i + 1] - s->timestamps[i]) / 2);
+        }
+    }
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+
+    std::vector<uint8_t> ra, rb;
+    for(uint32_t t : times) {
+        a.render(t, ra);
+        b.render(t, rb);
+        if(ra != rb) {
+            where = "output differs at " + std::to_string(t) + " ms";
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ================= tracks ================= */
+
+std::vector<uint64_t> track_masks(const Layout& layout, TrackGrouping grouping) {
+    std::vector<uint64_t> masks;
+    uint64_t of = 0;
+    for(int ch = 0; ch < LD_BOARD_PCA9955B_CH_NUM; ch++) {
+        if(!layout.of[ch])
+            continue;
+        if(grouping == TrackGrouping::Channel)
+            masks.push_back(LD_FRAME_FADE_PCA9955B(ch));
+        of |= LD_FRAME_FADE_PCA9955B(ch);
+    }
+    if(of && grouping == TrackGrouping::Strip)
+        masks.push_back(of);
+    for(int s = 0; s < LD_BOARD_WS2812B_NUM; s++) {
+        if(layout.strips[s])
+            masks.push_back(LD_FRAME_FADE_WS2812B(s));
+    }
+    return masks;
+}
+
+static void gather(const uint8_t* payload, const std::vector<std::pair<uint32_t, uint32_t>>& ranges, std::vector<uint8_t>& out) {
+    out.clear();
+    for(const auto& r : ranges)
+        out.insert(out.end(), payload + r.first, payload + r.first + r.second);
+}
+
+static void scatter(const uint8_t* data, const std::vector<std::pair<uint32_t, uint32_t>>& ranges, uint8_t* payload) {
+    for(const auto& r : ranges) {
+        memcpy(payload + r.first, data, r.second);
+        data += r.second;
+    }
+}
+
+bool make_tracks(Show& show, TrackGrouping grouping, std::string& error) {
+    size_t n = show.frames();
+    for(size_t i = 1; i < n; i++) {
+        if(show.timestamps[i] <= show.timestamps[i - 1]) {
+            error = "tracks need strictly increasing timestamps, frame " + std::to_string(i) + " is at " + std::to_string(show.timestamps[i]) + " ms";
+            return false;
+        }
+    }
+
+    show.tracks.clear();
+    std::vector<uint8_t> prev, cur, next;
+    for(uint64_t mask : track_masks(show.layout, grouping)) {
+        Track track{mask, {}};
+        auto ranges = show.layout.ranges(mask);
+        bool prev_fades = false;
+
+        for(size_t i = 0; i < n; i++) {
+            gather(show.payload(i), ranges, cur);
+            /* a fade to an identical value is no fade */
+            bool fades = false;
+            if((show.fade_mask(i) & mask) && i + 1 < n) {
+                gather(show.payload(i + 1), ranges, next);
+                fades = next != cur;
+            }
+            /* first and last key always stay, so every track spans the show */
+            bool drop = i > 0 && i + 1 < n && !prev_fades && !fades && cur == prev;
+            if(!drop)
+                track.keys.push_back({show.timestamps[i], (uint8_t)fades, cur, fades ? show.ease(i) : (uint8_t)LD_EASE_LINEAR});
+            prev_fades = fades;
+            prev.swap(cur);
+        }
+        show.tracks.push_back(std::move(track));
+    }
+
+    merge_tracks(show);
+    return true;
+}
+
+void merge_tracks(Show& show) {
+    std::vector<uint32_t> times;
+    for(const Track& t : show.tracks)
+        for(const TrackKey& k : t.keys)
+            times.push_back(k.ts);
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+
+    show.resize(times.size());
+    show.timestamps = times;
+    show.fade_masks.assign(times.size(), 0);
+    show.eases.assign(times.size(), LD_EASE_LINEAR);
+    show.effects.clear();
+    if(show.has_effects())
+        show.effects.assign(times.size(), {});
+    std::fill(show.payloads.begin(), show.payloads.end(), 0);
+
+    std::vector<size_t> at(show.tracks.size(), 0); /* first key after the current one */
+    std::vector<uint8_t> baked;
+    for(size_t i = 0; i < times.size(); i++) {
+        uint32_t t = times[i];
+        uint64_t mask = 0;
+        uint8_t ease = LD_EASE_LINEAR;
+        bool mixed = false;
+        for(size_t j = 0; j < show.tracks.size(); j++) {
+            const Track& track = show.tracks[j];
+            while(at[j] < track.keys.size() && track.keys[at[j]].ts <= t)
+                at[j]++;
+            if(at[j] == 0)
+                continue;
+
+            const TrackKey& a = track.keys[at[j] - 1];
+            const TrackKey* b = at[j] < track.keys.size() ? &track.keys[at[j]] : nullptr;
+            /* v1.9: channels of an effect stay 0, the Player renders them (track_merge_emit) */
+            if(a.effect) {
+                ld_frame_effect_t e;
+                memset(&e, 0, sizeof(e));
+                e.mask = track.mask;
+                e.start_ms = a.ts;
+                e.fx = a.fx;
+                show.effects[i].push_back(e);
+                continue;
+            }
+            const uint8_t* value = a.data.data();
+            if(a.fade && b) {
+                uint8_t key_ease = LD_EASE_LINEAR;
+                if(t != a.ts) {
+                    baked.resize(a.data.size());
+                    lerp_bytes(a.data.data(), b->data.data(), show.apply_ease(a.ease, lerp_p(t, a.ts, b->ts)), (uint32_t)a.data.size(), baked.data());
+                    value = baked.data();
+                } else {
+                    key_ease = a.ease;
+                }
+                /* one curve per frame, as in track_merge_emit() */
+                if(!mask)
+                    ease = key_ease;
+                else if(ease != key_ease)
+                    mixed = true;
+                mask |= track.mask;
+            }
+            scatter(value, show.layout.ranges(track.mask), show.payload(i));
+        }
+        show.fade_masks[i] = mask;
+        show.fades[i] = mask != 0;
+        show.eases[i] = mixed ? LD_EASE_LINEAR : ease;
+    }
+}
+
+std::string RecordCounts::str() const {
+    std::string s;
+    for(int t = 0; t <= PT_RECORD_SYNC; t++) {
+        if(!n[t])
+            continue;
+        s += (s.empty() ? "" : ", ") + std::to_string(n[t]) + " " + RECORD_NAMES[t];
+    }
+    return s.empty() ? "no records" : s;
+}
+
+void Diag::error(const char* file, size_t offset, const char* fmt, ...) {
+    if(full())
+        return;
+    char msg[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    char line[320];
+    snprintf(line, sizeof(line), "%s @%zu: %s", file, offset, msg);
+    errors.push_back(line);
+}
+
+uint8_t parse_version(const std::string& s) {
+    unsigned major, minor;
+    char tail;
+    if(sscanf(s.c_str(), "%u.%u%c", &major, &minor, &tail) != 2 || !pt_version_supported((uint8_t)major, (uint8_t)minor))
+        return 0;
+    return (uint8_t)minor;
+}
+
+/* ================= encoder ================= */
+
+std::vector<uint8_t> encode_control(const Show& show) {
+    std::vector<uint8_t> v;
+    v.reserve(PT_VERSION_HEADER_SIZE + sizeof(show.layout.of) + sizeof(show.layout.strips) + 4 + show.frames() * 4 + PT_CHECKSUM_SIZE);
+    v.push_back(PT_VERSION_MAJOR);
+    v.push_back(show.minor);
+    v.insert(v.end(), show.layout.of, show.layout.of + LD_BOARD_PCA9955B_CH_NUM);
+    v.insert(v.end(), show.layout.strips, show.layout.strips + LD_BOARD_WS2812B_NUM);
+    put_u32(v, (uint32_t)show.frames());
+    if(pt_version_has_varint_times(show.minor)) {
+        /* [time_bytes][delta from the previous timestamp x frames] */
+        size_t at = v.size();
+        put_u32(v, 0);
+        uint32_t prev = 0;
+        for(uint32_t t : show.timestamps) {
+            put_varint(v, t - prev);
+            prev = t;
+        }
+        uint32_t time_bytes = (uint32_t)(v.size() - at - 4);
+        for(int i = 0; i < 4; i++)
+            v[at + i] = (uint8_t)(time_bytes >> (8 * i));
+    } else {
+        for(uint32_t t : show.timestamps)
+            put_u32(v, t);
+    }
+    put_u32(v, checksum(show.minor, v.data(), v.size()));
+    return v;
+}
+
+/* XOR runs against key, gaps no longer than a run header are merged into one run */
+static void encode_delta(const uint8_t* payload, const uint8_t* key, uint32_t size, std::vector<uint8_t>& body) {
+    body.clear();
+    uint32_t pos = 0;
+    uint32_t i = 0;
+    while(i < size) {
+        if(payload[i] == key[i]) {
+            i++;
+            continue;
+        }
+
+        uint32_t start = i, end = i + 1;
+        for(uint32_t k = end; k < size && k - end <= PT_DELTA_RUN_HEADER_SIZE; k++) {
+            if(payload[k] != key[k])
+                end = k + 1;
+        }
+
+        while(start < end) {
+            uint32_t n = std::min(end - start, DELTA_RUN_MAX);
+            put_u16(body, (uint16_t)(start - pos));
+            put_u16(body, (uint16_t)n);
+            for(uint32_t k = start; k < start + n; k++)
+                body.push_back(payload[k] ^ key[k]);
+            pos = start = start + n;
+        }
+        i = end;
+    }
+}
+
+static void append_record(std::vector<uint8_t>& out, uint8_t type, uint32_t start_time, uint8_t fade, const uint8_t* body, size_t len) {
+    size_t at = out.size();
+    out.push_back(type);
+    put_u32(out, start_time);
+    out.push_back(fade);
+    put_u16(out, (uint16_t)len);
+    out.insert(out.end(), body, body + len);
+    put_u32(out, esp_rom_crc32_le(0, out.data() + at, (uint32_t)(out.size() - at)));
+}
+
+/* sorted distinct colors of one frame */
+static void frame_colors(const uint8_t* payload, uint32_t pixels, std::vector<uint32_t>& out) {
+    out.resize(pixels);
+    for(uint32_t i = 0; i < pixels; i++)
+        out[i] = color_key(payload + i * 3);
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+struct Segment {
+    size_t start, end;
+    std::vector<uint32_t> palette; /* empty: plain KEY records */
+};
+
+/* consecutive frames sharing one palette: 16 colors if possible, else 256 */
+static std::vector<Segment> plan_palettes(const Show& show) {
+    std::vector<Segment> segments;
+    std::vector<uint32_t> colors, next, merged;
+    uint32_t pixels = show.layout.pixels();
+
+    size_t i = 0;
+    while(i < show.frames()) {
+        frame_colors(show.payload(i), pixels, colors);
+        if(colors.size() > PT_PALETTE_MAX_COLORS) {
+            segments.push_back({i, i + 1, {}});
+            i++;
+            continue;
+        }
+
+        size_t limit = colors.size() <= 16 ? 16 : PT_PALETTE_MAX_COLORS;
+        size_t j = i + 1;
+        for(; j < show.frames(); j++) {
+            frame_colors(show.payload(j), pixels, next);
+            merged.clear();
+            std::set_union(colors.begin(), colors.end(), next.begin(), next.end(), std::back_inserter(merged));
+            if(merged.size() > limit)
+                break;
+            colors.swap(merged);
+        }
+        segments.push_back({i, j, colors});
+        i = j;
+    }
+    return segments;
+}
+
+static uint8_t encode_indexed(const uint8_t* payload, uint32_t pixels, const std::vector<uint32_t>& palette, std::vector<uint8_t>& body) {
+    body.clear();
+    bool nibbles = palette.size() <= 16;
+    for(uint32_t i = 0; i < pixels; i++) {
+        uint8_t idx = (uint8_t)(std::lower_bound(palette.begin(), palette.end(), color_key(payload + i * 3)) - palette.begin());
+        if(!nibbles)
+            body.push_back(idx);
+        else if(i & 1)
+            body.back() |= (uint8_t)(idx << 4);
+        else
+            body.push_back(idx);
+    }
+    return nibbles ? PT_RECORD_INDEXED4 : PT_RECORD_INDEXED8;
+}
+
+static void encode_records(const Show& show, uint32_t keyframe_interval, std::vector<uint8_t>& out, RecordCounts* counts) {
+    uint32_t size = show.layout.payload_size();
+    uint32_t pixels = show.layout.pixels();
+    bool palette = show.minor >= PT_VERSION_MINOR_PALETTE;
+
+    std::vector<Segment> segments = palette ? plan_palettes(show) : std::vector<Segment>{{0, show.frames(), {}}};
+    std::vector<uint8_t> key_body, delta, pal;
+    const uint8_t* key = nullptr;
+    uint32_t since_key = 0;
+
+    for(const Segment& seg : segments) {
+        if(!seg.palette.empty()) {
+            pal.clear();
+            for(uint32_t c : seg.palette) {
+                pal.push_back((uint8_t)(c >> 16));
+                pal.push_back((uint8_t)(c >> 8));
+                pal.push_back((uint8_t)c);
+            }
+            append_record(out, PT_RECORD_PALETTE, 0, 0, pal.data(), pal.size());
+            if(counts)
+                counts->n[PT_RECORD_PALETTE]++;
+        }
+
+        for(size_t i = seg.start; i < seg.end; i++) {
+            const uint8_t* payload = show.payload(i);
+            uint8_t key_type = PT_RECORD_KEY;
+            if(!seg.palette.empty())
+                key_type = encode_indexed(payload, pixels, seg.palette, key_body);
+            else
+                key_body.assign(payload, payload + size);
+
+            bool use_delta = false;
+            if(key && since_key < keyframe_interval) {
+                encode_delta(payload, key, size, delta);
+                /* drifted too far from the KEY: a fresh KEY makes the following DELTAs smaller */
+                use_delta = delta.size() < key_body.size() / 2;
+            }
+
+            if(use_delta) {
+                since_key++;
+                append_record(out, PT_RECORD_DELTA, show.timestamps[i], show.fades[i], delta.data(), delta.size());
+            } else {
+                key = payload;
+                since_key = 1;
+                append_record(out, key_type, show.timestamps[i], show.fades[i], key_body.data(), key_body.size());
+            }
+            if(counts)
+                counts->n[use_delta ? PT_RECORD_DELTA : key_type]++;
+        }
+    }
+}
+
+/* fade byte of a TRACK key, v1.8 keeps the curve in the upper bits */
+static uint8_t key_fade(const Show& show, const TrackKey& k) {
+    return (pt_version_has_easing(show.minor) && k.fade) ? (uint8_t)(PT_FADE_FLAG | k.ease << PT_FADE_EASE_SHIFT) : k.fade;
+}
+
+/* TRACK / EFFECT body of key k on track j */
+static void key_body(uint8_t j, const TrackKey& k, std::vector<uint8_t>& body) {
+    body.assign(1, j);
+    if(k.effect) {
+        const ld_effect_t& fx = k.fx;
+        body.insert(body.end(), {fx.type, fx.param, fx.spread});
+        put_u16(body, fx.period_ms);
+        put_u16(body, fx.phase);
+        body.insert(body.end(), {fx.a.g, fx.a.r, fx.a.b, fx.b.g, fx.b.r, fx.b.b});
+    } else {
+        body.insert(body.end(), k.data.begin(), k.data.end());
+    }
+}
+
+static size_t key_record_size(const TrackKey& k) {
+    return PT_RECORD_HEADER_SIZE + PT_TRACK_BODY_HEADER_SIZE + (k.effect ? PT_EFFECT_SIZE : k.data.size()) + PT_CHECKSUM_SIZE;
+}
+
+static void append_key(std::vector<uint8_t>& out, const Show& show, uint8_t j, const TrackKey& k, RecordCounts* counts) {
+    std::vector<uint8_t> body;
+    key_body(j, k, body);
+    uint8_t type = k.effect ? PT_RECORD_EFFECT : PT_RECORD_TRACK;
+    append_record(out, type, k.ts, k.effect ? 0 : key_fade(show, k), body.data(), body.size());
+    if(counts)
+        counts->n[type]++;
+}
+
+/* track table, then every record ordered by the time the reader needs it.
+ * A frame where every track can take one shared key (same fade, none mid-fade or in an effect)
+ * becomes a whole-board KEY / DELTA / INDEXED record when that is smaller than its TRACK records;
+ * every keyframe_interval frames a SYNC restates the keys a seek to that frame needs. */
+static void encode_tracks(const Show& show, uint32_t keyframe_interval, std::vector<uint8_t>& out, RecordCounts* counts) {
+    size_t at = out.size();
+    bool easing = pt_version_has_easing(show.minor);
+    out.push_back((uint8_t)show.tracks.size());
+    for(const Track& t : show.tracks)
+        put_u64(out, t.mask);
+    if(easing) {
+        out.push_back((uint8_t)show.curve_count());
+        out.insert(out.end(), show.curves.begin(), show.curves.end());
+    }
+    put_u32(out, esp_rom_crc32_le(0, out.data() + at, (uint32_t)(out.size() - at)));
+
+    /* SYNC first, then a PALETTE ahead of its INDEXED record, then keys */
+    enum { ORDER_SYNC, ORDER_PALETTE, ORDER_BOARD, ORDER_KEY };
+    struct Ref {
+        uint32_t need, ts;
+        uint8_t order, track;
+        uint8_t type, fade;
+        std::vector<uint8_t> body;
+        std::vector<uint8_t> group; /* SYNC: the restated records */
+    };
+    std::vector<Ref> refs;
+
+    size_t n = show.frames(), tracks = show.tracks.size();
+    uint32_t size = show.layout.payload_size();
+    uint32_t pixels = show.layout.pixels();
+    std::vector<Segment> segments = plan_palettes(show);
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> ranges;
+    for(const Track& t : show.tracks)
+        ranges.push_back(show.layout.ranges(t.mask));
+
+    /* one SYNC per keyframe_interval frames, where the fewest keys need restating */
+    std::vector<bool> sync_at(n, false);
+    for(size_t w = keyframe_interval; keyframe_interval && w < n; w += keyframe_interval) {
+        size_t best = w, best_cost = SIZE_MAX;
+        for(size_t i = w; i < std::min(w + keyframe_interval, n); i++) {
+            size_t cost = 0;
+            for(const Track& track : show.tracks) {
+                auto k = std::lower_bound(track.keys.begin(), track.keys.end(), show.timestamps[i], [](const TrackKey& key, uint32_t ts) { return key.ts < ts; });
+                if(k == track.keys.begin() || (k != track.keys.end() && k->ts == show.timestamps[i]))
+                    continue;
+                cost += key_record_size(k[-1]);
+                if(k[-1].fade && k != track.keys.end())
+                    cost += key_record_size(*k);
+            }
+            if(cost < best_cost) {
+                best = i;
+                best_cost = cost;
+            }
+        }
+        sync_at[best] = true;
+    }
+
+    std::vector<size_t> next(tracks, 0); /* first key after the frame */
+    std::vector<TrackKey> cur(tracks);   /* key in effect before the frame, as the reader has it */
+    std::vector<bool> has_cur(tracks, false);
+    std::vector<const TrackKey*> keyed(tracks);
+    std::vector<uint8_t> board_body, delta, body;
+    size_t seg = 0;
+    bool have_key = false;
+    std::vector<bool> palette_sent(segments.size(), false);
+
+    for(size_t i = 0; i < n; i++) {
+        uint32_t t = show.timestamps[i];
+        bool sync = sync_at[i];
+        while(segments[seg].end <= i)
+            seg++;
+
+        /* keys at t, the need of the frame, and whether one board record can carry them */
+        uint32_t need = t;
+        bool board = true;
+        int fade = -1;
+        size_t key_cost = 0;
+        for(size_t j = 0; j < tracks; j++) {
+            const std::vector<TrackKey>& keys = show.tracks[j].keys;
+            keyed[j] = nullptr;
+            if(next[j] < keys.size() && keys[next[j]].ts == t)
+                keyed[j] = &keys[next[j]++];
+            if(!keyed[j])
+                continue;
+            key_cost += key_record_size(*keyed[j]);
+            if(has_cur[j] && cur[j].fade) {
+                need = std::min(need, cur[j].ts);
+                /* a board record is read with the frame before it, not earlier */
+                if(cur[j].ts != show.timestamps[i - 1])
+                    board = false;
+            }
+            uint8_t f = keyed[j]->effect ? 0 : key_fade(show, *keyed[j]);
+            if(keyed[j]->effect || (fade >= 0 && f != fade))
+                board = false;
+            fade = f;
+        }
+        for(size_t j = 0; j < tracks && board; j++) {
+            /* the others keep their value: a fresh key holding it, never mid-fade */
+            if(!keyed[j] && (fade || (has_cur[j] && (cur[j].fade || cur[j].effect))))
+                board = false;
+        }
+
+        /* what a seek to this frame needs besides the keys at t */
+        size_t restate_cost = 0;
+        if(sync) {
+            have_key = false;
+            for(size_t j = 0; j < tracks; j++) {
+                if(keyed[j] || !has_cur[j])
+                    continue;
+                restate_cost += key_record_size(cur[j]);
+                if(cur[j].fade && next[j] < show.tracks[j].keys.size())
+                    restate_cost += key_record_size(show.tracks[j].keys[next[j]]);
+            }
+        }
+
+        const uint8_t* payload = show.payload(i);
+        uint8_t board_type = PT_RECORD_KEY;
+        bool use_board = false, use_palette = false;
+        if(board) {
+            const Segment& s = segments[seg];
+            if(!s.palette.empty())
+                board_type = encode_indexed(payload, pixels, s.palette, board_body);
+            else
+                board_body.assign(payload, payload + size);
+            size_t board_cost = PT_RECORD_HEADER_SIZE + board_body.size() + PT_CHECKSUM_SIZE;
+            use_palette = !s.palette.empty() && !palette_sent[seg];
+            if(use_palette)
+                board_cost += PT_RECORD_HEADER_SIZE + s.palette.size() * 3 + PT_CHECKSUM_SIZE;
+
+            /* against the frame before: the latest key of every channel (pt_format.h) */
+            if(have_key) {
+                encode_delta(payload, show.payload(i - 1), size, delta);
+                if(delta.size() < board_body.size() / 2) {
+                    board_type = PT_RECORD_DELTA;
+                    board_body.swap(delta);
+                    board_cost = PT_RECORD_HEADER_SIZE + board_body.size() + PT_CHECKSUM_SIZE;
+                    use_palette = false;
+                }
+            }
+            use_board = board_cost < key_cost + restate_cost;
+        }
+
+        if(sync) {
+            Ref r{need, t, ORDER_SYNC, 0, PT_RECORD_SYNC, 0, {}, {}};
+            /* restated keys in need order: the key in effect, then the key it fades to */
+            std::vector<std::pair<uint32_t, size_t>> order;
+            for(size_t j = 0; j < tracks && !use_board; j++) {
+                if(!keyed[j] && has_cur[j])
+                    order.push_back({cur[j].ts, j});
+            }
+            std::sort(order.begin(), order.end());
+            for(const auto& o : order) {
+                size_t j = o.second;
+                append_key(r.group, show, (uint8_t)j, cur[j], counts);
+                if(cur[j].fade && next[j] < show.tracks[j].keys.size())
+                    append_key(r.group, show, (uint8_t)j, show.tracks[j].keys[next[j]], counts);
+            }
+            put_u32(r.body, (uint32_t)r.group.size());
+            refs.push_back(std::move(r));
+        }
+
+        if(use_board) {
+            if(use_palette) {
+                Ref r{need, t, ORDER_PALETTE, 0, PT_RECORD_PALETTE, 0, {}, {}};
+                for(uint32_t c : segments[seg].palette)
+                    r.body.insert(r.body.end(), {(uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c});
+                refs.push_back(std::move(r));
+                palette_sent[seg] = true;
+            }
+            if(board_type != PT_RECORD_DELTA)
+                have_key = true;
+            refs.push_back({need, t, ORDER_BOARD, 0, board_type, (uint8_t)std::max(fade, 0), board_body, {}});
+        }
+
+        for(size_t j = 0; j < tracks; j++) {
+            if(keyed[j]) {
+                if(!use_board) {
+                    key_body((uint8_t)j, *keyed[j], body);
+                    uint32_t key_need = (has_cur[j] && cur[j].fade) ? cur[j].ts : t;
+                    uint8_t type = keyed[j]->effect ? PT_RECORD_EFFECT : PT_RECORD_TRACK;
+                    refs.push_back({key_need, t, ORDER_KEY, (uint8_t)j, type, keyed[j]->effect ? (uint8_t)0 : key_fade(show, *keyed[j]), body, {}});
+                }
+                cur[j] = *keyed[j];
+                has_cur[j] = true;
+            } else if(use_board) {
+                /* the board record keys every track */
+                cur[j] = TrackKey{t, 0, {}};
+                gather(payload, ranges[j], cur[j].data);
+                has_cur[j] = true;
+            }
+        }
+    }
+
+    std::sort(refs.begin(), refs.end(), [](const Ref& a, const Ref& b) {
+        if(a.need != b.need)
+            return a.need < b.need;
+        if(a.ts != b.ts)
+            return a.ts < b.ts;
+        return a.order != b.order ? a.order < b.order : a.track < b.track;
+    });
+    for(const Ref& r : refs) {
+        append_record(out, r.type, r.type == PT_RECORD_PALETTE ? 0 : r.ts, r.fade, r.body.data(), r.body.size());
+        out.insert(out.end(), r.group.begin(), r.group.end());
+        if(counts)
+            counts->n[r.type]++;
+    }
+}
+
+std::vector<uint8_t> encode_frames(const Show& show, uint32_t keyframe_interval, RecordCounts* counts) {
+    uint32_t size = show.layout.payload_size();
+    std::vector<uint8_t> out;
+    out.push_back(PT_VERSION_MAJOR);
+    out.push_back(show.minor);
+
+    if(pt_version_has_tracks(show.minor)) {
+        encode_tracks(show, keyframe_interval, out, counts);
+        return out;
+    }
+    if(pt_version_has_records(show.minor)) {
+        encode_records(show, keyframe_interval, out, counts);
+        return out;
+    }
+
+    out.reserve(PT_VERSION_HEADER_SIZE + show.frames() * (5 + size + PT_CHECKSUM_SIZE));
+    for(size_t i = 0; i < show.frames(); i++) {
+        size_t at = out.size();
+        put_u32(out, show.timestamps[i]);
+        out.push_back(show.fades[i]);
+        out.insert(out.end(), show.payload(i), show.payload(i) + size);
+        put_u32(out, checksum(show.minor, out.data() + at, out.size() - at));
+    }
+    if(counts)
+        counts->n[PT_RECORD_KEY] += (uint32_t)show.frames();
+    return out;
+}
+
+/* ================= decoder ================= */
+
+static const size_t CONTROL_FIXED = PT_VERSION_HEADER_SIZE + LD_BOARD_PCA9955B_CH_NUM + LD_BOARD_WS2812B_NUM + 4;
+
+/* v1.7: p points at [time_bytes], followed by the varint deltas and the checksum */
+static bool decode_varint_times(const std::vector<uint8_t>& d, const uint8_t* p, uint32_t n, Show& show, Diag& diag) {
+    const char* F = "control.dat";
+    const uint8_t* end = d.data() + d.size();
+    if(end - p < 4 + PT_CHECKSUM_SIZE) {
+        diag.error(F, p - d.data(), "missing time_bytes");
+        return false;
+    }
+    uint32_t time_bytes = pt_read_u32_le(p);
+    p += 4;
+    if((size_t)(end - p) != (size_t)time_bytes + PT_CHECKSUM_SIZE) {
+        diag.error(F, p - 4 - d.data(), "time_bytes=%u, file has %zu bytes after it", time_bytes, (size_t)(end - p));
+        return false;
+    }
+
+    if(time_bytes < n) {
+        diag.error(F, p - 4 - d.data(), "time_bytes=%u is too short for frame_num=%u", time_bytes, n);
+        return false;
+    }
+
+    const uint8_t* times_end = p + time_bytes;
+    show.resize(n);
+    uint32_t ts = 0;
+    for(uint32_t i = 0; i < n; i++) {
+        const uint8_t* at = p;
+        uint64_t delta = 0;
+        for(int shift = 0;; shift += 7) {
+            if(p == times_end || shift >= 7 * PT_VARINT_MAX_SIZE) {
+                diag.error(F, at - d.data(), "timestamp[%u]: varint runs past %s", i, p == times_end ? "time_bytes" : "5 bytes");
+                return false;
+            }
+            delta |= (uint64_t)(*p & 0x7f) << shift;
+            if(!(*p++ & 0x80))
+                break;
+        }
+        if(delta > UINT32_MAX - ts) {
+            diag.error(F, at - d.data(), "timestamp[%u]: delta %llu overflows after %u ms", i, (unsigned long long)delta, ts);
+            return false;
+        }
+        if(i && delta == 0)
+            diag.error(F, at - d.data(), "timestamp[%u]=%u repeats timestamp[%u], v1.%u needs strictly increasing timestamps", i, ts, i - 1, show.minor);
+        ts += (uint32_t)delta;
+        show.timestamps[i] = ts;
+    }
+    if(p != times_end)
+        diag.error(F, p - d.data(), "%zu bytes left after %u timestamps", (size_t)(times_end - p), n);
+
+    uint32_t want = checksum(show.minor, d.data(), d.size() - PT_CHECKSUM_SIZE);
+    if(pt_read_u32_le(times_end) != want)
+        diag.error(F, times_end - d.data(), "checksum %08x, expected %08x", pt_read_u32_le(times_end), want);
+    return true;
+}
+
+bool decode_control(const std::vector<uint8_t>& d, Show& show, Diag& diag) {
+    const char* F = "control.dat";
+    if(d.size() < CONTROL_FIXED + PT_CHECKSUM_SIZE) {
+        diag.error(F, 0, "%zu bytes, shorter than the fixed header", d.size());
+        return false;
+    }
+    if(!pt_version_supported(d[0], d[1])) {
+        diag.error(F, 0, "unsupported version %u.%u", d[0], d[1]);
+        return false;
+    }
+    show.minor = d[1];
+
+    const uint8_t* p = d.data() + PT_VERSION_HEADER_SIZE;
+    for(int i = 0; i < LD_BOARD_PCA9955B_CH_NUM; i++, p++) {
+        if(*p > 1)
+            diag.error(F, p - d.data(), "of_enable[%d]=%u, expected 0 or 1", i, *p);
+        show.layout.of[i] = *p ? 1 : 0;
+    }
+    for(int i = 0; i < LD_BOARD_WS2812B_NUM; i++, p++) {
+        if(*p > LD_BOARD_WS2812B_MAX_PIXEL_NUM)
+            diag.error(F, p - d.data(), "strip_led_num[%d]=%u > %u", i, *p, LD_BOARD_WS2812B_MAX_PIXEL_NUM);
+        show.layout.strips[i] = std::min<uint8_t>(*p, LD_BOARD_WS2812B_MAX_PIXEL_NUM);
+    }
+
+    uint32_t n = pt_read_u32_le(p);
+    if(pt_version_has_varint_times(show.minor))
+        return decode_varint_times(d, p + 4, n, show, diag);
+
+    size_t expect = CONTROL_FIXED + (size_t)n * 4 + PT_CHECKSUM_SIZE;
+    if(d.size() != expect) {
+        diag.error(F, p - d.data(), "frame_num=%u needs %zu bytes, file has %zu", n, expect, d.size());
+        return false;
+    }
+    p += 4;
+
+    show.resize(n);
+    for(uint32_t i = 0; i < n; i++, p += 4) {
+        show.timestamps[i] = pt_read_u32_le(p);
+        if(i && show.timestamps[i] < show.timestamps[i - 1])
+            diag.error(F, p - d.data(), "timestamp[%u]=%u before timestamp[%u]=%u", i, show.timestamps[i], i - 1, show.timestamps[i - 1]);
+    }
+
+    uint32_t want = checksum(show.minor, d.data(), d.size() - PT_CHECKSUM_SIZE);
+    if(pt_read_u32_le(p) != want)
+        diag.error(F, p - d.data(), "checksum %08x, expected %08x", pt_read_u32_le(p), want);
+    return true;
+}
+
+/* common tail of both decoders: record i decoded at offset */
+static void check_frame(const Show& show, size_t i, uint32_t start_time, size_t offset, Diag& diag) {
+    if(start_time != show.timestamps[i])
+        diag.error("frame.dat", offset, "frame %zu start_time=%u, control.dat says %u", i, start_time, show.timestamps[i]);
+}
+
+static bool decode_fixed(const std::vector<uint8_t>& d, Show& show, Diag& diag, RecordCounts* counts) {
+    const char* F = "frame.dat";
+    uint32_t size = show.layout.payload_size();
+    size_t frame_size = 5 + size + PT_CHECKSUM_SIZE;
+    size_t body = d.size() - PT_VERSION_HEADER_SIZE;
+
+    if(body % frame_size)
+        diag.error(F, d.size(), "%zu trailing bytes after the last %zu-byte frame", body % frame_size, frame_size);
+    if(body / frame_size != show.frames())
+        diag.error(F, d.size(), "%zu frames, control.dat says %zu", body / frame_size, show.frames());
+
+    size_t n = std::min(body / frame_size, show.frames());
+    for(size_t i = 0; i < n && !diag.full(); i++) {
+        size_t at = PT_VERSION_HEADER_SIZE + i * frame_size;
+        const uint8_t* r = d.data() + at;
+        uint32_t want = checksum(show.minor, r, 5 + size);
+        if(pt_read_u32_le(r + 5 + size) != want)
+            diag.error(F, at, "frame %zu checksum %08x, expected %08x", i, pt_read_u32_le(r + 5 + size), want);
+        check_frame(show, i, pt_read_u32_le(r), at, diag);
+        show.fades[i] = r[4];
+        memcpy(show.payload(i), r + 5, size);
+    }
+    if(counts)
+        counts->n[PT_RECORD_KEY] += (uint32_t)n;
+    return true;
+}
+
+/* one v1.4+ record at off: header, body and crc checked; false when decoding cannot go on */
+struct RecordView {
+    uint8_t type, fade;
+    uint32_t start_time;
+    uint16_t len;
+    const uint8_t* b; /* body */
+    size_t next;      /* offset of the record after it */
+};
+
+static bool view_record(const std::vector<uint8_t>& d, size_t off, uint8_t minor, RecordView& v, Diag& diag) {
+    const char* F = "frame.dat";
+    if(off + PT_RECORD_HEADER_SIZE + PT_CHECKSUM_SIZE > d.size()) {
+        diag.error(F, off, "truncated record header");
+        return false;
+    }
+    const uint8_t* r = d.data() + off;
+    v.type = r[0];
+    v.start_time = pt_read_u32_le(r + 1);
+    v.fade = r[5];
+    v.len = pt_read_u16_le(r + 6);
+    v.b = r + PT_RECORD_HEADER_SIZE;
+    v.next = off + PT_RECORD_HEADER_SIZE + v.len + PT_CHECKSUM_SIZE;
+
+    if(v.next > d.size()) {
+        diag.error(F, off, "record body_len=%u runs past end of file", v.len);
+        return false;
+    }
+    uint32_t want = esp_rom_crc32_le(0, r, PT_RECORD_HEADER_SIZE + v.len);
+    if(pt_read_u32_le(v.b + v.len) != want)
+        diag.error(F, off, "record crc %08x, expected %08x", pt_read_u32_le(v.b + v.len), want);
+    if(!pt_record_supported(minor, v.type)) {
+        diag.error(F, off, "record type %u not valid in v1.%u", v.type, minor);
+        return false;
+    }
+    return true;
+}
+
+/* KEY / INDEXED body, or DELTA runs XORed onto ref, into out (size bytes) */
+static bool decode_board(uint8_t type, const uint8_t* b, uint32_t len, const std::vector<uint8_t>& palette, const uint8_t* ref, uint32_t size, uint32_t pixels, uint8_t* out) {
+    if(type == PT_RECORD_KEY) {
+        if(len != size)
+            return false;
+        memcpy(out, b, size);
+        return true;
+    }
+    if(type == PT_RECORD_INDEXED8 || type == PT_RECORD_INDEXED4) {
+        bool nib = type == PT_RECORD_INDEXED4;
+        if(len != (nib ? (pixels + 1) / 2 : pixels) || palette.empty() || (nib && palette.size() > 16 * 3))
+            return false;
+        for(uint32_t i = 0; i < pixels; i++) {
+            uint32_t idx = nib ? (b[i >> 1] >> ((i & 1) * 4)) & 0x0F : b[i];
+            if(idx * 3 >= palette.size())
+                return false;
+            memcpy(out + i * 3, &palette[idx * 3], 3);
+        }
+        return true;
+    }
+
+    /* DELTA */
+    memcpy(out, ref, size);
+    uint32_t pos = 0;
+    for(uint32_t i = 0; i < len;) {
+        if(i + PT_DELTA_RUN_HEADER_SIZE > len)
+            return false;
+        uint32_t skip = pt_read_u16_le(b + i), n = pt_read_u16_le(b + i + 2);
+        i += PT_DELTA_RUN_HEADER_SIZE;
+        pos += skip;
+        if(pos + n > size || i + n > len)
+            return false;
+        for(uint32_t k = 0; k < n; k++)
+            out[pos + k] ^= b[i + k];
+        pos += n;
+        i += n;
+    }
+    return true;
+}
+
+/* v1.8: easing only on a key that fades, a built-in curve or one of the show's */
+static bool check_ease(bool fade, uint8_t ease, uint32_t curves) {
+    bool custom = ease >= LD_EASE_CUSTOM_FIRST && ease < LD_EASE_CUSTOM_FIRST + curves;
+    return !((ease && !fade) || (ease >= LD_EASE_BUILTIN_NUM && !custom));
+}
+
+/* TRACK / EFFECT record into key; false when the body does not fit its track */
+static bool parse_key(const Show& show, const RecordView& r, size_t off, const std::vector<uint32_t>& sizes, uint32_t curves, TrackKey& key, Diag& diag) {
+    const char* F = "frame.dat";
+    const uint8_t* b = r.b;
+    uint32_t n = (uint32_t)sizes.size();
+    uint32_t body = (r.type == PT_RECORD_EFFECT) ? PT_EFFECT_SIZE : (r.len && b[0] < n ? sizes[b[0]] : 0);
+    if(r.len < PT_TRACK_BODY_HEADER_SIZE || b[0] >= n || (uint32_t)(r.len - PT_TRACK_BODY_HEADER_SIZE) != body) {
+        diag.error(F, off, "%s body_len=%u does not match track %u", RECORD_NAMES[r.type], r.len, r.len ? b[0] : 0);
+        return false;
+    }
+
+    if(r.type == PT_RECORD_EFFECT) {
+        const uint8_t* p = b + PT_TRACK_BODY_HEADER_SIZE;
+        key = TrackKey{r.start_time, 0, {}};
+        key.effect = true;
+        key.fx.type = p[0];
+        key.fx.param = p[1];
+        key.fx.spread = p[2];
+        key.fx.period_ms = pt_read_u16_le(p + 3);
+        key.fx.phase = pt_read_u16_le(p + 5);
+        key.fx.a = {p[7], p[8], p[9]};
+        key.fx.b = {p[10], p[11], p[12]};
+        if(r.fade != 0)
+            diag.error(F, off, "track %u: effect at %u has fade byte %u", b[0], r.start_time, r.fade);
+        if(!ld_effect_valid(&key.fx))
+            diag.error(F, off, "track %u: effect at %u has type %u, period %u ms", b[0], r.start_time, key.fx.type, key.fx.period_ms);
+        return true;
+    }
+
+    bool fade = pt_fade_on(show.minor, r.fade);
+    uint8_t ease = pt_fade_ease(show.minor, r.fade);
+    if(!check_ease(fade, ease, curves))
+        diag.error(F, off, "track %u: key at %u has easing %u%s", b[0], r.start_time, ease, fade ? ", not a curve of this show" : " but no fade");
+    key = TrackKey{r.start_time, (uint8_t)(fade ? 1 : 0), std::vector<uint8_t>(b + PT_TRACK_BODY_HEADER_SIZE, b + r.len), ease};
+    return true;
+}
+
+static bool same_key(const TrackKey& a, const TrackKey& b) {
+    if(a.ts != b.ts || a.effect != b.effect)
+        return false;
+    if(a.effect)
+        return a.fx.type == b.fx.type && a.fx.param == b.fx.param && a.fx.spread == b.fx.spread && a.fx.period_ms == b.fx.period_ms && a.fx.phase == b.fx.phase &&
+               !memcmp(&a.fx.a, &b.fx.a, sizeof(a.fx.a)) && !memcmp(&a.fx.b, &b.fx.b, sizeof(a.fx.b));
+    return a.fade == b.fade && a.ease == b.ease && a.data == b.data;
+}
+
+struct KeySource {
+    size_t offset; /* record that gave the key */
+    bool delta;
+};
+
+struct SyncGroup {
+    size_t offset;
+    uint32_t ts;
+    std::vector<std::pair<uint8_t, TrackKey>> keys; /* restated, in file order */
+};
+
+/* a seek to s must see every key in effect from s.ts on: after the SYNC as a full record, or restated */
+static void check_sync(const Show& show, const std::vector<std::vector<KeySource>>& sources, const SyncGroup& s, Diag& diag) {
+    const char* F = "frame.dat";
+    std::vector<bool> started(show.tracks.size(), false);
+    std::vector<const TrackKey*> prev(show.tracks.size(), nullptr);
+    uint32_t last_need = 0;
+    for(const auto& e : s.keys) {
+        /* the reader pushes the group right after a reset */
+        uint32_t need = (prev[e.first] && prev[e.first]->fade) ? prev[e.first]->ts : e.second.ts;
+        if(need < last_need || (prev[e.first] && e.second.ts <= prev[e.first]->ts))
+            diag.error(F, s.offset, "SYNC at %u: track %u key at %u out of order in the group", s.ts, e.first, e.second.ts);
+        last_need = std::max(last_need, need);
+        prev[e.first] = &e.second;
+    }
+
+    for(size_t j = 0; j < show.tracks.size(); j++) {
+        const std::vector<TrackKey>& keys = show.tracks[j].keys;
+        size_t k = std::lower_bound(keys.begin(), keys.end(), s.ts, [](const TrackKey& key, uint32_t ts) { return key.ts < ts; }) - keys.begin();
+        bool keyed = k < keys.size() && keys[k].ts == s.ts && sources[j][k].offset > s.offset && !sources[j][k].delta;
+
+        std::vector<const TrackKey*> want;
+        if(!keyed && k > 0) {
+            want.push_back(&keys[k - 1]);
+            if(keys[k - 1].fade && k < keys.size())
+                want.push_back(&keys[k]);
+        }
+        std::vector<const TrackKey*> got;
+        for(const auto& e : s.keys) {
+            if(e.first == j)
+                got.push_back(&e.second);
+        }
+        bool same = got.size() == want.size();
+        for(size_t i = 0; same && i < got.size(); i++)
+            same = same_key(*got[i], *want[i]);
+        if(!same)
+            diag.error(F, s.offset, "SYNC at %u restates %zu keys of track %zu, the seek needs %zu", s.ts, got.size(), j, want.size());
+
+        /* the rest must come after the SYNC */
+        for(size_t i = k + (want.size() > 1 ? 1 : 0); i < keys.size(); i++) {
+            if(sources[j][i].offset < s.offset) {
+                diag.error(F, sources[j][i].offset, "track %zu key at %u comes before the SYNC at %u and is not restated", j, keys[i].ts, s.ts);
+                break;
+            }
+        }
+    }
+}
+
+static bool decode_records(const std::vector<uint8_t>& d, Show& show, Diag& diag, RecordCounts* counts) {
+    const char* F = "frame.dat";
+    uint32_t size = show.layout.payload_size();
+    uint32_t pixels = show.layout.pixels();
+    std::vector<uint8_t> key;
+    std::vector<uint8_t> palette;
+    size_t frame = 0;
+    size_t off = PT_VERSION_HEADER_SIZE;
+
+    while(off < d.size() && !diag.full()) {
+        RecordView r;
+        if(!view_record(d, off, show.minor, r, diag))
+            break;
+        if(counts)
+            counts->n[r.type]++;
+
+        if(r.type == PT_RECORD_PALETTE) {
+            if(r.len == 0 || r.len % 3 || r.len / 3 > PT_PALETTE_MAX_COLORS)
+                diag.error(F, off, "palette body_len=%u", r.len);
+            palette.assign(r.b, r.b + r.len);
+            off = r.next;
+            continue;
+        }
+
+        if(frame >= show.frames()) {
+            diag.error(F, off, "more frame records than control.dat frame_num=%zu", show.frames());
+            break;
+        }
+
+        /* DELTA against the last KEY, a KEY / INDEXED becomes the new one */
+        uint8_t* out = show.payload(frame);
+        bool ok = (r.type != PT_RECORD_DELTA || !key.empty()) && decode_board(r.type, r.b, r.len, palette, key.data(), size, pixels, out);
+        if(!ok) {
+            diag.error(F, off, "frame %zu: malformed %s record (body_len=%u, payload %u)", frame, RECORD_NAMES[r.type], r.len, size);
+            key.clear();
+        } else if(r.type != PT_RECORD_DELTA) {
+            key.assign(out, out + size);
+        }
+
+        check_frame(show, frame, r.start_time, off, diag);
+        show.fades[frame] = r.fade;
+        frame++;
+        off = r.next;
+    }
+
+    if(frame != show.frames() && !diag.full())
+        diag.error(F, d.size(), "%zu frames, control.dat says %zu", frame, show.frames());
+    return true;
+}
+
+static bool decode_tracks(const std::vector<uint8_t>& d, Show& show, Diag& diag, RecordCounts* counts) {
+    const char* F = "frame.dat";
+    size_t off = PT_VERSION_HEADER_SIZE;
+    uint32_t n = d.size() > off ? d[off] : 0;
+    size_t table = PT_TRACK_TABLE_HEADER_SIZE + (size_t)n * PT_TRACK_MASK_SIZE;
+    uint32_t curves = 0;
+    if(pt_version_has_easing(show.minor) && d.size() > off + table) {
+        curves = d[off + table];
+        table += PT_CURVE_TABLE_HEADER_SIZE + (size_t)curves * PT_CURVE_SIZE;
+    }
+    if(n == 0 || n > PT_TRACK_MAX || curves > PT_CURVE_MAX || d.size() < off + table + PT_CHECKSUM_SIZE) {
+        diag.error(F, off, "track table: %u tracks, %u curves, %zu bytes left", n, curves, d.size() - std::min(d.size(), off));
+        return false;
+    }
+    uint32_t want = esp_rom_crc32_le(0, d.data() + off, (uint32_t)table);
+    if(pt_read_u32_le(d.data() + off + table) != want)
+        diag.error(F, off + table, "track table crc %08x, expected %08x", pt_read_u32_le(d.data() + off + table), want);
+
+    show.tracks.assign(n, Track{0, {}});
+    std::vector<uint32_t> sizes(n, 0);
+    uint64_t seen = 0;
+    for(uint32_t j = 0; j < n; j++) {
+        uint64_t mask = pt_read_u64_le(d.data() + off + PT_TRACK_TABLE_HEADER_SIZE + j * PT_TRACK_MASK_SIZE);
+        if((mask & ~LD_FRAME_FADE_ALL) || (mask & seen))
+            diag.error(F, off + PT_TRACK_TABLE_HEADER_SIZE + j * PT_TRACK_MASK_SIZE, "track %u mask %016llx overlaps another track or names no channel", j, (unsigned long long)mask);
+        seen |= mask;
+        show.tracks[j].mask = mask;
+        for(const auto& r : show.layout.ranges(show.tracks[j].mask))
+            sizes[j] += r.second;
+    }
+    size_t curve_at = off + table - (size_t)curves * PT_CURVE_SIZE;
+    show.curves.assign(d.begin() + curve_at, d.begin() + off + table);
+    for(uint32_t c = 0; c < curves; c++) {
+        const uint8_t* lut = show.curves.data() + (size_t)c * PT_CURVE_SIZE;
+        if(lut[0] != 0 || lut[PT_CURVE_SIZE - 1] != 255)
+            diag.error(F, curve_at + (size_t)c * PT_CURVE_SIZE, "curve %u maps 0 -> %u and 255 -> %u", c, lut[0], lut[PT_CURVE_SIZE - 1]);
+    }
+    if(!diag.ok())
+        return false;
+
+    /* whole-board records key every track; a v1.6+ DELTA XORs onto the latest key of every channel */
+    uint32_t size = show.layout.payload_size();
+    uint32_t pixels = show.layout.pixels();
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> ranges;
+    for(const Track& t : show.tracks)
+        ranges.push_back(show.layout.ranges(t.mask));
+    std::vector<uint8_t> last(size, 0), board(size), palette;
+    bool have_key = false; /* a board KEY / INDEXED since the start or the last SYNC */
+
+    /* where each key came from, to check the SYNC groups once every key is known */
+    std::vector<std::vector<KeySource>> sources(n);
+    std::vector<SyncGroup> syncs;
+
+    uint32_t last_need = 0;
+    off += table + PT_CHECKSUM_SIZE;
+    while(off < d.size() && !diag.full()) {
+        RecordView r;
+        if(!view_record(d, off, show.minor, r, diag))
+            break;
+        if(counts)
+            counts->n[r.type]++;
+
+        if(r.type == PT_RECORD_PALETTE) {
+            if(r.len == 0 || r.len % 3 || r.len / 3 > PT_PALETTE_MAX_COLORS)
+                diag.error(F, off, "palette body_len=%u", r.len);
+            palette.assign(r.b, r.b + r.len);
+            off = r.next;
+            continue;
+        }
+
+        if(r.type == PT_RECORD_SYNC) {
+            if(r.len != PT_SYNC_SIZE || r.fade) {
+                diag.error(F, off, "SYNC body_len=%u, fade %u", r.len, r.fade);
+                off = r.next;
+                continue;
+            }
+            size_t end = r.next + pt_read_u32_le(r.b);
+            if(end > d.size()) {
+                diag.error(F, off, "SYNC group of %u bytes runs past end of file", pt_read_u32_le(r.b));
+                break;
+            }
+            SyncGroup s{off, r.start_time, {}};
+            size_t g = r.next;
+            while(g < end && !diag.full()) {
+                RecordView k;
+                if(!view_record(d, g, show.minor, k, diag))
+                    break;
+                if(counts)
+                    counts->n[k.type]++;
+                TrackKey key;
+                if(k.type != PT_RECORD_TRACK && k.type != PT_RECORD_EFFECT)
+                    diag.error(F, g, "%s record inside the SYNC group at %zu", RECORD_NAMES[k.type], off);
+                else if(parse_key(show, k, g, sizes, curves, key, diag))
+                    s.keys.push_back({k.b[0], std::move(key)});
+                g = k.next;
+            }
+            if(g != end)
+                diag.error(F, off, "SYNC group ends at %zu, inside a record", end);
+            syncs.push_back(std::move(s));
+            have_key = false;
+            off = end;
+            continue;
+        }
+
+        if(r.type != PT_RECORD_TRACK && r.type != PT_RECORD_EFFECT) {
+            bool fade = pt_fade_on(show.minor, r.fade);
+            uint8_t ease = pt_fade_ease(show.minor, r.fade);
+            if(!check_ease(fade, ease, curves))
+                diag.error(F, off, "%s at %u has easing %u%s", RECORD_NAMES[r.type], r.start_time, ease, fade ? ", not a curve of this show" : " but no fade");
+            if(r.type == PT_RECORD_DELTA && !have_key)
+                diag.error(F, off, "DELTA at %u without a KEY since the start or the last SYNC", r.start_time);
+            if(!decode_board(r.type, r.b, r.len, palette, last.data(), size, pixels, board.data())) {
+                diag.error(F, off, "malformed %s record at %u (body_len=%u, payload %u)", RECORD_NAMES[r.type], r.start_time, r.len, size);
+                off = r.next;
+                continue;
+            }
+
+            uint32_t need = r.start_time;
+            for(uint32_t j = 0; j < n; j++) {
+                const std::vector<TrackKey>& keys = show.tracks[j].keys;
+                if(!keys.empty() && r.start_time <= keys.back().ts)
+                    diag.error(F, off, "%s at %u after track %u's key at %u", RECORD_NAMES[r.type], r.start_time, j, keys.back().ts);
+                if(!keys.empty() && keys.back().fade)
+                    need = std::min(need, keys.back().ts);
+            }
+            if(need < last_need)
+                diag.error(F, off, "%s at %u needed at %u, after a record needed at %u", RECORD_NAMES[r.type], r.start_time, need, last_need);
+            last_need = std::max(last_need, need);
+
+            for(uint32_t j = 0; j < n; j++) {
+                TrackKey key{r.start_time, (uint8_t)(fade ? 1 : 0), {}, ease};
+                gather(board.data(), ranges[j], key.data);
+                show.tracks[j].keys.push_back(std::move(key));
+                sources[j].push_back({off, r.type == PT_RECORD_DELTA});
+            }
+            last = board;
+            if(r.type != PT_RECORD_DELTA)
+                have_key = true;
+            off = r.next;
+            continue;
+        }
+
+        TrackKey key;
+        if(!parse_key(show, r, off, sizes, curves, key, diag)) {
+            off = r.next;
+            continue;
+        }
+        uint8_t j = r.b[0];
+        std::vector<TrackKey>& keys = show.tracks[j].keys;
+        if(!keys.empty() && r.start_time <= keys.back().ts)
+            diag.error(F, off, "track %u: key at %u after %u", j, r.start_time, keys.back().ts);
+        uint32_t need = (!keys.empty() && keys.back().fade) ? keys.back().ts : r.start_time;
+        if(need < last_need)
+            diag.error(F, off, "track %u: key at %u needed at %u, after a record needed at %u", j, r.start_time, need, last_need);
+        last_need = std::max(last_need, need);
+        if(key.effect && !keys.empty() && keys.back().fade)
+            diag.error(F, off, "track %u: key at %u fades into the effect at %u", j, keys.back().ts, r.start_time);
+
+        if(key.effect) {
+            for(const auto& range : ranges[j])
+                memset(&last[range.first], 0, range.second);
+        } else {
+            scatter(key.data.data(), ranges[j], last.data());
+        }
+        keys.push_back(std::move(key));
+        sources[j].push_back({off, false});
+        off = r.next;
+    }
+    if(!diag.ok())
+        return true;
+
+    for(const SyncGroup& s : syncs)
+        check_sync(show, sources, s, diag);
+
+    /* the merged frames are what control.dat lists */
+    std::vector<uint32_t> listed = show.timestamps;
+    merge_tracks(show);
+    if(show.frames() != listed.size())
+        diag.error(F, d.size(), "tracks merge into %zu frames, control.dat says %zu", show.frames(), listed.size());
+    for(size_t i = 0; i < std::min(show.frames(), listed.size()) && !diag.full(); i++) {
+        if(show.timestamps[i] != listed[i])
+            diag.error("control.dat", pt_version_has_varint_times(show.minor) ? CONTROL_FIXED + 4 : CONTROL_FIXED + i * 4, "timestamp[%zu]=%u, tracks have a key at %u", i, listed[i], show.timestamps[i]);
+    }
+    for(const SyncGroup& s : syncs) {
+        if(!std::binary_search(show.timestamps.begin(), show.timestamps.end(), s.ts))
+            diag.error(F, s.offset, "SYNC at %u ms is not a frame time", s.ts);
+    }
+    for(size_t i = 0; i < show.effects.size() && !diag.full(); i++) {
+        if(show.effects[i].size() > LD_FRAME_EFFECT_MAX)
+            diag.error(F, d.size(), "%zu effects at %u ms, the Player runs at most %d", show.effects[i].size(), show.timestamps[i], LD_FRAME_EFFECT_MAX);
+    }
+    return true;
+}
+
+bool decode_frames(const std::vector<uint8_t>& d, Show& show, Diag& diag, RecordCounts* counts) {
+    if(d.size() < PT_VERSION_HEADER_SIZE) {
+        diag.error("frame.dat", 0, "missing version header");
+        return false;
+    }
+    if(d[0] != PT_VERSION_MAJOR || d[1] != show.minor) {
+        diag.error("frame.dat", 0, "version %u.%u, control.dat is %u.%u", d[0], d[1], PT_VERSION_MAJOR, show.minor);
+        return false;
+    }
+    if(pt_version_has_tracks(show.minor))
+        return decode_tracks(d, show, diag, counts);
+    return pt_version_has_records(show.minor) ? decode_records(d, show, diag, counts) : decode_fixed(d, show, diag, counts);
+}
+
+/* ================= files ================= */
+
+bool read_file(const std::string& path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if(!f)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    rewind(f);
+    out.resize(n > 0 ? (size_t)n : 0);
+    bool ok = n >= 0 && fread(out.data(), 1, out.size(), f) == out.size();
+    fclose(f);
+    return ok;
+}
+
+bool write_file(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if(!f)
+        return false;
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    return fclose(f) == 0 && ok;
+}
+
+bool load_show(const std::string& dir, Show& show, Diag& diag, RecordCounts* counts) {
+    std::vector<uint8_t> control, frame;
+    if(!read_file(dir + "/control.dat", control)) {
+        diag.error("control.dat", 0, "cannot read %s/control.dat", dir.c_str());
+        return false;
+    }
+    if(!read_file(dir + "/frame.dat", frame)) {
+        diag.error("frame.dat", 0, "cannot read %s/frame.dat", dir.c_str());
+        return false;
+    }
+    if(!decode_control(control, show, diag))
+        return false;
+    decode_frames(frame, show, diag, counts);
+    return diag.ok();
+}
+
+bool save_show(const std::string& dir, const Show& show, uint32_t keyframe_interval, RecordCounts* counts) {
+    return write_file(dir + "/control.dat", encode_control(show)) && write_file(dir + "/frame.dat", encode_frames(show, keyframe_interval, counts));
+}
+
+} // namespace pt
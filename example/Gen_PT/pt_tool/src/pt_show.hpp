@@ -0,0 +1,143 @@
+#pragma once
+
+/* In-memory pattern table and the v1.2 ~ v1.9 encoders / decoders.
+ *
+ * Record layout and checksums follow pt_format.h; the encoder makes the
+ * same KEY / DELTA / PALETTE / TRACK / SYNC decisions as pt_codec.py, so both
+ * produce byte-identical frame.dat files.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ld_board.h"
+#include "ld_ease.h"
+#include "ld_frame.h"
+#include "pt_format.h"
+
+namespace pt {
+
+/* [of flags][strip counts] as stored in control.dat */
+struct Layout {
+    uint8_t of[LD_BOARD_PCA9955B_CH_NUM] = {};
+    uint8_t strips[LD_BOARD_WS2812B_NUM] = {};
+
+    uint32_t pixels() const;
+    uint32_t payload_size() const { return pixels() * 3; }
+    std::string name() const;
+
+    /* payload bytes [offset, offset + len) of the channels in a fade_mask, in payload order */
+    std::vector<std::pair<uint32_t, uint32_t>> ranges(uint64_t mask) const;
+
+    /* "of40", "s8x100" or "<of>:<n>,<n>,..." (enabled OF count, then pixels per strip) */
+    static bool parse(const std::string& spec, Layout& out);
+};
+
+/* v1.6: keyframe of one track, data holds the track's channels in payload order */
+struct TrackKey {
+    uint32_t ts;
+    uint8_t fade; /* interpolate to the next key of the track */
+    std::vector<uint8_t> data;
+    uint8_t ease = LD_EASE_LINEAR; /* v1.8 curve of the fade */
+    bool effect = false;           /* v1.9 EFFECT key: fx instead of data, never fades */
+    ld_effect_t fx = {};
+};
+
+struct Track {
+    uint64_t mask; /* LD_FRAME_FADE_* bits */
+    std::vector<TrackKey> keys;
+};
+
+/* how split_tracks() groups channels: all OF + one per strip, or one per channel */
+enum class TrackGrouping { Strip, Channel };
+
+struct Show {
+    uint8_t minor = PT_VERSION_MINOR_CRC32;
+    Layout layout;
+    std::vector<uint32_t> timestamps;
+    std::vector<uint8_t> fades;
+    std::vector<uint8_t> payloads; /* frames() x payload_size, back to back */
+    std::vector<uint64_t> fade_masks; /* per frame once tracks are merged; empty: fades[i] means every channel */
+    std::vector<Track> tracks;        /* v1.6 source of the frames above */
+    std::vector<uint8_t> eases;       /* v1.8 per frame curve once tracks are merged; empty: all linear */
+    std::vector<uint8_t> curves;      /* v1.8 custom curves, LD_EASE_LUT_SIZE bytes each */
+    std::vector<std::vector<ld_frame_effect_t>> effects; /* v1.9 per frame once tracks are merged; empty: none */
+
+    size_t frames() const { return timestamps.size(); }
+    uint8_t* payload(size_t i) { return payloads.data() + i * layout.payload_size(); }
+    const uint8_t* payload(size_t i) const { return payloads.data() + i * layout.payload_size(); }
+
+    void resize(size_t frames);
+
+    /* CRC32 over every frame as table_frame_t, same value as the pt_bench digest column */
+    uint32_t digest() const;
+    /* unpack frame i the way frame_reader_read() does */
+    void to_table_frame(size_t i, table_frame_t& out) const;
+    uint64_t fade_mask(size_t i) const { return fade_masks.empty() ? (fades[i] ? LD_FRAME_FADE_ALL : 0) : fade_masks[i]; }
+    uint8_t ease(size_t i) const { return eases.empty() ? LD_EASE_LINEAR : eases[i]; }
+    size_t curve_count() const { return curves.size() / LD_EASE_LUT_SIZE; }
+    /* true when some frame or key uses a curve other than linear (v1.8 only) */
+    bool eased() const;
+    /* ld_ease_apply() with this show's custom curves */
+    uint8_t apply_ease(uint8_t ease, uint8_t p) const;
+    /* true when some track key is an effect (v1.9 only) */
+    bool has_effects() const;
+
+    /* what the Player outputs at time_ms before gamma / brightness, payload layout */
+    void render(uint32_t time_ms, std::vector<uint8_t>& out) const;
+
+  private:
+    /* ld_effect_render() of frame i's effects over out, as FrameBuffer::render_effects() */
+    void render_effects(size_t i, uint32_t time_ms, uint8_t* out) const;
+};
+
+/* number of records written / read per pt_record_type_t, fixed frames count as KEY */
+struct RecordCounts {
+    uint32_t n[PT_RECORD_SYNC + 1] = {};
+    std::string str() const;
+};
+
+/* errors found while decoding, each tagged with a file offset */
+struct Diag {
+    std::vector<std::string> errors;
+    size_t limit = 20; /* stop collecting after this many */
+
+    void error(const char* file, size_t offset, const char* fmt, ...) __attribute__((format(printf, 4, 5)));
+    bool ok() const { return errors.empty(); }
+    bool full() const { return errors.size() >= limit; }
+};
+
+/* track channel masks of a layout, empty channels left out */
+std::vector<uint64_t> track_masks(const Layout& layout, TrackGrouping grouping);
+/* v1.6: split the frames into tracks, dropping keys that neither change nor fade, then
+ * merge them back (merge_tracks) so timestamps / payloads are what the reader returns.
+ * false when timestamps are not strictly increasing. */
+bool make_tracks(Show& show, TrackGrouping grouping, std::string& error);
+/* frames from show.tracks: one per distinct key time, fades still running baked in like track_merge.c */
+void merge_tracks(Show& show);
+/* same Player output at every frame time and halfway between frames of both shows; where says when not */
+bool same_playback(const Show& a, const Show& b, std::string& where);
+
+std::vector<uint8_t> encode_control(const Show& show);
+std::vector<uint8_t> encode_frames(const Show& show, uint32_t keyframe_interval, RecordCounts* counts = nullptr);
+
+/* decode_control fills minor / layout / timestamps; decode_frames then fills fades / payloads
+ * (v1.6: tracks, then the merged frames, which must match the control.dat timestamps).
+ * Both return false only when the file is unusable; every problem found is added to diag. */
+bool decode_control(const std::vector<uint8_t>& data, Show& show, Diag& diag);
+bool decode_frames(const std::vector<uint8_t>& data, Show& show, Diag& diag, RecordCounts* counts = nullptr);
+
+bool read_file(const std::string& path, std::vector<uint8_t>& out);
+bool write_file(const std::string& path, const std::vector<uint8_t>& data);
+
+/* control.dat + frame.dat in dir, true when diag stays empty */
+bool load_show(const std::string& dir, Show& show, Diag& diag, RecordCounts* counts = nullptr);
+bool save_show(const std::string& dir, const Show& show, uint32_t keyframe_interval, RecordCounts* counts = nullptr);
+
+/* "1.3" -> 3, 0 if not a supported revision */
+uint8_t parse_version(const std::string& s);
+
+} // namespace pt
@@ -1,7 +1,7 @@
 import struct
 
-def calculate_checksum(data):
-    return sum(data) & 0xFFFFFFFF
+from pt_codec import (EASE_NAMES, EFFECT, EFFECT_NAMES, RECORD_DELTA, RECORD_NAMES, VERSION_EASING, VERSION_RECORDS, VERSION_TRACKS, VERSION_VARINT_TIMES,
+                      calculate_checksum, channel_ranges, decode_records, decode_times, decode_tracks, payload_size)
 
 def read_control_file():
     with open("control.dat", "rb") as file:
@@ -31,13 +31,16 @@ def read_control_file():
         frame_num = struct.unpack_from('<I', control_data, offset)[0]
         offset += 4
         
-        timestamps = []
-        for i in range(frame_num):
-            timestamps.append(struct.unpack_from('<I', control_data, offset)[0])
-            offset += 4
+        if version[1] >= VERSION_VARINT_TIMES:
+            timestamps, offset = decode_times(control_data, offset, frame_num)
+        else:
+            timestamps = []
+            for i in range(frame_num):
+                timestamps.append(struct.unpack_from('<I', control_data, offset)[0])
+                offset += 4
         
         # 驗證 checksum
-        calc_checksum = calculate_checksum(control_data)
+        calc_checksum = calculate_checksum(control_data, version[1])
         checksum_ok = (calc_checksum == stored_checksum)
         
         print(f"Enabled OF: {sum(of_channel)}")
@@ -56,6 +59,14 @@ def read_frame_file(of_channel, strip_channel, frame_num):
         print("\n=== frame.dat ===")
         print(f"Version: {version[0]}.{version[1]}")
         
+        if version[1] >= VERSION_TRACKS:
+            read_tracks(file.read(), of_channel, strip_channel, version[1])
+            return
+        
+        if version[1] >= VERSION_RECORDS:
+            read_records(file.read(), of_channel, strip_channel)
+            return
+        
         of_num = sum(of_channel)
         total_leds = sum(strip_channel)
         frame_size = 4 + 1 + (of_num * 3) + (total_leds * 3) + 4
@@ -95,12 +106,82 @@ def read_frame_file(of_channel, strip_channel, frame_num):
                         print(f"  LED[{i}][{j}]: G={g:03d}, R={r:03d}, B={b:03d}")
             
             stored_checksum = struct.unpack_from('<I', frame_data, offset)[0]
-            print(f"  Checksum: {stored_checksum:08X}")
+            calc_checksum = calculate_checksum(frame_data[:offset], version[1])
+            print(f"  Checksum: {stored_checksum:08X} ({'OK' if calc_checksum == stored_checksum else 'ERROR'})")
             
             frame_count += 1
         
         print(f"\nTotal frames read: {frame_count}")
 
+def print_payload(payload, of_channel, strip_channel):
+    offset = 0
+    for i, enabled in enumerate(of_channel):
+        if enabled:
+            g, r, b = payload[offset:offset + 3]
+            offset += 3
+            print(f"  OF[{i}]: G={g:03d}, R={r:03d}, B={b:03d}")
+    
+    for i, strip_leds in enumerate(strip_channel):
+        for j in range(strip_leds):
+            g, r, b = payload[offset:offset + 3]
+            offset += 3
+            print(f"  LED[{i}][{j}]: G={g:03d}, R={r:03d}, B={b:03d}")
+
+def read_records(data, of_channel, strip_channel):
+    # v1.4+: KEY / DELTA / INDEXED records, decoded back to full frames
+    size = payload_size(of_channel, strip_channel)
+    frame_count = 0
+    key_count = 0
+    for rtype, start_time, fade, payload, crc_ok in decode_records(data, size):
+        key_count += (rtype != RECORD_DELTA)
+        print(f"\nFrame{frame_count} [{RECORD_NAMES[rtype]}]: time={start_time}, fade={'on' if fade else 'off'}")
+        print_payload(payload, of_channel, strip_channel)
+        print(f"  Checksum: {'OK' if crc_ok else 'ERROR'}")
+        frame_count += 1
+    
+    print(f"\nTotal frames read: {frame_count} ({key_count} KEY)")
+
+def ease_name(ease):
+    return EASE_NAMES[ease] if ease < len(EASE_NAMES) else f"custom{ease - 8}" if ease >= 8 else f"reserved{ease}"
+
+def read_tracks(data, of_channel, strip_channel, version_minor):
+    # v1.6: track table + TRACK records, each holding only its own channels;
+    #       a whole-board KEY / DELTA / INDEXED record keys every track (listed as TRACK), SYNC groups are skipped
+    # v1.8: custom curves after the masks, easing id in bit 1~7 of the fade byte
+    # v1.9: EFFECT records (fade None) run a procedural effect until the track's next key
+    try:
+        tracks = decode_tracks(data, of_channel, strip_channel, version_minor)
+    except (ValueError, struct.error, IndexError) as e:
+        print(f"ERROR: {e}")
+        return
+    
+    print(f"Tracks: {len(tracks)}")
+    for j, (mask, keys) in enumerate(tracks):
+        ranges = channel_ranges(of_channel, strip_channel, mask)
+        of = [i for i in range(40) if mask >> i & 1]
+        strips = [s for s in range(8) if mask >> (40 + s) & 1]
+        print(f"  Track{j}: mask={mask:012X}, OF={of}, strip={strips}, {sum(n for _, n in ranges)} bytes, {len(keys)} keys")
+    
+    for j, (mask, keys) in enumerate(tracks):
+        for start_time, fade, value in keys:
+            if fade is None:
+                kind, param, spread, period, phase, a, b = EFFECT.unpack(value)
+                name = EFFECT_NAMES[kind] if kind < len(EFFECT_NAMES) else f"unknown{kind}"
+                print(f"\nTrack{j} [EFFECT]: time={start_time}, {name}, param={param}, spread={spread}, period={period}ms, phase={phase}")
+                print(f"  a: G={a[0]:03d}, R={a[1]:03d}, B={a[2]:03d}")
+                print(f"  b: G={b[0]:03d}, R={b[1]:03d}, B={b[2]:03d}")
+                continue
+            if version_minor >= VERSION_EASING:
+                print(f"\nTrack{j} [TRACK]: time={start_time}, fade={'on' if fade & 1 else 'off'}, ease={ease_name(fade >> 1)}")
+            else:
+                print(f"\nTrack{j} [TRACK]: time={start_time}, fade={'on' if fade else 'off'}")
+            for offset in range(0, len(value), 3):
+                g, r, b = value[offset:offset + 3]
+                print(f"  [{offset // 3}]: G={g:03d}, R={r:03d}, B={b:03d}")
+    
+    times = sorted({t for _, keys in tracks for t, _, _ in keys})
+    print(f"\nTotal keys read: {sum(len(keys) for _, keys in tracks)} ({len(times)} merged frames)")
+
 
 version, of_channel, strip_channel, frame_num = read_control_file()
   